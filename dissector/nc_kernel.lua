@@ -1,32 +1,69 @@
 nck_sw_data = Proto("nck_sw_data", "NCKernel SW Data")
 nck_sw_feedback = Proto("nck_sw_feedback", "NCKernel SW Feedback")
+nck_interflow_sw = Proto("nck_interflow_sw", "NCKernel Interflow SW")
+
+-- see enum sw_coded_packet_flags
+local SW_CODED_PACKET_SEED = 0x04
+
+-- see enum interflow_sw_packet_type
+local INTERFLOW_SW_PACKET_TYPE_CODED = 1
+local INTERFLOW_SW_PACKET_TYPE_FEEDBACK = 2
+local INTERFLOW_SW_PACKET_TYPE_MIXED = 3
 
 nck_sw_data.fields.packet_type = ProtoField.uint8("nck_sw_data.packet_type", "Packet Type", base.DEC)
 nck_sw_data.fields.packet_no = ProtoField.uint16("nck_sw_data.packet_no", "Packet Number", base.DEC)
-nck_sw_data.fields.flags = ProtoField.uint8("nck_sw_data.flags", "Flag field", base.DEC)
+nck_sw_data.fields.flags = ProtoField.uint8("nck_sw_data.flags", "Flag field", base.HEX)
+nck_sw_data.fields.flow = ProtoField.uint8("nck_sw_data.flow", "Flow", base.DEC)
 nck_sw_data.fields.order = ProtoField.uint8("nck_sw_data.order", "Elements in the coefficient vector", base.DEC)
 nck_sw_data.fields.seqno = ProtoField.uint32("nck_sw_data.seqno", "Sequence number", base.DEC)
 nck_sw_data.fields.data = ProtoField.uint8("nck_sw_data.data", "Missing data", base.DEC)
 nck_sw_data.fields.systematic = ProtoField.uint8("nck_sw_data.systematic", "Systematic flag", base.DEC)
 nck_sw_data.fields.coefficients = ProtoField.bytes("nck_sw_data.coefficients", "Coding coefficients", base.DOT)
+nck_sw_data.fields.seed = ProtoField.uint32("nck_sw_data.seed", "Coefficient seed", base.HEX)
+nck_sw_data.fields.first = ProtoField.uint16("nck_sw_data.first", "First window slot", base.DEC)
+nck_sw_data.fields.count = ProtoField.uint16("nck_sw_data.count", "Window slots", base.DEC)
 
 nck_sw_feedback.fields.packet_type = ProtoField.uint8("nck_sw_feedback.packet_type", "Packet Type", base.DEC)
 nck_sw_feedback.fields.packet_no = ProtoField.uint16("nck_sw_feedback.packet_no", "Last received packet number", base.DEC)
 nck_sw_feedback.fields.feedback_no = ProtoField.uint16("nck_sw_feedback.feedback_no", "Feedback number", base.DEC)
+nck_sw_feedback.fields.received = ProtoField.uint8("nck_sw_feedback.received", "Received packets (mod 256)", base.DEC)
+nck_sw_feedback.fields.loss_runs = ProtoField.uint8("nck_sw_feedback.loss_runs", "Loss runs (mod 256)", base.DEC)
 nck_sw_feedback.fields.seqno = ProtoField.uint32("nck_sw_feedback.seqno", "Sequence number", base.DEC)
 nck_sw_feedback.fields.order = ProtoField.uint8("nck_sw_feedback.order", "Bits in the missing symbols mask", base.DEC)
 nck_sw_feedback.fields.first_missing = ProtoField.uint32("nck_sw_feedback.first_missing", "First missing sequence number", base.DEC)
+nck_sw_feedback.fields.delay = ProtoField.uint32("nck_sw_feedback.delay", "Feedback delay (us)", base.DEC)
 nck_sw_feedback.fields.missing = ProtoField.bytes("nck_sw_feedback.missing", "Missing data", base.DOT)
 
-function nck_sw_data.dissector(buffer, pinfo, tree)
-	local subtree = tree:add(nck_sw_data, buffer)
-	pinfo.cols.protocol = "NCK SW data"
+nck_interflow_sw.fields.packet_type = ProtoField.uint8("nck_interflow_sw.packet_type", "Packet Type", base.DEC)
+nck_interflow_sw.fields.count = ProtoField.uint8("nck_interflow_sw.count", "Mixed packets", base.DEC)
+nck_interflow_sw.fields.length = ProtoField.uint16("nck_interflow_sw.length", "Mixed payload length", base.DEC)
+nck_interflow_sw.fields.flow = ProtoField.uint8("nck_interflow_sw.flow", "Flow", base.DEC)
+nck_interflow_sw.fields.coefficient = ProtoField.uint8("nck_interflow_sw.coefficient", "Coefficient", base.DEC)
+nck_interflow_sw.fields.entry_length = ProtoField.uint16("nck_interflow_sw.entry_length", "Packet length", base.DEC)
+nck_interflow_sw.fields.packet_no = ProtoField.uint16("nck_interflow_sw.packet_no", "Packet Number", base.DEC)
+nck_interflow_sw.fields.hash = ProtoField.uint32("nck_interflow_sw.hash", "Packet hash", base.HEX)
+nck_interflow_sw.fields.payload = ProtoField.bytes("nck_interflow_sw.payload", "Mixed payload", base.DOT)
 
+-- struct sw_coded_packet and struct interflow_sw_coded_packet, the interflow
+-- packet has the flow in place of the reserved byte
+local function dissect_coded(buffer, subtree, flow)
 	subtree:add(nck_sw_data.fields.packet_type, buffer(0, 1))
 	subtree:add(nck_sw_data.fields.order, buffer(1, 1))
 	subtree:add(nck_sw_data.fields.flags, buffer(2, 1))
+	if flow then
+		subtree:add(nck_sw_data.fields.flow, buffer(3, 1))
+	end
 	subtree:add(nck_sw_data.fields.packet_no, buffer(4, 2))
 	subtree:add(nck_sw_data.fields.seqno, buffer(6, 4))
+
+	-- struct sw_seed_header replaces the kodo header
+	if bit.band(buffer(2, 1):uint(), SW_CODED_PACKET_SEED) ~= 0 then
+		subtree:add(nck_sw_data.fields.seed, buffer(10, 4))
+		subtree:add(nck_sw_data.fields.first, buffer(14, 2))
+		subtree:add(nck_sw_data.fields.count, buffer(16, 2))
+		return
+	end
+
 	subtree:add(nck_sw_data.fields.systematic, buffer(10, 1))
 
 	local order = buffer(1, 1):uint()
@@ -39,6 +76,13 @@ function nck_sw_data.dissector(buffer, pinfo, tree)
 --	subtree:add(nck_sw_data.fields.data, buffer(6, buffer:len() - 6))
 end
 
+function nck_sw_data.dissector(buffer, pinfo, tree)
+	local subtree = tree:add(nck_sw_data, buffer)
+	pinfo.cols.protocol = "NCK SW data"
+
+	dissect_coded(buffer, subtree, false)
+end
+
 function nck_sw_feedback.dissector(buffer, pinfo, tree)
 	local subtree = tree:add(nck_sw_feedback, buffer)
 	pinfo.cols.protocol = "NCK SW feedback"
@@ -47,13 +91,65 @@ function nck_sw_feedback.dissector(buffer, pinfo, tree)
 	subtree:add(nck_sw_feedback.fields.order, buffer(1, 1))
 	subtree:add(nck_sw_feedback.fields.packet_no, buffer(2, 2))
 	subtree:add(nck_sw_feedback.fields.feedback_no, buffer(4, 2))
+	subtree:add(nck_sw_feedback.fields.received, buffer(6, 1))
+	subtree:add(nck_sw_feedback.fields.loss_runs, buffer(7, 1))
 	subtree:add(nck_sw_feedback.fields.seqno, buffer(8, 4))
 	subtree:add(nck_sw_feedback.fields.first_missing, buffer(12, 4))
+	subtree:add(nck_sw_feedback.fields.delay, buffer(16, 4))
 
 	local order = buffer(1, 1):uint()
 
-	subtree:add(nck_sw_feedback.fields.missing, buffer(16, (2^order)/8))
+	subtree:add(nck_sw_feedback.fields.missing, buffer(20, (2^order)/8))
+end
+
+function nck_interflow_sw.dissector(buffer, pinfo, tree)
+	local subtree = tree:add(nck_interflow_sw, buffer)
+	local packet_type = buffer(0, 1):uint()
+
+	if packet_type == INTERFLOW_SW_PACKET_TYPE_CODED then
+		pinfo.cols.protocol = "NCK Interflow SW data"
+		dissect_coded(buffer, subtree, true)
+	elseif packet_type == INTERFLOW_SW_PACKET_TYPE_FEEDBACK then
+		-- struct interflow_sw_feedback_packet has no loss_runs and delay
+		pinfo.cols.protocol = "NCK Interflow SW feedback"
+		subtree:add(nck_sw_feedback.fields.packet_type, buffer(0, 1))
+		subtree:add(nck_sw_feedback.fields.order, buffer(1, 1))
+		subtree:add(nck_sw_feedback.fields.packet_no, buffer(2, 2))
+		subtree:add(nck_sw_feedback.fields.feedback_no, buffer(4, 2))
+		subtree:add(nck_sw_feedback.fields.received, buffer(6, 1))
+		subtree:add(nck_sw_feedback.fields.seqno, buffer(8, 4))
+		subtree:add(nck_sw_feedback.fields.first_missing, buffer(12, 4))
+
+		local order = buffer(1, 1):uint()
+
+		subtree:add(nck_sw_feedback.fields.missing, buffer(16, (2^order)/8))
+	elseif packet_type == INTERFLOW_SW_PACKET_TYPE_MIXED then
+		-- struct interflow_sw_mixed_packet, one struct interflow_sw_mixed_entry
+		-- per packet and the mixed payload
+		pinfo.cols.protocol = "NCK Interflow SW mixed"
+		subtree:add(nck_interflow_sw.fields.packet_type, buffer(0, 1))
+		subtree:add(nck_interflow_sw.fields.count, buffer(1, 1))
+		subtree:add(nck_interflow_sw.fields.length, buffer(2, 2))
+
+		local count = buffer(1, 1):uint()
+		local pos = 4
+		for i = 1, count do
+			local entry = subtree:add(nck_interflow_sw, buffer(pos, 10), "Mixed packet " .. i)
+			entry:add(nck_interflow_sw.fields.flow, buffer(pos, 1))
+			entry:add(nck_interflow_sw.fields.coefficient, buffer(pos + 1, 1))
+			entry:add(nck_interflow_sw.fields.entry_length, buffer(pos + 2, 2))
+			entry:add(nck_interflow_sw.fields.packet_no, buffer(pos + 4, 2))
+			entry:add(nck_interflow_sw.fields.hash, buffer(pos + 6, 4))
+			pos = pos + 10
+		end
+
+		if buffer:len() > pos then
+			subtree:add(nck_interflow_sw.fields.payload, buffer(pos, buffer:len() - pos))
+		end
+	end
 end
 
 udp_table = DissectorTable.get("udp.port")
 udp_table:add(7867,nck_sw_data)
+udp_table:add_for_decode_as(nck_sw_feedback)
+udp_table:add_for_decode_as(nck_interflow_sw)
@@ -11,31 +11,28 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <nckernel/metrics.h>
 #include <nckernel/nckernel.h>
+#include <nckernel/pacer.h>
 #include <nckernel/skb.h>
 #include <nckernel/timer.h>
 
 #define MAX_PATHS 32
 
+/* By default every path sends at the rate of one full sized coded packet
+ * per 100us. The pacer counts bytes, so smaller packets are spaced closer. */
+#define DEFAULT_PACKETS_PER_SECOND 10000
+
+/* metrics are copied from the recoder once per second */
+#define DEFAULT_METRICS_INTERVAL_MS 1000
+
 struct path {
 	const char *ip;
 	int fd;
 
-	struct timeval interval;
-	struct nck_timer_entry *timer;
-	int ready;
+	struct nck_pacer pacer;
 };
 
-static void path_ready(struct nck_timer_entry *entry, void *context, int success)
-{
-	(void)entry; // unused parameter
-
-	struct path *path = (struct path *)context;
-	if (success) {
-		path->ready = 1;
-	}
-}
-
 static int send_packet(struct nck_recoder *rec, int writer, size_t coded_size)
 {
 	struct sk_buff packet;
@@ -107,7 +104,8 @@ static int mainloop(struct nck_schedule *schedule, struct nck_recoder *rec, int
 {
 	struct timespec clock;
 	int nfds = 0, r = 0;
-	fd_set rfds, wfds;
+	ssize_t len;
+	fd_set rfds;
 	int keep_running = 1;
 	struct timeval timeout;
 	struct path *path;
@@ -118,9 +116,7 @@ static int mainloop(struct nck_schedule *schedule, struct nck_recoder *rec, int
 	FD_SET(reader, &rfds);
 	nfds = reader + 1;
 
-	FD_ZERO(&wfds);
 	for (path = paths; path->fd != 0; ++path) {
-		FD_SET(path->fd, &wfds);
 		FD_SET(path->fd, &rfds);
 		if (nfds <= path->fd) {
 			nfds = path->fd + 1;
@@ -162,25 +158,18 @@ static int mainloop(struct nck_schedule *schedule, struct nck_recoder *rec, int
 				recv_feedback(rec, path->fd, rec->feedback_size);
 			}
 
-			if (!FD_ISSET(path->fd, &wfds)) {
-				if (path->ready) {
-					FD_SET(path->fd, &wfds);
+			// a path that is not ready schedules a wakeup, so select returns in time
+			if (nck_pacer_has_coded(&path->pacer, rec)) {
+				len = send_packet(rec, path->fd, rec->coded_size);
+				if (len > 0) {
+					nck_pacer_sent(&path->pacer, len);
 				}
-			} else if (nck_has_coded(rec)) {
-				send_packet(rec, path->fd, rec->coded_size);
-				FD_CLR(path->fd, &wfds);
-				path->ready = 0;
-				nck_timer_rearm(path->timer, &path->interval);
 			}
 		}
 
 		if (nck_has_feedback(rec) && addr_len > 0) {
 			send_feedback(rec, reader, &addr, addr_len, rec->feedback_size);
 		}
-
-		if (!nck_has_coded(rec)) {
-			FD_ZERO(&wfds);
-		}
 	}
 
 	return 0;
@@ -289,19 +278,71 @@ static const char *get_env_opt(void *context, const char *option)
 	return getenv(envname);
 }
 
+static uint64_t get_env_u64(const char *option, uint64_t fallback)
+{
+	const char *value = get_env_opt(NULL, option);
+	char *end;
+	unsigned long long result;
+
+	if (value == NULL) {
+		return fallback;
+	}
+
+	errno = 0;
+	result = strtoull(value, &end, 0);
+	if (errno || end == value || *end != '\0') {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, value);
+		return fallback;
+	}
+
+	return result;
+}
+
 static void usage(const char *name)
 {
 	fprintf(stderr, "usage: %s LOCAL_PORT REMOTE_PORT IP...\n", name);
 }
 
+static struct nck_metrics *create_metrics(struct nck_timer *timer, struct nck_recoder *rec)
+{
+	struct nck_metrics *metrics;
+	const char *path, *format;
+	struct timeval interval;
+	uint64_t interval_ms;
+
+	path = get_env_opt(NULL, "metrics_socket");
+	if (path == NULL) {
+		return NULL;
+	}
+
+	interval_ms = get_env_u64("metrics_interval", DEFAULT_METRICS_INTERVAL_MS);
+	interval.tv_sec = interval_ms / 1000;
+	interval.tv_usec = (interval_ms % 1000) * 1000;
+
+	metrics = nck_metrics(timer, &interval);
+	nck_metrics_add(metrics, (struct nck_coder *)rec, "relay");
+
+	format = get_env_opt(NULL, "metrics_format");
+	if (nck_metrics_listen(metrics, path,
+			format && !strcmp(format, "binary") ? NCK_METRICS_BINARY : NCK_METRICS_PROMETHEUS)) {
+		fprintf(stderr, "Could not serve metrics on %s\n", path);
+		nck_metrics_free(metrics);
+		return NULL;
+	}
+
+	return metrics;
+}
+
 int main(int argc, char *argv[])
 {
 	struct nck_recoder rec;
+	struct nck_metrics *metrics;
 	struct nck_schedule schedule;
 	struct nck_timer timer;
 	struct timespec clock;
 	int reader, writer;
 	struct path paths[MAX_PATHS+1];
+	uint64_t rate, burst;
 	int i;
 
 	if (argc < 4) {
@@ -326,6 +367,14 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	rate = get_env_u64("pacer_rate", rec.coded_size * DEFAULT_PACKETS_PER_SECOND);
+	// an empty bucket still lets one packet through, a larger burst would
+	// allow back to back packets after an idle period
+	burst = get_env_u64("pacer_burst", 0);
+
+	// the snapshots are taken by the timer, the socket is served by a thread
+	metrics = create_metrics(&timer, &rec);
+
 	reader = create_recv_socket(argv[1]);
 	if (reader < 0) {
 		fprintf(stderr, "Could not create listening socket\n");
@@ -341,13 +390,15 @@ int main(int argc, char *argv[])
 		paths[i] = (struct path) {
 			.ip = argv[i+3],
 			.fd = writer,
-			.interval = (struct timeval){ .tv_sec = 0, .tv_usec = 100 },
-			.timer = nck_timer_add(&timer, NULL, &paths[i], path_ready),
-			.ready = 1
 		};
+		nck_pacer_init(&paths[i].pacer, &timer, rate, burst);
 	}
 	paths[i].fd = 0;
 
 	mainloop(&schedule, &rec, reader, paths);
+
+	if (metrics) {
+		nck_metrics_free(metrics);
+	}
 }
 
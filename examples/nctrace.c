@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <nckernel/trace.h>
+
+// decodes a binary trace written with NCK_TRACE_FILE or nck_trace_dump
+int main(int argc, char *argv[])
+{
+	FILE *in = stdin;
+	int result;
+
+	if (argc > 2 || (argc == 2 && !strcmp(argv[1], "-h"))) {
+		fprintf(stderr, "Usage: %s [TRACE_FILE]\n", argv[0]);
+		return 1;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "-")) {
+		in = fopen(argv[1], "rb");
+		if (!in) {
+			perror("fopen");
+			return 1;
+		}
+	}
+
+	result = nck_trace_decode(in, stdout);
+
+	if (in != stdin)
+		fclose(in);
+
+	return result ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#ifndef _NCK_AGGREGATE_H_
+#define _NCK_AGGREGATE_H_
+
+#include "api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct nck_aggregate_enc;
+struct nck_aggregate_dec;
+struct nck_timer;
+struct timeval;
+
+/**
+ * nck_aggregate_create_enc - creates a encoder for the aggregate protocol
+ *
+ * @encoder: encoder structure that will be configured
+ * @timer: timer implementation that will be used by the encoder
+ * @context: configuration context (e.g. a file, a dict structure, ...)
+ * @get_opt: a function to extract a configuration value from the context
+ */
+int nck_aggregate_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt);
+/**
+ * nck_aggregate_create_dec - create a decoder for the aggregate protocol
+ *
+ * @decoder: decoder structure that will be configured
+ * @timer: timer implementation that will be used by the encoder
+ * @context: configuration context (e.g. a file, a dict structure, ...)
+ * @get_opt: a function to extract a configuration value from the context
+ */
+int nck_aggregate_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt);
+
+/**
+ * nck_aggregate_enc - create an aggregation encoder
+ *
+ * Source packets are packed into coded packets with a length prefix, so several
+ * small packets share one coded packet and a large packet is split across
+ * several coded packets. A coded packet is sent when no further record fits,
+ * on nck_flush_coded() or when @timeout expired since the first packet was
+ * added to it.
+ *
+ * @source_size: maximum size of a source packet
+ * @coded_size: maximum size of a coded packet, at most 65535
+ * @timer: timer for the @timeout, may be NULL
+ * @timeout: maximum time a source packet waits for more packets, may be NULL
+ */
+struct nck_aggregate_enc *nck_aggregate_enc(size_t source_size, size_t coded_size,
+					    struct nck_timer *timer, const struct timeval *timeout);
+/**
+ * nck_aggregate_dec - create an aggregation decoder
+ *
+ * Recovers the source packets with their exact length. Fragments of a source
+ * packet are dropped if a coded packet in between was lost.
+ *
+ * @source_size: maximum size of a source packet
+ * @coded_size: maximum size of a coded packet, at most 65535
+ */
+struct nck_aggregate_dec *nck_aggregate_dec(size_t source_size, size_t coded_size);
+
+NCK_ENCODER_API(nck_aggregate)
+NCK_DECODER_API(nck_aggregate)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _NCK_AGGREGATE_H_ */
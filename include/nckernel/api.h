@@ -23,6 +23,7 @@ extern "C" {
 	int  prefix ## _enc_full(struct prefix ## _enc *encoder); \
 	int  prefix ## _enc_complete(struct prefix ## _enc *encoder); \
 	void prefix ## _enc_free(struct prefix ## _enc *encoder); \
+	int  prefix ## _enc_reset(struct prefix ## _enc *encoder); \
 	void prefix ## _enc_api(struct nck_encoder *api, struct prefix ## _enc *encoder);
 
 #define NCK_DECODER_API(prefix) \
@@ -35,6 +36,7 @@ extern "C" {
 	int  prefix ## _dec_has_feedback(struct prefix ## _dec *decoder); \
 	int  prefix ## _dec_complete(struct prefix ## _dec *decoder); \
 	void prefix ## _dec_free(struct prefix ## _dec *decoder); \
+	int  prefix ## _dec_reset(struct prefix ## _dec *decoder); \
 	void prefix ## _dec_api(struct nck_decoder *api, struct prefix ## _dec *decoder);
 
 #define NCK_RECODER_API(prefix) \
@@ -51,9 +53,24 @@ extern "C" {
 	int  prefix ## _rec_has_feedback(struct prefix ## _rec *recoder); \
 	int  prefix ## _rec_complete(struct prefix ## _rec *recoder); \
 	void prefix ## _rec_free(struct prefix ## _rec *recoder); \
+	int  prefix ## _rec_reset(struct prefix ## _rec *recoder); \
 	void prefix ## _rec_api(struct nck_recoder *api, struct prefix ## _rec *recoder);
 
 #define NCK_ENCODER_IMPL(prefix, _debug, _describe_packet, _get_stats) \
+	NCK_ENCODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, NULL, NULL)
+
+/*
+ * Encoders that can pass a source packet through by only pushing their header
+ * provide _wrap_source, see nck_wrap_source().
+ */
+#define NCK_ENCODER_IMPL_INPLACE(prefix, _debug, _describe_packet, _get_stats, _wrap_source) \
+	NCK_ENCODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, NULL, _wrap_source)
+
+/*
+ * Encoders that record histograms provide _get_histograms, see
+ * nck_get_histograms().
+ */
+#define NCK_ENCODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, _get_histograms, _wrap_source) \
 	static int _set_option(void *enc, const char *name, const char *value) \
 	{ return prefix ## _enc_set_option((struct prefix ## _enc *)enc, name, value); } \
 	static int _put_source(void *enc, struct sk_buff *packet) \
@@ -72,6 +89,8 @@ extern "C" {
 	{ return prefix ## _enc_complete((struct prefix ## _enc *)enc); } \
 	static void _enc_free(void *enc) \
 	{ prefix ## _enc_free((struct prefix ## _enc *)enc); } \
+	static int _enc_reset(void *enc) \
+	{ return prefix ## _enc_reset((struct prefix ## _enc *)enc); } \
 	\
 	EXPORT void prefix ## _enc_api(struct nck_encoder *api, struct prefix ## _enc *encoder) \
 	{ \
@@ -83,9 +102,12 @@ extern "C" {
 			_full, \
 			_complete, \
 			_enc_free, \
+			_enc_reset, \
 			_debug, \
 			_describe_packet, \
 			_get_stats, \
+			_get_histograms, \
+			_wrap_source, /*_unwrap_coded*/ NULL, \
 		};\
 		api->type = &type; \
 		api->state = encoder; \
@@ -98,6 +120,20 @@ extern "C" {
 	}
 
 #define NCK_DECODER_IMPL(prefix, _debug, _describe_packet, _get_stats) \
+	NCK_DECODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, NULL, NULL)
+
+/*
+ * Decoders that can pass a coded packet through by only pulling their header
+ * provide _unwrap_coded, see nck_unwrap_coded().
+ */
+#define NCK_DECODER_IMPL_INPLACE(prefix, _debug, _describe_packet, _get_stats, _unwrap_coded) \
+	NCK_DECODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, NULL, _unwrap_coded)
+
+/*
+ * Decoders that record histograms provide _get_histograms, see
+ * nck_get_histograms().
+ */
+#define NCK_DECODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, _get_histograms, _unwrap_coded) \
 	static int _set_option(void *dec, const char *name, const char *value) \
 	{ return prefix ## _dec_set_option((struct prefix ## _dec *)dec, name, value); } \
 	static int _put_coded(void *dec, struct sk_buff *packet) \
@@ -116,6 +152,8 @@ extern "C" {
 	{ return prefix ## _dec_complete((struct prefix ## _dec *)dec); } \
 	static void _dec_free(void *dec) \
 	{ prefix ## _dec_free((struct prefix ## _dec *)dec); } \
+	static int _dec_reset(void *dec) \
+	{ return prefix ## _dec_reset((struct prefix ## _dec *)dec); } \
 	\
 	EXPORT void prefix ## _dec_api(struct nck_decoder *api, struct prefix ## _dec *decoder) \
 	{ \
@@ -127,9 +165,12 @@ extern "C" {
 			/*_full*/ NULL, \
 			_complete, \
 			_dec_free, \
+			_dec_reset, \
 			_debug, \
 			_describe_packet, \
 			_get_stats, \
+			_get_histograms, \
+			/*_wrap_source*/ NULL, _unwrap_coded, \
 		};\
 		api->type = &type; \
 		api->state = decoder; \
@@ -143,6 +184,13 @@ extern "C" {
 
 
 #define NCK_RECODER_IMPL(prefix, _debug, _describe_packet, _get_stats) \
+	NCK_RECODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, NULL)
+
+/*
+ * Recoders that record histograms provide _get_histograms, see
+ * nck_get_histograms().
+ */
+#define NCK_RECODER_IMPL_EXT(prefix, _debug, _describe_packet, _get_stats, _get_histograms) \
 	static int _set_option(void *rec, const char *name, const char *value) \
 	{ return prefix ## _rec_set_option((struct prefix ## _rec *)rec, name, value); } \
 	static int _put_coded(void *rec, struct sk_buff *packet) \
@@ -169,6 +217,8 @@ extern "C" {
 	{ return prefix ## _rec_has_coded((struct prefix ## _rec *)rec); } \
 	static void _rec_free(void *rec) \
 	{ prefix ## _rec_free((struct prefix ## _rec *)rec); } \
+	static int _rec_reset(void *rec) \
+	{ return prefix ## _rec_reset((struct prefix ## _rec *)rec); } \
 	\
 	EXPORT void prefix ## _rec_api(struct nck_recoder *api, struct prefix ## _rec *recoder) { \
 		static struct nck_recoder_class type = { \
@@ -179,9 +229,12 @@ extern "C" {
 			/*_full*/ NULL, \
 			_complete, \
 			_rec_free, \
+			_rec_reset, \
 			_debug, \
 			_describe_packet, \
 			_get_stats, \
+			_get_histograms, \
+			/*_wrap_source*/ NULL, /*_unwrap_coded*/ NULL, \
 		};\
 		api->type = &type; \
 		api->state = recoder; \
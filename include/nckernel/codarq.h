@@ -30,9 +30,11 @@ void nck_codarq_set_redundancy(struct nck_codarq_enc *encoder, uint16_t redundan
 
 void nck_codarq_set_dec_fb_timeout(struct nck_codarq_dec *decoder, const struct timeval *dec_fb_timeout);
 void nck_codarq_set_dec_flush_timeout(struct nck_codarq_dec *decoder, const struct timeval *dec_flush_timeout);
+void nck_codarq_set_dec_max_active_containers(struct nck_codarq_dec *decoder, uint32_t max_active_containers);
 
-void nck_codarq_set_enc_max_active_containers(struct nck_codarq_enc *encoder, uint8_t max_active_containers);
+void nck_codarq_set_enc_max_active_containers(struct nck_codarq_enc *encoder, uint32_t max_active_containers);
 void nck_codarq_set_enc_repair_timeout(struct nck_codarq_enc *encoder, const struct timeval *enc_repair_timeout);
+void nck_codarq_set_enc_adaptive_timeout(struct nck_codarq_enc *encoder, int adaptive_timeout);
 
 char *nck_codarq_dec_debug(void *dec);
 
@@ -10,6 +10,7 @@ extern "C" {
 struct nck_interflow_sw_enc;
 struct nck_interflow_sw_dec;
 struct nck_interflow_sw_rec;
+struct nck_interflow_sw_mix;
 struct nck_timer;
 
 /**
@@ -191,6 +192,32 @@ void nck_interflow_sw_rec_set_tx_attempts(struct nck_interflow_sw_rec *recoder,
  * @tx_attempts: maximum number of transmission attemps
  */
 void nck_interflow_sw_dec_set_tx_attempts(struct nck_interflow_sw_dec *decoder, uint8_t tx_attempts);
+/**
+ * Set the minimum time between two automatic feedback packets
+ *
+ * A feedback that is held back is sent once the interval has passed. The
+ * interval is ignored when the decoder has no timer.
+ *
+ * @decoder: decoder structure to configure
+ * @interval: minimum time between feedback packets, zero disables the limit
+ */
+void nck_interflow_sw_dec_set_feedback_interval(struct nck_interflow_sw_dec *decoder, const struct timeval *interval);
+/**
+ * Set the minimum number of received packets between two automatic feedback packets
+ *
+ * @decoder: decoder structure to configure
+ * @packets: minimum number of packets, zero disables the limit
+ */
+void nck_interflow_sw_dec_set_feedback_min_packets(struct nck_interflow_sw_dec *decoder, uint32_t packets);
+/**
+ * Send a feedback immediately when a packet loss was detected
+ *
+ * Losses bypass the feedback limits at most once per feedback interval.
+ *
+ * @decoder: decoder structure to configure
+ * @enable: 1 to report losses immediately, 0 to apply the limits
+ */
+void nck_interflow_sw_dec_set_feedback_on_gap(struct nck_interflow_sw_dec *decoder, int enable);
 /**
  * Set the number of redundant packets.
  *
@@ -211,6 +238,34 @@ void nck_interflow_sw_enc_set_redundancy(struct nck_interflow_sw_enc *encoder, i
  * @redundancy: redundant packets per generation
  */
 void nck_interflow_sw_rec_set_redundancy(struct nck_interflow_sw_rec *recoder, int32_t redundancy);
+/**
+ * Let the redundancy follow the estimated loss rate.
+ *
+ * The encoder compares the packets it sent with the reception counter in the
+ * decoder's feedback and sets the redundancy such that the expected losses of
+ * a window plus one standard deviation are covered. The packet numbers of
+ * interflow_sw are not consecutive, so the decoder cannot report loss bursts
+ * and the losses are assumed to be independent. The encoder never uses less
+ * than 0 redundancy. Must be set before the first source symbol is added.
+ *
+ * @encoder: encoder structure to configure
+ * @min_redundancy: lowest number of redundant packets per generation
+ * @max_redundancy: highest number of redundant packets per generation
+ */
+void nck_interflow_sw_enc_set_adaptive_redundancy(struct nck_interflow_sw_enc *encoder, int32_t min_redundancy, int32_t max_redundancy);
+/**
+ * Let the redundancy follow the estimated loss rate.
+ *
+ * The recoder compares the packets it sent with the reception counter in the
+ * feedback of the next decoder and sets the redundancy such that the expected
+ * losses of a window plus one standard deviation on its outgoing link are
+ * covered.
+ *
+ * @recoder: recoder structure to configure
+ * @min_redundancy: lowest number of redundant packets per generation
+ * @max_redundancy: highest number of redundant packets per generation
+ */
+void nck_interflow_sw_rec_set_adaptive_redundancy(struct nck_interflow_sw_rec *recoder, int32_t min_redundancy, int32_t max_redundancy);
 /**
  * Set the feedback timeout
  *
@@ -249,6 +304,190 @@ void nck_interflow_sw_enc_set_node_id(struct nck_interflow_sw_enc *encoder, uint
 
  */
 void nck_interflow_sw_enc_set_n_nodes(struct nck_interflow_sw_enc *encoder, uint32_t n_nodes);
+/**
+ * Enable incremental repair symbols
+ *
+ * The encoder keeps the given number of repair symbols that are updated whenever a
+ * source symbol enters or leaves the coding window. A repair packet then only copies
+ * one of these symbols instead of combining the whole window. A running repair symbol
+ * is only sent while it carries a source symbol that the previous repair packets did
+ * not cover, other repair packets are combined by kodo as before. Must be set before
+ * the first source symbol is added.
+ *
+ * @encoder: encoder structure to configure
+ * @accumulators: number of running repair symbols, 0 to disable
+ */
+void nck_interflow_sw_enc_set_incremental_repair(struct nck_interflow_sw_enc *encoder, uint32_t accumulators);
+/**
+ * Send repair packets with a seed header
+ *
+ * Instead of one coefficient per window slot, repair packets carry a 32-bit seed
+ * and the range of window slots they combine. Decoders and recoders regenerate
+ * the coefficients from the seed. The range must not contain disabled slots,
+ * otherwise the repair packet falls back to the full coefficient vector. The
+ * incremental repair symbols are only used for these fallbacks, because their
+ * coefficients can not be derived from a seed.
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 to send seed headers, 0 to send the full coefficient vector
+ */
+void nck_interflow_sw_enc_set_seed_header(struct nck_interflow_sw_enc *encoder, int enable);
+/**
+ * Record histograms of the encoder
+ *
+ * The encode delay is only recorded if the encoder has a timer. The feedback
+ * round trip time is not recorded, because the feedback echoes the interleaved
+ * packet numbers of all nodes and can not be mapped to the send times of this
+ * encoder. The histograms are returned by nck_get_histograms().
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_interflow_sw_enc_set_histograms(struct nck_interflow_sw_enc *encoder, int enable);
+/**
+ * Record histograms of the decoder
+ *
+ * The decode delay is only recorded if the decoder has a timer. The histograms
+ * are returned by nck_get_histograms().
+ *
+ * @decoder: decoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_interflow_sw_dec_set_histograms(struct nck_interflow_sw_dec *decoder, int enable);
+/**
+ * Record histograms of the recoder
+ *
+ * The histograms are returned by nck_get_histograms().
+ *
+ * @recoder: recoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_interflow_sw_rec_set_histograms(struct nck_interflow_sw_rec *recoder, int enable);
+/**
+ * Remember the sent packets for the extraction of mixed packets
+ *
+ * A node that sends one flow and receives another one through a mixing relay
+ * shares a mixer between its encoder and its decoder. The encoder remembers
+ * every coded packet it sends, so that the decoder can remove them from
+ * mixed packets. The node id of the encoder selects the flow.
+ *
+ * @encoder: encoder structure to configure
+ * @mix: mixer shared with the decoder, NULL to disable
+ */
+void nck_interflow_sw_enc_set_mix(struct nck_interflow_sw_enc *encoder, struct nck_interflow_sw_mix *mix);
+/**
+ * Extract the own flow from mixed packets
+ *
+ * Mixed packets that are given to the decoder are reduced to the single
+ * packet that is not yet known to the mixer, other mixed packets are rejected.
+ *
+ * @decoder: decoder structure to configure
+ * @mix: mixer shared with the encoder, NULL to reject all mixed packets
+ */
+void nck_interflow_sw_dec_set_mix(struct nck_interflow_sw_dec *decoder, struct nck_interflow_sw_mix *mix);
+
+/**
+ * nck_interflow_sw_mix - create a mixer for inter-flow coding
+ *
+ * A relay that forwards several flows over a shared hop puts the coded
+ * packets of all flows into one mixer. The mixer keeps a sub-window of the
+ * last packets per flow and combines the oldest unsent packet of every flow
+ * into one mixed packet with a small header that lists the flow, the
+ * coefficient, the packet_no and a 32 bit hash of each packet. Each
+ * receiver that knows all but one of the packets, because it sent or
+ * overheard them, can solve for the remaining packet with nck_interflow_sw_mix_extract().
+ *
+ * Packets are assigned to flows by the node id in their header.
+ *
+ * @flows: number of flows, node ids must be smaller than this
+ * @window: number of packets remembered per flow
+ * @packet_size: maximum size of a coded packet
+ * @timer: timer used to limit how long a packet waits for packets of other flows
+ * @timeout: maximum waiting time, zero to wait until the sub-window is half full
+ */
+struct nck_interflow_sw_mix *nck_interflow_sw_mix(uint32_t flows, uint32_t window, size_t packet_size,
+						  struct nck_timer *timer, const struct timeval *timeout);
+/**
+ * nck_interflow_sw_mix_free - free a mixer
+ *
+ * @mix: mixer to free
+ */
+void nck_interflow_sw_mix_free(struct nck_interflow_sw_mix *mix);
+/**
+ * nck_interflow_sw_mix_put_coded - queue a coded packet for mixing
+ *
+ * @mix: mixer that will be used
+ * @packet: coded packet of one of the flows
+ *
+ * Return: 0 on success, -1 if the packet is not a coded packet of a known flow
+ */
+int nck_interflow_sw_mix_put_coded(struct nck_interflow_sw_mix *mix, struct sk_buff *packet);
+/**
+ * nck_interflow_sw_mix_has_coded - check whether a mixed packet should be sent
+ *
+ * Packets wait until every flow has a packet queued, until the timeout
+ * expires or until a sub-window is half full.
+ *
+ * @mix: mixer to check
+ */
+int nck_interflow_sw_mix_has_coded(struct nck_interflow_sw_mix *mix);
+/**
+ * nck_interflow_sw_mix_get_coded - mix the oldest queued packet of each flow
+ *
+ * When only one flow has a packet queued, the packet is sent unchanged.
+ *
+ * @mix: mixer that will be used
+ * @packet: buffer for the packet, must hold nck_interflow_sw_mix_coded_size() bytes
+ *
+ * Return: 0 on success, -1 if no packet is queued
+ */
+int nck_interflow_sw_mix_get_coded(struct nck_interflow_sw_mix *mix, struct sk_buff *packet);
+/**
+ * nck_interflow_sw_mix_flush_coded - send the queued packets without waiting
+ *
+ * @mix: mixer to flush
+ */
+void nck_interflow_sw_mix_flush_coded(struct nck_interflow_sw_mix *mix);
+/**
+ * nck_interflow_sw_mix_remember - remember a packet that is known to this node
+ *
+ * @mix: mixer that will be used
+ * @packet: coded packet that was sent or overheard, it is not modified
+ *
+ * Return: 0 on success, -1 if the packet is not a coded packet of a known flow
+ */
+int nck_interflow_sw_mix_remember(struct nck_interflow_sw_mix *mix, struct sk_buff *packet);
+/**
+ * nck_interflow_sw_mix_extract - solve a mixed packet for the unknown packet
+ *
+ * All remembered packets are removed from the mixed packet. If exactly one
+ * packet remains, the buffer is replaced by it and it is remembered as well.
+ * A mixed packet is rejected if one of its entries matches remembered
+ * packets with different contents, or if the extracted packet does not
+ * match the hash of its entry.
+ *
+ * @mix: mixer that will be used
+ * @packet: mixed packet, contains the extracted coded packet on success
+ *
+ * Return: 0 on success, -1 if the packet is invalid or can not be solved,
+ *  the buffer is unusable in this case
+ */
+int nck_interflow_sw_mix_extract(struct nck_interflow_sw_mix *mix, struct sk_buff *packet);
+/**
+ * nck_interflow_sw_mix_set_on_coded_ready - register a callback for mixed packets
+ *
+ * @mix: mixer that will be used
+ * @context: context passed to @callback
+ * @callback: called when nck_interflow_sw_mix_has_coded() becomes true
+ */
+void nck_interflow_sw_mix_set_on_coded_ready(struct nck_interflow_sw_mix *mix, void *context,
+					     void (*callback)(void *context));
+/**
+ * nck_interflow_sw_mix_coded_size - maximum size of a mixed packet
+ *
+ * @mix: mixer to query
+ */
+size_t nck_interflow_sw_mix_coded_size(struct nck_interflow_sw_mix *mix);
 
 NCK_ENCODER_API(nck_interflow_sw)
 NCK_DECODER_API(nck_interflow_sw)
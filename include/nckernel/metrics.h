@@ -0,0 +1,173 @@
+#ifndef _NCK_METRICS_H_
+#define _NCK_METRICS_H_
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#endif
+
+#include <sys/time.h>
+
+#include "nckernel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* output formats of nck_metrics_listen() */
+#define NCK_METRICS_PROMETHEUS 0
+#define NCK_METRICS_BINARY     1
+
+#define NCK_METRICS_NAME_SIZE 32
+
+/* flags of struct nck_metrics_record */
+#define NCK_METRICS_HAS_STATS      0x1
+#define NCK_METRICS_HAS_HISTOGRAMS 0x2
+
+#define NCK_METRICS_MAGIC "NCKM"
+#define NCK_METRICS_VERSION 1
+
+struct nck_metrics;
+
+/**
+ * struct nck_metrics_summary - Summary of a histogram in the binary format.
+ * @count: Number of recorded values.
+ * @sum: Sum of the recorded values.
+ * @max: Largest recorded value.
+ * @p50: Median of the recorded values.
+ * @p90: 90th percentile of the recorded values.
+ * @p99: 99th percentile of the recorded values.
+ */
+struct nck_metrics_summary {
+	uint64_t count;
+	uint64_t sum;
+	uint32_t max;
+	uint32_t p50;
+	uint32_t p90;
+	uint32_t p99;
+};
+
+/**
+ * struct nck_metrics_header - Start of a snapshot in the binary format.
+ * @magic: NCK_METRICS_MAGIC without the terminating zero.
+ * @version: NCK_METRICS_VERSION.
+ * @records: Number of struct nck_metrics_record that follow.
+ * @record_size: Size of a single record.
+ * @time: Wall clock time of the snapshot in microseconds.
+ *
+ * All fields use the byte order of the host that serves the metrics.
+ */
+struct nck_metrics_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t records;
+	uint32_t record_size;
+	uint64_t time;
+};
+
+/**
+ * struct nck_metrics_record - Snapshot of a single coder in the binary format.
+ * @name: Name given to nck_metrics_add(), zero terminated.
+ * @flags: NCK_METRICS_HAS_STATS and NCK_METRICS_HAS_HISTOGRAMS.
+ * @reserved: Always 0.
+ * @stats: Counters of nck_get_stats(), indexed by enum nck_stat_type.
+ * @histograms: Summaries of nck_get_histograms(), indexed by enum
+ *              nck_histogram_type.
+ */
+struct nck_metrics_record {
+	char name[NCK_METRICS_NAME_SIZE];
+	uint32_t flags;
+	uint32_t reserved;
+	uint64_t stats[NCK_STATS_MAX];
+	struct nck_metrics_summary histograms[NCK_HISTOGRAM_MAX];
+};
+
+/**
+ * nck_metrics() - Create a metrics exporter.
+ * @timer: Timer that triggers the snapshots, may be NULL.
+ * @interval: Time between two snapshots, NULL or zero if the application
+ *            calls nck_metrics_snapshot() itself.
+ *
+ * The exporter copies the counters and histograms of its coders into a
+ * snapshot on the thread that runs the timer. Formatting and serving the
+ * snapshot happens on a separate thread started by nck_metrics_listen(), so
+ * the coders are never read outside of the data thread.
+ *
+ * Returns: The new exporter; NULL on failure.
+ */
+struct nck_metrics *nck_metrics(struct nck_timer *timer, const struct timeval *interval);
+
+/**
+ * nck_metrics_free() - Stop serving and free the exporter.
+ * @metrics: Exporter to free.
+ */
+void nck_metrics_free(struct nck_metrics *metrics);
+
+/**
+ * nck_metrics_add() - Export the metrics of a coder.
+ * @metrics: Exporter.
+ * @coder: Encoder, decoder or recoder to export.
+ * @name: Name of the coder in the output, truncated to
+ *        NCK_METRICS_NAME_SIZE - 1 characters.
+ *
+ * Counters are only exported if the coder provides nck_get_stats() and
+ * histograms if the coder was created with histograms enabled.
+ *
+ * Returns: 0 on success; -1 on failure.
+ */
+int nck_metrics_add(struct nck_metrics *metrics, struct nck_coder *coder, const char *name);
+
+/**
+ * nck_metrics_del() - Stop exporting a coder.
+ * @metrics: Exporter.
+ * @coder: Coder that was given to nck_metrics_add().
+ *
+ * Must be called before the coder is freed. The coder stays in the current
+ * snapshot until the next one is taken.
+ */
+void nck_metrics_del(struct nck_metrics *metrics, struct nck_coder *coder);
+
+/**
+ * nck_metrics_snapshot() - Copy the current metrics of all coders.
+ * @metrics: Exporter.
+ *
+ * Called by the timer of the exporter, but may also be called by the
+ * application on the thread that uses the coders.
+ */
+void nck_metrics_snapshot(struct nck_metrics *metrics);
+
+/**
+ * nck_metrics_listen() - Serve the snapshots on a UNIX domain socket.
+ * @metrics: Exporter.
+ * @path: Path of the socket, an existing socket file is replaced.
+ * @format: NCK_METRICS_PROMETHEUS or NCK_METRICS_BINARY.
+ *
+ * Every client that connects receives the latest snapshot and the connection
+ * is closed. The Prometheus text format can be read for example with
+ * ``socat - UNIX-CONNECT:path``. The binary format is a struct
+ * nck_metrics_header followed by one struct nck_metrics_record per coder.
+ *
+ * Returns: 0 on success; -1 on failure.
+ */
+int nck_metrics_listen(struct nck_metrics *metrics, const char *path, int format);
+
+/**
+ * nck_metrics_write() - Write the latest snapshot to a file.
+ * @metrics: Exporter.
+ * @out: File that receives the snapshot.
+ * @format: NCK_METRICS_PROMETHEUS or NCK_METRICS_BINARY.
+ *
+ * Returns: 0 on success; -1 on a write error.
+ */
+int nck_metrics_write(struct nck_metrics *metrics, FILE *out, int format);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _NCK_METRICS_H_ */
@@ -33,6 +33,7 @@ struct nck_recoder;
 struct nck_trigger;
 struct sk_buff;
 struct nck_timer;
+struct nck_config;
 
 typedef const char *(*nck_opt_getter)(void *context, const char *option);
 
@@ -60,6 +61,7 @@ enum nck_stat_type {
 	NCK_STATS_TIMER_FLUSH,
 	NCK_STATS_TIMER_FB_FLUSH,
 	NCK_STATS_UNDECODED_SYMBOLS,
+	NCK_STATS_GET_CODED_SKIPPED_NOT_INNOVATIVE,
 	NCK_STATS_MAX
 };
 
@@ -84,6 +86,7 @@ static __inline__ const char *nck_stat_string(enum nck_stat_type nck_stat_type)
 	case NCK_STATS_TIMER_FLUSH: return "TIMER_FLUSH";
 	case NCK_STATS_TIMER_FB_FLUSH: return "TIMER_FB_FLUSH";
 	case NCK_STATS_UNDECODED_SYMBOLS: return "UNDECODED_SYMBOLS";
+	case NCK_STATS_GET_CODED_SKIPPED_NOT_INNOVATIVE: return "GET_CODED_SKIPPED_NOT_INNOVATIVE";
 	case NCK_STATS_MAX: break;
 	}
 
@@ -94,6 +97,139 @@ struct nck_stats {
 	uint64_t s[NCK_STATS_MAX];
 };
 
+/**
+ * enum nck_histogram_type - Distributions recorded by a coder with histograms enabled.
+ * @NCK_HISTOGRAM_ENCODE_DELAY: Microseconds from nck_put_source() until the
+ *  symbol is first sent by nck_get_coded().
+ * @NCK_HISTOGRAM_DECODE_DELAY: Microseconds from the first nck_put_coded() that
+ *  carried a symbol until it is returned by nck_get_source().
+ * @NCK_HISTOGRAM_WINDOW: Number of symbols in the coding window, sampled for
+ *  every coded packet.
+ * @NCK_HISTOGRAM_FLUSH_DEFICIT: Number of symbols that were skipped undecoded
+ *  by a flush of the decoder.
+ * @NCK_HISTOGRAM_FEEDBACK_RTT: Microseconds from sending a coded packet until
+ *  the feedback for it arrived.
+ */
+enum nck_histogram_type {
+	NCK_HISTOGRAM_ENCODE_DELAY,
+	NCK_HISTOGRAM_DECODE_DELAY,
+	NCK_HISTOGRAM_WINDOW,
+	NCK_HISTOGRAM_FLUSH_DEFICIT,
+	NCK_HISTOGRAM_FEEDBACK_RTT,
+	NCK_HISTOGRAM_MAX
+};
+
+static __inline__ const char *nck_histogram_string(enum nck_histogram_type nck_histogram_type)
+{
+	switch (nck_histogram_type) {
+	case NCK_HISTOGRAM_ENCODE_DELAY: return "ENCODE_DELAY";
+	case NCK_HISTOGRAM_DECODE_DELAY: return "DECODE_DELAY";
+	case NCK_HISTOGRAM_WINDOW: return "WINDOW";
+	case NCK_HISTOGRAM_FLUSH_DEFICIT: return "FLUSH_DEFICIT";
+	case NCK_HISTOGRAM_FEEDBACK_RTT: return "FEEDBACK_RTT";
+	case NCK_HISTOGRAM_MAX: break;
+	}
+
+	return "unknown";
+}
+
+/* every power of two is split into 2^NCK_HISTOGRAM_SUB_BITS buckets */
+#define NCK_HISTOGRAM_SUB_BITS 3
+#define NCK_HISTOGRAM_BUCKETS ((32 - NCK_HISTOGRAM_SUB_BITS + 1) << NCK_HISTOGRAM_SUB_BITS)
+
+/**
+ * struct nck_histogram - Log-linear histogram of 32 bit values
+ * @count: Number of recorded values.
+ * @sum: Sum of all recorded values.
+ * @max: Largest recorded value.
+ * @buckets: Number of values per bucket, see nck_histogram_bucket_min().
+ *
+ * Values below 2^NCK_HISTOGRAM_SUB_BITS have a bucket of their own, larger
+ * values are recorded with a relative error of at most 2^-NCK_HISTOGRAM_SUB_BITS.
+ */
+struct nck_histogram {
+	uint64_t count;
+	uint64_t sum;
+	uint32_t max;
+	uint32_t buckets[NCK_HISTOGRAM_BUCKETS];
+};
+
+struct nck_histograms {
+	struct nck_histogram h[NCK_HISTOGRAM_MAX];
+};
+
+/**
+ * nck_histogram_bucket - Index of the bucket that counts a value.
+ * @value: Value to look up.
+ */
+static __inline__ unsigned int nck_histogram_bucket(uint32_t value)
+{
+	unsigned int shift;
+
+	if (value < (1U << NCK_HISTOGRAM_SUB_BITS))
+		return value;
+
+	shift = 31 - __builtin_clz(value) - NCK_HISTOGRAM_SUB_BITS;
+	return ((shift + 1) << NCK_HISTOGRAM_SUB_BITS) +
+		((value >> shift) & ((1U << NCK_HISTOGRAM_SUB_BITS) - 1));
+}
+
+/**
+ * nck_histogram_bucket_min - Smallest value counted by a bucket.
+ * @bucket: Index of the bucket.
+ */
+static __inline__ uint32_t nck_histogram_bucket_min(unsigned int bucket)
+{
+	unsigned int shift;
+
+	if (bucket < (1U << NCK_HISTOGRAM_SUB_BITS))
+		return bucket;
+
+	shift = (bucket >> NCK_HISTOGRAM_SUB_BITS) - 1;
+	return ((1U << NCK_HISTOGRAM_SUB_BITS) | (bucket & ((1U << NCK_HISTOGRAM_SUB_BITS) - 1))) << shift;
+}
+
+/**
+ * nck_histogram_record - Add a value to a histogram.
+ * @histogram: Histogram to update.
+ * @value: Value to record.
+ */
+static __inline__ void nck_histogram_record(struct nck_histogram *histogram, uint32_t value)
+{
+	histogram->count += 1;
+	histogram->sum += value;
+	if (value > histogram->max)
+		histogram->max = value;
+	histogram->buckets[nck_histogram_bucket(value)] += 1;
+}
+
+/**
+ * nck_histogram_record_delay - Add the time between two points in microseconds to a histogram.
+ * @histogram: Histogram to update.
+ * @from: Start of the delay.
+ * @to: End of the delay.
+ */
+static __inline__ void nck_histogram_record_delay(struct nck_histogram *histogram,
+						   const struct timeval *from, const struct timeval *to)
+{
+	int64_t us = ((int64_t)to->tv_sec - from->tv_sec) * 1000000 + (to->tv_usec - from->tv_usec);
+
+	if (us < 0)
+		us = 0;
+	else if (us > UINT32_MAX)
+		us = UINT32_MAX;
+
+	nck_histogram_record(histogram, (uint32_t)us);
+}
+
+/**
+ * nck_histogram_percentile - Estimate a percentile of the recorded values.
+ * @histogram: Histogram to query.
+ * @percentile: Percentile between 0 and 100.
+ * @return: Smallest value of the bucket that contains the percentile, 0 if nothing was recorded.
+ */
+uint32_t nck_histogram_percentile(const struct nck_histogram *histogram, double percentile);
+
 /**
  * nck_option_from_array - Retrieve an option value from an array of struct nck_option_value.
  * @value_array: Pointer to a NULL-terminated array of struct nck_option_value.
@@ -159,12 +295,83 @@ int nck_create_decoder(struct nck_decoder *decoder, struct nck_timer *timer, voi
  */
 int nck_create_recoder(struct nck_recoder *recoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt);
 
+/**
+ * nck_config_compile - Validate a configuration once for many coders.
+ * @protocol: Name of the protocol or NULL to read the "protocol" option
+ * @timer: Timer implementation that is used while validating the configuration
+ * @context: Contextual object that will be passed to get_opt
+ * @get_opt: Function used to get configuration values for the coder
+ * @return: The compiled configuration or NULL if it is invalid
+ *
+ * The protocol is looked up once and test coders are created to validate the
+ * options. Every option they read is copied into a sorted table, so later
+ * coders do not call @get_opt for these options. Options that are only read
+ * on code paths the validation did not take, for example because @timer was
+ * NULL, are still passed through to @get_opt, so @context must stay valid
+ * until nck_config_free() is called.
+ *
+ * Numeric and time options are stored as parsed values, and protocols built
+ * on kodo_rlnc keep one kodo factory for the encoders and one for the decoders
+ * and recoders in the configuration. Coders created from the configuration
+ * share these factories, so they neither parse these options nor build a
+ * factory. Options that the coders pass on to their set_option functions are
+ * still parsed by every coder.
+ *
+ * The configuration is only read after it was compiled, so coders can be
+ * created from it in several threads.
+ */
+struct nck_config *nck_config_compile(const char *protocol, struct nck_timer *timer, void *context, nck_opt_getter get_opt);
+/**
+ * nck_config_free - Free a compiled configuration.
+ * @config: Configuration returned by nck_config_compile
+ *
+ * Coders created from the configuration remain valid.
+ */
+void nck_config_free(struct nck_config *config);
+/**
+ * nck_create_encoder_from_config - Configures an encoder from a compiled configuration.
+ * @encoder: Encoder structure to configure
+ * @timer: Timer implementation that will be used by the coder
+ * @config: Configuration returned by nck_config_compile
+ * @return: Returns 0 on success
+ */
+int nck_create_encoder_from_config(struct nck_encoder *encoder, struct nck_timer *timer, const struct nck_config *config);
+/**
+ * nck_create_decoder_from_config - Configures a decoder from a compiled configuration.
+ * @decoder: Decoder structure to configure
+ * @timer: Timer implementation that will be used by the coder
+ * @config: Configuration returned by nck_config_compile
+ * @return: Returns 0 on success
+ */
+int nck_create_decoder_from_config(struct nck_decoder *decoder, struct nck_timer *timer, const struct nck_config *config);
+/**
+ * nck_create_recoder_from_config - Configures a recoder from a compiled configuration.
+ * @recoder: Recoder structure to configure
+ * @timer: Timer implementation that will be used by the coder
+ * @config: Configuration returned by nck_config_compile
+ * @return: Returns 0 on success
+ */
+int nck_create_recoder_from_config(struct nck_recoder *recoder, struct nck_timer *timer, const struct nck_config *config);
+
 /**
  * nck_free - Free all resources used by a coder.
  * @c: Pointer to the coder structure
  */
 #define nck_free(c) (c)->type->free((c)->state)
 
+/**
+ * nck_reset - Return a coder to the state it had after its creation.
+ * @c: Pointer to the coder structure
+ * @return: Returns 0 on success
+ *
+ * Queued packets are dropped, statistics are cleared and pending timers are
+ * cancelled, but allocated buffers and timer entries are kept. Options that
+ * were set with nck_set_option() stay in effect. Triggers keep their
+ * callbacks, so a reset coder can serve a new flow without calling
+ * nck_free() and nck_create_coder().
+ */
+#define nck_reset(c) (c)->type->reset((c)->state)
+
 /*
  * nck_set_option - Set an option for a coder.
  * @c: Pointer to the coder structure
@@ -307,6 +514,46 @@ int nck_create_recoder(struct nck_recoder *recoder, struct nck_timer *timer, voi
  */
 #define nck_get_stats(c) ((c)->type->get_stats ? (c)->type->get_stats((c)->state) : NULL)
 
+/**
+ * nck_get_histograms - Returns a pointer to the struct nck_histograms if enabled, NULL otherwise
+ *
+ * Coders only record histograms if they were created with the histograms
+ * option. The values are updated in place, so the pointer can be kept and
+ * read at any time from the thread that drives the coder.
+ *
+ * @c: Pointer to the coder structure
+ * @return: Returns the histograms of the coder
+ */
+#define nck_get_histograms(c) ((c)->type->get_histograms ? (c)->type->get_histograms((c)->state) : NULL)
+
+/**
+ * nck_wrap_source - Turn a source packet into a coded packet in place
+ *
+ * Only encoders whose coded packets can be the source packet behind a header
+ * support this. The encoder pushes its header into the headroom of the packet
+ * and accounts for it as if it was added with nck_put_source() and retrieved
+ * with nck_get_coded(). An encoder that would send a different packet next,
+ * e.g. a repair packet, refuses and the packet must be put instead.
+ *
+ * @c: Pointer to the encoder structure
+ * @packet: Source packet with at least coded_size - source_size bytes headroom
+ * @return: Returns 0 if the packet was wrapped, nonzero if nck_put_source() must be used
+ */
+#define nck_wrap_source(c, packet) ((c)->type->wrap_source ? (c)->type->wrap_source((c)->state, (packet)) : -1)
+
+/**
+ * nck_unwrap_coded - Turn a coded packet into a source packet in place
+ *
+ * This is the counterpart to nck_wrap_source() for decoders. The decoder pulls
+ * its header from the packet and accounts for it as if it was added with
+ * nck_put_coded() and retrieved with nck_get_source().
+ *
+ * @c: Pointer to the decoder structure
+ * @packet: Coded packet that is turned into a source packet
+ * @return: Returns 0 if the packet was unwrapped, nonzero if nck_put_coded() must be used
+ */
+#define nck_unwrap_coded(c, packet) ((c)->type->unwrap_coded ? (c)->type->unwrap_coded((c)->state, (packet)) : -1)
+
 /* Trigger functions */
 void nck_trigger_init(struct nck_trigger *trigger);
 void nck_trigger_set(struct nck_trigger *trigger, void *context, void (*callback)(void *context));
@@ -349,9 +596,13 @@ struct nck_trigger {
 	int   (* D##R## full           )(void *coder); \
 	int   (*        complete       )(void *coder); \
 	void  (*        free           )(void *coder); \
+	int   (*        reset          )(void *coder); \
 	char* (*        debug          )(void *coder); \
 	char* (*        describe_packet)(void *coder, struct sk_buff *packet); \
-	struct nck_stats *(*get_stats  )(void *coder);
+	struct nck_stats *(*get_stats  )(void *coder); \
+	struct nck_histograms *(*get_histograms)(void *coder); \
+	int   (* D##R## wrap_source    )(void *coder, struct sk_buff *packet); \
+	int   (* E##R## unwrap_coded   )(void *coder, struct sk_buff *packet);
 
 #define NCK_CODER_MEMBERS(E,D,R) \
 	void *	state; \
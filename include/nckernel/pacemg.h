@@ -60,9 +60,9 @@ void nck_pacemg_set_rec_fb_timeout(struct nck_pacemg_rec *recoder, const struct
 void nck_pacemg_set_rec_flush_timeout(struct nck_pacemg_rec *recoder, const struct timeval *rec_flush_timeout);
 void nck_pacemg_set_rec_redundancy_timeout(struct nck_pacemg_rec *recoder, const struct timeval *rec_redundancy_timeout);
 
-void nck_pacemg_set_rec_max_active_containers(struct nck_pacemg_rec *recoder, uint16_t max_active_containers);
-void nck_pacemg_set_dec_max_active_containers(struct nck_pacemg_dec *decoder, uint16_t max_active_containers);
-void nck_pacemg_set_rec_max_containers(struct nck_pacemg_rec *recoder, uint16_t max_containers);
+void nck_pacemg_set_rec_max_active_containers(struct nck_pacemg_rec *recoder, uint32_t max_active_containers);
+void nck_pacemg_set_dec_max_active_containers(struct nck_pacemg_dec *decoder, uint32_t max_active_containers);
+void nck_pacemg_set_rec_max_containers(struct nck_pacemg_rec *recoder, uint32_t max_containers);
 
 
 char *nck_pacemg_dec_debug(void *dec);
@@ -0,0 +1,117 @@
+#ifndef _NCK_PACER_H_
+#define _NCK_PACER_H_
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#include <sys/time.h>
+
+#include "nckernel.h"
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * struct nck_pacer - Token bucket that spaces out outgoing packets.
+ * @timer: Timer used as clock and to schedule the wakeup.
+ * @wakeup: Timer entry that fires when the bucket is no longer empty.
+ * @on_ready: Trigger that is called when sending is possible again.
+ * @rate: Long term sending rate in bytes per second, 0 disables pacing.
+ * @burst: Size of the bucket in bytes.
+ * @tokens: Number of bytes that can be sent, negative after a packet
+ *          larger than the remaining tokens was sent.
+ * @last: Time when @tokens was last updated.
+ *
+ * The pacer sits between a coder and the send path. Before sending a packet
+ * the application checks nck_pacer_ready() and afterwards reports the size of
+ * the packet with nck_pacer_sent(). A packet may be sent whenever the bucket
+ * is not in debt, so even a @burst smaller than a packet lets the packets
+ * through at @rate.
+ */
+struct nck_pacer {
+	struct nck_timer *timer;
+	struct nck_timer_entry *wakeup;
+	struct nck_trigger on_ready;
+
+	uint64_t rate;
+	uint32_t burst;
+	double tokens;
+	struct timeval last;
+};
+
+/**
+ * nck_pacer_init() - Initialize a pacer with a full bucket.
+ * @pacer: Pacer to initialize.
+ * @timer: Timer that provides the clock and schedules wakeups.
+ * @rate: Sending rate in bytes per second, 0 disables pacing.
+ * @burst: Size of the bucket in bytes.
+ */
+void nck_pacer_init(struct nck_pacer *pacer, struct nck_timer *timer, uint64_t rate, uint32_t burst);
+
+/**
+ * nck_pacer_set_rate() - Change the rate of a pacer.
+ * @pacer: Pacer to change.
+ * @rate: New sending rate in bytes per second, 0 disables pacing.
+ * @burst: New size of the bucket in bytes.
+ *
+ * The tokens collected so far are kept, so this can be called for every new
+ * estimate of the available rate.
+ */
+void nck_pacer_set_rate(struct nck_pacer *pacer, uint64_t rate, uint32_t burst);
+
+/**
+ * nck_pacer_ready() - Check if a packet may be sent now.
+ * @pacer: Pacer to check.
+ *
+ * If the bucket is in debt a wakeup is scheduled and the on_ready trigger is
+ * called as soon as the next packet can be sent.
+ *
+ * Returns: 1 if a packet may be sent; 0 otherwise.
+ */
+int nck_pacer_ready(struct nck_pacer *pacer);
+
+/**
+ * nck_pacer_sent() - Account for a packet that was sent.
+ * @pacer: Pacer that released the packet.
+ * @len: Size of the packet in bytes.
+ */
+void nck_pacer_sent(struct nck_pacer *pacer, size_t len);
+
+/**
+ * nck_pacer_free() - Free the resources used by the pacer.
+ * @pacer: Pacer to free.
+ */
+void nck_pacer_free(struct nck_pacer *pacer);
+
+/**
+ * nck_pacer_on_ready - Register a function that will be called when the pacer allows sending again.
+ * @pacer: Pointer to the pacer.
+ * @context: Pointer that is passed to the callback.
+ * @callback: Callback function.
+ */
+#define nck_pacer_on_ready(pacer, context, callback)\
+	nck_trigger_set(&(pacer)->on_ready, context, callback)
+
+/**
+ * nck_pacer_has_coded - Check if a coder has a coded packet that may be sent now.
+ * @pacer: Pointer to the pacer.
+ * @c: Pointer to the coder structure.
+ *
+ * The pacer is only asked when the coder has something to send, so no wakeup
+ * is scheduled for an idle coder.
+ */
+#define nck_pacer_has_coded(pacer, c)\
+	(nck_has_coded(c) && nck_pacer_ready(pacer))
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _NCK_PACER_H_ */
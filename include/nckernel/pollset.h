@@ -0,0 +1,130 @@
+#ifndef _NCK_POLLSET_H_
+#define _NCK_POLLSET_H_
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#include "nckernel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NCK_POLL_SOURCE   0x1
+#define NCK_POLL_CODED    0x2
+#define NCK_POLL_FEEDBACK 0x4
+
+struct nck_pollset;
+
+/**
+ * struct nck_poll_handle - Registration of a single coder in a pollset.
+ * @set: Pollset the coder is registered with.
+ * @context: Pointer that is reported with the events of the coder.
+ * @events: Events the coder was registered for.
+ * @ready: Events that happened since the coder was last drained.
+ * @next: Next coder in the ready list of the pollset.
+ * @pprev: Link that points to this handle, NULL if it is not in the ready list.
+ *
+ * The handle is owned by the application, usually next to the coder, so
+ * registering a coder does not allocate any memory.
+ */
+struct nck_poll_handle {
+	struct nck_pollset *set;
+	void *context;
+	uint32_t events;
+	uint32_t ready;
+	struct nck_poll_handle *next;
+	struct nck_poll_handle **pprev;
+};
+
+/**
+ * struct nck_pollset - Collects the readiness of many coders.
+ * @head: First coder that became ready.
+ * @tail: Link where the next ready coder is appended.
+ * @count: Number of coders in the ready list.
+ *
+ * A coder that is registered with a pollset does not call back into the
+ * application. Its triggers only mark the coder as ready and append it once
+ * to the ready list, no matter how often they fire. The application then
+ * processes all ready coders in one pass with nck_pollset_drain(). Events
+ * that happen while the application processes a coder are reported by the
+ * next drain, so the processing never recurses.
+ */
+struct nck_pollset {
+	struct nck_poll_handle *head;
+	struct nck_poll_handle **tail;
+	size_t count;
+};
+
+/**
+ * struct nck_poll_event - Readiness of a coder reported by nck_pollset_drain().
+ * @context: Pointer that was given to nck_pollset_add().
+ * @events: Bitmask of NCK_POLL_* events that happened.
+ */
+struct nck_poll_event {
+	void *context;
+	uint32_t events;
+};
+
+/**
+ * nck_pollset_init() - Initialize an empty pollset.
+ * @set: Pollset to initialize.
+ */
+void nck_pollset_init(struct nck_pollset *set);
+
+/**
+ * nck_pollset_add() - Register a coder with a pollset.
+ * @set: Pollset that will collect the events.
+ * @handle: Handle for the registration, must stay valid until nck_pollset_del().
+ * @coder: Encoder, decoder or recoder to register.
+ * @events: Bitmask of NCK_POLL_* events the application is interested in.
+ * @context: Pointer that is reported with the events of the coder.
+ *
+ * This replaces the callbacks of the requested events that were set with
+ * nck_on_source_ready(), nck_on_coded_ready() and nck_on_feedback_ready().
+ * Events that the coder type does not provide are ignored.
+ *
+ * Returns: 0 on success; -1 if the coder provides none of the events.
+ */
+int nck_pollset_add(struct nck_pollset *set, struct nck_poll_handle *handle,
+		    struct nck_coder *coder, uint32_t events, void *context);
+
+/**
+ * nck_pollset_del() - Remove a coder from its pollset.
+ * @handle: Handle given to nck_pollset_add().
+ * @coder: Coder that was registered with the handle.
+ *
+ * Events of the coder that were not drained yet are dropped and the triggers
+ * of the coder are cleared.
+ */
+void nck_pollset_del(struct nck_poll_handle *handle, struct nck_coder *coder);
+
+/**
+ * nck_pollset_drain() - Retrieve the coders that became ready.
+ * @set: Pollset to drain.
+ * @events: Array that receives the events, one entry per coder.
+ * @max_events: Size of @events.
+ *
+ * The coders are reported in the order in which they became ready. Coders
+ * that do not fit into @events stay in the ready list for the next call.
+ *
+ * Returns: Number of entries stored in @events.
+ */
+size_t nck_pollset_drain(struct nck_pollset *set, struct nck_poll_event *events, size_t max_events);
+
+/**
+ * nck_pollset_pending - Number of coders that wait to be drained.
+ * @set: Pointer to the pollset.
+ */
+#define nck_pollset_pending(set) ((set)->count)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _NCK_POLLSET_H_ */
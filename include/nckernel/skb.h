@@ -20,6 +20,9 @@
 extern "C" {
 #endif
 
+/* Maximum number of bytes skb_put_varint() writes for a 32 bit value. */
+#define SKB_VARINT_MAX 5
+
 /**
  * struct sk_buff - Socket Buffer
  * @len: Length of the payload in the buffer.
@@ -161,6 +164,31 @@ uint8_t skb_pull_u8(struct sk_buff *skb);
 uint16_t skb_pull_u16(struct sk_buff *skb);
 uint32_t skb_pull_u32(struct sk_buff *skb);
 
+/**
+ * skb_put_varint() - Append a variable length integer to the payload.
+ * @skb: Socket buffer to modify.
+ * @value: Value to append.
+ *
+ * The value is written in LEB128 form, 7 bits per byte with the most significant
+ * bit set on all but the last byte, so values below 128 need a single byte and
+ * any 32 bit value at most SKB_VARINT_MAX bytes.
+ */
+void skb_put_varint(struct sk_buff *skb, uint32_t value);
+/**
+ * skb_pull_varint() - Remove a variable length integer from the payload.
+ * @skb: Socket buffer to read from.
+ * @value: Location to store the decoded value.
+ *
+ * Returns: 0 on success, -1 if the payload ends before the integer or the integer
+ * does not fit into 32 bits. The socket buffer is not modified on failure.
+ */
+int skb_pull_varint(struct sk_buff *skb, uint32_t *value);
+/**
+ * skb_varint_size() - Number of bytes skb_put_varint() writes for a value.
+ * @value: Value to measure.
+ */
+unsigned skb_varint_size(uint32_t value);
+
 /**
  * skb_trim_zeros() - Remove zero bytes from the end of the packet.
  * @skb: Socket buffer to trim.
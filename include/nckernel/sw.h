@@ -191,6 +191,32 @@ void nck_sw_rec_set_tx_attempts(struct nck_sw_rec *recoder, uint8_t tx_attempts)
  * @tx_attempts: maximum number of transmission attemps
  */
 void nck_sw_dec_set_tx_attempts(struct nck_sw_dec *decoder, uint8_t tx_attempts);
+/**
+ * Set the minimum time between two automatic feedback packets
+ *
+ * A feedback that is held back is sent once the interval has passed. The
+ * interval is ignored when the decoder has no timer.
+ *
+ * @decoder: decoder structure to configure
+ * @interval: minimum time between feedback packets, zero disables the limit
+ */
+void nck_sw_dec_set_feedback_interval(struct nck_sw_dec *decoder, const struct timeval *interval);
+/**
+ * Set the minimum number of received packets between two automatic feedback packets
+ *
+ * @decoder: decoder structure to configure
+ * @packets: minimum number of packets, zero disables the limit
+ */
+void nck_sw_dec_set_feedback_min_packets(struct nck_sw_dec *decoder, uint32_t packets);
+/**
+ * Send a feedback immediately when a packet loss was detected
+ *
+ * Losses bypass the feedback limits at most once per feedback interval.
+ *
+ * @decoder: decoder structure to configure
+ * @enable: 1 to report losses immediately, 0 to apply the limits
+ */
+void nck_sw_dec_set_feedback_on_gap(struct nck_sw_dec *decoder, int enable);
 /**
  * Set the number of redundant packets.
  *
@@ -211,6 +237,60 @@ void nck_sw_enc_set_redundancy(struct nck_sw_enc *encoder, int32_t redundancy);
  * @redundancy: redundant packets per generation
  */
 void nck_sw_rec_set_redundancy(struct nck_sw_rec *recoder, int32_t redundancy);
+/**
+ * Let the redundancy follow the estimated loss rate.
+ *
+ * The encoder estimates the erasure rate and the length of loss bursts from the
+ * reception statistics in the decoder's feedback and sets the redundancy such
+ * that the expected losses of a window plus one standard deviation are covered.
+ * The encoder never uses less than 0 redundancy. Must be set before the first
+ * source symbol is added.
+ *
+ * @encoder: encoder structure to configure
+ * @min_redundancy: lowest number of redundant packets per generation
+ * @max_redundancy: highest number of redundant packets per generation
+ */
+void nck_sw_enc_set_adaptive_redundancy(struct nck_sw_enc *encoder, int32_t min_redundancy, int32_t max_redundancy);
+/**
+ * Let the redundancy follow the estimated loss rate.
+ *
+ * The recoder compares the packets it sent with the reception counter in the
+ * feedback of the next decoder and sets the redundancy such that the expected
+ * losses of a window plus one standard deviation on its outgoing link are
+ * covered.
+ *
+ * @recoder: recoder structure to configure
+ * @min_redundancy: lowest number of redundant packets per generation
+ * @max_redundancy: highest number of redundant packets per generation
+ */
+void nck_sw_rec_set_adaptive_redundancy(struct nck_sw_rec *recoder, int32_t min_redundancy, int32_t max_redundancy);
+/**
+ * Let the flush timeout follow the measured round trip time.
+ *
+ * The encoder measures the round trip time from the packet numbers echoed in
+ * the decoder's feedback and uses the smoothed round trip time plus four
+ * times its variation as timeout. The configured timeout is used until the
+ * first measurement.
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 - adaptive timeout; 0 - fixed timeout
+ */
+void nck_sw_enc_set_adaptive_timeout(struct nck_sw_enc *encoder, int enable);
+/**
+ * Limit the packets in flight with a congestion controller.
+ *
+ * The encoder estimates the bottleneck bandwidth and the round trip time from
+ * the packet numbers echoed in the decoder's feedback. It keeps at most about
+ * twice their product in flight and paces the coded packets at the estimated
+ * bandwidth. While the controller holds back packets nck_sw_enc_has_coded()
+ * returns false and on_coded_ready is called once sending is possible again.
+ * Requires a timer and feedback. Must be set before the first source symbol
+ * is added.
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 - enable congestion control; 0 - disable it
+ */
+void nck_sw_enc_set_congestion_control(struct nck_sw_enc *encoder, int enable);
 /**
  * Set the feedback timeout
  *
@@ -231,6 +311,63 @@ void nck_sw_dec_set_fb_timeout(struct nck_sw_dec *decoder, struct timeval *fb_ti
  * @feedback_only_on_repair: flag to set the mode
  */
 void nck_sw_enc_set_feedback_only_on_repair(struct nck_sw_enc *encoder, uint32_t feedback_only_on_repair);
+/**
+ * Enable incremental repair symbols
+ *
+ * The encoder keeps the given number of repair symbols that are updated whenever a
+ * source symbol enters or leaves the coding window. A repair packet then only copies
+ * one of these symbols instead of combining the whole window. A running repair symbol
+ * is only sent while it carries a source symbol that the previous repair packets did
+ * not cover, other repair packets are combined by kodo as before. Must be set before
+ * the first source symbol is added.
+ *
+ * @encoder: encoder structure to configure
+ * @accumulators: number of running repair symbols, 0 to disable
+ */
+void nck_sw_enc_set_incremental_repair(struct nck_sw_enc *encoder, uint32_t accumulators);
+/**
+ * Send repair packets with a seed header
+ *
+ * Instead of one coefficient per window slot, repair packets carry a 32-bit seed
+ * and the range of window slots they combine. Decoders and recoders regenerate
+ * the coefficients from the seed. The range must not contain disabled slots,
+ * otherwise the repair packet falls back to the full coefficient vector. The
+ * incremental repair symbols are only used for these fallbacks, because their
+ * coefficients can not be derived from a seed.
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 to send seed headers, 0 to send the full coefficient vector
+ */
+void nck_sw_enc_set_seed_header(struct nck_sw_enc *encoder, int enable);
+/**
+ * Record histograms of the encoder
+ *
+ * The encode delay and the feedback round trip time are only recorded if the
+ * encoder has a timer. The histograms are returned by nck_get_histograms().
+ *
+ * @encoder: encoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_sw_enc_set_histograms(struct nck_sw_enc *encoder, int enable);
+/**
+ * Record histograms of the decoder
+ *
+ * The decode delay is only recorded if the decoder has a timer. The histograms
+ * are returned by nck_get_histograms().
+ *
+ * @decoder: decoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_sw_dec_set_histograms(struct nck_sw_dec *decoder, int enable);
+/**
+ * Record histograms of the recoder
+ *
+ * The histograms are returned by nck_get_histograms().
+ *
+ * @recoder: recoder structure to configure
+ * @enable: 1 to record histograms, 0 to stop and free them
+ */
+void nck_sw_rec_set_histograms(struct nck_sw_rec *recoder, int enable);
 
 NCK_ENCODER_API(nck_sw)
 NCK_DECODER_API(nck_sw)
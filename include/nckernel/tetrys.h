@@ -31,7 +31,7 @@ int nck_tetrys_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 int nck_tetrys_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt);
 
 struct nck_tetrys_enc *nck_tetrys_enc(size_t symbol_size, int window_size, struct nck_timer *timer, const struct timeval *timeout);
-struct nck_tetrys_dec *nck_tetrys_dec(size_t symbol_size, int window_size);
+struct nck_tetrys_dec *nck_tetrys_dec(size_t symbol_size, int window_size, struct nck_timer *timer);
 
 /**
  * Set the length of the systematic phase.
@@ -52,6 +52,46 @@ void nck_tetrys_enc_set_systematic_phase(struct nck_tetrys_enc *encoder, uint32_
  * @phase_length: number of coded packets to send in a row
  */
 void nck_tetrys_enc_set_coded_phase(struct nck_tetrys_enc *encoder, uint32_t phase_length);
+/**
+ * Let the redundancy follow the estimated loss rate.
+ *
+ * Instead of the systematic and coded phases, the encoder sends repair packets
+ * with a credit that follows the losses of the systematic packets reported in
+ * the decoder's feedback. The redundancy covers the expected losses of a
+ * window plus one standard deviation. Must be set before the first source
+ * symbol is added, the phase lengths are ignored afterwards.
+ *
+ * @encoder: encoder structure to configure
+ * @min_redundancy: lowest number of repair packets per window_size source packets
+ * @max_redundancy: highest number of repair packets per window_size source packets
+ */
+void nck_tetrys_enc_set_adaptive_redundancy(struct nck_tetrys_enc *encoder, int32_t min_redundancy, int32_t max_redundancy);
+/**
+ * Set the minimum time between two feedback packets.
+ *
+ * A feedback that is held back is sent once the interval has passed. The
+ * interval is ignored when the decoder has no timer.
+ *
+ * @decoder: decoder structure to configure
+ * @interval: minimum time between feedback packets, zero disables the limit
+ */
+void nck_tetrys_dec_set_feedback_interval(struct nck_tetrys_dec *decoder, const struct timeval *interval);
+/**
+ * Set the minimum number of received packets between two feedback packets.
+ *
+ * @decoder: decoder structure to configure
+ * @packets: minimum number of packets, zero disables the limit
+ */
+void nck_tetrys_dec_set_feedback_min_packets(struct nck_tetrys_dec *decoder, uint32_t packets);
+/**
+ * Send a feedback immediately when a source packet was skipped.
+ *
+ * Losses bypass the feedback limits at most once per feedback interval.
+ *
+ * @decoder: decoder structure to configure
+ * @enable: 1 to report losses immediately, 0 to apply the limits
+ */
+void nck_tetrys_dec_set_feedback_on_gap(struct nck_tetrys_dec *decoder, int enable);
 
 NCK_ENCODER_API(nck_tetrys)
 NCK_DECODER_API(nck_tetrys)
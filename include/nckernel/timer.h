@@ -31,6 +31,7 @@ struct nck_timer {
     int (*pending)(struct nck_timer_entry *handle);
     void (*rearm)(struct nck_timer_entry *handle, const struct timeval *delay);
     void (*free)(struct nck_timer_entry *handle);
+    void (*gettime)(struct nck_timer *timer, struct timeval *now);
 };
 
 /**
@@ -61,6 +62,17 @@ void nck_timer_rearm(struct nck_timer_entry *handle, const struct timeval *delay
  */
 void nck_timer_free(struct nck_timer_entry *handle);
 
+/**
+ * nck_timer_gettime() - Get the current time of the timer.
+ * @timer: Timer to query.
+ * @now: Updated to contain the current time.
+ *
+ * Protocols should use this instead of the system clock, so they follow the
+ * simulated time of a &struct nck_schedule. Timers without a clock fall back
+ * to gettimeofday().
+ */
+void nck_timer_gettime(struct nck_timer *timer, struct timeval *now);
+
 /**
  * nck_libevent_timer() - Create a timer backed by libevent.
  * @ev: Pointer to the libevent instance.
@@ -1,13 +1,24 @@
 #ifndef _NCK_TRACE_H_
 #define _NCK_TRACE_H_
 
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstdio>
+#else
+#include <stdint.h>
+#include <stdio.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* With this function pointer `nck_trace_print` a program can customize the
- * trace output.  The default implementation writes to stdout and uses the
- * environment variables NCK_TRACE and NCK_TRACE_FUNC.
+/* Every call of nck_trace() is a tracepoint. A tracepoint is checked against
+ * the trace settings only once and the result is cached in the tracepoint, so
+ * a disabled tracepoint costs a load and a compare and its arguments are not
+ * evaluated. The trace settings are read from environment variables when the
+ * first tracepoint fires and can be changed at runtime with
+ * nck_trace_set_mask() and nck_trace_set_filter().
  *
  * NCK_TRACE must be set to a glob pattern to filter the files which write to
  * the trace log. If the variable is not set no output is written. To show all
@@ -15,12 +26,141 @@ extern "C" {
  *
  * NCK_TRACE_FUNC can be used to filter specific function names. It also
  * accepts glob patterns. By default all functions will be traced.
+ *
+ * NCK_TRACE_OUTPUT selects the backends as a comma separated list of "text",
+ * "binary" and "probe". By default only the text backend is used.
+ *
+ * NCK_TRACE_BUFFER sets the number of records in the ring buffer of each
+ * thread for the binary backend.
+ *
+ * NCK_TRACE_FILE names a file that receives the binary trace when the program
+ * exits. It can be decoded with nck_trace_decode(), for example with the
+ * nctrace example program.
  */
 
+/* With this function pointer `nck_trace_print` a program can customize the
+ * output of the text backend. The default implementation writes to stderr.
+ */
 extern void (*nck_trace_print)(void *context, const char *file, int line,
 		const char *func, const char *format, ...)
 	__attribute__ ((format (printf, 5, 6)));
 
+#define NCK_TRACE_TEXT   0x1
+#define NCK_TRACE_BINARY 0x2
+#define NCK_TRACE_PROBE  0x4
+
+struct nck_trace_format;
+
+/**
+ * struct nck_tracepoint - Static description of a single nck_trace() call.
+ * @file: Source file of the call.
+ * @func: Function that contains the call.
+ * @line: Source line of the call.
+ * @state: Settings generation of the last check shifted left by one, the
+ *         lowest bit tells whether the tracepoint is enabled.
+ * @format: Argument layout, parsed when the tracepoint fires the first time.
+ */
+struct nck_tracepoint {
+	const char *file;
+	const char *func;
+	int line;
+	uint32_t state;
+	struct nck_trace_format *format;
+};
+
+/* incremented whenever the trace settings change */
+extern uint32_t nck_trace_generation;
+
+/**
+ * nck_trace_check() - Compare a tracepoint with the current trace settings.
+ * @tp: Tracepoint to check.
+ *
+ * Returns: The new state of the tracepoint.
+ */
+uint32_t nck_trace_check(struct nck_tracepoint *tp);
+
+/**
+ * nck_trace_enabled() - Check whether a tracepoint needs to be recorded.
+ * @tp: Tracepoint to check.
+ */
+static inline int nck_trace_enabled(struct nck_tracepoint *tp)
+{
+	uint32_t state = __atomic_load_n(&tp->state, __ATOMIC_RELAXED);
+
+	if ((state >> 1) != __atomic_load_n(&nck_trace_generation, __ATOMIC_RELAXED))
+		state = nck_trace_check(tp);
+
+	return state & 1;
+}
+
+/**
+ * nck_trace_emit() - Record an enabled tracepoint in all selected backends.
+ * @tp: Tracepoint that fired.
+ * @context: Pointer that identifies the coder that writes the trace.
+ * @format: printf format of the message, followed by the arguments.
+ *
+ * The binary backend stores the raw arguments in the ring buffer of the
+ * calling thread. Strings are copied up to the precision of their conversion
+ * and truncated if they do not fit into a record. The message is only
+ * formatted when the trace is decoded.
+ */
+void nck_trace_emit(struct nck_tracepoint *tp, void *context, const char *format, ...)
+	__attribute__ ((format (printf, 3, 4)));
+
+/**
+ * nck_trace_set_mask() - Select the trace backends.
+ * @mask: Bitmask of NCK_TRACE_TEXT, NCK_TRACE_BINARY and NCK_TRACE_PROBE.
+ *
+ * NCK_TRACE_PROBE only has an effect if the library was built with
+ * ENABLE_USDT. A mask of 0 disables tracing.
+ */
+void nck_trace_set_mask(uint32_t mask);
+
+/**
+ * nck_trace_get_mask() - Return the selected trace backends.
+ */
+uint32_t nck_trace_get_mask(void);
+
+/**
+ * nck_trace_set_filter() - Select the traced files and functions.
+ * @file_pattern: Glob pattern for the source files, NULL traces no file.
+ * @func_pattern: Glob pattern for the function names, NULL traces all functions.
+ */
+void nck_trace_set_filter(const char *file_pattern, const char *func_pattern);
+
+/**
+ * nck_trace_set_buffer() - Set the size of the binary ring buffers.
+ * @records: Number of records per thread, rounded up to a power of two.
+ *
+ * Only ring buffers of threads that did not trace yet are affected.
+ *
+ * Returns: 0 on success; -1 if @records is 0.
+ */
+int nck_trace_set_buffer(size_t records);
+
+/**
+ * nck_trace_dump() - Write the binary trace of all threads.
+ * @out: File that receives the trace.
+ *
+ * The ring buffers keep the newest records of each thread. Threads may keep
+ * tracing while the buffers are dumped, records that are overwritten during
+ * the dump are skipped.
+ *
+ * Returns: 0 on success; -1 on a write error.
+ */
+int nck_trace_dump(FILE *out);
+
+/**
+ * nck_trace_decode() - Convert a binary trace to text.
+ * @in: File written by nck_trace_dump().
+ * @out: File that receives one line per record, ordered by time.
+ *
+ * The trace must be decoded on the same architecture that recorded it.
+ *
+ * Returns: 0 on success; -1 if @in is not a valid trace.
+ */
+int nck_trace_decode(FILE *in, FILE *out);
+
 // __FILENAME__ can be defined by the programmer or by the build system to make the
 // trace output more legible
 #ifndef __FILENAME__
@@ -32,12 +172,20 @@ extern void (*nck_trace_print)(void *context, const char *file, int line,
  * context and the message must be provided.
  *
  * The second parameter must be a format string as accepted by printf, followed
- * by the the arguments.
+ * by the the arguments. The format is kept by the binary backend and must be a
+ * string literal. The arguments are only evaluated if the tracepoint is
+ * enabled.
+ *
+ * Define NCK_TRACE_DISABLE to remove all tracepoints at compile time.
  */
-#ifdef NDEBUG
+#ifdef NCK_TRACE_DISABLE
 # define nck_trace(context, ...) ((void)0)
 #else
-# define nck_trace(context, ...) nck_trace_print((context), __FILENAME__, __LINE__, __func__, __VA_ARGS__)
+# define nck_trace(context, ...) do { \
+	static struct nck_tracepoint _nck_tp = { __FILENAME__, __func__, __LINE__, 0, NULL }; \
+	if (nck_trace_enabled(&_nck_tp)) \
+		nck_trace_emit(&_nck_tp, (context), __VA_ARGS__); \
+} while (0)
 #endif
 
 #ifdef __cplusplus
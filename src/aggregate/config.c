@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nckernel/nckernel.h>
+#include <nckernel/aggregate.h>
+
+#include "../private.h"
+#include "../config.h"
+
+EXPORT
+int nck_aggregate_enc_set_option(struct nck_aggregate_enc *encoder, const char *name, const char *value)
+{
+	UNUSED(encoder);
+	UNUSED(name);
+	UNUSED(value);
+	return ENOTSUP;
+}
+
+EXPORT
+int nck_aggregate_dec_set_option(struct nck_aggregate_dec *decoder, const char *name, const char *value)
+{
+	UNUSED(decoder);
+	UNUSED(name);
+	UNUSED(value);
+	return ENOTSUP;
+}
+
+static int get_sizes(uint32_t *source_size, uint32_t *coded_size, void *context, nck_opt_getter get_opt)
+{
+	const char *value;
+
+	value = get_opt(context, "symbol_size");
+	if (nck_parse_u32(source_size, value)) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+		return -1;
+	}
+
+	*coded_size = *source_size;
+	value = get_opt(context, "fragment_size");
+	if (nck_parse_u32(coded_size, value)) {
+		fprintf(stderr, "Invalid fragment_size: %s\n", value);
+		return -1;
+	}
+
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
+{
+	const char *value;
+	uint32_t source_size = 1500, coded_size;
+	struct timeval timeout = { 0, 10000 };
+	struct nck_aggregate_enc *enc;
+
+	if (get_sizes(&source_size, &coded_size, context, get_opt))
+		return -1;
+
+	value = get_opt(context, "timeout");
+	if (!timer) {
+		assert(value == NULL);
+		timerclear(&timeout);
+	} else {
+		if (nck_parse_timeval(&timeout, value)) {
+			fprintf(stderr, "Invalid timeout: %s\n", value);
+			return -1;
+		}
+	}
+
+	enc = nck_aggregate_enc(source_size, coded_size, timer, &timeout);
+	if (!enc)
+		return -1;
+
+	nck_aggregate_enc_api(encoder, enc);
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
+{
+	uint32_t source_size = 1500, coded_size;
+	struct nck_aggregate_dec *dec;
+
+	UNUSED(timer);
+
+	if (get_sizes(&source_size, &coded_size, context, get_opt))
+		return -1;
+
+	dec = nck_aggregate_dec(source_size, coded_size);
+	if (!dec)
+		return -1;
+
+	nck_aggregate_dec_api(decoder, dec);
+	return 0;
+}
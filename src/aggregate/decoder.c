@@ -0,0 +1,244 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <linux/types.h>
+
+#include <nckernel/aggregate.h>
+#include <nckernel/api.h>
+#include <nckernel/segment.h>
+#include <nckernel/skb.h>
+#include <nckernel/trace.h>
+
+#include "../private.h"
+#include "packet.h"
+
+struct nck_aggregate_dec {
+	size_t source_size, coded_size, feedback_size;
+
+	struct nck_trigger on_source_ready;
+	struct nck_trigger on_feedback_ready;
+
+	int initialized;
+	uint16_t packet_no;
+
+	// the last coded packet and the position of the next unread record
+	size_t len;
+	size_t pos;
+	uint16_t records;
+	uint8_t *buffer;
+
+	// reassembly of a fragmented source packet
+	int partial;
+	struct nck_seg seg;
+	uint8_t *message;
+
+	// the next source packet, either in buffer or in message
+	const uint8_t *ready;
+	size_t ready_len;
+};
+
+NCK_DECODER_IMPL(nck_aggregate, NULL, NULL, NULL)
+
+/**
+ * next_source - find the next complete source packet
+ * @decoder: decoder structure that will be used
+ *
+ * Reads records of the last coded packet until a source packet is complete,
+ * fragments are collected in the message buffer on the way.
+ *
+ * Return: true if a source packet is ready
+ */
+static int next_source(struct nck_aggregate_dec *decoder)
+{
+	struct aggregate_record record;
+	struct sk_buff fragment;
+	uint8_t *data;
+	size_t length;
+
+	while (!decoder->ready && decoder->records > 0) {
+		if (decoder->pos + sizeof(record) > decoder->len)
+			break;
+
+		memcpy(&record, &decoder->buffer[decoder->pos], sizeof(record));
+		length = ntohs(record.length);
+		data = &decoder->buffer[decoder->pos + sizeof(record)];
+
+		if (decoder->pos + sizeof(record) + length > decoder->len)
+			break;
+
+		decoder->pos += sizeof(record) + length;
+		decoder->records -= 1;
+
+		if (record.flags & AGGREGATE_RECORD_CONTINUED) {
+			// the beginning of this source packet was lost
+			if (!decoder->partial)
+				continue;
+		} else if (!(record.flags & AGGREGATE_RECORD_MORE)) {
+			decoder->partial = 0;
+			decoder->ready = data;
+			decoder->ready_len = length;
+			break;
+		} else {
+			nck_seg_restore(&decoder->seg, decoder->message, decoder->source_size);
+			decoder->partial = 1;
+		}
+
+		if (length > decoder->seg.space) {
+			decoder->partial = 0;
+			continue;
+		}
+
+		fragment.data = data;
+		fragment.len = length;
+		nck_seg_push(&decoder->seg, &fragment);
+
+		if (!(record.flags & AGGREGATE_RECORD_MORE)) {
+			decoder->partial = 0;
+			decoder->ready = decoder->message;
+			decoder->ready_len = decoder->seg.len;
+		}
+	}
+
+	// a malformed packet is dropped with everything that follows
+	if (!decoder->ready && decoder->records > 0) {
+		decoder->records = 0;
+		decoder->partial = 0;
+	}
+
+	return decoder->ready != NULL;
+}
+
+EXPORT
+struct nck_aggregate_dec *nck_aggregate_dec(size_t source_size, size_t coded_size)
+{
+	struct nck_aggregate_dec *result;
+
+	if (coded_size <= sizeof(struct aggregate_packet) + sizeof(struct aggregate_record) ||
+	    coded_size > UINT16_MAX) {
+		fprintf(stderr, "Invalid coded size %zu\n", coded_size);
+		return NULL;
+	}
+
+	result = malloc(sizeof(*result));
+	memset(result, 0, sizeof(*result));
+	nck_trigger_init(&result->on_source_ready);
+	nck_trigger_init(&result->on_feedback_ready);
+	result->source_size = source_size;
+	result->coded_size = coded_size;
+	result->feedback_size = 0;
+
+	result->buffer = malloc(coded_size);
+	result->message = malloc(source_size);
+
+	return result;
+}
+
+EXPORT
+void nck_aggregate_dec_free(struct nck_aggregate_dec *decoder)
+{
+	free(decoder->buffer);
+	free(decoder->message);
+	free(decoder);
+}
+
+EXPORT
+int nck_aggregate_dec_reset(struct nck_aggregate_dec *decoder)
+{
+	decoder->initialized = 0;
+	decoder->packet_no = 0;
+	decoder->len = 0;
+	decoder->pos = 0;
+	decoder->records = 0;
+	decoder->partial = 0;
+	decoder->ready = NULL;
+	decoder->ready_len = 0;
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_dec_has_source(struct nck_aggregate_dec *decoder)
+{
+	return next_source(decoder);
+}
+
+EXPORT
+int nck_aggregate_dec_complete(struct nck_aggregate_dec *decoder)
+{
+	return !next_source(decoder);
+}
+
+EXPORT
+void nck_aggregate_dec_flush_source(struct nck_aggregate_dec *decoder)
+{
+	UNUSED(decoder);
+}
+
+EXPORT
+int nck_aggregate_dec_put_coded(struct nck_aggregate_dec *decoder, struct sk_buff *packet)
+{
+	struct aggregate_packet header;
+	uint16_t packet_no;
+
+	nck_trace(decoder, "%s", skb_str(packet));
+
+	if (packet->len < sizeof(header) || packet->len > decoder->coded_size)
+		return -1;
+
+	memcpy(&header, packet->data, sizeof(header));
+	packet_no = ntohs(header.packet_no);
+
+	// unread records or a lost packet break the fragment that is collected
+	if (decoder->records > 0 || (decoder->initialized && packet_no != decoder->packet_no))
+		decoder->partial = 0;
+
+	decoder->initialized = 1;
+	decoder->packet_no = packet_no + 1;
+
+	// padding added by an underlying protocol is ignored
+	memcpy(decoder->buffer, packet->data, packet->len);
+	decoder->len = packet->len;
+	decoder->pos = sizeof(header);
+	decoder->records = ntohs(header.records);
+	decoder->ready = NULL;
+
+	if (next_source(decoder))
+		nck_trigger_call(&decoder->on_source_ready);
+
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_dec_get_source(struct nck_aggregate_dec *decoder, struct sk_buff *packet)
+{
+	uint8_t *payload;
+
+	if (!next_source(decoder))
+		return -1;
+
+	payload = skb_put(packet, decoder->ready_len);
+	memcpy(payload, decoder->ready, decoder->ready_len);
+	decoder->ready = NULL;
+
+	nck_trace(decoder, "%s", skb_str(packet));
+
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_dec_get_feedback(struct nck_aggregate_dec *decoder, struct sk_buff *packet)
+{
+	UNUSED(decoder);
+	UNUSED(packet);
+	return -1;
+}
+
+EXPORT
+int nck_aggregate_dec_has_feedback(struct nck_aggregate_dec *decoder)
+{
+	UNUSED(decoder);
+	return 0;
+}
@@ -0,0 +1,295 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <linux/types.h>
+
+#include <nckernel/aggregate.h>
+#include <nckernel/api.h>
+#include <nckernel/segment.h>
+#include <nckernel/skb.h>
+#include <nckernel/timer.h>
+#include <nckernel/trace.h>
+
+#include "../private.h"
+#include "packet.h"
+
+struct nck_aggregate_enc {
+	size_t source_size, coded_size, feedback_size;
+
+	struct nck_trigger on_coded_ready;
+
+	struct timeval timeout;
+	struct nck_timer_entry *timeout_handle;
+
+	uint16_t packet_no;
+
+	// finished packets are sent from head, the packet after them is filled
+	unsigned int slots;
+	unsigned int head;
+	unsigned int count;
+	size_t fill;
+	size_t *lengths;
+	uint8_t *packets;
+};
+
+NCK_ENCODER_IMPL(nck_aggregate, NULL, NULL, NULL)
+
+static uint8_t *current_packet(struct nck_aggregate_enc *encoder)
+{
+	unsigned int index = (encoder->head + encoder->count) % encoder->slots;
+	return &encoder->packets[index * encoder->coded_size];
+}
+
+/**
+ * finish_packet - mark the packet that is filled as ready to send
+ */
+static void finish_packet(struct nck_aggregate_enc *encoder)
+{
+	unsigned int index = (encoder->head + encoder->count) % encoder->slots;
+
+	if (encoder->fill == 0)
+		return;
+
+	encoder->lengths[index] = encoder->fill;
+	encoder->count += 1;
+	encoder->fill = 0;
+
+	assert(encoder->count < encoder->slots);
+}
+
+/**
+ * add_record - append a record to the packet that is filled
+ *
+ * Return: pointer to the data of the record
+ */
+static uint8_t *add_record(struct nck_aggregate_enc *encoder, size_t len, uint8_t flags)
+{
+	uint8_t *packet = current_packet(encoder);
+	struct aggregate_packet *header = (struct aggregate_packet *)packet;
+	struct aggregate_record *record;
+
+	if (encoder->fill == 0) {
+		header->packet_no = htons(encoder->packet_no++);
+		header->records = 0;
+		encoder->fill = sizeof(*header);
+	}
+
+	record = (struct aggregate_record *)&packet[encoder->fill];
+	record->length = htons(len);
+	record->flags = flags;
+	header->records = htons(ntohs(header->records) + 1);
+
+	encoder->fill += sizeof(*record) + len;
+	return (uint8_t *)(record + 1);
+}
+
+/**
+ * record_space - number of data bytes that fit into the next record
+ */
+static size_t record_space(struct nck_aggregate_enc *encoder)
+{
+	size_t used = encoder->fill ? encoder->fill : sizeof(struct aggregate_packet);
+
+	if (used + sizeof(struct aggregate_record) >= encoder->coded_size)
+		return 0;
+
+	return encoder->coded_size - used - sizeof(struct aggregate_record);
+}
+
+static void encoder_timeout_flush(struct nck_timer_entry *entry, void *context, int success)
+{
+	UNUSED(entry);
+
+	if (success) {
+		struct nck_aggregate_enc *encoder = (struct nck_aggregate_enc *)context;
+		nck_aggregate_enc_flush_coded(encoder);
+	}
+}
+
+EXPORT
+struct nck_aggregate_enc *nck_aggregate_enc(size_t source_size, size_t coded_size,
+					    struct nck_timer *timer, const struct timeval *timeout)
+{
+	struct nck_aggregate_enc *result;
+	size_t payload;
+
+	if (coded_size <= sizeof(struct aggregate_packet) + sizeof(struct aggregate_record) ||
+	    coded_size > UINT16_MAX) {
+		fprintf(stderr, "Invalid coded size %zu\n", coded_size);
+		return NULL;
+	}
+
+	result = malloc(sizeof(*result));
+	memset(result, 0, sizeof(*result));
+	nck_trigger_init(&result->on_coded_ready);
+	result->source_size = source_size;
+	result->coded_size = coded_size;
+	result->feedback_size = 0;
+
+	// a source packet may start with a single byte at the end of a packet,
+	// the rest fills complete packets and the last one is not yet finished
+	payload = coded_size - sizeof(struct aggregate_packet) - sizeof(struct aggregate_record);
+	result->slots = DIV_ROUND_UP(source_size, payload) + 2;
+	result->lengths = calloc(result->slots, sizeof(*result->lengths));
+	result->packets = malloc(result->slots * coded_size);
+
+	if (timeout && timerisset(timeout)) {
+		assert(timer != NULL);
+		result->timeout = *timeout;
+		result->timeout_handle = nck_timer_add(timer, NULL, result, encoder_timeout_flush);
+	}
+
+	return result;
+}
+
+EXPORT
+void nck_aggregate_enc_free(struct nck_aggregate_enc *encoder)
+{
+	if (encoder->timeout_handle) {
+		nck_timer_cancel(encoder->timeout_handle);
+		nck_timer_free(encoder->timeout_handle);
+	}
+
+	free(encoder->lengths);
+	free(encoder->packets);
+	free(encoder);
+}
+
+EXPORT
+int nck_aggregate_enc_reset(struct nck_aggregate_enc *encoder)
+{
+	nck_timer_cancel(encoder->timeout_handle);
+
+	encoder->packet_no = 0;
+	encoder->head = 0;
+	encoder->count = 0;
+	encoder->fill = 0;
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_enc_has_coded(struct nck_aggregate_enc *encoder)
+{
+	return encoder->count > 0;
+}
+
+EXPORT
+int nck_aggregate_enc_full(struct nck_aggregate_enc *encoder)
+{
+	// there is always space for one source packet besides the finished ones
+	return encoder->count > 0;
+}
+
+EXPORT
+int nck_aggregate_enc_complete(struct nck_aggregate_enc *encoder)
+{
+	return encoder->count == 0 && encoder->fill == 0;
+}
+
+EXPORT
+void nck_aggregate_enc_flush_coded(struct nck_aggregate_enc *encoder)
+{
+	finish_packet(encoder);
+	nck_timer_cancel(encoder->timeout_handle);
+
+	if (encoder->count > 0)
+		nck_trigger_call(&encoder->on_coded_ready);
+}
+
+EXPORT
+int nck_aggregate_enc_put_source(struct nck_aggregate_enc *encoder, struct sk_buff *packet)
+{
+	struct nck_seg seg;
+	struct sk_buff fragment;
+	uint8_t flags = 0;
+	uint8_t *data;
+	size_t space;
+
+	nck_trace(encoder, "%s", skb_str(packet));
+
+	if (packet->len > encoder->source_size || nck_aggregate_enc_full(encoder))
+		return -1;
+
+	nck_seg_new(&seg, packet->data, packet->len, 0);
+
+	if (packet->len == 0) {
+		// the empty packet still needs a record to be delivered
+		if (record_space(encoder) == 0)
+			finish_packet(encoder);
+		add_record(encoder, 0, 0);
+	}
+
+	while (seg.len > 0) {
+		space = record_space(encoder);
+		if (space == 0) {
+			finish_packet(encoder);
+			continue;
+		}
+
+		nck_seg_pull(&seg, &fragment, space);
+		if (seg.len > 0)
+			flags |= AGGREGATE_RECORD_MORE;
+		else
+			flags &= ~AGGREGATE_RECORD_MORE;
+
+		data = add_record(encoder, fragment.len, flags);
+		memcpy(data, fragment.data, fragment.len);
+
+		flags = AGGREGATE_RECORD_CONTINUED;
+
+		// a fragment always ends the packet
+		if (seg.len > 0)
+			finish_packet(encoder);
+	}
+
+	if (record_space(encoder) == 0)
+		finish_packet(encoder);
+
+	if (encoder->fill > 0) {
+		// bound the delay of the first packet that is waiting
+		if (encoder->timeout_handle && !nck_timer_pending(encoder->timeout_handle))
+			nck_timer_rearm(encoder->timeout_handle, &encoder->timeout);
+	} else {
+		nck_timer_cancel(encoder->timeout_handle);
+	}
+
+	if (encoder->count > 0)
+		nck_trigger_call(&encoder->on_coded_ready);
+
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_enc_get_coded(struct nck_aggregate_enc *encoder, struct sk_buff *packet)
+{
+	uint8_t *payload;
+	size_t len;
+
+	if (encoder->count == 0)
+		return -1;
+
+	len = encoder->lengths[encoder->head];
+	payload = skb_put(packet, len);
+	memcpy(payload, &encoder->packets[encoder->head * encoder->coded_size], len);
+
+	encoder->head = (encoder->head + 1) % encoder->slots;
+	encoder->count -= 1;
+
+	nck_trace(encoder, "%s", skb_str(packet));
+
+	return 0;
+}
+
+EXPORT
+int nck_aggregate_enc_put_feedback(struct nck_aggregate_enc *encoder, struct sk_buff *packet)
+{
+	UNUSED(encoder);
+	UNUSED(packet);
+	return -1;
+}
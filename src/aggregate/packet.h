@@ -0,0 +1,35 @@
+#ifndef __packed
+#define __packed __attribute((packed))   /* linux kernel compat */
+#endif
+
+/**
+ * aggregate_packet - header of an aggregated packet
+ * @packet_no: incremental packet counter, used to detect lost fragments
+ * @records: number of records that follow the header
+ */
+struct aggregate_packet {
+	uint16_t packet_no;
+	uint16_t records;
+} __packed;
+
+/**
+ * aggregate_record - header of a source packet or a fragment of it
+ * @length: number of data bytes that follow the header
+ * @flags: see enum aggregate_record_flags
+ */
+struct aggregate_record {
+	uint16_t length;
+	uint8_t flags;
+} __packed;
+
+/**
+ * aggregate_record_flags - position of a fragment within the source packet
+ * @AGGREGATE_RECORD_CONTINUED: the record continues the source packet of the
+ *    last record in the previous packet
+ * @AGGREGATE_RECORD_MORE: the source packet continues in the first record of
+ *    the next packet
+ */
+enum aggregate_record_flags {
+	AGGREGATE_RECORD_CONTINUED = 0x01,
+	AGGREGATE_RECORD_MORE = 0x02,
+};
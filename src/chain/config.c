@@ -92,9 +92,8 @@ int nck_chain_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, v
 	struct nck_encoder stages[MAX_STAGES];
 	struct stage_context stage_context = { stage_name, context, get_opt, symbol_size_str, NULL };
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -141,9 +140,8 @@ int nck_chain_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, v
 	struct stage_context stage_context = { stage_name, context, get_opt, symbol_size_str, NULL };
 
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -28,19 +28,24 @@ struct nck_chain_dec {
 	struct nck_decoder *first_stage;
 	struct nck_decoder *last_stage;
 
+	// the stages after the input stage usually only unwrap packets in place
+	unsigned int input;
+	struct nck_decoder *input_stage;
+
+	uint8_t *buffer;
+
 	unsigned int stage_count;
 	struct stage stages[];
 };
 
 NCK_DECODER_IMPL(nck_chain, NULL, NULL, NULL)
 
-static int forward_decoded(struct nck_decoder *source, struct nck_decoder *dest, unsigned int size) {
+static int forward_decoded(struct nck_chain_dec *chain, struct nck_decoder *source, struct nck_decoder *dest) {
 	int packets = 0;
-	uint8_t buffer[size];
 	struct sk_buff skb;
 
 	while (nck_has_source(source)) {
-		skb_new(&skb, buffer, sizeof(buffer));
+		skb_new(&skb, chain->buffer, source->source_size);
 		if (nck_get_source(source, &skb)) {
 			break;
 		}
@@ -67,13 +72,13 @@ static void on_source_ready(void *c)
 
 	assert(stage->decoder.source_size == next->decoder.coded_size);
 
-	forward_decoded(&stage->decoder, &next->decoder, stage->decoder.source_size);
+	forward_decoded(stage->parent, &stage->decoder, &next->decoder);
 }
 
 EXPORT
 struct nck_chain_dec *nck_chain_dec(struct nck_decoder *stages, unsigned int stage_count)
 {
-	size_t feedback_size = 0;
+	size_t feedback_size = 0, buffer_size = 0;
 	struct nck_chain_dec *result;
 	size_t size = sizeof(*result) + stage_count*sizeof(struct stage);
 	unsigned int i;
@@ -97,6 +102,19 @@ struct nck_chain_dec *nck_chain_dec(struct nck_decoder *stages, unsigned int sta
 	result->first_stage = &result->stages[0].decoder;
 	result->last_stage = &result->stages[stage_count-1].decoder;
 
+	// trailing stages that can unwrap packets in place are bypassed
+	result->input = stage_count-1;
+	while (result->input > 0 && result->stages[result->input].decoder.type->unwrap_coded) {
+		result->input -= 1;
+	}
+	result->input_stage = &result->stages[result->input].decoder;
+
+	// a bypassed stage that refuses to unwrap a packet decodes it instead
+	for (i = 1; i < stage_count; ++i) {
+		buffer_size = max_t(size_t, buffer_size, result->stages[i].decoder.source_size);
+	}
+	result->buffer = malloc(buffer_size);
+
 	nck_trigger_init(&result->on_source_ready);
 	nck_trigger_init(&result->on_feedback_ready);
 	result->source_size = result->first_stage->source_size;
@@ -124,9 +142,24 @@ void nck_chain_dec_free(struct nck_chain_dec *decoder)
 		nck_free(&decoder->stages[i].decoder);
 	}
 
+	free(decoder->buffer);
 	free(decoder);
 }
 
+EXPORT
+int nck_chain_dec_reset(struct nck_chain_dec *decoder)
+{
+	unsigned int i;
+	int result = 0;
+
+	for (i = 0; i < decoder->stage_count; ++i) {
+		if (nck_reset(&decoder->stages[i].decoder))
+			result = -1;
+	}
+
+	return result;
+}
+
 EXPORT
 int nck_chain_dec_has_source(struct nck_chain_dec *decoder)
 {
@@ -151,7 +184,17 @@ void nck_chain_dec_flush_source(struct nck_chain_dec *decoder)
 EXPORT
 int nck_chain_dec_put_coded(struct nck_chain_dec *decoder, struct sk_buff *packet)
 {
-	return nck_put_coded(decoder->last_stage, packet);
+	unsigned int stage;
+
+	// the bypassed stages only pull their headers, a stage that cannot
+	// unwrap the packet forwards what it decodes to the next stage
+	for (stage = decoder->stage_count-1; stage > decoder->input; --stage) {
+		if (nck_unwrap_coded(&decoder->stages[stage].decoder, packet)) {
+			return nck_put_coded(&decoder->stages[stage].decoder, packet);
+		}
+	}
+
+	return nck_put_coded(decoder->input_stage, packet);
 }
 
 EXPORT
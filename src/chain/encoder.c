@@ -18,6 +18,7 @@ struct stage {
 	unsigned int number; // current stage number
 	struct nck_chain_enc *parent; // pointer to the container
 	struct nck_encoder encoder; // encoder for this stage
+	size_t headroom; // header budget of the bypassed stages after this one
 };
 
 struct nck_chain_enc {
@@ -28,6 +29,13 @@ struct nck_chain_enc {
 	struct nck_encoder *first_stage; // shortcut to the first stage
 	struct nck_encoder *last_stage; // shortcut to the last stage
 
+	// the stages after the output stage wrap its packets in place, packets
+	// they refuse to wrap are put into them and sent from there
+	unsigned int output;
+	struct nck_encoder *output_stage;
+
+	uint8_t *buffer; // packets forwarded between stages
+
 	unsigned int stage_count; // number of items in the following array
 	struct stage stages[]; // dynamically sized array of stages
 };
@@ -37,15 +45,14 @@ NCK_ENCODER_IMPL(nck_chain, NULL, NULL, NULL)
 /**
  * forward_coded - get packets from one encoder and put it to the next
  */
-static int forward_coded(struct nck_encoder *source, struct nck_encoder *dest, unsigned int size) {
+static int forward_coded(struct nck_chain_enc *chain, struct nck_encoder *source, struct nck_encoder *dest) {
 	int packets = 0;
-	uint8_t buffer[size];
 	struct sk_buff skb;
 
 	// forward all packets to the next encoder until the next
 	// encoder is either full or we have no more packets
 	while (nck_has_coded(source) && !nck_full(dest)) {
-		skb_new(&skb, buffer, sizeof(buffer));
+		skb_new(&skb, chain->buffer, source->coded_size);
 		if (nck_get_coded(source, &skb)) {
 			break;
 		}
@@ -62,24 +69,23 @@ static void on_coded_ready(void *c)
 	struct stage *stage = (struct stage *)c;
 	struct stage *next;
 
-	// if the callback was triggered by the last stage
-	// then we propagate the call to the parent encoder
-	if (stage->parent->last_stage == &stage->encoder) {
+	// if the callback was triggered by the output stage or a bypassed
+	// stage then we propagate the call to the parent encoder
+	if (stage->number >= stage->parent->output) {
 		nck_trigger_call(&stage->parent->on_coded_ready);
 		return;
 	}
 
 	// for everything else we should propagate to the next stage
-	assert(stage->number+1 < stage->parent->stage_count);
 	next = &stage->parent->stages[stage->number+1];
 
-	forward_coded(&stage->encoder, &next->encoder, stage->encoder.coded_size);
+	forward_coded(stage->parent, &stage->encoder, &next->encoder);
 }
 
 EXPORT
 struct nck_chain_enc *nck_chain_enc(struct nck_encoder *stages, unsigned int stage_count)
 {
-	size_t feedback_size = 0;
+	size_t feedback_size = 0, buffer_size = 0;
 	struct nck_chain_enc *result;
 	size_t size = sizeof(*result) + stage_count*sizeof(struct stage);
 	unsigned int i;
@@ -110,6 +116,26 @@ struct nck_chain_enc *nck_chain_enc(struct nck_encoder *stages, unsigned int sta
 	result->first_stage = &result->stages[0].encoder;
 	result->last_stage = &result->stages[stage_count-1].encoder;
 
+	// trailing stages that can wrap packets in place are bypassed, the
+	// output stage writes into the final packet behind their headers
+	result->output = stage_count-1;
+	while (result->output > 0 && result->stages[result->output].encoder.type->wrap_source) {
+		result->output -= 1;
+	}
+	result->output_stage = &result->stages[result->output].encoder;
+
+	for (i = stage_count-1; i > result->output; --i) {
+		struct nck_encoder *stage = &result->stages[i].encoder;
+		result->stages[i-1].headroom = result->stages[i].headroom + stage->coded_size - stage->source_size;
+		// a packet that is not wrapped is copied into the buffer
+		buffer_size = max_t(size_t, buffer_size, stage->source_size);
+	}
+
+	for (i = 0; i < result->output; ++i) {
+		buffer_size = max_t(size_t, buffer_size, result->stages[i].encoder.coded_size);
+	}
+	result->buffer = malloc(buffer_size);
+
 	nck_trigger_init(&result->on_coded_ready);
 
 	// our input should fit into the first encoder
@@ -142,13 +168,35 @@ void nck_chain_enc_free(struct nck_chain_enc *encoder)
 		nck_free(&encoder->stages[i].encoder);
 	}
 
+	free(encoder->buffer);
 	free(encoder);
 }
 
+EXPORT
+int nck_chain_enc_reset(struct nck_chain_enc *encoder)
+{
+	unsigned int i;
+	int result = 0;
+
+	for (i = 0; i < encoder->stage_count; ++i) {
+		if (nck_reset(&encoder->stages[i].encoder))
+			result = -1;
+	}
+
+	return result;
+}
+
 EXPORT
 int nck_chain_enc_has_coded(struct nck_chain_enc *encoder)
 {
-	return nck_has_coded(encoder->last_stage);
+	unsigned int stage;
+
+	for (stage = encoder->stage_count-1; stage > encoder->output; --stage) {
+		if (nck_has_coded(&encoder->stages[stage].encoder))
+			return 1;
+	}
+
+	return nck_has_coded(encoder->output_stage);
 }
 
 EXPORT
@@ -189,13 +237,16 @@ static void push_coded(struct nck_chain_enc *encoder, unsigned int stage)
 	struct nck_encoder *source;
 	struct nck_encoder *dest;
 
+	// the bypassed stages never hold packets
+	stage = min_t(unsigned int, stage, encoder->output);
+
 	// iterate from the initial stage up to the first encoder
 	for (; stage > 0; --stage) {
 		source = &encoder->stages[stage-1].encoder;
 		dest = &encoder->stages[stage].encoder;
 
 		// try to add some packets from the previous controller
-		if (forward_coded(source, dest, source->coded_size) == 0) {
+		if (forward_coded(encoder, source, dest) == 0) {
 			// If nothing was pushed then probably nothing has changed
 			// in the source encoder. So there is no reason to check
 			// further upwards.
@@ -210,11 +261,46 @@ static void push_coded(struct nck_chain_enc *encoder, unsigned int stage)
 EXPORT
 int nck_chain_enc_get_coded(struct nck_chain_enc *encoder, struct sk_buff *packet)
 {
+	struct sk_buff start = *packet;
+	struct sk_buff skb;
+	unsigned int source, stage;
 	int ret;
-	ret = nck_get_coded(encoder->last_stage, packet);
-	// getting a coded packet could free up some space in the last encoder
+
+	// packets waiting in a bypassed stage are sent first, the latest
+	// stage is the closest to the output
+	for (source = encoder->stage_count-1; source > encoder->output; --source) {
+		if (nck_has_coded(&encoder->stages[source].encoder))
+			break;
+	}
+
+	for (;;) {
+		// leave room for the headers of the bypassed stages
+		skb_reserve(packet, encoder->stages[source].headroom);
+		ret = nck_get_coded(&encoder->stages[source].encoder, packet);
+		if (ret)
+			break;
+
+		for (stage = source+1; stage < encoder->stage_count; ++stage) {
+			if (nck_wrap_source(&encoder->stages[stage].encoder, packet))
+				break;
+		}
+
+		if (stage == encoder->stage_count)
+			break;
+
+		// the stage wants to send something else first, so it keeps
+		// the packet and we start over with its next coded packet
+		skb_new(&skb, encoder->buffer, encoder->stages[stage].encoder.source_size);
+		memcpy(skb_put(&skb, packet->len), packet->data, packet->len);
+		nck_put_source(&encoder->stages[stage].encoder, &skb);
+
+		*packet = start;
+		source = stage;
+	}
+
+	// getting a coded packet could free up some space in the output encoder
 	// so we might be able to push more coded packets down the chain
-	push_coded(encoder, encoder->stage_count-1);
+	push_coded(encoder, encoder->output);
 	return ret;
 }
 
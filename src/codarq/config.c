@@ -35,10 +35,10 @@ int nck_codarq_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 {
 	krlnc_encoder_factory_t factory;
 	struct nck_codarq_enc *enc;
-	const char *value;
 	uint16_t redundancy = 2;
-	uint8_t max_active_containers = 8;
+	uint32_t max_active_containers = 8;
 	struct timeval repair_timeout =   { 0, 100000 };
+	uint32_t adaptive_timeout = 0;
 
 	if (get_kodo_enc_factory(&factory, context, get_opt)) {
 		fprintf(stderr, "Failed to create the kodo encoder factory.\n");
@@ -48,26 +48,29 @@ int nck_codarq_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 	enc = nck_codarq_enc(factory, timer);
 	nck_codarq_enc_api(encoder, enc);
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u16(&redundancy, value)) {
-		fprintf(stderr, "Invalid redundancy: %s\n", value);
+	if (nck_get_opt_u16(&redundancy, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid redundancy: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "max_containers");
-	if (nck_parse_u8(&max_active_containers, value)) {
-		fprintf(stderr, "Invalid max_containers: %s\n", value);
+	if (nck_get_opt_u32(&max_active_containers, context, get_opt, "max_containers")) {
+		fprintf(stderr, "Invalid max_containers: %s\n", get_opt(context, "max_containers"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&repair_timeout, value)) {
-		fprintf(stderr, "Invalid repair_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&repair_timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid repair_timeout: %s\n", get_opt(context, "timeout"));
+		return -1;
+	}
+
+	if (nck_get_opt_u32(&adaptive_timeout, context, get_opt, "adaptive_timeout")) {
+		fprintf(stderr, "Invalid adaptive_timeout: %s\n", get_opt(context, "adaptive_timeout"));
 		return -1;
 	}
 
 	nck_codarq_set_redundancy(enc, redundancy);
 	nck_codarq_set_enc_repair_timeout(enc,&repair_timeout);
+	nck_codarq_set_enc_adaptive_timeout(enc, adaptive_timeout);
 	nck_codarq_set_enc_max_active_containers(enc, max_active_containers);
 
 	return 0;
@@ -78,8 +81,8 @@ int nck_codarq_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 {
 	krlnc_decoder_factory_t factory;
 	struct nck_codarq_dec *dec;
-	const char *value;
 	struct timeval fb_timeout = { 0, 50000 };
+	uint32_t max_active_containers = 8;
 
 	if (get_kodo_dec_factory(&factory, context, get_opt)) {
 		fprintf(stderr, "Failed to create the kodo decoder factory.\n");
@@ -89,13 +92,18 @@ int nck_codarq_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 	dec = nck_codarq_dec(factory, timer);
 	nck_codarq_dec_api(decoder, dec);
 
-	value = get_opt(context, "fb_timeout");
-	if (nck_parse_timeval(&fb_timeout, value)) {
-		fprintf(stderr, "Invalid fb_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&fb_timeout, context, get_opt, "fb_timeout")) {
+		fprintf(stderr, "Invalid fb_timeout: %s\n", get_opt(context, "fb_timeout"));
+		return -1;
+	}
+
+	if (nck_get_opt_u32(&max_active_containers, context, get_opt, "max_containers")) {
+		fprintf(stderr, "Invalid max_containers: %s\n", get_opt(context, "max_containers"));
 		return -1;
 	}
 
 	nck_codarq_set_dec_fb_timeout(dec, &fb_timeout);
+	nck_codarq_set_dec_max_active_containers(dec, max_active_containers);
 
 	return 0;
 }
@@ -13,10 +13,10 @@
 #include "../private.h"
 #include "../kodo.h"
 #include "../util/helper.h"
-#include "list.h"
+#include "../util/gen_table.h"
+#include "../util/buffer_pool.h"
 
 typedef struct nck_codarq_dec_container {
-	struct list_head list;
 	struct nck_codarq_dec *codarq_decoder;
 	krlnc_decoder_t coder;
 	uint32_t generation;
@@ -31,6 +31,7 @@ typedef struct nck_codarq_dec_container {
 
 struct nck_codarq_dec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	uint32_t last_seqno;
 	uint32_t gen_newest;
 	uint32_t gen_oldest;
@@ -38,6 +39,7 @@ struct nck_codarq_dec {
 	uint32_t block_size;
 	uint32_t symbols;
 	uint32_t num_containers;
+	uint32_t max_containers;
 	uint8_t has_feedback;
 	dec_container *cont_oldest;
 	dec_container *cont_newest;
@@ -51,16 +53,17 @@ struct nck_codarq_dec {
 	struct nck_trigger on_source_ready;
 	struct nck_trigger on_feedback_ready;
 
-	struct list_head container_list;
+	struct gen_table containers;
+	struct buffer_pool buffers;
 };
 
 NCK_DECODER_IMPL(nck_codarq, nck_codarq_dec_debug, NULL, NULL)
 
 static void nck_codarq_update_decoder_stat(struct nck_codarq_dec *decoder) {
-	if (!list_empty(&decoder->container_list)) {
-		decoder->cont_newest = list_entry(decoder->container_list.prev, dec_container, list);
+	if (decoder->containers.count > 0) {
+		decoder->cont_newest = gen_table_newest(&decoder->containers);
 		decoder->gen_newest = decoder->cont_newest->generation;
-		decoder->cont_oldest = list_entry(decoder->container_list.next, dec_container, list);
+		decoder->cont_oldest = gen_table_oldest(&decoder->containers);
 		decoder->gen_oldest = decoder->cont_oldest->generation;
 	} else {
 		decoder->cont_newest = NULL;
@@ -87,10 +90,14 @@ static void decoder_send_feedback(struct nck_timer_entry *entry, void *context,
 
 dec_container *nck_codarq_dec_start_next_generation(struct nck_codarq_dec *decoder, uint32_t generation) {
 	dec_container *container;
-	dec_container *cont_tmp;
 	container = malloc(sizeof(*container));
 	memset(container, 0, sizeof(*container));
 
+	if (gen_table_insert(&decoder->containers, generation, container)) {
+		free(container);
+		return NULL;
+	}
+
 	if (decoder->cont_newest) {
 		// if we start the next generation then the previous generation should be full
 		decoder->cont_newest->enc_rank = decoder->symbols;
@@ -101,23 +108,14 @@ dec_container *nck_codarq_dec_start_next_generation(struct nck_codarq_dec *decod
 	container->rank = 0;
 	container->enc_rank = decoder->symbols;
 	container->index = 0;
-	container->coder = kodo_build_decoder(decoder->factory);
+	container->coder = kodo_decoder_pool_get(&decoder->pool);
 	krlnc_decoder_set_status_updater_on(container->coder);
 
-	container->buffer = malloc(decoder->block_size);
-	memset(container->buffer, 0, decoder->block_size);
+	container->buffer = buffer_pool_get(&decoder->buffers);
 	krlnc_decoder_set_mutable_symbols(container->coder, container->buffer, decoder->block_size);
 
 	decoder->num_containers += 1;
 
-	INIT_LIST_HEAD(&container->list);
-
-	// We ensure that the containers are placed in ascending order of the generation
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
-		if (cont_tmp->generation > generation) break;
-	}
-	list_add_before(&container->list, &cont_tmp->list);
-
 	nck_codarq_update_decoder_stat(decoder);
 
 	return container;
@@ -130,6 +128,7 @@ char *nck_codarq_dec_debug(void *dec) {
 	char *sep = "";
 	int len = sizeof(debug), pos = 0;
 	dec_container *cont;
+	uint32_t gen;
 
 	debug[0] = 0;
 
@@ -137,7 +136,7 @@ char *nck_codarq_dec_debug(void *dec) {
 		 "\"newest generation\": %d, \"has source\": %d, \"num\": %u, \"last_seqno\": %u, \"containers\": [",
 		 decoder->gen_newest, _has_source(decoder), decoder->num_containers, decoder->last_seqno);
 
-	list_for_each_entry(cont, &decoder->container_list, list) {
+	gen_table_for_each(&decoder->containers, gen, cont) {
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos),
 			 "%s{ \"gen\": %u, \"rank\": %u }",
 			 sep, cont->generation, cont->rank);
@@ -170,28 +169,38 @@ struct nck_codarq_dec *nck_codarq_dec(krlnc_decoder_factory_t factory, struct nc
 	result->symbols = krlnc_decoder_factory_symbols(factory);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(dec) + 4 + 2 + 4;
-	result->feedback_size = 1408;        // Supports up to 140 containers
+	result->coded_size = kodo_decoder_payload_size(dec) + 4 + 2 + 4;
+	result->feedback_size = 1408;        // Holds up to 232 containers, see get_feedback
 
 	result->last_seqno = 0;
 	result->factory = factory;
+	kodo_decoder_pool_init(&result->pool, factory);
 	result->block_size = block_size;
 	result->gen_oldest_deleted = 0;
 	result->has_feedback = 0;
+	result->max_containers = 8;
 
 
-	INIT_LIST_HEAD(&(result->container_list));
+	gen_table_init(&result->containers, result->max_containers);
+	gen_table_set_max_span(&result->containers, result->max_containers);
+	buffer_pool_init(&result->buffers, block_size, 4);
 	nck_codarq_dec_start_next_generation(result, 1);
 
 	result->timer = timer;
 
 	result->dec_fb_timeout_handle = nck_timer_add(timer, NULL, result, decoder_send_feedback);
 
-	krlnc_delete_decoder(dec);
+	kodo_decoder_pool_put(&result->pool, dec);
 
 	return result;
 }
 
+EXPORT
+void nck_codarq_set_dec_max_active_containers(struct nck_codarq_dec *decoder, uint32_t max_active_containers) {
+	decoder->max_containers = max_active_containers;
+	gen_table_set_max_span(&decoder->containers, max_active_containers);
+}
+
 EXPORT
 void nck_codarq_set_dec_fb_timeout(struct nck_codarq_dec *decoder, const struct timeval *dec_fb_timeout) {
 	if (dec_fb_timeout != NULL) {
@@ -203,21 +212,26 @@ void nck_codarq_set_dec_fb_timeout(struct nck_codarq_dec *decoder, const struct
 
 void nck_codarq_dec_container_del(dec_container *container) {
 	container->codarq_decoder->num_containers -= 1;
-	list_del(&container->list);
-	krlnc_delete_decoder(container->coder);
+	gen_table_remove(&container->codarq_decoder->containers, container->generation);
+	kodo_decoder_pool_put(&container->codarq_decoder->pool, container->coder);
 	nck_timer_cancel(container->dec_cont_flush_timeout_handle);
 	nck_timer_free(container->dec_cont_flush_timeout_handle);
-	free(container->buffer);
+	buffer_pool_put(&container->codarq_decoder->buffers, container->buffer);
 	free(container);
 }
 
 EXPORT
 void nck_codarq_dec_free(struct nck_codarq_dec *decoder) {
-	dec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &decoder->container_list, list) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		nck_codarq_dec_container_del(cont_tmp);
 	}
-	krlnc_delete_decoder_factory(decoder->factory);
+	gen_table_free(&decoder->containers);
+	buffer_pool_free(&decoder->buffers);
+	kodo_decoder_pool_free(&decoder->pool);
+	kodo_delete_decoder_factory(decoder->factory);
 
 	nck_timer_cancel(decoder->dec_fb_timeout_handle);
 	nck_timer_free(decoder->dec_fb_timeout_handle);
@@ -225,17 +239,39 @@ void nck_codarq_dec_free(struct nck_codarq_dec *decoder) {
 	free(decoder);
 }
 
+EXPORT
+int nck_codarq_dec_reset(struct nck_codarq_dec *decoder) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
+		nck_codarq_dec_container_del(cont_tmp);
+	}
+	nck_codarq_update_decoder_stat(decoder);
+
+	nck_timer_cancel(decoder->dec_fb_timeout_handle);
+
+	decoder->last_seqno = 0;
+	decoder->gen_newest = 0;
+	decoder->gen_oldest = 0;
+	decoder->gen_oldest_deleted = 0;
+	decoder->has_feedback = 0;
+
+	nck_codarq_dec_start_next_generation(decoder, 1);
+
+	return 0;
+}
+
 EXPORT
 int nck_codarq_dec_has_source(struct nck_codarq_dec *decoder) {
 	dec_container *oldest_container = decoder->cont_oldest;
 
 	// No containers are present
-	if (list_empty(&decoder->container_list))
+	if (decoder->containers.count == 0)
 		return 0;
 
 	// do not skip over a missing generation if no packets haven't been received yet
-	// TODO: this is not wrap-around safe
-	if (decoder->gen_oldest > decoder->gen_oldest_deleted + 1)
+	if (gen_before(decoder->gen_oldest_deleted + 1, decoder->gen_oldest))
 		return 0;
 
 	return krlnc_decoder_is_symbol_uncoded(oldest_container->coder, oldest_container->index);
@@ -260,7 +296,7 @@ void nck_codarq_dec_flush_source(struct nck_codarq_dec *decoder) {
 EXPORT
 int nck_codarq_dec_put_coded(struct nck_codarq_dec *decoder, struct sk_buff *packet) {
 	uint32_t generation, rank, seqno;
-	dec_container *cont_tmp, *cont = NULL;
+	dec_container *cont;
 
 	if (packet->len < 6) {
 		return ENOSPC;
@@ -275,12 +311,7 @@ int nck_codarq_dec_put_coded(struct nck_codarq_dec *decoder, struct sk_buff *pac
 	}
 
 	// "cont" will contain the pointer to the container of the gen if exists else NULL
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
-		if (cont_tmp->generation != generation)
-			continue;
-		cont = cont_tmp;
-		break;
-	}
+	cont = gen_table_get(&decoder->containers, generation);
 
 	if ((int32_t)(generation - decoder->gen_oldest_deleted) <= 0) {
 		// Encoder sending old gen packets.
@@ -295,11 +326,21 @@ int nck_codarq_dec_put_coded(struct nck_codarq_dec *decoder, struct sk_buff *pac
 	}
 
 	if (!cont) {
-		while (decoder->gen_newest < generation ||
-		    (decoder->gen_oldest_deleted < generation && generation < decoder->gen_newest)) {
+		// The containers between the last delivered generation and this
+		// one are kept, so drop generations that are too far ahead. The
+		// encoder repeats them once the older generations are delivered.
+		if (generation - decoder->gen_oldest_deleted > decoder->max_containers)
+			return 0;
+
+		while (gen_before(decoder->gen_newest, generation)) {
 			// Create new container
 			cont = nck_codarq_dec_start_next_generation(decoder, decoder->gen_newest+1);
+			if (!cont)
+				return -1;
 		}
+
+		if (!cont)
+			return -1;
 	}
 
 	assert(cont != NULL);
@@ -364,12 +405,21 @@ int nck_codarq_dec_get_source(struct nck_codarq_dec *decoder, struct sk_buff *pa
 EXPORT
 int nck_codarq_dec_get_feedback(struct nck_codarq_dec *decoder, struct sk_buff *packet) {
 	dec_container *cont_tmp;
+	uint32_t gen, count;
+
+	if (skb_tailroom(packet) < 12)
+		return -1;
+
+	// report as many generations as fit into the packet, starting with the oldest
+	count = min_t(uint32_t, decoder->num_containers, (skb_tailroom(packet) - 12) / 6);
 
 	skb_put_u32(packet, decoder->gen_oldest_deleted);
-	skb_put_u32(packet, decoder->num_containers);
+	skb_put_u32(packet, count);
 	skb_put_u32(packet, decoder->last_seqno);
 
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
+		if (count-- == 0)
+			break;
 		skb_put_u32(packet, cont_tmp->generation);
 		skb_put_u16(packet, (uint16_t)(cont_tmp->enc_rank - cont_tmp->rank));
 	}
@@ -18,11 +18,12 @@
 #include "../private.h"
 #include "../kodo.h"
 #include "../util/helper.h"
-#include "list.h"
+#include "../util/gen_table.h"
+#include "../util/buffer_pool.h"
+#include "../util/rtt.h"
 
 
 typedef struct nck_codarq_enc_container {
-	struct list_head list;
 	struct nck_codarq_enc *codarq_encoder;
 	krlnc_encoder_t coder;
 	uint32_t generation;
@@ -34,6 +35,7 @@ typedef struct nck_codarq_enc_container {
 
 struct nck_codarq_enc {
 	krlnc_encoder_factory_t factory;
+	struct kodo_encoder_pool pool;
 
 	uint32_t block_size;
 	uint32_t symbols;
@@ -44,18 +46,22 @@ struct nck_codarq_enc {
 	uint32_t gen_newest;
 	uint32_t gen_oldest;
 	uint32_t num_containers;
-	uint8_t max_active_containers;
+	uint32_t max_active_containers;
 	enc_container *cont_oldest;
 	enc_container *cont_newest;
 
 	struct nck_timer *timer;
 	struct timeval enc_repair_timeout;
 	struct nck_timer_entry *repair_timeout_handle;
+	// the repair timeout follows the round trip time if adaptive_timeout is set
+	int adaptive_timeout;
+	struct rtt_estimator rtt;
 	size_t source_size, coded_size, feedback_size;
 
 	struct nck_trigger on_coded_ready;
 	int to_send;
-	struct list_head container_list;
+	struct gen_table containers;
+	struct buffer_pool buffers;
 };
 
 EXPORT
@@ -65,6 +71,7 @@ char *nck_codarq_enc_debug(void *enc) {
 	char *sep = "";
 	int len = sizeof(debug), pos = 0;
 	enc_container *cont;
+	uint32_t gen;
 
 	debug[0] = 0;
 
@@ -72,7 +79,7 @@ char *nck_codarq_enc_debug(void *enc) {
 		 "\"newest generation\": %d, \"to_send\": %d, \"num\": %u, \"containers\": [",
 		 encoder->gen_newest, encoder->to_send, encoder->num_containers);
 
-	list_for_each_entry(cont, &encoder->container_list, list) {
+	gen_table_for_each(&encoder->containers, gen, cont) {
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos),
 			 "%s{ \"gen\": %u, \"rank\": %u, \"last_seqno\": %u, \"to_send\": %u}",
 			 sep, cont->generation, cont->rank, cont->last_seqno, cont->to_send_cont);
@@ -90,10 +97,10 @@ char *nck_codarq_enc_debug(void *enc) {
 NCK_ENCODER_IMPL(nck_codarq, nck_codarq_enc_debug, NULL, NULL)
 
 static void nck_codarq_update_encoder_stat(struct nck_codarq_enc *encoder) {
-	if (!list_empty(&encoder->container_list)) {
-		encoder->cont_newest = list_entry(encoder->container_list.prev, enc_container, list);
+	if (encoder->containers.count > 0) {
+		encoder->cont_newest = gen_table_newest(&encoder->containers);
 		encoder->gen_newest = encoder->cont_newest->generation;
-		encoder->cont_oldest = list_entry(encoder->container_list.next, enc_container, list);
+		encoder->cont_oldest = gen_table_oldest(&encoder->containers);
 		encoder->gen_oldest = encoder->cont_oldest->generation;
 	} else {
 		encoder->cont_newest = NULL;
@@ -101,6 +108,24 @@ static void nck_codarq_update_encoder_stat(struct nck_codarq_enc *encoder) {
 	}
 }
 
+/**
+ * Restart the repair timeout. With the adaptive timeout the configured value
+ * is only used until the first round trip time was measured.
+ *
+ * @param encoder
+ */
+static void nck_codarq_enc_rearm_repair_timeout(struct nck_codarq_enc *encoder) {
+	struct timeval timeout;
+
+	if (encoder->adaptive_timeout) {
+		rtt_timeout(&encoder->rtt, &encoder->enc_repair_timeout, &timeout);
+	} else {
+		timeout = encoder->enc_repair_timeout;
+	}
+
+	nck_timer_rearm(encoder->repair_timeout_handle, &timeout);
+}
+
 static void enc_repair_timeout(struct nck_timer_entry *entry, void *context, int success) {
 	UNUSED(entry);
 	if (success) {
@@ -112,7 +137,7 @@ static void enc_repair_timeout(struct nck_timer_entry *entry, void *context, int
 			encoder->to_send += 1;
 			container->to_send_cont += 1;
 
-			nck_timer_rearm(encoder->repair_timeout_handle, &encoder->enc_repair_timeout);
+			nck_codarq_enc_rearm_repair_timeout(encoder);
 			nck_trigger_call(&container->codarq_encoder->on_coded_ready);
 		}
 	}
@@ -121,7 +146,6 @@ static void enc_repair_timeout(struct nck_timer_entry *entry, void *context, int
 
 enc_container *nck_codarq_enc_start_next_generation(struct nck_codarq_enc *encoder, uint32_t generation) {
 	enc_container *container;
-	enc_container *cont_tmp;
 	container = malloc(sizeof(*container));
 	memset(container, 0, sizeof(*container));
 
@@ -130,20 +154,14 @@ enc_container *nck_codarq_enc_start_next_generation(struct nck_codarq_enc *encod
 	container->rank = 0;
 	container->last_seqno = 0;
 	container->to_send_cont = 0;
-	container->coder = kodo_build_encoder(encoder->factory);
+	container->coder = kodo_encoder_pool_get(&encoder->pool);
 
-	container->buffer = malloc(encoder->block_size);
-	memset(container->buffer, 0, encoder->block_size);
+	container->buffer = buffer_pool_get(&encoder->buffers);
 
 	encoder->num_containers += 1;
 
-	INIT_LIST_HEAD(&container->list);
-
-	// We ensure that the containers are placed in ascending order of the generation
-	list_for_each_entry(cont_tmp, &encoder->container_list, list) {
-		if (cont_tmp->generation > generation) break;
-	}
-	list_add_before(&container->list, &cont_tmp->list);
+	// generations are created in ascending order, so the span never exceeds the limit
+	gen_table_insert(&encoder->containers, generation, container);
 
 	nck_codarq_update_encoder_stat(encoder);
 
@@ -162,9 +180,11 @@ struct nck_codarq_enc *nck_codarq_enc(krlnc_encoder_factory_t factory, struct nc
 	result = malloc(sizeof(*result));
 	memset(result, 0, sizeof(*result));
 	nck_trigger_init(&result->on_coded_ready);
+	rtt_init(&result->rtt);
 
 	result->symbols = krlnc_encoder_factory_symbols(factory);
 	result->factory = factory;
+	kodo_encoder_pool_init(&result->pool, factory);
 	result->block_size = block_size;
 
 	result->seqno = 0;
@@ -178,14 +198,15 @@ struct nck_codarq_enc *nck_codarq_enc(krlnc_encoder_factory_t factory, struct nc
 		result->repair_timeout_handle = NULL;
 	}
 
-	INIT_LIST_HEAD(&(result->container_list));
+	gen_table_init(&result->containers, 8);
+	buffer_pool_init(&result->buffers, block_size, 4);
 
 	result->source_size = krlnc_encoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_encoder_payload_size(enc) + 4 + 2 + 4;
+	result->coded_size = kodo_encoder_payload_size(enc) + 4 + 2 + 4;
 	result->feedback_size = 1408;
 	result->timer = timer;
 
-	krlnc_delete_encoder(enc);
+	kodo_encoder_pool_put(&result->pool, enc);
 
 	return result;
 }
@@ -196,7 +217,7 @@ void nck_codarq_set_redundancy(struct nck_codarq_enc *encoder, uint16_t redundan
 }
 
 EXPORT
-void nck_codarq_set_enc_max_active_containers(struct nck_codarq_enc *encoder, uint8_t max_active_containers) {
+void nck_codarq_set_enc_max_active_containers(struct nck_codarq_enc *encoder, uint32_t max_active_containers) {
 	encoder->max_active_containers = max_active_containers;
 }
 
@@ -209,25 +230,56 @@ void nck_codarq_set_enc_repair_timeout(struct nck_codarq_enc *encoder, const str
 	}
 }
 
+EXPORT
+void nck_codarq_set_enc_adaptive_timeout(struct nck_codarq_enc *encoder, int adaptive_timeout) {
+	encoder->adaptive_timeout = adaptive_timeout;
+}
+
 
 void nck_codarq_enc_container_del(enc_container *container) {
 	container->codarq_encoder->num_containers -= 1;
-	list_del(&container->list);
-	krlnc_delete_encoder(container->coder);
-	free(container->buffer);
+	gen_table_remove(&container->codarq_encoder->containers, container->generation);
+	kodo_encoder_pool_put(&container->codarq_encoder->pool, container->coder);
+	buffer_pool_put(&container->codarq_encoder->buffers, container->buffer);
 	free(container);
 }
 
 EXPORT
 void nck_codarq_enc_free(struct nck_codarq_enc *encoder) {
-	enc_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &encoder->container_list, list) {
+	enc_container *cont_tmp;
+	uint32_t gen;
+
+	gen_table_for_each(&encoder->containers, gen, cont_tmp) {
 		nck_codarq_enc_container_del(cont_tmp);
 	}
-	krlnc_delete_encoder_factory(encoder->factory);
+	gen_table_free(&encoder->containers);
+	buffer_pool_free(&encoder->buffers);
+	kodo_encoder_pool_free(&encoder->pool);
+	kodo_delete_encoder_factory(encoder->factory);
 	free(encoder);
 }
 
+EXPORT
+int nck_codarq_enc_reset(struct nck_codarq_enc *encoder) {
+	enc_container *cont_tmp;
+	uint32_t gen;
+
+	gen_table_for_each(&encoder->containers, gen, cont_tmp) {
+		nck_codarq_enc_container_del(cont_tmp);
+	}
+	nck_codarq_update_encoder_stat(encoder);
+
+	nck_timer_cancel(encoder->repair_timeout_handle);
+	rtt_init(&encoder->rtt);
+
+	encoder->seqno = 0;
+	encoder->to_send = 0;
+	encoder->gen_oldest = 0;
+	encoder->gen_newest = 0;
+
+	return 0;
+}
+
 EXPORT
 int nck_codarq_enc_has_coded(struct nck_codarq_enc *encoder) {
 	return encoder->to_send >= 1;
@@ -262,6 +314,7 @@ void nck_codarq_enc_flush_coded(struct nck_codarq_enc *encoder) {
 EXPORT
 int nck_codarq_enc_get_coded(struct nck_codarq_enc *encoder, struct sk_buff *packet) {
 	enc_container *container;
+	uint32_t gen;
 	int found = 0;
 
 	if (!_has_coded(encoder)) {
@@ -269,7 +322,7 @@ int nck_codarq_enc_get_coded(struct nck_codarq_enc *encoder, struct sk_buff *pac
 	}
 
 	// Skip to the container that has coded pkts
-	list_for_each_entry(container, &encoder->container_list, list) {
+	gen_table_for_each(&encoder->containers, gen, container) {
 		if (nck_codarq_enc_cont_has_coded(container)) {
 			found = 1;
 			break;
@@ -293,11 +346,17 @@ int nck_codarq_enc_get_coded(struct nck_codarq_enc *encoder, struct sk_buff *pac
 	container->to_send_cont -= 1;
 	container->last_seqno = encoder->seqno;
 
+	if (encoder->adaptive_timeout) {
+		struct timeval now;
+		nck_timer_gettime(encoder->timer, &now);
+		rtt_sent(&encoder->rtt, encoder->seqno, &now);
+	}
+
 	if (encoder->repair_timeout_handle) {
 		if (_has_coded(encoder)) {
 			nck_timer_cancel(encoder->repair_timeout_handle);
 		} else {
-			nck_timer_rearm(encoder->repair_timeout_handle, &encoder->enc_repair_timeout);
+			nck_codarq_enc_rearm_repair_timeout(encoder);
 		}
 	}
 
@@ -313,7 +372,7 @@ int nck_codarq_enc_put_source(struct nck_codarq_enc *encoder, struct sk_buff *pa
 		return -1;
 	}
 
-	if (list_empty(&encoder->container_list) || encoder->cont_newest->rank == encoder->symbols) {
+	if (encoder->containers.count == 0 || encoder->cont_newest->rank == encoder->symbols) {
 		nck_codarq_enc_start_next_generation(encoder, encoder->gen_newest + 1);
 	}
 
@@ -364,7 +423,7 @@ static void enc_cont_put_feedback(enc_container *container, uint16_t rank_diff,
 
 EXPORT
 int nck_codarq_enc_put_feedback(struct nck_codarq_enc *encoder, struct sk_buff *packet) {
-	enc_container *cont_tmp, *cont_tmp_safe;
+	enc_container *cont_tmp;
 	uint32_t decoded_gen, num_dec_containers, rx_gen, rx_seq;
 	uint16_t rx_rank_diff;
 
@@ -372,13 +431,20 @@ int nck_codarq_enc_put_feedback(struct nck_codarq_enc *encoder, struct sk_buff *
 	num_dec_containers = skb_pull_u32(packet);
 	rx_seq = skb_pull_u32(packet);
 
+	// the decoder answers every packet right away, the repeats after its
+	// fb_timeout echo a seqno that gave a sample already
+	if (encoder->adaptive_timeout) {
+		struct timeval now;
+		nck_timer_gettime(encoder->timer, &now);
+		rtt_acked(&encoder->rtt, rx_seq, &now, NULL, NULL);
+	}
+
 	// delete all generations which are not necessary anymore
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &encoder->container_list, list) {
-		if (cont_tmp->generation <= decoded_gen) {
-			encoder->to_send -= cont_tmp->to_send_cont;
-			cont_tmp->to_send_cont = 0;
-			nck_codarq_enc_container_del(cont_tmp);
-		}
+	while ((cont_tmp = gen_table_oldest(&encoder->containers)) != NULL &&
+	       cont_tmp->generation <= decoded_gen) {
+		encoder->to_send -= cont_tmp->to_send_cont;
+		cont_tmp->to_send_cont = 0;
+		nck_codarq_enc_container_del(cont_tmp);
 	}
 
 	nck_codarq_update_encoder_stat(encoder);
@@ -388,11 +454,9 @@ int nck_codarq_enc_put_feedback(struct nck_codarq_enc *encoder, struct sk_buff *
 		rx_gen = skb_pull_u32(packet);
 		rx_rank_diff = skb_pull_u16(packet);
 
-		list_for_each_entry(cont_tmp, &encoder->container_list, list) {
-			if (cont_tmp->generation == rx_gen) {
-				enc_cont_put_feedback(cont_tmp, rx_rank_diff, rx_seq);
-				break;
-			}
+		cont_tmp = gen_table_get(&encoder->containers, rx_gen);
+		if (cont_tmp) {
+			enc_cont_put_feedback(cont_tmp, rx_rank_diff, rx_seq);
 		}
 	}
 
@@ -404,7 +468,7 @@ int nck_codarq_enc_put_feedback(struct nck_codarq_enc *encoder, struct sk_buff *
 		if (_has_coded(encoder)) {
 			nck_timer_cancel(encoder->repair_timeout_handle);
 		} else {
-			nck_timer_rearm(encoder->repair_timeout_handle, &encoder->enc_repair_timeout);
+			nck_codarq_enc_rearm_repair_timeout(encoder);
 		}
 	}
 
@@ -14,6 +14,9 @@
 #ifdef ENABLE_REP
   #include <nckernel/rep.h>
 #endif
+#ifdef ENABLE_AGGREGATE
+  #include <nckernel/aggregate.h>
+#endif
 #ifdef ENABLE_NOACK
   #include <nckernel/noack.h>
 #endif
@@ -59,6 +62,10 @@ static struct {
 	{"nocode", nck_nocode_create_enc, nck_nocode_create_dec, nck_nocode_create_rec,
 		"Sends source packets without any modification."},
 #endif
+#ifdef ENABLE_AGGREGATE
+	{"aggregate", nck_aggregate_create_enc, nck_aggregate_create_dec, NULL,
+		"Packs small packets into one coded packet and splits large packets."},
+#endif
 #ifdef ENABLE_REP
 	{"rep", nck_rep_create_enc, nck_rep_create_dec, nck_rep_create_rec,
 		"Implementation of a simple repetition code."},
@@ -173,6 +180,26 @@ int nck_parse_s32(int32_t *value, const char *name)
 	}
 }
 
+int nck_parse_s32_range(int32_t *low, int32_t *high, const char *name)
+{
+	char dummy;
+	int32_t buffer_low, buffer_high;
+	if (name == NULL || !strcmp(name, "")) {
+		return 0;
+	} else if (sscanf(name, "%d:%d%c", &buffer_low, &buffer_high, &dummy) == 2) {
+		if (buffer_low > buffer_high)
+			return -1;
+		*low = buffer_low;
+		*high = buffer_high;
+		return 0;
+	} else if (sscanf(name, "%d%c", &buffer_high, &dummy) == 1) {
+		*high = buffer_high;
+		return 0;
+	} else {
+		return -1;
+	}
+}
+
 int nck_parse_u16(uint16_t *value, const char *name)
 {
 	char dummy;
@@ -336,6 +363,323 @@ int nck_create_recoder(struct nck_recoder *recoder, struct nck_timer *timer, voi
 	return -1;
 }
 
+enum config_type {
+	CONFIG_NONE,
+	CONFIG_U32,
+	CONFIG_U16,
+	CONFIG_U8,
+	CONFIG_TIMEVAL,
+};
+
+/**
+ * struct config_option - Option of a compiled configuration.
+ * @name: Name of the option
+ * @value: Value from the original getter or NULL if it is not set
+ * @type: Type of @parsed, CONFIG_NONE if no typed getter read the option
+ * @parsed: The value as it was parsed by the first typed getter
+ */
+struct config_option {
+	const char *name;
+	const char *value;
+	enum config_type type;
+	union {
+		uint32_t u32;
+		uint16_t u16;
+		uint8_t u8;
+		struct timeval timeval;
+	} parsed;
+};
+
+#define CONFIG_SHARED_MAX 4
+
+/**
+ * struct config_shared - Object shared by all coders of a configuration.
+ * @key: Name of the object
+ * @object: The shared object, e.g. a kodo factory
+ * @release: Drops the reference of the configuration
+ */
+struct config_shared {
+	const char *key;
+	void *object;
+	void (*release)(void *object);
+};
+
+/**
+ * struct nck_config - Compiled configuration of a protocol.
+ * @protocol: Index of the protocol in the protocol list
+ * @options: Options read during validation, sorted by name
+ * @count: Number of entries in @options
+ * @capacity: Allocated entries in @options
+ * @shared: Objects that the coders share, see nck_config_share()
+ * @compiling: Whether options that are read are added to @options
+ * @context: Context of the original getter
+ * @get_opt: The original getter, asked for options missing in @options
+ */
+struct nck_config {
+	int protocol;
+	struct config_option *options;
+	size_t count;
+	size_t capacity;
+
+	struct config_shared shared[CONFIG_SHARED_MAX];
+
+	int compiling;
+	void *context;
+	nck_opt_getter get_opt;
+};
+
+static int config_option_cmp(const void *key, const void *entry)
+{
+	return strcmp((const char *)key, ((const struct config_option *)entry)->name);
+}
+
+static struct config_option *config_find(const struct nck_config *config, const char *name)
+{
+	if (!config->count)
+		return NULL;
+
+	return bsearch(name, config->options, config->count, sizeof(*config->options), config_option_cmp);
+}
+
+/**
+ * config_insert - Copy an option into the sorted table
+ *
+ * Return: the inserted entry or NULL if no memory is available
+ */
+static struct config_option *config_insert(struct nck_config *config, const char *name, const char *value)
+{
+	struct config_option *opt, *options;
+	char *name_copy, *value_copy = NULL;
+	size_t pos, capacity;
+
+	if (config->count == config->capacity) {
+		capacity = max_t(size_t, 16, config->capacity * 2);
+		options = realloc(config->options, capacity * sizeof(*options));
+		if (!options)
+			return NULL;
+		config->options = options;
+		config->capacity = capacity;
+	}
+
+	name_copy = strdup(name);
+	if (value)
+		value_copy = strdup(value);
+	if (!name_copy || (value && !value_copy)) {
+		free(name_copy);
+		free(value_copy);
+		return NULL;
+	}
+
+	for (pos = 0; pos < config->count; ++pos) {
+		if (strcmp(name, config->options[pos].name) < 0)
+			break;
+	}
+
+	opt = &config->options[pos];
+	memmove(opt + 1, opt, (config->count - pos) * sizeof(*opt));
+	memset(opt, 0, sizeof(*opt));
+	opt->name = name_copy;
+	opt->value = value_copy;
+	config->count += 1;
+
+	return opt;
+}
+
+static const char *config_get_opt(void *context, const char *name)
+{
+	struct nck_config *config = (struct nck_config *)context;
+	struct config_option *opt;
+	const char *value;
+
+	opt = config_find(config, name);
+	if (opt)
+		return opt->value;
+
+	// after compiling the table is final, options that the validation did
+	// not read still come from the original getter
+	value = config->get_opt(config->context, name);
+	if (!config->compiling)
+		return value;
+
+	// without memory for the copy the option is simply not cached
+	opt = config_insert(config, name, value);
+	return opt ? opt->value : value;
+}
+
+/*
+ * The first typed read of a set option while compiling keeps the parsed
+ * value, so coders created from the configuration skip the parsing. Unset
+ * options are not stored because every coder has its own default.
+ */
+#define CONFIG_GET_OPT(suffix, ctype, field, tag) \
+	int nck_get_opt_ ## suffix(ctype *value, void *context, nck_opt_getter get_opt, const char *name) \
+	{ \
+		struct nck_config *config = NULL; \
+		struct config_option *opt; \
+		const char *text; \
+		\
+		if (get_opt == config_get_opt) { \
+			config = (struct nck_config *)context; \
+			opt = config_find(config, name); \
+			if (opt && opt->type == tag) { \
+				*value = opt->parsed.field; \
+				return 0; \
+			} \
+		} \
+		\
+		text = get_opt(context, name); \
+		if (nck_parse_ ## suffix(value, text)) \
+			return -1; \
+		\
+		if (config && config->compiling && text && *text) { \
+			opt = config_find(config, name); \
+			if (opt && opt->type == CONFIG_NONE) { \
+				opt->type = tag; \
+				opt->parsed.field = *value; \
+			} \
+		} \
+		return 0; \
+	}
+
+CONFIG_GET_OPT(u32, uint32_t, u32, CONFIG_U32)
+CONFIG_GET_OPT(u16, uint16_t, u16, CONFIG_U16)
+CONFIG_GET_OPT(u8, uint8_t, u8, CONFIG_U8)
+CONFIG_GET_OPT(timeval, struct timeval, timeval, CONFIG_TIMEVAL)
+
+void *nck_config_shared(void *context, nck_opt_getter get_opt, const char *key)
+{
+	struct nck_config *config = (struct nck_config *)context;
+	size_t i;
+
+	if (get_opt != config_get_opt)
+		return NULL;
+
+	for (i = 0; i < CONFIG_SHARED_MAX && config->shared[i].key; ++i) {
+		if (!strcmp(config->shared[i].key, key))
+			return config->shared[i].object;
+	}
+	return NULL;
+}
+
+int nck_config_share(void *context, nck_opt_getter get_opt, const char *key,
+		     void *object, void (*release)(void *object))
+{
+	struct nck_config *config = (struct nck_config *)context;
+	size_t i;
+
+	// coders created later only read the configuration
+	if (get_opt != config_get_opt || !config->compiling)
+		return -1;
+
+	for (i = 0; i < CONFIG_SHARED_MAX; ++i) {
+		if (config->shared[i].key == NULL) {
+			config->shared[i].key = key;
+			config->shared[i].object = object;
+			config->shared[i].release = release;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+EXPORT
+struct nck_config *nck_config_compile(const char *protocol, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
+{
+	struct nck_config *config;
+	struct nck_encoder encoder;
+	struct nck_decoder decoder;
+	struct nck_recoder recoder;
+	int index = 0;
+
+	if (!get_opt)
+		get_opt = stub_get_opt;
+
+	if (protocol == NULL)
+		protocol = get_opt(context, "protocol");
+
+	if (protocol != NULL) {
+		index = nck_protocol_find(protocol);
+		if (index < 0) {
+			fprintf(stderr, "Unknown protocol: %s\n", protocol);
+			return NULL;
+		}
+	}
+
+	config = malloc(sizeof(*config));
+	if (!config)
+		return NULL;
+
+	memset(config, 0, sizeof(*config));
+	config->protocol = index;
+	config->compiling = 1;
+	config->context = context;
+	config->get_opt = get_opt;
+
+	// the coders read every option they need, which fills the table
+	assert(protocols[index].create_encoder != NULL);
+	if (protocols[index].create_encoder(&encoder, timer, config, config_get_opt))
+		goto fail;
+	nck_free(&encoder);
+
+	assert(protocols[index].create_decoder != NULL);
+	if (protocols[index].create_decoder(&decoder, timer, config, config_get_opt))
+		goto fail;
+	nck_free(&decoder);
+
+	if (protocols[index].create_recoder) {
+		if (protocols[index].create_recoder(&recoder, timer, config, config_get_opt))
+			goto fail;
+		nck_free(&recoder);
+	}
+
+	config->compiling = 0;
+	return config;
+
+fail:
+	nck_config_free(config);
+	return NULL;
+}
+
+EXPORT
+void nck_config_free(struct nck_config *config)
+{
+	size_t i;
+
+	for (i = 0; i < CONFIG_SHARED_MAX && config->shared[i].key; ++i)
+		config->shared[i].release(config->shared[i].object);
+
+	for (i = 0; i < config->count; ++i) {
+		free((char *)config->options[i].name);
+		free((char *)config->options[i].value);
+	}
+
+	free(config->options);
+	free(config);
+}
+
+EXPORT
+int nck_create_encoder_from_config(struct nck_encoder *encoder, struct nck_timer *timer, const struct nck_config *config)
+{
+	return protocols[config->protocol].create_encoder(encoder, timer, (void *)config, config_get_opt);
+}
+
+EXPORT
+int nck_create_decoder_from_config(struct nck_decoder *decoder, struct nck_timer *timer, const struct nck_config *config)
+{
+	return protocols[config->protocol].create_decoder(decoder, timer, (void *)config, config_get_opt);
+}
+
+EXPORT
+int nck_create_recoder_from_config(struct nck_recoder *recoder, struct nck_timer *timer, const struct nck_config *config)
+{
+	if (protocols[config->protocol].create_recoder == NULL) {
+		fprintf(stderr, "Protocol %s has no recoder\n", protocols[config->protocol].name);
+		return -1;
+	}
+
+	return protocols[config->protocol].create_recoder(recoder, timer, (void *)config, config_get_opt);
+}
+
 const char *nck_option_from_array(void *context, const char *name)
 {
 	struct nck_option_value *opt;
@@ -11,16 +11,58 @@
 
 #include <sys/time.h>
 
+#include <nckernel/nckernel.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int nck_parse_u32(uint32_t *value, const char *text);
 int nck_parse_s32(int32_t *value, const char *text);
+/* parses "low:high" or just "high", keeping the previous low bound */
+int nck_parse_s32_range(int32_t *low, int32_t *high, const char *text);
 int nck_parse_u16(uint16_t *value, const char *text);
 int nck_parse_u8(uint8_t *value, const char *text);
 int nck_parse_timeval(struct timeval *value, const char *text);
 
+/*
+ * Read and parse an option like get_opt() and nck_parse_*(). Coders created
+ * from a compiled configuration get the value that was parsed while
+ * compiling, see nck_config_compile(). An unset option leaves @value alone.
+ */
+int nck_get_opt_u32(uint32_t *value, void *context, nck_opt_getter get_opt, const char *name);
+int nck_get_opt_u16(uint16_t *value, void *context, nck_opt_getter get_opt, const char *name);
+int nck_get_opt_u8(uint8_t *value, void *context, nck_opt_getter get_opt, const char *name);
+int nck_get_opt_timeval(struct timeval *value, void *context, nck_opt_getter get_opt, const char *name);
+
+/**
+ * nck_config_shared - Find an object shared by the coders of a configuration
+ * @context: Context that was passed to the create function
+ * @get_opt: Getter that was passed to the create function
+ * @key: Name of the object
+ *
+ * Return: the object that was stored with nck_config_share() or NULL if the
+ *  coder is not created from a compiled configuration
+ */
+void *nck_config_shared(void *context, nck_opt_getter get_opt, const char *key);
+
+/**
+ * nck_config_share - Store an object for the coders of a configuration
+ * @context: Context that was passed to the create function
+ * @get_opt: Getter that was passed to the create function
+ * @key: Name of the object, must be a constant string
+ * @object: Object that is shared
+ * @release: Called by nck_config_free() to drop the reference of the
+ *  configuration
+ *
+ * Objects can only be stored while nck_config_compile() validates the
+ * options.
+ *
+ * Return: 0 if the configuration keeps a reference to @object, -1 otherwise
+ */
+int nck_config_share(void *context, nck_opt_getter get_opt, const char *key,
+		     void *object, void (*release)(void *object));
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -83,7 +83,7 @@ struct nck_gack_dec *nck_gack_dec(krlnc_decoder_factory_t factory)
 	krlnc_decoder_set_mutable_symbols(result->coder, result->buffer, block_size);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(result->coder) + 6;
+	result->coded_size = kodo_decoder_payload_size(result->coder) + 6;
 	result->feedback_size = 6;
 
 	result->on_source_ready = (struct nck_trigger){0};
@@ -96,11 +96,26 @@ EXPORT
 void nck_gack_dec_free(struct nck_gack_dec *decoder)
 {
 	krlnc_delete_decoder(decoder->coder);
-	krlnc_delete_decoder_factory(decoder->factory);
+	kodo_delete_decoder_factory(decoder->factory);
 	free(decoder->buffer);
 	free(decoder);
 }
 
+EXPORT
+int nck_gack_dec_reset(struct nck_gack_dec *decoder)
+{
+	decoder->generation = 0;
+	decoder->index = 0;
+	decoder->flush = 0;
+	decoder->feedback_generation = 0;
+
+	krlnc_delete_decoder(decoder->coder);
+	decoder->coder = kodo_build_decoder(decoder->factory);
+	krlnc_decoder_set_mutable_symbols(decoder->coder, decoder->buffer, krlnc_decoder_block_size(decoder->coder));
+
+	return 0;
+}
+
 EXPORT
 int nck_gack_dec_has_source(struct nck_gack_dec *decoder)
 {
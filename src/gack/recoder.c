@@ -93,7 +93,7 @@ struct nck_gack_rec *nck_gack_rec(krlnc_decoder_factory_t factory)
 	krlnc_decoder_set_mutable_symbols(result->coder, result->buffer, block_size);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(result->coder) + 6;
+	result->coded_size = kodo_decoder_payload_size(result->coder) + 6;
 	result->feedback_size = 6;
 
 	result->on_source_ready = (struct nck_trigger){0};
@@ -107,11 +107,21 @@ EXPORT
 void nck_gack_rec_free(struct nck_gack_rec *recoder)
 {
 	krlnc_delete_decoder(recoder->coder);
-	krlnc_delete_decoder_factory(recoder->factory);
+	kodo_delete_decoder_factory(recoder->factory);
 	free(recoder->buffer);
 	free(recoder);
 }
 
+EXPORT
+int nck_gack_rec_reset(struct nck_gack_rec *recoder)
+{
+	rec_reset(recoder, 0);
+	recoder->complete = 0;
+	recoder->feedback_generation = 0;
+	recoder->feedback_rank = 0;
+	return 0;
+}
+
 /**
  * Returns true when there are no packets received by the recoder yet, i.e. rank=0.
  */
@@ -64,7 +64,7 @@ struct nck_gsaw_enc *nck_gsaw_enc(krlnc_encoder_factory_t factory, int redundanc
 	memset(result->buffer, 0, block_size);
 
 	result->source_size = krlnc_encoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_encoder_payload_size(result->coder) + 6;
+	result->coded_size = kodo_encoder_payload_size(result->coder) + 6;
 	result->feedback_size = 6;
 
 	result->on_coded_ready = (struct nck_trigger){0};
@@ -76,11 +76,27 @@ EXPORT
 void nck_gsaw_enc_free(struct nck_gsaw_enc *encoder)
 {
 	krlnc_delete_encoder(encoder->coder);
-	krlnc_delete_encoder_factory(encoder->factory);
+	kodo_delete_encoder_factory(encoder->factory);
 	free(encoder->buffer);
 	free(encoder);
 }
 
+EXPORT
+int nck_gsaw_enc_reset(struct nck_gsaw_enc *encoder)
+{
+	encoder->generation = 1;
+	encoder->rank = 0;
+	encoder->full = 0;
+	encoder->complete = 0;
+	encoder->limit = 0;
+
+	krlnc_delete_encoder(encoder->coder);
+	encoder->coder = kodo_build_encoder(encoder->factory);
+	memset(encoder->buffer, 0, krlnc_encoder_block_size(encoder->coder));
+
+	return 0;
+}
+
 EXPORT
 int nck_gsaw_enc_has_coded(struct nck_gsaw_enc *encoder)
 {
@@ -1,15 +1,41 @@
 #include <arpa/inet.h>
 #include <nckernel/skb.h>
 #include <stdint.h>
+#include <string.h>
 #include "../private.h"
 #include "packet.h"
 #include "common.h"
 
+#include <algorithm>
+
 struct kodo_header {
 	uint32_t seqno;
 	uint8_t systematic_flag;
 } __packed;
 
+static char *nck_interflow_sw_common_describe_seed_packet(struct sk_buff *packet)
+{
+	static char debug[4096];
+	struct interflow_sw_coded_packet *interflow_sw_coded_packet;
+	struct interflow_sw_seed_header *seed_header;
+
+	interflow_sw_coded_packet = (struct interflow_sw_coded_packet *) packet->data;
+	seed_header = (struct interflow_sw_seed_header *) (interflow_sw_coded_packet + 1);
+
+	if (packet->len < sizeof(*interflow_sw_coded_packet) + sizeof(*seed_header))
+		return (char *)"\"error\":\"too short seed packet\"";
+
+	snprintf(debug, sizeof(debug), "\"packetno\":% 5d, \"seqno\":% 5d, "
+		 "\"flags\": { \"feedback_requested\": %s, \"flush\": %s }, "
+		 "\"coded\":true, \"seed\":\"%08x\", \"first\":%d, \"count\":%d",
+		 ntohs(interflow_sw_coded_packet->packet_no), ntohl(seed_header->seqno),
+		 (interflow_sw_coded_packet->flags & INTERFLOW_SW_CODED_PACKET_FEEDBACK_REQUESTED) ? "true" : "false",
+		 (interflow_sw_coded_packet->flags & INTERFLOW_SW_CODED_PACKET_FLUSH) ? "true" : "false",
+		 ntohl(seed_header->seed), ntohs(seed_header->first), ntohs(seed_header->count));
+
+	return debug;
+}
+
 static char *nck_interflow_sw_common_describe_coded_packet(struct sk_buff *packet, int symbols)
 {
 	static char debug[4096];
@@ -25,6 +51,9 @@ static char *nck_interflow_sw_common_describe_coded_packet(struct sk_buff *packe
 	kodo_header = (struct kodo_header *) (interflow_sw_coded_packet + 1);
 	coefficients = (uint8_t *) (kodo_header + 1);
 
+	if (interflow_sw_coded_packet->flags & INTERFLOW_SW_CODED_PACKET_SEED)
+		return nck_interflow_sw_common_describe_seed_packet(packet);
+
 	if (packet->len < sizeof(*interflow_sw_coded_packet) + sizeof(kodo_header) + symbols)
 		return (char *)"\"error\":\"too short coded packet\"";
 
@@ -90,6 +119,38 @@ static char *nck_interflow_sw_common_describe_feedback_packet(struct sk_buff *pa
 	return debug;
 }
 
+static char *nck_interflow_sw_common_describe_mixed_packet(struct sk_buff *packet)
+{
+	struct interflow_sw_mixed_packet *interflow_sw_mixed_packet;
+	struct interflow_sw_mixed_entry *entry;
+	static char debug[4096];
+	int i, len = sizeof(debug), pos = 0;
+
+	debug[0] = 0;
+
+	interflow_sw_mixed_packet = (struct interflow_sw_mixed_packet *)packet->data;
+	entry = (struct interflow_sw_mixed_entry *)(interflow_sw_mixed_packet + 1);
+
+	if (packet->len < sizeof(*interflow_sw_mixed_packet) ||
+	    packet->len < sizeof(*interflow_sw_mixed_packet) + interflow_sw_mixed_packet->count * sizeof(*entry))
+		return (char *)"\"error\":\"too short mixed packet\"";
+
+	pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"mixed\":true, \"length\":% 5d, \"packets\":[",
+			ntohs(interflow_sw_mixed_packet->length));
+
+	for (i = 0; i < interflow_sw_mixed_packet->count && pos < len; i++, entry++) {
+		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "%s{\"flow\":%d, \"coefficient\":%d, \"length\":%d, \"packet_no\":%d, \"hash\":\"%08x\"}",
+				i ? ", " : "", entry->flow, entry->coefficient, ntohs(entry->length),
+				ntohs(entry->packet_no), ntohl(entry->hash));
+	}
+
+	pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "]");
+
+	debug[sizeof(debug) - 1] = 0;
+
+	return debug;
+}
+
 EXPORT
 char *nck_interflow_sw_common_describe_packet(struct sk_buff *packet, int symbols)
 {
@@ -105,7 +166,67 @@ char *nck_interflow_sw_common_describe_packet(struct sk_buff *packet, int symbol
 	case INTERFLOW_SW_PACKET_TYPE_FEEDBACK:
 		return nck_interflow_sw_common_describe_feedback_packet(packet, symbols);
 		break;
+	case INTERFLOW_SW_PACKET_TYPE_MIXED:
+		return nck_interflow_sw_common_describe_mixed_packet(packet);
+		break;
 	}
 
 	return (char *)"\"error\":\"unknown data type\"";
 }
+
+void nck_interflow_sw_common_seed_coefficients(uint32_t seed, uint8_t *coefficients, uint32_t count)
+{
+	// xorshift32, the state must never become zero
+	uint32_t state = seed ? seed : 0x9e3779b9U;
+	uint32_t i = 0;
+
+	while (i < count) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		// a zero coefficient would drop the symbol from the combination
+		if (state & 0xff)
+			coefficients[i++] = state & 0xff;
+	}
+}
+
+int nck_interflow_sw_common_expand_seed(struct sk_buff *packet, struct sk_buff *expanded,
+					   uint8_t *buffer, size_t size, uint32_t symbols)
+{
+	struct interflow_sw_seed_header seed_header;
+	struct kodo_header *kodo_header = (struct kodo_header *)buffer;
+	uint8_t *coefficients = (uint8_t *)(kodo_header + 1);
+	uint8_t *symbol = coefficients + symbols;
+	uint32_t first, count;
+	size_t symbol_size;
+
+	if (size < sizeof(*kodo_header) + symbols || !pskb_may_pull(packet, sizeof(seed_header)))
+		return -1;
+
+	symbol_size = size - sizeof(*kodo_header) - symbols;
+
+	memcpy(&seed_header, packet->data, sizeof(seed_header));
+	skb_pull(packet, sizeof(seed_header));
+
+	first = ntohs(seed_header.first);
+	count = ntohs(seed_header.count);
+	if (first >= symbols || count > symbols || packet->len > symbol_size)
+		return -1;
+
+	kodo_header->seqno = seed_header.seqno;
+	kodo_header->systematic_flag = 0;
+
+	// the generated coefficients are placed at their window slots
+	memset(coefficients, 0, symbols);
+	nck_interflow_sw_common_seed_coefficients(ntohl(seed_header.seed), coefficients, count);
+	std::rotate(coefficients, coefficients + (symbols - first) % symbols, coefficients + symbols);
+
+	memcpy(symbol, packet->data, packet->len);
+	memset(symbol + packet->len, 0, symbol_size - packet->len);
+
+	skb_new(expanded, buffer, size);
+	skb_put(expanded, size);
+
+	return 0;
+}
@@ -1 +1,26 @@
 char *nck_interflow_sw_common_describe_packet(struct sk_buff *packet, int symbols);
+
+/**
+ * nck_sw_common_seed_coefficients - generate the coefficients of a seed header
+ * @seed: seed that was sent in the struct sw_seed_header
+ * @coefficients: receives @count nonzero coefficients
+ * @count: number of coefficients to generate
+ *
+ * The generator is part of the packet format, encoder and decoder must
+ * produce the same sequence on every platform.
+ */
+void nck_interflow_sw_common_seed_coefficients(uint32_t seed, uint8_t *coefficients, uint32_t count);
+
+/**
+ * nck_sw_common_expand_seed - rebuild the kodo header of a seed packet
+ * @packet: packet after the struct sw_coded_packet
+ * @expanded: initialized to point to the rebuilt packet in @buffer
+ * @buffer: memory of @size bytes for the rebuilt packet
+ * @size: payload size of the kodo coder
+ * @symbols: number of symbols in the window
+ *
+ * Return: 0 on success, -1 if the packet is malformed or the coder does not
+ *  use the plain kodo header
+ */
+int nck_interflow_sw_common_expand_seed(struct sk_buff *packet, struct sk_buff *expanded,
+					   uint8_t *buffer, size_t size, uint32_t symbols);
@@ -17,6 +17,9 @@
 
 #include "../private.h"
 #include "../util/rate.h"
+#include "../util/repair_acc.h"
+#include "../util/bitmap.h"
+#include "../util/finite_field.h"
 #include "packet.h"
 #include "common.h"
 
@@ -24,6 +27,8 @@
 
 #include <boost/circular_buffer.hpp>
 
+#include <algorithm>
+
 typedef kodo_sliding_window::sliding_window_encoder::factory factory_t;
 typedef factory_t::pointer coder_t;
 
@@ -33,25 +38,32 @@ struct kodo_header {
 } __packed;
 
 struct nck_interflow_sw_enc {
-	nck_interflow_sw_enc(coder_t coder, int ord) :
-		coder(coder), source_size(coder->symbol_size()),
+	nck_interflow_sw_enc(uint32_t symbols, uint32_t symbol_size, int ord) :
+		factory(fifi::api::field::binary8, symbols, symbol_size),
+		coder(factory.build()), source_size(coder->symbol_size()),
 		coded_size(sizeof(struct interflow_sw_coded_packet) + coder->payload_size()),
 		feedback_size(sizeof(struct interflow_sw_feedback_packet) + DIV_ROUND_UP(coder->symbols(), 8)),
 		initialized(0), window_size(coder->symbols()),
 		cfg_systematic_phase(coder->symbols()), cfg_coded_phase(1),
+		seed_header(false), seed(rand()),
 		source_symbols(0), index(0), order(ord), first_missing(0),
 		feedback_only_on_repair(0), coded_retrans(0),
 		feedback_period(1), packet_count(0), systematic_time(coder->symbols()), coded_time(coder->symbols()),
 		max_tx_attempts(UINT8_MAX), tx_attempts(coder->symbols()), flush_attempts(0), flush_next(0),
-		packet_memory(0), coded_packets(1), timeout(), timeout_handle(), on_coded_ready(),
-		buffer(coder->block_size()), node_id(0), n_nodes(0)
+		unacked(BITMAP_WORDS(coder->symbols())),
+		packet_memory(0), coded_packets(1), coded_used(1),
+		timer(NULL), hist(NULL), timeout(), timeout_handle(), on_coded_ready(),
+		buffer(coder->block_size()), node_id(0), n_nodes(0), mix(NULL)
 	{
 		nck_trigger_init(&on_coded_ready);
 		rate_control_dual_init(&rc, cfg_systematic_phase, cfg_coded_phase);
+		rate_control_sent_log_reset(&sent_log);
+		repair_acc_init(&acc, 0, coder->symbols(), coder->symbol_size());
 
 		memset(&stats, 0, sizeof(stats));
 	}
 
+	factory_t factory;
 	coder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -65,6 +77,16 @@ struct nck_interflow_sw_enc {
 	// rate control
 	int cfg_systematic_phase, cfg_coded_phase;
 	struct rate_control rc;
+	struct rate_control_sent_log sent_log;
+
+	// incrementally maintained repair symbols
+	struct repair_acc acc;
+
+	// repair packets carry a seed instead of the coefficients
+	bool seed_header;
+	unsigned int seed;
+	std::vector<uint8_t> seed_factors;
+	std::vector<uint8_t *> seed_sources;
 
 	// total number of source packets to send
 	int source_symbols;
@@ -86,12 +108,24 @@ struct nck_interflow_sw_enc {
 	uint8_t flush_attempts;
 	uint8_t flush_next;
 
+	// symbols that were added or re-enabled and whose acknowledgement was
+	// not yet processed, feedback only needs to visit these and the losses
+	std::vector<uint64_t> unacked;
+
 	// keep track when we sent coded packets
 	int packet_memory;
 	boost::circular_buffer<uint16_t> coded_packets;
+	// scratch bitmap of the coded packets already used by one feedback
+	std::vector<uint64_t> coded_used;
 
 	struct nck_stats stats;
 
+	// optional histograms, the put time is kept for slots that were not sent yet
+	struct nck_timer *timer;
+	struct nck_histograms *hist;
+	std::vector<struct timeval> hist_put_time;
+	std::vector<uint64_t> hist_unsent;
+
 	struct timeval timeout;
 	struct nck_timer_entry *timeout_handle;
 
@@ -103,13 +137,17 @@ struct nck_interflow_sw_enc {
 	uint32_t node_id;
 	uint32_t n_nodes;
 
+	// remembers sent packets to extract other flows from mixed packets
+	struct nck_interflow_sw_mix *mix;
 };
 
 char *nck_interflow_sw_enc_debug(void *encoder);
 char *nck_interflow_sw_enc_describe_packet(void *encoder, struct sk_buff *packet);
 struct nck_stats *nck_interflow_sw_enc_get_stats(void *encoder);
+struct nck_histograms *nck_interflow_sw_enc_get_histograms(void *encoder);
 
-NCK_ENCODER_IMPL(nck_interflow_sw, nck_interflow_sw_enc_debug, nck_interflow_sw_enc_describe_packet, nck_interflow_sw_enc_get_stats)
+NCK_ENCODER_IMPL_EXT(nck_interflow_sw, nck_interflow_sw_enc_debug, nck_interflow_sw_enc_describe_packet,
+		     nck_interflow_sw_enc_get_stats, nck_interflow_sw_enc_get_histograms, NULL)
 
 EXPORT
 void nck_interflow_sw_enc_set_feedback_only_on_repair(struct nck_interflow_sw_enc *encoder, uint32_t feedback_only_on_repair)
@@ -127,6 +165,12 @@ void nck_interflow_sw_enc_set_n_nodes(struct nck_interflow_sw_enc *encoder, uint
 	encoder->n_nodes = n_nodes;
 }
 
+EXPORT
+void nck_interflow_sw_enc_set_mix(struct nck_interflow_sw_enc *encoder, struct nck_interflow_sw_mix *mix)
+{
+	encoder->mix = mix;
+}
+
 EXPORT
 void nck_interflow_sw_enc_set_sequence(struct nck_interflow_sw_enc *encoder, uint32_t sequence)
 {
@@ -165,6 +209,26 @@ void nck_interflow_sw_enc_set_redundancy(struct nck_interflow_sw_enc *encoder, i
 	rate_control_credit_change(&encoder->rc,  max_t(int32_t, 0, redundancy));
 }
 
+EXPORT
+void nck_interflow_sw_enc_set_adaptive_redundancy(struct nck_interflow_sw_enc *encoder, int32_t min_redundancy, int32_t max_redundancy)
+{
+	/* like for the fixed redundancy, the encoder must send at least as
+	 * many packets as it was given
+	 */
+	min_redundancy = max_t(int32_t, 0, min_redundancy);
+
+	if (encoder->rc.algo != RATE_CONTROL_ADAPTIVE) {
+		/* reject setting when already initialized */
+		if (encoder->initialized)
+			return;
+
+		rate_control_adaptive_init(&encoder->rc, encoder->coder->symbols(), min_redundancy, max_redundancy);
+		return;
+	}
+
+	rate_control_adaptive_change(&encoder->rc, min_redundancy, max_redundancy);
+}
+
 EXPORT
 void nck_interflow_sw_enc_set_systematic_phase(struct nck_interflow_sw_enc *encoder, uint32_t phase_length)
 {
@@ -223,10 +287,11 @@ void nck_interflow_sw_enc_set_memory(struct nck_interflow_sw_enc *encoder, uint3
 
 	if (memory_size == 0) {
 		// zero size is not supported
-		encoder->coded_packets.resize(1);
+		encoder->coded_packets.set_capacity(1);
 	} else {
-		encoder->coded_packets.resize(memory_size);
+		encoder->coded_packets.set_capacity(memory_size);
 	}
+	encoder->coded_used.resize(BITMAP_WORDS(encoder->coded_packets.capacity()));
 }
 
 EXPORT
@@ -242,6 +307,77 @@ void nck_interflow_sw_enc_set_tx_attempts(struct nck_interflow_sw_enc *encoder,
 		encoder->feedback_period = 1;
 }
 
+EXPORT
+void nck_interflow_sw_enc_set_incremental_repair(struct nck_interflow_sw_enc *encoder, uint32_t accumulators)
+{
+	auto coder = encoder->coder;
+
+	/* reject setting when already initialized */
+	if (encoder->initialized)
+		return;
+
+	/* the accumulated repair symbols are written with a full coefficient
+	 * vector, fall back to kodo if the header does not look like that
+	 */
+	if (encoder->header_size != sizeof(struct kodo_header) + coder->symbols())
+		accumulators = 0;
+
+	repair_acc_free(&encoder->acc);
+	repair_acc_init(&encoder->acc, accumulators, coder->symbols(), coder->symbol_size());
+}
+
+EXPORT
+void nck_interflow_sw_enc_set_seed_header(struct nck_interflow_sw_enc *encoder, int enable)
+{
+	auto coder = encoder->coder;
+
+	/* the decoder rebuilds the kodo header from the seed, this only works
+	 * if it looks like we expect and is larger than the seed header
+	 */
+	if (encoder->header_size != sizeof(struct kodo_header) + coder->symbols() ||
+	    encoder->header_size <= sizeof(struct interflow_sw_seed_header))
+		enable = 0;
+
+	encoder->seed_header = enable;
+	if (enable) {
+		binary8_init();
+		encoder->seed_factors.resize(coder->symbols());
+		encoder->seed_sources.resize(coder->symbols());
+	}
+}
+
+EXPORT
+void nck_interflow_sw_enc_set_histograms(struct nck_interflow_sw_enc *encoder, int enable)
+{
+	auto coder = encoder->coder;
+
+	if (!enable) {
+		free(encoder->hist);
+		encoder->hist = NULL;
+		return;
+	}
+
+	if (encoder->hist)
+		return;
+
+	encoder->hist = (struct nck_histograms *)calloc(1, sizeof(*encoder->hist));
+	encoder->hist_put_time.resize(coder->symbols());
+	encoder->hist_unsent.assign(BITMAP_WORDS(coder->symbols()), 0);
+}
+
+static void nck_interflow_sw_enc_enable_symbol(struct nck_interflow_sw_enc *encoder, uint32_t index)
+{
+	encoder->coder->enable_symbol(index);
+	bitmap_set(encoder->unacked.data(), index);
+	repair_acc_enter(&encoder->acc, index, &encoder->buffer[index * encoder->source_size]);
+}
+
+static void nck_interflow_sw_enc_disable_symbol(struct nck_interflow_sw_enc *encoder, uint32_t index)
+{
+	encoder->coder->disable_symbol(index);
+	repair_acc_leave(&encoder->acc, index, &encoder->buffer[index * encoder->source_size]);
+}
+
 static void encoder_timeout_flush(struct nck_timer_entry *entry, void *context, int success)
 {
 	UNUSED(entry);
@@ -271,10 +407,9 @@ struct nck_interflow_sw_enc *nck_interflow_sw_enc(uint32_t symbols, uint32_t sym
 		return NULL;
 	}
 
-	factory_t factory(fifi::api::field::binary8, symbols, symbol_size);
-
-	struct nck_interflow_sw_enc *result = new struct nck_interflow_sw_enc(factory.build(), ord);
-	result->header_size = factory.header_size();
+	struct nck_interflow_sw_enc *result = new struct nck_interflow_sw_enc(symbols, symbol_size, ord);
+	result->header_size = result->factory.header_size();
+	result->timer = timer;
 
 	if (timeout && timerisset(timeout)) {
 		assert(timer != NULL);
@@ -291,9 +426,47 @@ void nck_interflow_sw_enc_free(struct nck_interflow_sw_enc *encoder)
 		nck_timer_cancel(encoder->timeout_handle);
 		nck_timer_free(encoder->timeout_handle);
 	}
+	repair_acc_free(&encoder->acc);
+	free(encoder->hist);
 	delete encoder;
 }
 
+EXPORT
+int nck_interflow_sw_enc_reset(struct nck_interflow_sw_enc *encoder)
+{
+	nck_timer_cancel(encoder->timeout_handle);
+
+	/* kodo has no way to empty a sliding window encoder, we build a fresh
+	 * one from the factory of the encoder instead
+	 */
+	encoder->coder = encoder->factory.build();
+
+	encoder->initialized = 0;
+	encoder->source_symbols = 0;
+	encoder->index = 0;
+	encoder->first_missing = 0;
+	encoder->packet_count = 0;
+	encoder->flush_attempts = 0;
+	encoder->flush_next = 0;
+
+	std::fill(encoder->systematic_time.begin(), encoder->systematic_time.end(), 0);
+	std::fill(encoder->coded_time.begin(), encoder->coded_time.end(), 0);
+	std::fill(encoder->tx_attempts.begin(), encoder->tx_attempts.end(), 0);
+	std::fill(encoder->unacked.begin(), encoder->unacked.end(), 0);
+	encoder->coded_packets.clear();
+
+	rate_control_restart(&encoder->rc);
+	rate_control_sent_log_reset(&encoder->sent_log);
+	repair_acc_reset(&encoder->acc);
+
+	memset(&encoder->stats, 0, sizeof(encoder->stats));
+	if (encoder->hist) {
+		memset(encoder->hist, 0, sizeof(*encoder->hist));
+		std::fill(encoder->hist_unsent.begin(), encoder->hist_unsent.end(), 0);
+	}
+	return 0;
+}
+
 EXPORT
 int nck_interflow_sw_enc_has_coded(struct nck_interflow_sw_enc *encoder)
 {
@@ -366,7 +539,7 @@ static void nck_interflow_sw_enc_free_symbols(struct nck_interflow_sw_enc *encod
 		s = encoder_sequence - rank + 1 + i;
 		rs = s % symbols;
 
-		encoder->coder->disable_symbol(rs);
+		nck_interflow_sw_enc_disable_symbol(encoder, rs);
 		encoder->tx_attempts[rs] = 0;
 		if (encoder->coder->is_systematic(rs)) {
 			// we have to decrement the source_symbols counter
@@ -415,7 +588,7 @@ void nck_interflow_sw_enc_flush_coded(struct nck_interflow_sw_enc *encoder)
 				continue;
 
 			/* retransmit the last symbol with tx_attemps > 0 */
-			coder->enable_symbol(s);
+			nck_interflow_sw_enc_enable_symbol(encoder, s);
 			if (!coder->is_systematic(s)) {
 				coder->enable_systematic_symbol(s);
 				encoder->source_symbols += 1;
@@ -459,6 +632,10 @@ int nck_interflow_sw_enc_put_source(struct nck_interflow_sw_enc *encoder, struct
 		encoder->source_symbols -= 1;
 	}
 
+	// the old symbol in this slot must leave the repair accumulators
+	// before it is overwritten
+	repair_acc_leave(&encoder->acc, index, symbol);
+
 	// copy packet into that memory
 	memcpy(symbol, packet->data, packet->len);
 	// fill the rest with zeros
@@ -469,11 +646,18 @@ int nck_interflow_sw_enc_put_source(struct nck_interflow_sw_enc *encoder, struct
 	// IMPORTANT: if we want to allow shifting out a symbol marked for systematic coding
 	// then we also need to decrement the encoder->source_symbols counter!
 	assert(!coder->is_systematic(index));
-	coder->disable_symbol((index-encoder->forward_code_window+symbols)%symbols);
+	nck_interflow_sw_enc_disable_symbol(encoder, (index-encoder->forward_code_window+symbols)%symbols);
 
 	// pass the memory to the kodo encoder
 	coder->set_const_symbol(index, storage::storage(symbol, symbol_size));
+	repair_acc_enter(&encoder->acc, index, symbol);
+
+	if (encoder->hist && encoder->timer) {
+		nck_timer_gettime(encoder->timer, &encoder->hist_put_time[index]);
+		bitmap_set(encoder->hist_unsent.data(), index);
+	}
 	encoder->tx_attempts[index] = encoder->max_tx_attempts;
+	bitmap_set(encoder->unacked.data(), index);
 
 	/* allow flushing again */
 	encoder->flush_attempts = max_t(uint8_t, encoder->max_tx_attempts, 1) - 1;
@@ -494,6 +678,107 @@ int nck_interflow_sw_enc_put_source(struct nck_interflow_sw_enc *encoder, struct
 	return 0;
 }
 
+/**
+ * nck_interflow_sw_enc_write_accumulated - write the next accumulated repair symbol
+ * @encoder: encoder structure that will be used
+ * @payload: buffer of at least payload_size bytes
+ *
+ * Writes the same layout as the kodo encoder: the sequence number, the
+ * systematic flag, one coefficient per window slot and the coded symbol.
+ *
+ * Return: number of bytes written
+ */
+static size_t nck_interflow_sw_enc_write_accumulated(struct nck_interflow_sw_enc *encoder, uint8_t *payload)
+{
+	auto coder = encoder->coder;
+	struct kodo_header *kodo_header = (struct kodo_header *)payload;
+	uint8_t *coefficients = (uint8_t *)(kodo_header + 1);
+	const uint8_t *acc_coefficients, *acc_payload;
+
+	repair_acc_emit(&encoder->acc, &acc_coefficients, &acc_payload);
+
+	kodo_header->seqno = htonl(coder->sequence_number());
+	kodo_header->systematic_flag = 0;
+	memcpy(coefficients, acc_coefficients, coder->symbols());
+	memcpy(coefficients + coder->symbols(), acc_payload, coder->symbol_size());
+
+	return sizeof(*kodo_header) + coder->symbols() + coder->symbol_size();
+}
+
+/**
+ * nck_interflow_sw_enc_seed_span - find the slots combined by a seeded repair
+ * @encoder: encoder structure that will be used
+ * @first: set to the slot of the oldest enabled symbol
+ * @count: set to the number of slots up to the newest enabled symbol
+ *
+ * The seed header can only describe a contiguous range of slots, so it is
+ * only used when every slot of the range is enabled.
+ *
+ * Return: true if the enabled symbols form a contiguous, non-empty range
+ */
+static bool nck_interflow_sw_enc_seed_span(struct nck_interflow_sw_enc *encoder, uint32_t *first, uint32_t *count)
+{
+	auto coder = encoder->coder;
+	uint32_t symbols = coder->symbols();
+	uint32_t start = symbols, last = 0;
+
+	// the slot at the index is the oldest one in the window
+	for (uint32_t i = 0; i < symbols; ++i) {
+		if (coder->is_symbol_enabled((encoder->index + i) % symbols)) {
+			if (start == symbols)
+				start = i;
+			last = i;
+		}
+	}
+
+	if (start == symbols || last - start + 1 != coder->enabled_symbols())
+		return false;
+
+	*first = (encoder->index + start) % symbols;
+	*count = last - start + 1;
+	return true;
+}
+
+/**
+ * nck_interflow_sw_enc_write_seeded - write a repair symbol with a seed header
+ * @encoder: encoder structure that will be used
+ * @payload: buffer of at least payload_size bytes
+ * @first: slot of the first symbol in the combination
+ * @count: number of consecutive slots in the combination
+ *
+ * Combines the slots given by nck_interflow_sw_enc_seed_span() with coefficients
+ * generated from a fresh seed, see struct interflow_sw_seed_header.
+ *
+ * Return: number of bytes written
+ */
+static size_t nck_interflow_sw_enc_write_seeded(struct nck_interflow_sw_enc *encoder, uint8_t *payload,
+		uint32_t first, uint32_t count)
+{
+	auto coder = encoder->coder;
+	struct interflow_sw_seed_header *seed_header = (struct interflow_sw_seed_header *)payload;
+	uint8_t *symbol = (uint8_t *)(seed_header + 1);
+	uint32_t symbols = coder->symbols();
+	uint32_t symbol_size = coder->symbol_size();
+	uint32_t seed = rand_r(&encoder->seed);
+
+	nck_interflow_sw_common_seed_coefficients(seed, encoder->seed_factors.data(), count);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t slot = (first + i) % symbols;
+		encoder->seed_sources[i] = &encoder->buffer[slot * encoder->source_size];
+	}
+
+	memset(symbol, 0, symbol_size);
+	binary8_region_multiply_sum(symbol, encoder->seed_sources.data(),
+				    encoder->seed_factors.data(), count, symbol_size);
+
+	seed_header->seqno = htonl(coder->sequence_number());
+	seed_header->seed = htonl(seed);
+	seed_header->first = htons(first);
+	seed_header->count = htons(count);
+
+	return sizeof(*seed_header) + symbol_size;
+}
+
 EXPORT
 int nck_interflow_sw_enc_get_coded(struct nck_interflow_sw_enc *encoder, struct sk_buff *packet)
 {
@@ -524,6 +809,13 @@ int nck_interflow_sw_enc_get_coded(struct nck_interflow_sw_enc *encoder, struct
 
 		encoder->systematic_time[index] = encoder->packet_count;
 		encoder->coded_time[index] = encoder->packet_count;
+		if (encoder->hist && bitmap_test(encoder->hist_unsent.data(), index)) {
+			struct timeval now;
+			nck_timer_gettime(encoder->timer, &now);
+			nck_histogram_record_delay(&encoder->hist->h[NCK_HISTOGRAM_ENCODE_DELAY],
+						   &encoder->hist_put_time[index], &now);
+			bitmap_clear(encoder->hist_unsent.data(), index);
+		}
 		if (encoder->max_tx_attempts != UINT8_MAX) {
 			encoder->tx_attempts[index]--;
 		}
@@ -544,21 +836,38 @@ int nck_interflow_sw_enc_get_coded(struct nck_interflow_sw_enc *encoder, struct
 		encoder->stats.s[NCK_STATS_GET_CODED_REPAIR]++;
 	}
 
+	if (encoder->hist)
+		nck_histogram_record(&encoder->hist->h[NCK_HISTOGRAM_WINDOW], coder->enabled_symbols());
+
 	size_t payload_size = coder->payload_size();
 	uint8_t *payload = (uint8_t *)skb_put(packet, payload_size);
-	size_t real_size = coder->write_payload(payload);
+	size_t real_size, min_size = encoder->header_size;
+	uint32_t seed_first, seed_count;
+	bool seeded = repair && encoder->seed_header &&
+		nck_interflow_sw_enc_seed_span(encoder, &seed_first, &seed_count);
+	if (seeded) {
+		real_size = nck_interflow_sw_enc_write_seeded(encoder, payload, seed_first, seed_count);
+		min_size = sizeof(struct interflow_sw_seed_header);
+	} else if (repair && repair_acc_ready(&encoder->acc)) {
+		real_size = nck_interflow_sw_enc_write_accumulated(encoder, payload);
+	} else {
+		real_size = coder->write_payload(payload);
+	}
 
 	assert(real_size <= payload_size);
 	skb_trim(packet, payload_size - real_size);
 	skb_trim_zeros(packet);
 
 	/* do not trim off the minimal header as well. */
-	if (packet->len < encoder->header_size) {
-		skb_put(packet, encoder->header_size - packet->len);
+	if (packet->len < min_size) {
+		skb_put(packet, min_size - packet->len);
 	}
 
 	int flags = 0;
 
+	if (seeded)
+		flags |= INTERFLOW_SW_CODED_PACKET_SEED;
+
 	if (encoder->feedback_only_on_repair) {
 		if (repair)
 			flags |= INTERFLOW_SW_CODED_PACKET_FEEDBACK_REQUESTED;
@@ -590,6 +899,7 @@ int nck_interflow_sw_enc_get_coded(struct nck_interflow_sw_enc *encoder, struct
 	interflow_sw_coded_packet->packet_type = INTERFLOW_SW_PACKET_TYPE_CODED;
 	interflow_sw_coded_packet->order = encoder->order;
 	interflow_sw_coded_packet->flags = flags;
+	interflow_sw_coded_packet->flow = encoder->node_id;
 
 	kodo_header = (struct kodo_header *) (interflow_sw_coded_packet + 1);
 	uint32_t seqno = ntohl(kodo_header->seqno);
@@ -597,6 +907,13 @@ int nck_interflow_sw_enc_get_coded(struct nck_interflow_sw_enc *encoder, struct
 	memcpy (kodo_header, &new_seqno, sizeof(new_seqno));
 	uint16_t new_packetno = (uint16_t)(ntohl(new_seqno));
 	interflow_sw_coded_packet->packet_no = htons(new_packetno);
+
+	// repairs reuse the packet_no of the newest source symbol
+	rate_control_sent_log_add(&encoder->sent_log, new_packetno);
+
+	if (encoder->mix)
+		nck_interflow_sw_mix_remember(encoder->mix, packet);
+
 	if (encoder->timeout_handle && !_has_coded(encoder)) {
 		// We have nothing more to send, so we register a timeout.
 		// The timeout should be reset if either a new source packet
@@ -627,6 +944,12 @@ char *nck_interflow_sw_enc_debug(void *enc)
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"redundancy\":%d,", encoder->rc.credit.redundancy);
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"credit_counter\":%d,", encoder->rc.credit.counter);
 		break;
+	case RATE_CONTROL_ADAPTIVE:
+		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"redundancy\":%d,", encoder->rc.adaptive.credit.redundancy);
+		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"credit_counter\":%d,", encoder->rc.adaptive.credit.counter);
+		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"loss\":%.3f,", encoder->rc.adaptive.loss);
+		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"burst\":%.2f,", encoder->rc.adaptive.burst);
+		break;
 	}
 
 	pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"source_symbols\":%d,", encoder->source_symbols);
@@ -679,6 +1002,33 @@ struct nck_stats *nck_interflow_sw_enc_get_stats(void *enc)
 	return &encoder->stats;
 }
 
+EXPORT
+struct nck_histograms *nck_interflow_sw_enc_get_histograms(void *enc)
+{
+	struct nck_interflow_sw_enc *encoder = (struct nck_interflow_sw_enc*)enc;
+
+	return encoder->hist;
+}
+
+static void nck_interflow_sw_enc_ack_symbol(struct nck_interflow_sw_enc *encoder, uint32_t i)
+{
+	nck_interflow_sw_enc_disable_symbol(encoder, i);
+	encoder->tx_attempts[i] = 0;
+	if (encoder->coder->is_systematic(i)) {
+		// we have to decrement the source_symbols counter
+		assert(encoder->source_symbols > 0);
+		encoder->coder->disable_systematic_symbol(i);
+		encoder->source_symbols -= 1;
+	} else if ((int16_t)(encoder->systematic_time[i] - encoder->packet_count) > 0) {
+		// This case can happen for coded-only retransmissions.
+		// We faked the systematic time with a future value.
+		// And in this case we should decrement the retransmission counter.
+		assert(encoder->rc.algo == RATE_CONTROL_DUAL);
+		assert(encoder->rc.dual.repair_counter > 0);
+		encoder->rc.dual.repair_counter -= 1;
+	}
+}
+
 /**
  * nck_sw_feedback_seqno_valid() - check if received feedback seqno is valid
  * @sequence: Received sequence number in feedback
@@ -713,9 +1063,8 @@ EXPORT
 int nck_interflow_sw_enc_put_feedback(struct nck_interflow_sw_enc *encoder, struct sk_buff *packet)
 {
 	auto coder = encoder->coder;
-	int symbols = encoder->coder->symbols();
-	int i;
-	uint32_t s;
+	uint32_t symbols = encoder->coder->symbols();
+	uint32_t i, start, span, remaining;
 	struct interflow_sw_feedback_packet *interflow_sw_feedback_packet;
 	uint16_t feedback_packet_no;
 	uint32_t sequence;
@@ -743,6 +1092,10 @@ int nck_interflow_sw_enc_put_feedback(struct nck_interflow_sw_enc *encoder, stru
 			feedback_packet_no, ntohs(interflow_sw_feedback_packet->feedback_no),
 			sequence, first_missing);
 
+	// the packet numbers have gaps, so the decoder cannot count loss runs
+	rate_control_sent_log_feedback(&encoder->rc, &encoder->sent_log, feedback_packet_no,
+				       interflow_sw_feedback_packet->received, 0);
+
 	/*
 	 * Not all bits from the feedback are useful.
 	 * But it surprisingly easy to enumerate all useful bits.
@@ -774,13 +1127,13 @@ int nck_interflow_sw_enc_put_feedback(struct nck_interflow_sw_enc *encoder, stru
 	// find first coded packet that is in flight
 	// we use this later as start for iterations
 	// TODO: we could also delete all skipped packets, if we assume no feedback reordering
-	auto in_flight = encoder->coded_packets.begin();
-	while (in_flight != encoder->coded_packets.end() && (int)(*in_flight - feedback_packet_no) < 0) {
-		++in_flight;
-	}
+	// the packet numbers are increasing, so the boundary is found by bisection
+	auto in_flight = std::partition_point(encoder->coded_packets.begin(), encoder->coded_packets.end(),
+			[feedback_packet_no](uint16_t packet_no) { return (int16_t)(packet_no - feedback_packet_no) < 0; });
 
 	int use_index, resend, losses = 0, resend_counter = 0;
-	std::vector<uint8_t> used(encoder->coded_packets.size());
+	uint64_t *used = encoder->coded_used.data();
+	std::fill(encoder->coded_used.begin(), encoder->coded_used.end(), 0);
 
 	// Since the encoder never misses any packets the rank is basically the number
 	// of consecutive symbols available to the encoder.
@@ -792,99 +1145,101 @@ int nck_interflow_sw_enc_put_feedback(struct nck_interflow_sw_enc *encoder, stru
 	if (!nck_interflow_sw_feedback_seqno_valid(sequence, encoder_sequence, rank))
 		return -1;
 
-	for (s = encoder_sequence - rank; s != sequence; ++s) {
-		/* TODO why is it valid that the data is parsed relative to the state of the encoder (its rank)?
-		 * why isn't here any size check to see that i actually fits in packet->data?
-		 */
-		i = s%symbols;
-
-		if ((packet->data[i/8] & (1 << (i%8))) == 0) {
-			// packet was marked as acknowledged
-			encoder->coder->disable_symbol(i);
-			encoder->tx_attempts[i] = 0;
-			if (encoder->coder->is_systematic(i)) {
-				// we have to decrement the source_symbols counter
-				assert(encoder->source_symbols > 0);
-				encoder->coder->disable_systematic_symbol(i);
-				encoder->source_symbols -= 1;
-			} else if ((int16_t)(encoder->systematic_time[i] - encoder->packet_count) > 0) {
-				// This case can happen for coded-only retransmissions.
-				// We faked the systematic time with a future value.
-				// And in this case we should decrement the retransmission counter.
-				assert(encoder->rc.algo == RATE_CONTROL_DUAL);
-				assert(encoder->rc.dual.repair_counter > 0);
-				encoder->rc.dual.repair_counter -= 1;
+	/* The usable bits are visited one word at a time. Lost symbols and
+	 * symbols with a pending acknowledgement are picked out with ctz, so
+	 * symbols that were acknowledged by an earlier feedback cost nothing.
+	 * The range has at most `rank` bits, so it wraps around at most once.
+	 */
+	start = (encoder_sequence - rank) % symbols;
+	remaining = sequence - (encoder_sequence - rank);
+	for (; remaining > 0; start = (start + span) % symbols, remaining -= span) {
+		uint32_t word = start / 64;
+		uint32_t offset = start % 64;
+		span = min_t(uint32_t, min_t(uint32_t, 64 - offset, symbols - start), remaining);
+
+		uint64_t range = bitmap_range(offset, offset + span);
+		uint64_t lost = bitmap_load(packet->data, DIV_ROUND_UP(symbols, 8), word) & range;
+		uint64_t acked = ~lost & range & encoder->unacked[word];
+
+		for (uint64_t pending = lost | acked; pending; pending = bitmap_drop_first(pending)) {
+			uint32_t bit = bitmap_first(pending);
+			i = word * 64 + bit;
+
+			if (acked & ((uint64_t)1 << bit)) {
+				// packet was marked as acknowledged
+				bitmap_clear(encoder->unacked.data(), i);
+				nck_interflow_sw_enc_ack_symbol(encoder, i);
+				continue;
 			}
-			continue;
-		}
 
-		// packet is missing
-		losses += 1;
+			// packet is missing
+			losses += 1;
 
-		// check if a retransmission is already planned for the future
-		if ((int16_t)(encoder->systematic_time[i] - feedback_packet_no) > 0) {
-			// we can ignore this feedback
-			continue;
-		}
+			// check if a retransmission is already planned for the future
+			if ((int16_t)(encoder->systematic_time[i] - feedback_packet_no) > 0) {
+				// we can ignore this feedback
+				continue;
+			}
 
-		if (encoder->packet_memory && (int16_t)(encoder->coded_time[i] - feedback_packet_no) >= 0) {
-			// if the timestamp is between the last systematic and last coded packet
-			// we might want to do some checks to make sure we need to retransmit
-
-			// so the following idea might not be completely true:
-			// we search for the first unused coded packet that is in flight and can fix this error
-			// if we find such a packet, we mark it as used
-			// else we trigger a retransmission
-			use_index = 0;
-			resend = 1;
-			for (auto it = in_flight; it != encoder->coded_packets.end(); ++it, ++use_index) {
-				if ((int)(encoder->coded_time[i] - *it) < 0) {
-					// we passed the last relevant coded packet
-					break;
-				}
-				if ((int)(*it - encoder->coded_time[i]) < 0) {
-					// we have not yet reached the first relevant coded packet
-					continue;
+			if (encoder->packet_memory && (int16_t)(encoder->coded_time[i] - feedback_packet_no) >= 0) {
+				// if the timestamp is between the last systematic and last coded packet
+				// we might want to do some checks to make sure we need to retransmit
+
+				// so the following idea might not be completely true:
+				// we search for the first unused coded packet that is in flight and can fix this error
+				// if we find such a packet, we mark it as used
+				// else we trigger a retransmission
+				use_index = 0;
+				resend = 1;
+				for (auto it = in_flight; it != encoder->coded_packets.end(); ++it, ++use_index) {
+					if ((int)(encoder->coded_time[i] - *it) < 0) {
+						// we passed the last relevant coded packet
+						break;
+					}
+					if ((int)(*it - encoder->coded_time[i]) < 0) {
+						// we have not yet reached the first relevant coded packet
+						continue;
+					}
+
+					if (!bitmap_test(used, use_index)) {
+						resend = 0;
+						bitmap_set(used, use_index);
+						break;
+					}
 				}
 
-				if (!used[use_index]) {
-					resend = 0;
-					used[use_index] = 1;
-					break;
+				// why this might fail:
+				// it only estimates how the decoder could use the packets
+				// if there is reordering or losses the matrix might look completely different
+
+				if (!resend) {
+					continue;
 				}
 			}
 
-			// why this might fail:
-			// it only estimates how the decoder could use the packets
-			// if there is reordering or losses the matrix might look completely different
-
-			if (!resend) {
+			/* ignore packets with empty retry counter */
+			if (encoder->tx_attempts[i] <= 0)
 				continue;
-			}
-		}
 
-		/* ignore packets with empty retry counter */
-		if (encoder->tx_attempts[i] <= 0)
-			continue;
-
-		// this enables the symbol for retransmission
-		encoder->coder->enable_symbol(i);
-		if (!encoder->coder->is_systematic(i)) {
-			resend_counter += 1;
-
-			if (!encoder->coded_retrans || encoder->rc.algo != RATE_CONTROL_DUAL) {
-				// do systematic retransmission
-				encoder->stats.s[NCK_STATS_GET_CODED_RETRY]++;
-				encoder->coder->enable_systematic_symbol(i);
-				encoder->source_symbols += 1;
-				rate_control_insert(&encoder->rc, true);
-				encoder->flush_attempts = max_t(uint8_t, encoder->max_tx_attempts, 1) - 1;
-			} else {
-				// If we do only coded retransmissions, the systematic time will never be updated.
-				// However, remembering the last retransmission time is crucial for the feedback process.
-				// If we don't remember the retransmission, the next feedback packet will trigger additional retransmissions.
-				// To counter this we "fake" the systematic_time with the time when these retransmissions should happen.
-				encoder->systematic_time[i] = encoder->packet_count + resend_counter;
+			// this enables the symbol for retransmission
+			nck_interflow_sw_enc_enable_symbol(encoder, i);
+			if (!encoder->coder->is_systematic(i)) {
+				resend_counter += 1;
+
+				if (!encoder->coded_retrans || encoder->rc.algo != RATE_CONTROL_DUAL) {
+					// do systematic retransmission
+					encoder->stats.s[NCK_STATS_GET_CODED_RETRY]++;
+					encoder->coder->enable_systematic_symbol(i);
+					encoder->source_symbols += 1;
+					rate_control_insert(&encoder->rc, true);
+					encoder->flush_attempts = max_t(uint8_t, encoder->max_tx_attempts, 1) - 1;
+				} else {
+					// If we do only coded retransmissions, the systematic time will never be updated.
+					// However, remembering the last retransmission time is crucial for the feedback process.
+					// If we don't remember the retransmission, the next feedback packet will trigger additional retransmissions.
+					// To counter this we "fake" the systematic_time with the time when these retransmissions should happen.
+					encoder->systematic_time[i] = encoder->packet_count + resend_counter;
+				}
 			}
 		}
 	}
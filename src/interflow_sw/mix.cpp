@@ -0,0 +1,410 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <linux/types.h>
+
+#include <vector>
+
+#include <nckernel/interflowsw.h>
+#include <nckernel/api.h>
+#include <nckernel/skb.h>
+#include <nckernel/timer.h>
+#include <nckernel/trace.h>
+
+#include "../private.h"
+#include "../util/finite_field.h"
+#include "packet.h"
+#include "common.h"
+
+/**
+ * struct mix_slot - coded packet in the sub-window of a flow
+ * @valid: whether the slot contains a packet
+ * @packet_no: packet_no from the interflow_sw_coded_packet header
+ * @hash: hash of the packet, see mix_hash()
+ * @data: the packet including its interflow_sw_coded_packet header
+ */
+struct mix_slot {
+	bool valid;
+	uint16_t packet_no;
+	uint32_t hash;
+	std::vector<uint8_t> data;
+};
+
+/**
+ * struct mix_flow - sub-window of a single flow
+ * @slots: the last packets of the flow, used as ring buffer
+ * @next: slot that is overwritten by the next packet
+ * @queue: slots of packets that still have to be mixed, oldest first
+ */
+struct mix_flow {
+	std::vector<struct mix_slot> slots;
+	uint32_t next;
+	std::vector<uint32_t> queue;
+};
+
+struct nck_interflow_sw_mix {
+	nck_interflow_sw_mix(uint32_t flows, uint32_t window, size_t packet_size) :
+		flows(flows), coded_size(sizeof(struct interflow_sw_mixed_packet) +
+					 flows * sizeof(struct interflow_sw_mixed_entry) + packet_size),
+		packet_size(packet_size), flush(0), seed(rand()),
+		timeout(), timeout_handle(NULL), sub_windows(flows)
+	{
+		for (auto &flow : sub_windows) {
+			flow.slots.resize(window);
+			flow.next = 0;
+		}
+		nck_trigger_init(&on_coded_ready);
+	}
+
+	uint32_t flows;
+	size_t coded_size;
+	size_t packet_size;
+
+	int flush;
+	unsigned int seed;
+
+	struct timeval timeout;
+	struct nck_timer_entry *timeout_handle;
+
+	struct nck_trigger on_coded_ready;
+
+	std::vector<struct mix_flow> sub_windows;
+};
+
+/**
+ * mix_hash - identify a coded packet within its flow
+ * @data: the coded packet
+ * @len: length of the coded packet
+ *
+ * The packet_no of a flow is not unique, repair packets repeat it, so
+ * packets are identified by their packet_no together with a FNV-1a hash of
+ * their contents.
+ */
+static uint32_t mix_hash(const uint8_t *data, size_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static int mix_flow_of(struct nck_interflow_sw_mix *mix, struct sk_buff *packet)
+{
+	struct interflow_sw_coded_packet *coded;
+
+	if (!pskb_may_pull(packet, sizeof(*coded)) || packet->len > mix->packet_size)
+		return -1;
+
+	coded = (struct interflow_sw_coded_packet *)packet->data;
+	if (coded->packet_type != INTERFLOW_SW_PACKET_TYPE_CODED || coded->flow >= mix->flows)
+		return -1;
+
+	return coded->flow;
+}
+
+static uint32_t mix_store(struct mix_flow *flow, const uint8_t *data, size_t len)
+{
+	const struct interflow_sw_coded_packet *coded = (const struct interflow_sw_coded_packet *)data;
+	uint32_t index = flow->next;
+	struct mix_slot *slot = &flow->slots[index];
+
+	// a queued packet that is overwritten can not be mixed anymore
+	for (auto it = flow->queue.begin(); it != flow->queue.end(); ++it) {
+		if (*it == index) {
+			flow->queue.erase(it);
+			break;
+		}
+	}
+
+	slot->valid = true;
+	slot->packet_no = ntohs(coded->packet_no);
+	slot->hash = mix_hash(data, len);
+	slot->data.assign(data, data + len);
+
+	flow->next = (index + 1) % flow->slots.size();
+	return index;
+}
+
+/**
+ * mix_find - look up the packet of a mixed entry in the sub-window of its flow
+ * @flow: sub-window of the flow of the entry
+ * @entry: entry of the mixed packet
+ * @slot: set to the matching slot, or NULL if the packet is unknown
+ *
+ * Slots that match but contain different data can not be told apart, so
+ * the entry is ambiguous. Copies of the same packet do not count.
+ *
+ * Return: 0 on success, -1 if the entry is ambiguous
+ */
+static int mix_find(struct mix_flow *flow, const struct interflow_sw_mixed_entry *entry,
+		    struct mix_slot **slot)
+{
+	uint16_t packet_no = ntohs(entry->packet_no);
+	uint16_t length = ntohs(entry->length);
+	uint32_t hash = ntohl(entry->hash);
+
+	*slot = NULL;
+	for (auto &candidate : flow->slots) {
+		if (!candidate.valid || candidate.packet_no != packet_no ||
+		    candidate.hash != hash || candidate.data.size() != length)
+			continue;
+
+		if (*slot && (*slot)->data != candidate.data)
+			return -1;
+
+		*slot = &candidate;
+	}
+
+	return 0;
+}
+
+static void mix_timeout_flush(struct nck_timer_entry *entry, void *context, int success)
+{
+	UNUSED(entry);
+
+	if (success) {
+		struct nck_interflow_sw_mix *mix = (struct nck_interflow_sw_mix *)context;
+		nck_interflow_sw_mix_flush_coded(mix);
+	}
+}
+
+EXPORT
+struct nck_interflow_sw_mix *nck_interflow_sw_mix(uint32_t flows, uint32_t window, size_t packet_size,
+						  struct nck_timer *timer, const struct timeval *timeout)
+{
+	if (flows == 0 || flows > UINT8_MAX || window == 0) {
+		fprintf(stderr, "Invalid number of flows or window size\n");
+		return NULL;
+	}
+
+	binary8_init();
+
+	struct nck_interflow_sw_mix *result = new struct nck_interflow_sw_mix(flows, window, packet_size);
+
+	if (timeout && timerisset(timeout)) {
+		assert(timer != NULL);
+		result->timeout = *timeout;
+		result->timeout_handle = nck_timer_add(timer, NULL, result, mix_timeout_flush);
+	}
+
+	return result;
+}
+
+EXPORT
+void nck_interflow_sw_mix_free(struct nck_interflow_sw_mix *mix)
+{
+	if (mix->timeout_handle) {
+		nck_timer_cancel(mix->timeout_handle);
+		nck_timer_free(mix->timeout_handle);
+	}
+
+	delete mix;
+}
+
+EXPORT
+int nck_interflow_sw_mix_remember(struct nck_interflow_sw_mix *mix, struct sk_buff *packet)
+{
+	int flow = mix_flow_of(mix, packet);
+
+	if (flow < 0)
+		return -1;
+
+	mix_store(&mix->sub_windows[flow], packet->data, packet->len);
+	return 0;
+}
+
+EXPORT
+int nck_interflow_sw_mix_put_coded(struct nck_interflow_sw_mix *mix, struct sk_buff *packet)
+{
+	int flow = mix_flow_of(mix, packet);
+	struct mix_flow *sub_window;
+	uint32_t index;
+
+	if (flow < 0)
+		return -1;
+
+	sub_window = &mix->sub_windows[flow];
+	index = mix_store(sub_window, packet->data, packet->len);
+	sub_window->queue.push_back(index);
+
+	// a flow that fills its sub-window can not wait for the others
+	if (sub_window->queue.size() >= sub_window->slots.size() / 2 + 1)
+		mix->flush = 1;
+
+	if (mix->timeout_handle && !nck_timer_pending(mix->timeout_handle))
+		nck_timer_rearm(mix->timeout_handle, &mix->timeout);
+
+	if (nck_interflow_sw_mix_has_coded(mix))
+		nck_trigger_call(&mix->on_coded_ready);
+
+	return 0;
+}
+
+EXPORT
+int nck_interflow_sw_mix_has_coded(struct nck_interflow_sw_mix *mix)
+{
+	uint32_t waiting = 0;
+
+	for (auto &flow : mix->sub_windows) {
+		if (!flow.queue.empty())
+			waiting += 1;
+	}
+
+	if (waiting == 0)
+		return 0;
+
+	// mixing every flow gives the largest gain, otherwise wait for a flush
+	return waiting == mix->flows || mix->flush;
+}
+
+EXPORT
+void nck_interflow_sw_mix_flush_coded(struct nck_interflow_sw_mix *mix)
+{
+	mix->flush = 1;
+
+	if (nck_interflow_sw_mix_has_coded(mix))
+		nck_trigger_call(&mix->on_coded_ready);
+}
+
+EXPORT
+int nck_interflow_sw_mix_get_coded(struct nck_interflow_sw_mix *mix, struct sk_buff *packet)
+{
+	struct interflow_sw_mixed_packet *header;
+	struct interflow_sw_mixed_entry *entry;
+	std::vector<struct mix_slot *> slots;
+	std::vector<uint8_t> coefficients;
+	std::vector<uint8_t> flows;
+	size_t length = 0;
+	uint8_t *payload;
+
+	for (uint32_t i = 0; i < mix->flows; ++i) {
+		struct mix_flow *flow = &mix->sub_windows[i];
+
+		if (flow->queue.empty())
+			continue;
+
+		slots.push_back(&flow->slots[flow->queue.front()]);
+		flows.push_back(i);
+		flow->queue.erase(flow->queue.begin());
+		length = max_t(size_t, length, slots.back()->data.size());
+	}
+
+	if (slots.empty())
+		return -1;
+
+	if (!nck_interflow_sw_mix_has_coded(mix))
+		mix->flush = 0;
+
+	if (slots.size() == 1) {
+		// nothing to mix with, so we save the header
+		payload = (uint8_t *)skb_put(packet, slots[0]->data.size());
+		memcpy(payload, slots[0]->data.data(), slots[0]->data.size());
+		return 0;
+	}
+
+	header = (struct interflow_sw_mixed_packet *)skb_put(packet, sizeof(*header));
+	header->packet_type = INTERFLOW_SW_PACKET_TYPE_MIXED;
+	header->count = slots.size();
+	header->length = htons(length);
+
+	for (size_t i = 0; i < slots.size(); ++i) {
+		coefficients.push_back(1 + rand_r(&mix->seed) % 255);
+
+		entry = (struct interflow_sw_mixed_entry *)skb_put(packet, sizeof(*entry));
+		entry->flow = flows[i];
+		entry->coefficient = coefficients[i];
+		entry->length = htons(slots[i]->data.size());
+		entry->packet_no = htons(slots[i]->packet_no);
+		entry->hash = htonl(slots[i]->hash);
+	}
+
+	payload = (uint8_t *)skb_put(packet, length);
+	memset(payload, 0, length);
+	for (size_t i = 0; i < slots.size(); ++i) {
+		binary8_region_multiply_add(payload, slots[i]->data.data(), coefficients[i],
+					    slots[i]->data.size());
+	}
+
+	return 0;
+}
+
+EXPORT
+int nck_interflow_sw_mix_extract(struct nck_interflow_sw_mix *mix, struct sk_buff *packet)
+{
+	struct interflow_sw_mixed_packet header;
+	struct interflow_sw_mixed_entry entry, unknown;
+	struct mix_slot *slot;
+	uint32_t missing = 0;
+	uint16_t length;
+
+	if (!pskb_may_pull(packet, sizeof(header)))
+		return -1;
+
+	memcpy(&header, packet->data, sizeof(header));
+	skb_pull(packet, sizeof(header));
+	if (header.packet_type != INTERFLOW_SW_PACKET_TYPE_MIXED)
+		return -1;
+
+	length = ntohs(header.length);
+	if (!pskb_may_pull(packet, header.count * sizeof(entry) + length))
+		return -1;
+
+	uint8_t *payload = packet->data + header.count * sizeof(entry);
+
+	for (uint8_t i = 0; i < header.count; ++i) {
+		memcpy(&entry, packet->data, sizeof(entry));
+		skb_pull(packet, sizeof(entry));
+		if (entry.flow >= mix->flows || entry.coefficient == 0 || ntohs(entry.length) > length ||
+		    ntohs(entry.length) < sizeof(struct interflow_sw_coded_packet))
+			return -1;
+
+		if (mix_find(&mix->sub_windows[entry.flow], &entry, &slot))
+			return -1;
+
+		if (slot) {
+			binary8_region_multiply_subtract(payload, slot->data.data(), entry.coefficient,
+							 slot->data.size());
+		} else {
+			unknown = entry;
+			missing += 1;
+		}
+	}
+
+	// we can only solve for a single packet
+	if (missing != 1)
+		return -1;
+
+	binary8_region_multiply(payload, binary8_invert(unknown.coefficient), length);
+	skb_trim(packet, packet->len - ntohs(unknown.length));
+
+	// a known packet that was mistaken for another one corrupts the result
+	if (mix_hash(packet->data, packet->len) != ntohl(unknown.hash))
+		return -1;
+
+	// the packet may be mixed again on the next hop
+	mix_store(&mix->sub_windows[unknown.flow], packet->data, packet->len);
+
+	return 0;
+}
+
+EXPORT
+void nck_interflow_sw_mix_set_on_coded_ready(struct nck_interflow_sw_mix *mix, void *context,
+					     void (*callback)(void *context))
+{
+	nck_trigger_set(&mix->on_coded_ready, context, callback);
+}
+
+EXPORT
+size_t nck_interflow_sw_mix_coded_size(struct nck_interflow_sw_mix *mix)
+{
+	return mix->coded_size;
+}
@@ -8,10 +8,13 @@
  *    or linear combination of symbols (coded). Sent by encoders and recoders.
  * @SW_PACKET_TYPE_FEEDBACK: feedback packet to report the current decoding status. Sent
  *    by decoders and recoders.
+ * @INTERFLOW_SW_PACKET_TYPE_MIXED: linear combination of coded packets from several flows.
+ *    Sent by mixers.
  */
 enum interflow_sw_packet_type {
 	INTERFLOW_SW_PACKET_TYPE_CODED = 1,
 	INTERFLOW_SW_PACKET_TYPE_FEEDBACK = 2,
+	INTERFLOW_SW_PACKET_TYPE_MIXED = 3,
 };
 
 /**
@@ -19,33 +22,54 @@ enum interflow_sw_packet_type {
  * @packet_type: either SW_PACKET_TYPE_CODED or SW_PACKET_TYPE_SYSTEMATIC
  * @order: window size is 2^order
  * @flags: see enum sw_coded_packet_flags
- * @reserved: reserved byte for future use (for padding)
+ * @flow: node id of the source, used by mixers to keep the flows apart
  * @packet_no: incremental packet counter
  */
 struct interflow_sw_coded_packet {
 	uint8_t packet_type;
 	uint8_t order;
 	uint8_t flags;
-	uint8_t reserved;
+	uint8_t flow;
 	uint16_t packet_no;
 } __packed;
 
 /**
  * sw_coded_packet_flags - flags sent by the encoder
  * @SW_CODED_PACKET_FEEDBACK_REQUESTED: requests a feedback from the decoder
+ * @SW_CODED_PACKET_SEED: the coefficients are given by a struct sw_seed_header
+ *    instead of the kodo header
  */
 enum interflow_sw_coded_packet_flags {
 	INTERFLOW_SW_CODED_PACKET_FEEDBACK_REQUESTED = 0x01,
 	INTERFLOW_SW_CODED_PACKET_FLUSH = 0x02,
+	INTERFLOW_SW_CODED_PACKET_SEED = 0x04,
 };
 
+/**
+ * sw_seed_header - compact header of a coded packet with SW_CODED_PACKET_SEED
+ * @seqno: sequence number of the encoder, as in the kodo header
+ * @seed: seed of the coefficients, see nck_sw_common_seed_coefficients()
+ * @first: window slot of the first symbol in the linear combination
+ * @count: number of consecutive window slots in the linear combination
+ *
+ * The coded symbol follows the header. Slots outside of the range have a
+ * zero coefficient.
+ */
+struct interflow_sw_seed_header {
+	uint32_t seqno;
+	uint32_t seed;
+	uint16_t first;
+	uint16_t count;
+} __packed;
+
 /**
  * sw_feedback_packet - sliding window feedback packet
  * @packet_type: should be set to SW_PACKET_TYPE_FEEDBACK
  * @order: window size is 2^order
  * @packet_no: number of the last received packet_no
  * @feedback_no: incremental number of the feedback
- * @reserved: currently unused fields
+ * @received: number of coded packets received by the decoder, modulo 256
+ * @reserved: currently unused field
  * @sequence: latest sequence number of the decoder
  * @first_missing: sequence number of the first missing packet
  */
@@ -54,7 +78,40 @@ struct interflow_sw_feedback_packet {
 	uint8_t order;
 	uint16_t packet_no;
 	uint16_t feedback_no;
-	uint16_t reserved;
+	uint8_t received;
+	uint8_t reserved;
 	uint32_t sequence;
 	uint32_t first_missing;
 } __packed;
+
+/**
+ * interflow_sw_mixed_packet - linear combination of coded packets from several flows
+ * @packet_type: should be set to INTERFLOW_SW_PACKET_TYPE_MIXED
+ * @count: number of struct interflow_sw_mixed_entry that follow the header
+ * @length: length of the mixed payload, which is the length of the longest packet
+ *
+ * The entries are followed by the sum of the coded packets of all entries,
+ * each multiplied with its coefficient and padded with zeros to @length.
+ */
+struct interflow_sw_mixed_packet {
+	uint8_t packet_type;
+	uint8_t count;
+	uint16_t length;
+} __packed;
+
+/**
+ * interflow_sw_mixed_entry - coded packet contained in a mixed packet
+ * @flow: flow of the coded packet, see struct interflow_sw_coded_packet
+ * @coefficient: factor of the coded packet in the sum
+ * @length: length of the coded packet
+ * @packet_no: packet_no of the coded packet, see struct interflow_sw_coded_packet
+ * @hash: hash of the coded packet, identifies it together with @flow,
+ *        @packet_no and @length
+ */
+struct interflow_sw_mixed_entry {
+	uint8_t flow;
+	uint8_t coefficient;
+	uint16_t length;
+	uint16_t packet_no;
+	uint32_t hash;
+} __packed;
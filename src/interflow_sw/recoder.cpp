@@ -14,6 +14,7 @@
 #include <nckernel/trace.h>
 
 #include "../private.h"
+#include "../util/bitmap.h"
 #include "../util/rate.h"
 #include "packet.h"
 #include "common.h"
@@ -28,16 +29,18 @@ typedef factory_t::pointer coder_t;
 typedef recoder_t::header_type header_t;
 
 struct nck_interflow_sw_rec {
-	nck_interflow_sw_rec(coder_t coder, int ord) :
-		coder(coder), source_size(coder->symbol_size()),
+	nck_interflow_sw_rec(uint32_t symbols, uint32_t symbol_size, int ord) :
+		factory(fifi::api::field::binary8, symbols, symbol_size),
+		coder(factory.build()), source_size(coder->symbol_size()),
 		coded_size(sizeof(struct interflow_sw_coded_packet) + coder->payload_size()),
 		feedback_size(sizeof(struct interflow_sw_feedback_packet) + DIV_ROUND_UP(coder->symbols(), 8)),
 		forward_code_window(coder->symbols() / 2), /* TODO: make configurable, possibly use a different default */
 		flush(0), flush_next(0), flush_packet_no(0), order(ord), feedback(1),
 		max_tx_attempts(UINT8_MAX), flush_attempts(0),
-		has_source(0), has_feedback(0), timeout(), timeout_handle(), on_source_ready(), buffer(coder->block_size()),
+		has_source(0), has_feedback(0), hist(NULL), timeout(), timeout_handle(), on_source_ready(), buffer(coder->block_size()),
 		queue(coder->symbols() * coder->symbol_size()), queue_index(0), queue_length(0),
-		last_packet_no(0), last_feedback_no(0), feedback_buffer(feedback_size)
+		last_packet_no(0), last_feedback_no(0), feedback_buffer(feedback_size),
+		enabled(BITMAP_WORDS(coder->symbols()), ~(uint64_t)0)
 	{
 		nck_trigger_init(&on_source_ready);
 		nck_trigger_init(&on_coded_ready);
@@ -47,10 +50,12 @@ struct nck_interflow_sw_rec {
 		coder->set_trace_stdout();
 
 		rate_control_credit_init(&rc, coder->symbols(), 0);
+		rate_control_sent_log_reset(&sent_log);
 
 		memset(&stats, 0, sizeof(stats));
 	}
 
+	factory_t factory;
 	coder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -69,6 +74,7 @@ struct nck_interflow_sw_rec {
 
 	// rate control
 	struct rate_control rc;
+	struct rate_control_sent_log sent_log;
 
 
 	uint8_t max_tx_attempts;
@@ -78,6 +84,7 @@ struct nck_interflow_sw_rec {
 	int has_feedback;
 
 	struct nck_stats stats;
+	struct nck_histograms *hist;
 
 	struct timeval timeout;
 	struct nck_timer_entry *timeout_handle;
@@ -88,6 +95,9 @@ struct nck_interflow_sw_rec {
 
 	std::vector<uint8_t> buffer;
 
+	// packets with a seed header are rebuilt here
+	std::vector<uint8_t> seed_buffer;
+
 	std::vector<uint8_t> queue;
 	unsigned int queue_index;
 	unsigned int queue_length;
@@ -96,12 +106,19 @@ struct nck_interflow_sw_rec {
 	uint16_t last_feedback_no;
 
 	std::vector<uint8_t> feedback_buffer;
+
+	// mirrors the enabled symbols of the coder, which excludes the symbols
+	// the downstream decoder acknowledged, so that packets that are not
+	// innovative for it can be skipped before they are generated
+	std::vector<uint64_t> enabled;
 };
 
 char *nck_interflow_sw_rec_describe_packet(void *recoder, struct sk_buff *packet);
 struct nck_stats *nck_interflow_sw_rec_get_stats(void *recoder);
+struct nck_histograms *nck_interflow_sw_rec_get_histograms(void *recoder);
 
-NCK_RECODER_IMPL(nck_interflow_sw, NULL, nck_interflow_sw_rec_describe_packet, nck_interflow_sw_rec_get_stats)
+NCK_RECODER_IMPL_EXT(nck_interflow_sw, NULL, nck_interflow_sw_rec_describe_packet, nck_interflow_sw_rec_get_stats,
+		     nck_interflow_sw_rec_get_histograms)
 
 static void recoder_timeout_flush(struct nck_timer_entry *entry, void *context, int success)
 {
@@ -134,9 +151,7 @@ struct nck_interflow_sw_rec *nck_interflow_sw_rec(uint32_t symbols, uint32_t sym
 		return NULL;
 	}
 
-	factory_t factory(fifi::api::field::binary8, symbols, symbol_size);
-
-	struct nck_interflow_sw_rec *result = new struct nck_interflow_sw_rec(factory.build(), ord);
+	struct nck_interflow_sw_rec *result = new struct nck_interflow_sw_rec(symbols, symbol_size, ord);
 	result->header_size = 4+1;
 
 	if (timer) {
@@ -160,9 +175,25 @@ void nck_interflow_sw_rec_set_redundancy(struct nck_interflow_sw_rec *recoder, i
 	 *
 	 * The minimum allowed redundancy is therefore -coder->symbols()
 	 */
+	if (recoder->rc.algo != RATE_CONTROL_CREDIT)
+		rate_control_credit_init(&recoder->rc, coder->symbols(), effective);
+
 	rate_control_credit_change(&recoder->rc, effective);
 }
 
+EXPORT
+void nck_interflow_sw_rec_set_adaptive_redundancy(struct nck_interflow_sw_rec *recoder, int32_t min_redundancy, int32_t max_redundancy)
+{
+	auto coder = recoder->coder;
+
+	if (recoder->rc.algo != RATE_CONTROL_ADAPTIVE) {
+		rate_control_adaptive_init(&recoder->rc, coder->symbols(), min_redundancy, max_redundancy);
+		return;
+	}
+
+	rate_control_adaptive_change(&recoder->rc, min_redundancy, max_redundancy);
+}
+
 EXPORT
 void nck_interflow_sw_rec_set_feedback(struct nck_interflow_sw_rec *recoder, uint32_t enable)
 {
@@ -182,6 +213,19 @@ void nck_interflow_sw_rec_set_forward_code_window(struct nck_interflow_sw_rec *r
 	recoder->forward_code_window = forward_code_window;
 }
 
+EXPORT
+void nck_interflow_sw_rec_set_histograms(struct nck_interflow_sw_rec *recoder, int enable)
+{
+	if (!enable) {
+		free(recoder->hist);
+		recoder->hist = NULL;
+		return;
+	}
+
+	if (!recoder->hist)
+		recoder->hist = (struct nck_histograms *)calloc(1, sizeof(*recoder->hist));
+}
+
 EXPORT
 void nck_interflow_sw_rec_free(struct nck_interflow_sw_rec *recoder)
 {
@@ -189,9 +233,46 @@ void nck_interflow_sw_rec_free(struct nck_interflow_sw_rec *recoder)
 		nck_timer_cancel(recoder->timeout_handle);
 		nck_timer_free(recoder->timeout_handle);
 	}
+	free(recoder->hist);
 	delete recoder;
 }
 
+EXPORT
+int nck_interflow_sw_rec_reset(struct nck_interflow_sw_rec *recoder)
+{
+	uint32_t symbols = recoder->coder->symbols();
+
+	nck_timer_cancel(recoder->timeout_handle);
+
+	/* kodo has no way to empty a sliding window recoder, we build a fresh
+	 * one from the factory of the recoder that decodes into the same buffer
+	 */
+	recoder->coder = recoder->factory.build();
+	recoder->coder->set_mutable_symbols(storage::storage(recoder->buffer));
+	recoder->coder->set_trace_stdout();
+	rbufmgr_init(&recoder->rbufmgr, symbols, 1);
+
+	rate_control_restart(&recoder->rc);
+	rate_control_sent_log_reset(&recoder->sent_log);
+
+	recoder->flush = 0;
+	recoder->flush_next = 0;
+	recoder->flush_packet_no = 0;
+	recoder->flush_attempts = 0;
+	recoder->has_source = 0;
+	recoder->has_feedback = 0;
+	recoder->queue_index = 0;
+	recoder->queue_length = 0;
+	recoder->last_packet_no = 0;
+	recoder->last_feedback_no = 0;
+	recoder->enabled.assign(recoder->enabled.size(), ~(uint64_t)0);
+
+	memset(&recoder->stats, 0, sizeof(recoder->stats));
+	if (recoder->hist)
+		memset(recoder->hist, 0, sizeof(*recoder->hist));
+	return 0;
+}
+
 EXPORT
 int nck_interflow_sw_rec_has_source(struct nck_interflow_sw_rec *recoder)
 {
@@ -280,6 +361,42 @@ void nck_interflow_sw_rec_flush_source(struct nck_interflow_sw_rec *recoder)
 	}
 }
 
+static inline void nck_interflow_sw_rec_enable_symbol(struct nck_interflow_sw_rec *recoder, uint32_t index)
+{
+	recoder->coder->nested()->enable_symbol(index);
+	bitmap_set(recoder->enabled.data(), index);
+}
+
+static inline void nck_interflow_sw_rec_disable_symbol(struct nck_interflow_sw_rec *recoder, uint32_t index)
+{
+	recoder->coder->nested()->disable_symbol(index);
+	bitmap_clear(recoder->enabled.data(), index);
+}
+
+/**
+ * nck_interflow_sw_rec_has_innovative - check whether a coded packet would help downstream
+ * @recoder: recoder structure that will be used
+ *
+ * A coded packet only combines enabled symbols. If none of them is known to
+ * the recoder, the packet would have only zero coefficients.
+ *
+ * Return: true if the recoder holds a symbol the downstream decoder misses
+ */
+static bool nck_interflow_sw_rec_has_innovative(struct nck_interflow_sw_rec *recoder)
+{
+	auto coder = recoder->coder;
+
+	for (uint32_t word = 0; word < recoder->enabled.size(); ++word) {
+		for (uint64_t bits = recoder->enabled[word]; bits; bits = bitmap_drop_first(bits)) {
+			uint32_t index = word * 64 + bitmap_first(bits);
+			if (index < coder->symbols() && coder->is_symbol_pivot(index))
+				return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * nck_sw_rec_apply_forward_window - enable/disable symbols in the forward_window
  * @recoder: recoder structure that will be used
@@ -302,7 +419,7 @@ static inline void nck_interflow_sw_rec_apply_forward_window(struct nck_interflo
 	/* enable the new symbols */
 	for (s = local_seqno - enabled_symbols; s != local_seqno; s++) {
 		i = s % symbols;
-		coder->nested()->enable_symbol(i);
+		nck_interflow_sw_rec_enable_symbol(recoder, i);
 	}
 
 	/* disable the symbols which moved out of the forwarding window */
@@ -310,7 +427,7 @@ static inline void nck_interflow_sw_rec_apply_forward_window(struct nck_interflo
 	for (s = local_seqno - recoder->forward_code_window - disabled_symbols;
 	     s != local_seqno - recoder->forward_code_window; s++) {
 		i = s % symbols;
-		coder->nested()->disable_symbol(i);
+		nck_interflow_sw_rec_disable_symbol(recoder, i);
 	}
 }
 
@@ -428,6 +545,7 @@ EXPORT
 int nck_interflow_sw_rec_put_coded(struct nck_interflow_sw_rec *recoder, struct sk_buff *packet)
 {
 	struct interflow_sw_coded_packet *interflow_sw_coded_packet;
+	struct sk_buff expanded;
 	auto coder = recoder->coder;
 	uint32_t symbols = coder->symbols();
 	uint32_t pos, previous_seqno;
@@ -444,6 +562,15 @@ int nck_interflow_sw_rec_put_coded(struct nck_interflow_sw_rec *recoder, struct
 	if (interflow_sw_coded_packet->packet_type != INTERFLOW_SW_PACKET_TYPE_CODED)
 		return -1;
 
+	/* rebuild the kodo header if the coefficients were sent as a seed */
+	if (interflow_sw_coded_packet->flags & INTERFLOW_SW_CODED_PACKET_SEED) {
+		recoder->seed_buffer.resize(coder->payload_size());
+		if (nck_interflow_sw_common_expand_seed(packet, &expanded, recoder->seed_buffer.data(),
+							recoder->seed_buffer.size(), symbols))
+			return -1;
+		packet = &expanded;
+	}
+
 	/* should hold a least the sequence number + systematic flag */
 	if (!pskb_may_pull(packet, recoder->header_size))
 		return -1;
@@ -575,6 +702,12 @@ int nck_interflow_sw_rec_get_coded(struct nck_interflow_sw_rec *recoder, struct
 	 */
 	rate_control_step(&recoder->rc, 0);
 
+	if (!nck_interflow_sw_rec_has_innovative(recoder)) {
+		// the downstream decoder has everything we could combine
+		recoder->stats.s[NCK_STATS_GET_CODED_SKIPPED_NOT_INNOVATIVE]++;
+		return -1;
+	}
+
 	skb_reserve(packet, sizeof(*interflow_sw_coded_packet));
 
 	size_t payload_size = coder->payload_size();
@@ -586,6 +719,8 @@ int nck_interflow_sw_rec_get_coded(struct nck_interflow_sw_rec *recoder, struct
 	}
 
 	recoder->stats.s[NCK_STATS_GET_CODED]++;
+	if (recoder->hist)
+		nck_histogram_record(&recoder->hist->h[NCK_HISTOGRAM_WINDOW], coder->rank());
 
 	assert(payload_size >= real_size);
 	skb_trim(packet, payload_size - real_size);
@@ -608,6 +743,8 @@ int nck_interflow_sw_rec_get_coded(struct nck_interflow_sw_rec *recoder, struct
 		recoder->flush_next = 0;
 	}
 
+	rate_control_sent_log_add(&recoder->sent_log, ntohs(interflow_sw_coded_packet->packet_no));
+
 	return 0;
 }
 
@@ -627,6 +764,14 @@ struct nck_stats *nck_interflow_sw_rec_get_stats(void *rec)
 	return &recoder->stats;
 }
 
+EXPORT
+struct nck_histograms *nck_interflow_sw_rec_get_histograms(void *rec)
+{
+	struct nck_interflow_sw_rec *recoder = (struct nck_interflow_sw_rec*)rec;
+
+	return recoder->hist;
+}
+
 EXPORT
 int nck_interflow_sw_rec_get_source(struct nck_interflow_sw_rec *recoder, struct sk_buff *packet)
 {
@@ -677,14 +822,17 @@ static inline void nck_interflow_sw_rec_schedule_retransmission(struct nck_inter
 
 	/* TODO: this can be implemented in various ways. We may want to make this
 	 * configurable from outside, and switch() between various ways. For now,
-	 * just use a stupid resender which sends as much as the feedback is missing,
-	 * regardless of whether we even have the needed information. We do not send
-	 * more than our own rank, though. */
+	 * send as much as the feedback is missing of what we hold ourselves. We
+	 * do not send more than our own rank, though. */
 	count = 0;
 	for (i = 0; i < symbols; i++) {
 		if ((data[i/8] & (1 << (i%8))) == 0)
 			continue;
 
+		/* we can not help with symbols we do not have */
+		if (!coder->is_symbol_pivot(i))
+			continue;
+
 		rate_control_insert(&recoder->rc, true);
 
 		count++;
@@ -745,10 +893,10 @@ static inline void nck_interflow_sw_rec_apply_feedback(struct nck_interflow_sw_r
 		/* enable/disable symbols */
 		if ((data[i/8] & (1 << (i%8))) == 0) {
 			/* index was acknowledged, disable it */
-			coder->nested()->disable_symbol(i);
+			nck_interflow_sw_rec_disable_symbol(recoder, i);
 		} else {
 			/* index is missing, enable it */
-			coder->nested()->enable_symbol(i);
+			nck_interflow_sw_rec_enable_symbol(recoder, i);
 		}
 	}
 
@@ -787,6 +935,11 @@ int nck_interflow_sw_rec_put_feedback(struct nck_interflow_sw_rec *recoder, stru
 	if ((-symbols < feedback_no_diff) && (feedback_no_diff <= 0))
 		return 0;
 
+	/* the feedback describes the link behind us, so it drives our redundancy */
+	rate_control_sent_log_feedback(&recoder->rc, &recoder->sent_log,
+				       ntohs(interflow_sw_feedback_packet->packet_no),
+				       interflow_sw_feedback_packet->received, 0);
+
 	nck_interflow_sw_rec_apply_feedback(recoder, packet->data, feedback_sequence);
 
 	/* copy the feedback to send it out again */
@@ -1,3 +1,5 @@
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -8,6 +10,7 @@
 
 #include "kodo.h"
 #include "config.h"
+#include "util/finite_field.h"
 
 krlnc_encoder_t kodo_build_encoder(krlnc_encoder_factory_t factory)
 {
@@ -25,6 +28,83 @@ krlnc_decoder_t kodo_build_decoder(krlnc_decoder_factory_t factory)
 	return dec;
 }
 
+void kodo_encoder_pool_init(struct kodo_encoder_pool *pool, krlnc_encoder_factory_t factory)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->factory = factory;
+}
+
+void kodo_encoder_pool_free(struct kodo_encoder_pool *pool)
+{
+	while (pool->count > 0)
+		krlnc_delete_encoder(pool->coders[--pool->count]);
+}
+
+krlnc_encoder_t kodo_encoder_pool_get(struct kodo_encoder_pool *pool)
+{
+	krlnc_encoder_t enc;
+
+	if (pool->count == 0)
+		return kodo_build_encoder(pool->factory);
+
+	enc = pool->coders[--pool->count];
+	krlnc_encoder_set_seed(enc, rand());
+	return enc;
+}
+
+void kodo_encoder_pool_put(struct kodo_encoder_pool *pool, krlnc_encoder_t encoder)
+{
+	if (!encoder)
+		return;
+
+	/* an encoder without symbols is as good as a new one */
+	if (krlnc_encoder_rank(encoder) == 0 && pool->count < KODO_CODER_POOL_MAX) {
+		pool->coders[pool->count++] = encoder;
+		return;
+	}
+
+	krlnc_delete_encoder(encoder);
+}
+
+void kodo_decoder_pool_init(struct kodo_decoder_pool *pool, krlnc_decoder_factory_t factory)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->factory = factory;
+}
+
+void kodo_decoder_pool_free(struct kodo_decoder_pool *pool)
+{
+	while (pool->count > 0)
+		krlnc_delete_decoder(pool->coders[--pool->count]);
+}
+
+krlnc_decoder_t kodo_decoder_pool_get(struct kodo_decoder_pool *pool)
+{
+	krlnc_decoder_t dec;
+
+	if (pool->count == 0)
+		return kodo_build_decoder(pool->factory);
+
+	dec = pool->coders[--pool->count];
+	krlnc_decoder_set_seed(dec, rand());
+	return dec;
+}
+
+void kodo_decoder_pool_put(struct kodo_decoder_pool *pool, krlnc_decoder_t decoder)
+{
+	if (!decoder)
+		return;
+
+	/* a decoder that has not seen a symbol is as good as a new one, its
+	 * storage is set again by the next user */
+	if (krlnc_decoder_rank(decoder) == 0 && pool->count < KODO_CODER_POOL_MAX) {
+		pool->coders[pool->count++] = decoder;
+		return;
+	}
+
+	krlnc_delete_decoder(decoder);
+}
+
 /**
  * kodo_skip_undecoded - sets index to the next decoded symbol or the end of
  *   the generation
@@ -104,15 +184,46 @@ int kodo_flush_source(krlnc_decoder_t decoder, uint8_t *symbol_storage, uint32_t
 	return count;
 }
 
+size_t kodo_encoder_payload_size(krlnc_encoder_t encoder)
+{
+	return 1 + krlnc_encoder_payload_size(encoder);
+}
+
+size_t kodo_decoder_payload_size(krlnc_decoder_t decoder)
+{
+	return 1 + krlnc_decoder_payload_size(decoder);
+}
+
 int kodo_put_coded(krlnc_decoder_t decoder, struct sk_buff *packet)
 {
-	int symbol_size;
+	uint32_t symbols, symbol_size;
+	uint8_t type;
 
-	symbol_size = krlnc_decoder_symbol_size(decoder);
-	skb_put_zeros(packet, symbol_size);
+	if (packet->len < 1) {
+		return -1;
+	}
 
-	krlnc_decoder_read_payload(decoder, packet->data);
-	return 0;
+	type = packet->data[0];
+	skb_pull(packet, 1);
+
+	switch (type) {
+	case KODO_PAYLOAD_KRLNC:
+		skb_put_zeros(packet, krlnc_decoder_payload_size(decoder));
+		krlnc_decoder_read_payload(decoder, packet->data);
+		return 0;
+	case KODO_PAYLOAD_SYMBOL:
+		symbols = krlnc_decoder_symbols(decoder);
+		symbol_size = krlnc_decoder_symbol_size(decoder);
+		if (krlnc_decoder_coefficient_vector_size(decoder) != symbols) {
+			return -1;
+		}
+
+		skb_put_zeros(packet, symbols + symbol_size);
+		krlnc_decoder_read_symbol(decoder, packet->data + symbols, packet->data);
+		return 0;
+	default:
+		return -1;
+	}
 }
 
 int kodo_decoder_get_coded(krlnc_decoder_t decoder, struct sk_buff *packet)
@@ -120,12 +231,12 @@ int kodo_decoder_get_coded(krlnc_decoder_t decoder, struct sk_buff *packet)
 	uint8_t *payload;
 	size_t payload_size, real_size;
 
+	*(uint8_t *)skb_put(packet, 1) = KODO_PAYLOAD_KRLNC;
+
 	payload_size = krlnc_decoder_payload_size(decoder);
 	payload = skb_put(packet, payload_size);
 	real_size = krlnc_decoder_write_payload(decoder, payload);
-	if (payload_size > packet->len) {
-		skb_trim(packet, payload_size - real_size);
-	}
+	skb_trim(packet, payload_size - real_size);
 	skb_trim_zeros(packet);
 
 	return 0;
@@ -136,13 +247,147 @@ int kodo_encoder_get_coded(krlnc_encoder_t encoder, struct sk_buff *packet)
 	uint8_t *payload;
 	size_t payload_size, real_size;
 
+	*(uint8_t *)skb_put(packet, 1) = KODO_PAYLOAD_KRLNC;
+
 	payload_size = krlnc_encoder_payload_size(encoder);
 	payload = skb_put(packet, payload_size);
 	real_size = krlnc_encoder_write_payload(encoder, payload);
-	if (payload_size > packet->len) {
-		skb_trim(packet, payload_size - real_size);
+	skb_trim(packet, payload_size - real_size);
+	skb_trim_zeros(packet);
+
+	return 0;
+}
+
+void kodo_repair_batch_init(struct kodo_repair_batch *batch, krlnc_encoder_factory_t factory)
+{
+	memset(batch, 0, sizeof(*batch));
+
+	batch->symbols = krlnc_encoder_factory_symbols(factory);
+	batch->symbol_size = krlnc_encoder_factory_symbol_size(factory);
+	batch->payload_size = 1 + batch->symbols + batch->symbol_size;
+	batch->seed = rand();
+	batch->usable = 1;
+}
+
+void kodo_repair_batch_free(struct kodo_repair_batch *batch)
+{
+	free(batch->storage);
+	free(batch->factors);
+	free(batch->sources);
+	memset(batch, 0, sizeof(*batch));
+}
+
+void kodo_repair_batch_clear(struct kodo_repair_batch *batch)
+{
+	batch->count = 0;
+	batch->next = 0;
+}
+
+/**
+ * kodo_repair_batch_alloc - check the encoder and allocate the batch memory
+ *
+ * @batch: batch to prepare
+ * @encoder: encoder that the repairs are generated for
+ *
+ * The symbol payload carries one byte per coefficient, so only binary8
+ * encoders are supported. The batch is not used again if it would make the
+ * payloads larger than those of the encoder.
+ *
+ * Return: 0 if the batch can be filled
+ */
+static int kodo_repair_batch_alloc(struct kodo_repair_batch *batch, krlnc_encoder_t encoder)
+{
+	if (batch->storage) {
+		return 0;
+	}
+
+	if (krlnc_encoder_coefficient_vector_size(encoder) != batch->symbols ||
+	    batch->payload_size > kodo_encoder_payload_size(encoder)) {
+		batch->usable = 0;
+		return -1;
+	}
+
+	binary8_init();
+
+	batch->storage = malloc(KODO_REPAIR_BATCH_MAX * batch->payload_size);
+	batch->factors = malloc(KODO_REPAIR_BATCH_MAX * batch->symbols);
+	batch->sources = malloc(batch->symbols * sizeof(*batch->sources));
+	if (!batch->storage || !batch->factors || !batch->sources) {
+		free(batch->storage);
+		free(batch->factors);
+		free(batch->sources);
+		batch->storage = NULL;
+		batch->factors = NULL;
+		batch->sources = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * kodo_repair_batch_fill - generate a batch of repair payloads
+ *
+ * @batch: batch to fill, queued payloads are dropped
+ * @symbol_storage: memory block where the symbols are stored
+ * @rank: number of source symbols in the block
+ * @count: number of repair payloads to generate
+ */
+static void kodo_repair_batch_fill(struct kodo_repair_batch *batch,
+		const uint8_t *symbol_storage, uint32_t rank, uint32_t count)
+{
+	uint8_t *dests[KODO_REPAIR_BATCH_MAX];
+	uint8_t *payload, *coefficients;
+	uint32_t r, i;
+
+	if (count > KODO_REPAIR_BATCH_MAX) {
+		count = KODO_REPAIR_BATCH_MAX;
+	}
+
+	for (i = 0; i < rank; ++i) {
+		batch->sources[i] = (uint8_t *)&symbol_storage[i * batch->symbol_size];
+	}
+
+	for (r = 0; r < count; ++r) {
+		payload = &batch->storage[r * batch->payload_size];
+		coefficients = payload + 1;
+
+		payload[0] = KODO_PAYLOAD_SYMBOL;
+		memset(coefficients, 0, batch->symbols);
+		for (i = 0; i < rank; ++i) {
+			coefficients[i] = 1 + rand_r(&batch->seed) % 255;
+			batch->factors[r * rank + i] = coefficients[i];
+		}
+
+		dests[r] = coefficients + batch->symbols;
+		memset(dests[r], 0, batch->symbol_size);
+	}
+
+	binary8_region_multiply_sum_batch(dests, count, batch->sources, batch->factors, rank, batch->symbol_size);
+
+	batch->count = count;
+	batch->next = 0;
+}
+
+int kodo_encoder_get_repair(krlnc_encoder_t encoder, struct kodo_repair_batch *batch,
+		const uint8_t *symbol_storage, uint32_t rank, uint32_t pending,
+		struct sk_buff *packet)
+{
+	uint8_t *payload;
+
+	if (batch->usable && batch->next == batch->count && pending > 1 && rank > 0 &&
+	    !kodo_repair_batch_alloc(batch, encoder)) {
+		kodo_repair_batch_fill(batch, symbol_storage, rank, pending);
+	}
+
+	if (batch->next == batch->count) {
+		return kodo_encoder_get_coded(encoder, packet);
 	}
+
+	payload = skb_put(packet, batch->payload_size);
+	memcpy(payload, &batch->storage[batch->next * batch->payload_size], batch->payload_size);
 	skb_trim_zeros(packet);
+	batch->next += 1;
 
 	return 0;
 }
@@ -193,15 +438,13 @@ int get_kodo_options(krlnc_coding_vector_format *codec, krlnc_finite_field *fiel
 		return -1;
 	}
 
-	value = get_opt(context, "symbols");
-	if (nck_parse_u32(symbols, value)) {
-		fprintf(stderr, "Invalid symbol count: %s\n", value);
+	if (nck_get_opt_u32(symbols, context, get_opt, "symbols")) {
+		fprintf(stderr, "Invalid symbol count: %s\n", get_opt(context, "symbols"));
 		return -1;
 	}
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol size: %s\n", value);
+	if (nck_get_opt_u32(symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -209,6 +452,110 @@ int get_kodo_options(krlnc_coding_vector_format *codec, krlnc_finite_field *fiel
 }
 
 
+/**
+ * struct kodo_shared_factory - factory with more than one owner
+ * @factory: krlnc encoder or decoder factory
+ * @owners: number of owners that did not release the factory yet
+ * @next: next shared factory
+ *
+ * Factories that are not in the list have a single owner.
+ */
+struct kodo_shared_factory {
+	void *factory;
+	unsigned int owners;
+	struct kodo_shared_factory *next;
+};
+
+static struct kodo_shared_factory *kodo_shared_factories;
+static pthread_mutex_t kodo_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * kodo_share_factory - add an owner to a factory
+ * @factory: krlnc encoder or decoder factory
+ *
+ * Return: 0 on success, -1 if no memory is available
+ */
+static int kodo_share_factory(void *factory)
+{
+	struct kodo_shared_factory *shared;
+	int result = 0;
+
+	pthread_mutex_lock(&kodo_shared_lock);
+	for (shared = kodo_shared_factories; shared; shared = shared->next) {
+		if (shared->factory == factory)
+			break;
+	}
+
+	if (shared) {
+		shared->owners += 1;
+	} else {
+		shared = malloc(sizeof(*shared));
+		if (shared) {
+			shared->factory = factory;
+			shared->owners = 2;
+			shared->next = kodo_shared_factories;
+			kodo_shared_factories = shared;
+		} else {
+			result = -1;
+		}
+	}
+	pthread_mutex_unlock(&kodo_shared_lock);
+
+	return result;
+}
+
+/**
+ * kodo_release_factory - drop an owner of a factory
+ * @factory: krlnc encoder or decoder factory
+ *
+ * Return: true if the caller was the last owner and has to delete @factory
+ */
+static bool kodo_release_factory(void *factory)
+{
+	struct kodo_shared_factory **prev, *shared;
+	bool last = true;
+
+	pthread_mutex_lock(&kodo_shared_lock);
+	for (prev = &kodo_shared_factories; *prev; prev = &(*prev)->next) {
+		shared = *prev;
+		if (shared->factory != factory)
+			continue;
+
+		shared->owners -= 1;
+		last = false;
+		if (shared->owners == 1) {
+			*prev = shared->next;
+			free(shared);
+		}
+		break;
+	}
+	pthread_mutex_unlock(&kodo_shared_lock);
+
+	return last;
+}
+
+void kodo_delete_encoder_factory(krlnc_encoder_factory_t factory)
+{
+	if (kodo_release_factory(factory))
+		krlnc_delete_encoder_factory(factory);
+}
+
+void kodo_delete_decoder_factory(krlnc_decoder_factory_t factory)
+{
+	if (kodo_release_factory(factory))
+		krlnc_delete_decoder_factory(factory);
+}
+
+static void kodo_release_encoder_factory(void *factory)
+{
+	kodo_delete_encoder_factory((krlnc_encoder_factory_t)factory);
+}
+
+static void kodo_release_decoder_factory(void *factory)
+{
+	kodo_delete_decoder_factory((krlnc_decoder_factory_t)factory);
+}
+
 int get_kodo_enc_factory(krlnc_encoder_factory_t *factory,
 		void *context, nck_opt_getter get_opt)
 {
@@ -216,12 +563,25 @@ int get_kodo_enc_factory(krlnc_encoder_factory_t *factory,
 	krlnc_finite_field field = krlnc_binary8;
 	krlnc_coding_vector_format codec = krlnc_full_vector;
 
+	// coders of a compiled configuration use the same factory
+	*factory = (krlnc_encoder_factory_t)nck_config_shared(context, get_opt, "kodo_encoder_factory");
+	if (*factory && !kodo_share_factory(*factory))
+		return 0;
+
 	if (get_kodo_options(&codec, &field, &symbols, &symbol_size, context, get_opt)) {
 		return -1;
 	}
 
 	*factory = krlnc_new_encoder_factory(field, symbols, symbol_size);
 	krlnc_encoder_factory_set_coding_vector_format(*factory, codec);
+
+	// the configuration keeps a reference for the coders created from it,
+	// without memory to track the owners this coder gets its own factory
+	if (!nck_config_share(context, get_opt, "kodo_encoder_factory", *factory, kodo_release_encoder_factory) &&
+	    kodo_share_factory(*factory)) {
+		*factory = krlnc_new_encoder_factory(field, symbols, symbol_size);
+		krlnc_encoder_factory_set_coding_vector_format(*factory, codec);
+	}
 	return 0;
 }
 
@@ -232,12 +592,24 @@ int get_kodo_dec_factory(krlnc_decoder_factory_t *factory,
 	krlnc_finite_field field = krlnc_binary8;
 	krlnc_coding_vector_format codec = krlnc_full_vector;
 
+	// coders of a compiled configuration use the same factory
+	*factory = (krlnc_decoder_factory_t)nck_config_shared(context, get_opt, "kodo_decoder_factory");
+	if (*factory && !kodo_share_factory(*factory))
+		return 0;
+
 	if (get_kodo_options(&codec, &field, &symbols, &symbol_size, context, get_opt)) {
 		return -1;
 	}
 
 	*factory = krlnc_new_decoder_factory(field, symbols, symbol_size);
 	krlnc_decoder_factory_set_coding_vector_format(*factory, codec);
+
+	// the configuration keeps a reference for the coders created from it,
+	// without memory to track the owners this coder gets its own factory
+	if (!nck_config_share(context, get_opt, "kodo_decoder_factory", *factory, kodo_release_decoder_factory) &&
+	    kodo_share_factory(*factory)) {
+		*factory = krlnc_new_decoder_factory(field, symbols, symbol_size);
+		krlnc_decoder_factory_set_coding_vector_format(*factory, codec);
+	}
 	return 0;
 }
-
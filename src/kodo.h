@@ -10,6 +10,94 @@ krlnc_encoder_t kodo_build_encoder(krlnc_encoder_factory_t factory);
 
 krlnc_decoder_t kodo_build_decoder(krlnc_decoder_factory_t factory);
 
+/**
+ * Maximum number of idle coders kept by a coder pool.
+ */
+#define KODO_CODER_POOL_MAX 4
+
+/**
+ * Coders built from the factory of a coder that wait to be used.
+ *
+ * krlnc cannot reset a coder, so a coder that took symbols or payloads has to
+ * be deleted. Coders that are still empty, e.g. the one built to query the
+ * sizes at creation or the coder of a generation that retired without data,
+ * are kept and handed out instead of building a new one. The factory stays
+ * owned by the caller.
+ */
+struct kodo_encoder_pool {
+	krlnc_encoder_factory_t factory;
+	uint32_t count;
+	krlnc_encoder_t coders[KODO_CODER_POOL_MAX];
+};
+
+/**
+ * Decoders built from the factory of a coder that wait to be used.
+ *
+ * See struct kodo_encoder_pool. The caller has to set the symbol storage of
+ * every decoder it takes from the pool.
+ */
+struct kodo_decoder_pool {
+	krlnc_decoder_factory_t factory;
+	uint32_t count;
+	krlnc_decoder_t coders[KODO_CODER_POOL_MAX];
+};
+
+/**
+ * Create an empty encoder pool.
+ *
+ * @param pool Pool to initialize
+ * @param factory Factory that builds the encoders
+ */
+void kodo_encoder_pool_init(struct kodo_encoder_pool *pool, krlnc_encoder_factory_t factory);
+/**
+ * Delete all idle encoders of a pool.
+ *
+ * @param pool Pool to free
+ */
+void kodo_encoder_pool_free(struct kodo_encoder_pool *pool);
+/**
+ * Take an empty encoder from the pool, building one if the pool is empty.
+ *
+ * @param pool Pool to use
+ * @returns Encoder with a new seed
+ */
+krlnc_encoder_t kodo_encoder_pool_get(struct kodo_encoder_pool *pool);
+/**
+ * Give an encoder back, it is deleted unless it is still empty.
+ *
+ * @param pool Pool to use
+ * @param encoder Encoder from kodo_encoder_pool_get(), may be NULL
+ */
+void kodo_encoder_pool_put(struct kodo_encoder_pool *pool, krlnc_encoder_t encoder);
+
+/**
+ * Create an empty decoder pool.
+ *
+ * @param pool Pool to initialize
+ * @param factory Factory that builds the decoders
+ */
+void kodo_decoder_pool_init(struct kodo_decoder_pool *pool, krlnc_decoder_factory_t factory);
+/**
+ * Delete all idle decoders of a pool.
+ *
+ * @param pool Pool to free
+ */
+void kodo_decoder_pool_free(struct kodo_decoder_pool *pool);
+/**
+ * Take an empty decoder from the pool, building one if the pool is empty.
+ *
+ * @param pool Pool to use
+ * @returns Decoder with a new seed
+ */
+krlnc_decoder_t kodo_decoder_pool_get(struct kodo_decoder_pool *pool);
+/**
+ * Give a decoder back, it is deleted unless it is still empty.
+ *
+ * @param pool Pool to use
+ * @param decoder Decoder from kodo_decoder_pool_get(), may be NULL
+ */
+void kodo_decoder_pool_put(struct kodo_decoder_pool *pool, krlnc_decoder_t decoder);
+
 /**
  * Increment the index untin the next decoded symbol is found.
  *
@@ -48,6 +136,35 @@ int kodo_get_source(krlnc_decoder_t decoder, struct sk_buff *packet, uint8_t *sy
  * @returns Number of stored packets
  */
 int kodo_flush_source(krlnc_decoder_t decoder, uint8_t *symbol_storage, uint32_t index, uint8_t *buffer);
+/**
+ * Type of a coded payload, the first byte of every payload written here.
+ *
+ * KODO_PAYLOAD_KRLNC is followed by a payload of krlnc_encoder_write_payload()
+ * or krlnc_decoder_write_payload().
+ *
+ * KODO_PAYLOAD_SYMBOL is followed by the coefficient vector, one binary8
+ * coefficient for every symbol of the block, and the coded symbol. This is
+ * the input of krlnc_decoder_read_symbol(). Trailing zeros may be removed.
+ */
+enum kodo_payload_type {
+	KODO_PAYLOAD_KRLNC = 0,
+	KODO_PAYLOAD_SYMBOL = 1,
+};
+
+/**
+ * Maximum size of a payload of the encoder, including the payload type.
+ *
+ * @param encoder Kodo encoder
+ * @returns Size in bytes
+ */
+size_t kodo_encoder_payload_size(krlnc_encoder_t encoder);
+/**
+ * Maximum size of a payload of the decoder, including the payload type.
+ *
+ * @param decoder Kodo decoder
+ * @returns Size in bytes
+ */
+size_t kodo_decoder_payload_size(krlnc_decoder_t decoder);
 /**
  * Give a coded packet to the decoder
  *
@@ -63,12 +180,101 @@ int kodo_put_coded(krlnc_decoder_t decoder, struct sk_buff *packet);
  * @returns 0 on success
  */
 int kodo_encoder_get_coded(krlnc_encoder_t encoder, struct sk_buff *packet);
+
+/**
+ * Maximum number of repair payloads generated in one pass over the block.
+ */
+#define KODO_REPAIR_BATCH_MAX 16
+
+/**
+ * Queue of repair payloads that were generated together.
+ *
+ * All repairs of a batch are computed in a single blocked pass over the
+ * source symbols instead of one pass per repair and are sent as
+ * KODO_PAYLOAD_SYMBOL payloads. The batch is only used with binary8
+ * coefficient vectors, otherwise callers fall back to
+ * kodo_encoder_get_coded(). The memory is allocated with the first batch.
+ */
+struct kodo_repair_batch {
+	uint32_t symbols;
+	uint32_t symbol_size;
+	size_t payload_size;
+	unsigned int seed;
+	int usable;
+
+	uint32_t count;
+	uint32_t next;
+
+	uint8_t *storage;
+	uint8_t *factors;
+	uint8_t **sources;
+};
+
+/**
+ * Prepare a repair batch for encoders built from a factory.
+ *
+ * @param batch Batch to initialize
+ * @param factory Factory that is used to build the encoders
+ */
+void kodo_repair_batch_init(struct kodo_repair_batch *batch, krlnc_encoder_factory_t factory);
+/**
+ * Release the memory of a repair batch.
+ *
+ * @param batch Batch to free
+ */
+void kodo_repair_batch_free(struct kodo_repair_batch *batch);
+/**
+ * Drop all queued repair payloads, e.g. because the block changed.
+ *
+ * @param batch Batch to clear
+ */
+void kodo_repair_batch_clear(struct kodo_repair_batch *batch);
+/**
+ * Retrieve a repair packet, generating a new batch if required.
+ *
+ * Queued repairs are returned first. If the queue is empty and more than one
+ * repair is pending, up to KODO_REPAIR_BATCH_MAX repairs over the first
+ * @rank symbols are generated together. Otherwise the packet is produced by
+ * the encoder itself. The caller has to make sure that the encoder has left
+ * its systematic phase and has to clear the batch when the block changes.
+ *
+ * @param encoder Kodo encoder
+ * @param batch Batch belonging to the encoder
+ * @param symbol_storage Memory block where the symbols are stored
+ * @param rank Number of source symbols in the block
+ * @param pending Number of repair packets that will be requested
+ * @param packet Packet where the coded payload will be stored
+ * @returns 0 on success
+ */
+int kodo_encoder_get_repair(krlnc_encoder_t encoder, struct kodo_repair_batch *batch,
+		const uint8_t *symbol_storage, uint32_t rank, uint32_t pending,
+		struct sk_buff *packet);
 int kodo_decoder_get_coded(krlnc_decoder_t encoder, struct sk_buff *packet);
 
 int get_kodo_codec(krlnc_coding_vector_format *codec, const char *name);
 int get_kodo_field(krlnc_finite_field *field, const char *name);
+/**
+ * Create the kodo factory of a coder from its options.
+ *
+ * Coders that are created from a compiled configuration share the factory of
+ * the configuration. Coders must release the factory with
+ * kodo_delete_encoder_factory() or kodo_delete_decoder_factory().
+ */
 int get_kodo_enc_factory(krlnc_encoder_factory_t *factory, void *context, nck_opt_getter get_opt);
 int get_kodo_dec_factory(krlnc_decoder_factory_t *factory, void *context, nck_opt_getter get_opt);
 
+/**
+ * Release a factory, it is deleted when no other coder uses it.
+ *
+ * @param factory Factory from get_kodo_enc_factory() or passed to the coder
+ */
+void kodo_delete_encoder_factory(krlnc_encoder_factory_t factory);
+/**
+ * Release a factory, it is deleted when no other coder uses it.
+ *
+ * @param factory Factory from get_kodo_dec_factory() or passed to the coder
+ */
+void kodo_delete_decoder_factory(krlnc_decoder_factory_t factory);
+
 #endif /* _KODO_H_ */
 
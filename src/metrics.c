@@ -0,0 +1,482 @@
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <nckernel/metrics.h>
+#include <nckernel/timer.h>
+
+#include "private.h"
+
+struct metrics_entry {
+	struct metrics_entry *next;
+	struct nck_coder *coder;
+	char name[NCK_METRICS_NAME_SIZE];
+};
+
+/**
+ * struct metrics_sample - copy of a coder taken by nck_metrics_snapshot()
+ * @name: name of the coder
+ * @flags: NCK_METRICS_HAS_STATS and NCK_METRICS_HAS_HISTOGRAMS
+ * @stats: counters of the coder
+ * @histograms: raw histograms, the percentiles are computed by the server
+ */
+struct metrics_sample {
+	char name[NCK_METRICS_NAME_SIZE];
+	uint32_t flags;
+	struct nck_stats stats;
+	struct nck_histograms histograms;
+};
+
+struct nck_metrics {
+	struct metrics_entry *entries;
+	size_t count;
+
+	struct timeval interval;
+	struct nck_timer_entry *timeout;
+
+	// the snapshot is shared with the server thread
+	pthread_mutex_t lock;
+	struct metrics_sample *samples;
+	size_t samples_count;
+	size_t samples_capacity;
+	uint64_t time;
+
+	int listening;
+	int fd;
+	int format;
+	char *path;
+	pthread_t thread;
+};
+
+static void metrics_timeout(struct nck_timer_entry *entry, void *context, int success)
+{
+	struct nck_metrics *metrics = (struct nck_metrics *)context;
+
+	if (!success)
+		return;
+
+	nck_metrics_snapshot(metrics);
+	nck_timer_rearm(entry, &metrics->interval);
+}
+
+EXPORT
+struct nck_metrics *nck_metrics(struct nck_timer *timer, const struct timeval *interval)
+{
+	struct nck_metrics *result;
+
+	result = malloc(sizeof(*result));
+	if (!result)
+		return NULL;
+
+	memset(result, 0, sizeof(*result));
+	pthread_mutex_init(&result->lock, NULL);
+	result->fd = -1;
+
+	if (timer && interval && timerisset(interval)) {
+		result->interval = *interval;
+		result->timeout = nck_timer_add(timer, &result->interval, result, metrics_timeout);
+	}
+
+	return result;
+}
+
+EXPORT
+void nck_metrics_free(struct nck_metrics *metrics)
+{
+	struct metrics_entry *entry;
+
+	if (metrics->listening) {
+		// wakes up the blocking accept of the server thread
+		shutdown(metrics->fd, SHUT_RDWR);
+		pthread_join(metrics->thread, NULL);
+		close(metrics->fd);
+		unlink(metrics->path);
+		free(metrics->path);
+	}
+
+	if (metrics->timeout) {
+		nck_timer_cancel(metrics->timeout);
+		nck_timer_free(metrics->timeout);
+	}
+
+	while (metrics->entries) {
+		entry = metrics->entries;
+		metrics->entries = entry->next;
+		free(entry);
+	}
+
+	pthread_mutex_destroy(&metrics->lock);
+	free(metrics->samples);
+	free(metrics);
+}
+
+EXPORT
+int nck_metrics_add(struct nck_metrics *metrics, struct nck_coder *coder, const char *name)
+{
+	struct metrics_entry *entry, **tail;
+
+	entry = malloc(sizeof(*entry));
+	if (!entry)
+		return -1;
+
+	entry->next = NULL;
+	entry->coder = coder;
+	snprintf(entry->name, sizeof(entry->name), "%s", name);
+
+	// keep the order in which the coders were added
+	for (tail = &metrics->entries; *tail; tail = &(*tail)->next)
+		;
+	*tail = entry;
+	metrics->count += 1;
+
+	return 0;
+}
+
+EXPORT
+void nck_metrics_del(struct nck_metrics *metrics, struct nck_coder *coder)
+{
+	struct metrics_entry *entry, **link;
+
+	for (link = &metrics->entries; *link; link = &(*link)->next) {
+		entry = *link;
+		if (entry->coder == coder) {
+			*link = entry->next;
+			metrics->count -= 1;
+			free(entry);
+			return;
+		}
+	}
+}
+
+EXPORT
+void nck_metrics_snapshot(struct nck_metrics *metrics)
+{
+	struct metrics_sample *sample, *samples;
+	struct metrics_entry *entry;
+	struct nck_stats *stats;
+	struct nck_histograms *histograms;
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+
+	pthread_mutex_lock(&metrics->lock);
+
+	if (metrics->count > metrics->samples_capacity) {
+		samples = realloc(metrics->samples, metrics->count * sizeof(*samples));
+		if (!samples) {
+			pthread_mutex_unlock(&metrics->lock);
+			return;
+		}
+		metrics->samples = samples;
+		metrics->samples_capacity = metrics->count;
+	}
+
+	sample = metrics->samples;
+	for (entry = metrics->entries; entry; entry = entry->next, ++sample) {
+		memcpy(sample->name, entry->name, sizeof(sample->name));
+		sample->flags = 0;
+
+		stats = nck_get_stats(entry->coder);
+		if (stats) {
+			sample->stats = *stats;
+			sample->flags |= NCK_METRICS_HAS_STATS;
+		}
+
+		histograms = nck_get_histograms(entry->coder);
+		if (histograms) {
+			sample->histograms = *histograms;
+			sample->flags |= NCK_METRICS_HAS_HISTOGRAMS;
+		}
+	}
+
+	metrics->samples_count = metrics->count;
+	metrics->time = (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
+
+	pthread_mutex_unlock(&metrics->lock);
+}
+
+static void metrics_summarize(struct nck_metrics_summary *summary, const struct nck_histogram *histogram)
+{
+	summary->count = histogram->count;
+	summary->sum = histogram->sum;
+	summary->max = histogram->max;
+	summary->p50 = nck_histogram_percentile(histogram, 50);
+	summary->p90 = nck_histogram_percentile(histogram, 90);
+	summary->p99 = nck_histogram_percentile(histogram, 99);
+}
+
+static void metrics_print_name(FILE *out, const char *prefix, const char *name, const char *suffix)
+{
+	fputs(prefix, out);
+	for (; *name; ++name)
+		fputc(tolower((unsigned char)*name), out);
+	fputs(suffix, out);
+}
+
+static void metrics_print_label(FILE *out, const char *name)
+{
+	fputs("{coder=\"", out);
+	for (; *name; ++name) {
+		if (*name == '\\' || *name == '"')
+			fputc('\\', out);
+
+		if (*name == '\n')
+			fputs("\\n", out);
+		else
+			fputc(*name, out);
+	}
+	fputc('"', out);
+}
+
+static void metrics_write_prometheus(FILE *out, const struct nck_metrics_record *records,
+				     size_t count, uint64_t time)
+{
+	static const char *quantiles[] = { "0.5", "0.9", "0.99" };
+	const struct nck_metrics_summary *summary;
+	uint32_t values[3], flags = 0;
+	size_t i, q;
+	int type;
+
+	// families without any sample are left out
+	for (i = 0; i < count; ++i)
+		flags |= records[i].flags;
+
+	fprintf(out, "# snapshot at %llu.%06llu\n",
+		(unsigned long long)(time / 1000000), (unsigned long long)(time % 1000000));
+
+	fputs("# TYPE nck_coder_info gauge\n", out);
+	for (i = 0; i < count; ++i) {
+		fputs("nck_coder_info", out);
+		metrics_print_label(out, records[i].name);
+		fputs("} 1\n", out);
+	}
+
+	for (type = 0; (flags & NCK_METRICS_HAS_STATS) && type < NCK_STATS_MAX; ++type) {
+		metrics_print_name(out, "# TYPE nck_", nck_stat_string(type), "_total counter\n");
+
+		for (i = 0; i < count; ++i) {
+			if (!(records[i].flags & NCK_METRICS_HAS_STATS))
+				continue;
+
+			metrics_print_name(out, "nck_", nck_stat_string(type), "_total");
+			metrics_print_label(out, records[i].name);
+			fprintf(out, "} %llu\n", (unsigned long long)records[i].stats[type]);
+		}
+	}
+
+	for (type = 0; (flags & NCK_METRICS_HAS_HISTOGRAMS) && type < NCK_HISTOGRAM_MAX; ++type) {
+		metrics_print_name(out, "# TYPE nck_", nck_histogram_string(type), " summary\n");
+
+		for (i = 0; i < count; ++i) {
+			if (!(records[i].flags & NCK_METRICS_HAS_HISTOGRAMS))
+				continue;
+
+			summary = &records[i].histograms[type];
+			values[0] = summary->p50;
+			values[1] = summary->p90;
+			values[2] = summary->p99;
+
+			for (q = 0; q < 3; ++q) {
+				metrics_print_name(out, "nck_", nck_histogram_string(type), "");
+				metrics_print_label(out, records[i].name);
+				fprintf(out, ",quantile=\"%s\"} %u\n", quantiles[q], values[q]);
+			}
+
+			metrics_print_name(out, "nck_", nck_histogram_string(type), "_sum");
+			metrics_print_label(out, records[i].name);
+			fprintf(out, "} %llu\n", (unsigned long long)summary->sum);
+
+			metrics_print_name(out, "nck_", nck_histogram_string(type), "_count");
+			metrics_print_label(out, records[i].name);
+			fprintf(out, "} %llu\n", (unsigned long long)summary->count);
+		}
+
+		// the maximum is a family of its own, a summary has no place for it
+		metrics_print_name(out, "# TYPE nck_", nck_histogram_string(type), "_max gauge\n");
+
+		for (i = 0; i < count; ++i) {
+			if (!(records[i].flags & NCK_METRICS_HAS_HISTOGRAMS))
+				continue;
+
+			metrics_print_name(out, "nck_", nck_histogram_string(type), "_max");
+			metrics_print_label(out, records[i].name);
+			fprintf(out, "} %u\n", records[i].histograms[type].max);
+		}
+	}
+}
+
+EXPORT
+int nck_metrics_write(struct nck_metrics *metrics, FILE *out, int format)
+{
+	struct nck_metrics_header header;
+	struct nck_metrics_record *records, *record;
+	struct metrics_sample *samples, *sample;
+	size_t count, i;
+	uint64_t time;
+	int type;
+
+	// only copy the snapshot under the lock, so the data thread is never
+	// held up by computing the percentiles or by formatting
+	pthread_mutex_lock(&metrics->lock);
+	count = metrics->samples_count;
+	time = metrics->time;
+	samples = malloc((count ? count : 1) * sizeof(*samples));
+	if (!samples) {
+		pthread_mutex_unlock(&metrics->lock);
+		return -1;
+	}
+	if (count)
+		memcpy(samples, metrics->samples, count * sizeof(*samples));
+	pthread_mutex_unlock(&metrics->lock);
+
+	records = calloc(count ? count : 1, sizeof(*records));
+	if (!records) {
+		free(samples);
+		return -1;
+	}
+
+	for (i = 0; i < count; ++i) {
+		sample = &samples[i];
+		record = &records[i];
+
+		memcpy(record->name, sample->name, sizeof(record->name));
+		record->flags = sample->flags;
+		if (sample->flags & NCK_METRICS_HAS_STATS)
+			memcpy(record->stats, sample->stats.s, sizeof(record->stats));
+		if (sample->flags & NCK_METRICS_HAS_HISTOGRAMS)
+			for (type = 0; type < NCK_HISTOGRAM_MAX; ++type)
+				metrics_summarize(&record->histograms[type], &sample->histograms.h[type]);
+	}
+	free(samples);
+
+	if (format == NCK_METRICS_BINARY) {
+		memcpy(header.magic, NCK_METRICS_MAGIC, sizeof(header.magic));
+		header.version = NCK_METRICS_VERSION;
+		header.records = count;
+		header.record_size = sizeof(*records);
+		header.time = time;
+
+		fwrite(&header, sizeof(header), 1, out);
+		fwrite(records, sizeof(*records), count, out);
+	} else {
+		metrics_write_prometheus(out, records, count, time);
+	}
+
+	free(records);
+	return fflush(out) || ferror(out) ? -1 : 0;
+}
+
+static void metrics_send(struct nck_metrics *metrics, int client)
+{
+	const struct timeval timeout = { .tv_sec = 1, .tv_usec = 0 };
+	char *data = NULL;
+	size_t len = 0, pos = 0;
+	ssize_t sent;
+	FILE *out;
+
+	out = open_memstream(&data, &len);
+	if (!out)
+		return;
+
+	nck_metrics_write(metrics, out, metrics->format);
+	fclose(out);
+
+	// a stuck client must not block the next ones for long
+	setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	while (pos < len) {
+		sent = send(client, data + pos, len - pos, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			break;
+		pos += sent;
+	}
+
+	free(data);
+}
+
+static void *metrics_serve(void *context)
+{
+	struct nck_metrics *metrics = (struct nck_metrics *)context;
+	int client;
+
+	while (1) {
+		client = accept(metrics->fd, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			// the socket was shut down by nck_metrics_free
+			break;
+		}
+
+		metrics_send(metrics, client);
+		close(client);
+	}
+
+	return NULL;
+}
+
+EXPORT
+int nck_metrics_listen(struct nck_metrics *metrics, const char *path, int format)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+
+	if (metrics->listening)
+		return -1;
+
+	if (format != NCK_METRICS_PROMETHEUS && format != NCK_METRICS_BINARY) {
+		fprintf(stderr, "Invalid metrics format %d\n", format);
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Metrics socket path too long: %s\n", path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	// replace the socket of a previous run, but nothing else
+	if (!stat(path, &st) && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	metrics->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (metrics->fd < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	if (bind(metrics->fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(metrics->fd, 8)) {
+		perror("bind");
+		close(metrics->fd);
+		metrics->fd = -1;
+		return -1;
+	}
+
+	metrics->format = format;
+	metrics->path = strdup(path);
+
+	if (pthread_create(&metrics->thread, NULL, metrics_serve, metrics)) {
+		fprintf(stderr, "Could not start the metrics thread\n");
+		close(metrics->fd);
+		unlink(path);
+		free(metrics->path);
+		metrics->fd = -1;
+		return -1;
+	}
+
+	metrics->listening = 1;
+	return 0;
+}
@@ -25,3 +25,24 @@ void nck_trigger_call(struct nck_trigger *trigger)
 	}
 }
 
+
+EXPORT
+uint32_t nck_histogram_percentile(const struct nck_histogram *histogram, double percentile)
+{
+	uint64_t rank, seen = 0;
+	unsigned int bucket;
+
+	if (histogram->count == 0)
+		return 0;
+
+	rank = (uint64_t)(histogram->count * percentile / 100.0);
+	rank = min_t(uint64_t, max_t(uint64_t, rank, 1), histogram->count);
+
+	for (bucket = 0; bucket < NCK_HISTOGRAM_BUCKETS; ++bucket) {
+		seen += histogram->buckets[bucket];
+		if (seen >= rank)
+			return nck_histogram_bucket_min(bucket);
+	}
+
+	return histogram->max;
+}
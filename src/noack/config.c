@@ -49,7 +49,6 @@ EXPORT
 int nck_noack_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 			 void *context, nck_opt_getter get_opt)
 {
-	const char *value;
 	krlnc_encoder_factory_t factory;
 	uint32_t redundancy = 3;
 	uint32_t systematic = 1;
@@ -61,21 +60,18 @@ int nck_noack_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u32(&redundancy, value)) {
-		fprintf(stderr, "Invalid redundancy: %s\n", value);
+	if (nck_get_opt_u32(&redundancy, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid redundancy: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&timeout, value)) {
-		fprintf(stderr, "Invalid timeout: %s\n", value);
+	if (nck_get_opt_timeval(&timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "systematic");
-	if (nck_parse_u32(&systematic, value)) {
-		fprintf(stderr, "Invalid 'Systematic' mode: %s\n", value);
+	if (nck_get_opt_u32(&systematic, context, get_opt, "systematic")) {
+		fprintf(stderr, "Invalid 'Systematic' mode: %s\n", get_opt(context, "systematic"));
 		return -1;
 	}
 
@@ -91,7 +87,6 @@ int nck_noack_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 {
 	krlnc_decoder_factory_t factory;
 	struct timeval timeout = { 0, 500000 };
-	const char *value;
 
 	UNUSED(timer);
 
@@ -100,9 +95,8 @@ int nck_noack_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&timeout, value)) {
-		fprintf(stderr, "Invalid timeout: %s\n", value);
+	if (nck_get_opt_timeval(&timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
@@ -114,7 +108,6 @@ EXPORT
 int nck_noack_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 			 void *context, nck_opt_getter get_opt)
 {
-	const char *value;
 	krlnc_decoder_factory_t factory;
 	uint32_t redundancy = 3;
 	struct timeval timeout = { 0, 100000 };
@@ -125,15 +118,13 @@ int nck_noack_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u32(&redundancy, value)) {
-		fprintf(stderr, "Invalid redundancy: %s\n", value);
+	if (nck_get_opt_u32(&redundancy, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid redundancy: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&timeout, value)) {
-		fprintf(stderr, "Invalid timeout: %s\n", value);
+	if (nck_get_opt_timeval(&timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
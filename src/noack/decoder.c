@@ -17,6 +17,7 @@
 
 struct nck_noack_dec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	krlnc_decoder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -95,14 +96,15 @@ struct nck_noack_dec *nck_noack_dec(krlnc_decoder_factory_t factory, struct nck_
 	}
 
 	result->factory = factory;
-	result->coder = kodo_build_decoder(factory);
+	kodo_decoder_pool_init(&result->pool, factory);
+	result->coder = kodo_decoder_pool_get(&result->pool);
 
 	block_size = krlnc_decoder_block_size(result->coder);
 	result->buffer = malloc(block_size);
 	memset(result->buffer, 0, block_size);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(result->coder) + 4;
+	result->coded_size = kodo_decoder_payload_size(result->coder) + 4;
 	result->feedback_size = 0;
 
 	result->queue = malloc(result->symbols * result->source_size);
@@ -118,7 +120,8 @@ EXPORT
 void nck_noack_dec_free(struct nck_noack_dec *decoder)
 {
 	krlnc_delete_decoder(decoder->coder);
-	krlnc_delete_decoder_factory(decoder->factory);
+	kodo_decoder_pool_free(&decoder->pool);
+	kodo_delete_decoder_factory(decoder->factory);
 	if (decoder->timeout_handle) {
 		nck_timer_cancel(decoder->timeout_handle);
 		nck_timer_free(decoder->timeout_handle);
@@ -128,6 +131,26 @@ void nck_noack_dec_free(struct nck_noack_dec *decoder)
 	free(decoder);
 }
 
+EXPORT
+int nck_noack_dec_reset(struct nck_noack_dec *decoder)
+{
+	if (decoder->timeout_handle) {
+		nck_timer_cancel(decoder->timeout_handle);
+	}
+
+	decoder->generation = 0;
+	decoder->index = 0;
+	decoder->flush = 0;
+	decoder->queue_index = 0;
+	decoder->queue_length = 0;
+
+	kodo_decoder_pool_put(&decoder->pool, decoder->coder);
+	decoder->coder = kodo_decoder_pool_get(&decoder->pool);
+	krlnc_decoder_set_mutable_symbols(decoder->coder, decoder->buffer, krlnc_decoder_block_size(decoder->coder));
+
+	return 0;
+}
+
 EXPORT
 int nck_noack_dec_has_source(struct nck_noack_dec *decoder)
 {
@@ -192,8 +215,8 @@ int nck_noack_dec_put_coded(struct nck_noack_dec *decoder, struct sk_buff *packe
 		decoder->index = 0;
 		decoder->flush = 0;
 
-		krlnc_delete_decoder(decoder->coder);
-		decoder->coder = kodo_build_decoder(decoder->factory);
+		kodo_decoder_pool_put(&decoder->pool, decoder->coder);
+		decoder->coder = kodo_decoder_pool_get(&decoder->pool);
 		krlnc_decoder_set_mutable_symbols(decoder->coder, decoder->buffer, krlnc_decoder_block_size(decoder->coder));
 	}
 
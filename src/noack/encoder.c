@@ -17,6 +17,7 @@
 
 struct nck_noack_enc {
 	krlnc_encoder_factory_t factory;
+	struct kodo_encoder_pool pool;
 	krlnc_encoder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -24,6 +25,7 @@ struct nck_noack_enc {
 	uint32_t generation;
 	uint32_t symbols;
 	uint32_t rank;
+	uint32_t uncoded;
 
 	int full;
 	int complete;
@@ -37,6 +39,7 @@ struct nck_noack_enc {
 	struct nck_trigger on_coded_ready;
 
 	uint8_t *buffer;
+	struct kodo_repair_batch repairs;
 };
 
 NCK_ENCODER_IMPL(nck_noack, NULL, NULL, NULL)
@@ -82,17 +85,19 @@ struct nck_noack_enc *nck_noack_enc(krlnc_encoder_factory_t factory, struct nck_
 	}
 
 	result->factory = factory;
-	result->coder = kodo_build_encoder(factory);
+	kodo_encoder_pool_init(&result->pool, factory);
+	result->coder = kodo_encoder_pool_get(&result->pool);
 	if (!result->systematic) {
 		krlnc_encoder_set_systematic_off(result->coder);
 	}
+	kodo_repair_batch_init(&result->repairs, factory);
 
 	block_size = krlnc_encoder_block_size(result->coder);
 	result->buffer = malloc(block_size);
 	memset(result->buffer, 0, block_size);
 
 	result->source_size = krlnc_encoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_encoder_payload_size(result->coder) + 4;
+	result->coded_size = kodo_encoder_payload_size(result->coder) + 4;
 	result->feedback_size = 0;
 
 	return result;
@@ -108,17 +113,44 @@ EXPORT
 void nck_noack_enc_free(struct nck_noack_enc *encoder)
 {
 	krlnc_delete_encoder(encoder->coder);
-	krlnc_delete_encoder_factory(encoder->factory);
+	kodo_encoder_pool_free(&encoder->pool);
+	kodo_delete_encoder_factory(encoder->factory);
 
 	if (encoder->timeout_handle) {
 		nck_timer_cancel(encoder->timeout_handle);
 		nck_timer_free(encoder->timeout_handle);
 	}
 
+	kodo_repair_batch_free(&encoder->repairs);
 	free(encoder->buffer);
 	free(encoder);
 }
 
+EXPORT
+int nck_noack_enc_reset(struct nck_noack_enc *encoder)
+{
+	if (encoder->timeout_handle) {
+		nck_timer_cancel(encoder->timeout_handle);
+	}
+
+	encoder->generation = 1;
+	encoder->rank = 0;
+	encoder->uncoded = 0;
+	encoder->full = 0;
+	encoder->complete = 0;
+	encoder->limit = 0;
+
+	kodo_encoder_pool_put(&encoder->pool, encoder->coder);
+	encoder->coder = kodo_encoder_pool_get(&encoder->pool);
+	if (!encoder->systematic) {
+		krlnc_encoder_set_systematic_off(encoder->coder);
+	}
+	memset(encoder->buffer, 0, krlnc_encoder_block_size(encoder->coder));
+	kodo_repair_batch_clear(&encoder->repairs);
+
+	return 0;
+}
+
 EXPORT
 int nck_noack_enc_has_coded(struct nck_noack_enc *encoder)
 {
@@ -151,11 +183,12 @@ int nck_noack_enc_put_source(struct nck_noack_enc *encoder, struct sk_buff *pack
 	if (encoder->complete) {
 		encoder->generation++;
 		encoder->rank = 0;
+		encoder->uncoded = 0;
 		encoder->complete = 0;
 		encoder->full = 0;
 
-		krlnc_delete_encoder(encoder->coder);
-		encoder->coder = kodo_build_encoder(encoder->factory);
+		kodo_encoder_pool_put(&encoder->pool, encoder->coder);
+		encoder->coder = kodo_encoder_pool_get(&encoder->pool);
 		if (!encoder->systematic) {
 			krlnc_encoder_set_systematic_off(encoder->coder);
 		}
@@ -163,6 +196,7 @@ int nck_noack_enc_put_source(struct nck_noack_enc *encoder, struct sk_buff *pack
 	}
 
 	kodo_put_source(encoder->coder, packet, encoder->buffer, encoder->rank);
+	kodo_repair_batch_clear(&encoder->repairs);
 
 	encoder->rank++;
 	encoder->limit++;
@@ -185,7 +219,13 @@ int nck_noack_enc_get_coded(struct nck_noack_enc *encoder, struct sk_buff *packe
 {
 	skb_reserve(packet, 4);
 
-	kodo_encoder_get_coded(encoder->coder, packet);
+	if (encoder->systematic && encoder->uncoded < encoder->rank) {
+		kodo_encoder_get_coded(encoder->coder, packet);
+		encoder->uncoded++;
+	} else {
+		kodo_encoder_get_repair(encoder->coder, &encoder->repairs, encoder->buffer,
+				encoder->rank, encoder->limit, packet);
+	}
 	skb_push_u32(packet, encoder->generation);
 
 	encoder->limit--;
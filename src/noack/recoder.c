@@ -17,6 +17,7 @@
 
 struct nck_noack_rec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	krlnc_decoder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -82,14 +83,15 @@ struct nck_noack_rec *nck_noack_rec(krlnc_decoder_factory_t factory,
 	}
 
 	result->factory = factory;
-	result->coder = kodo_build_decoder(factory);
+	kodo_decoder_pool_init(&result->pool, factory);
+	result->coder = kodo_decoder_pool_get(&result->pool);
 
 	block_size = krlnc_decoder_block_size(result->coder);
 	result->buffer = malloc(block_size);
 	memset(result->buffer, 0, block_size);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(result->coder) + 4;
+	result->coded_size = kodo_decoder_payload_size(result->coder) + 4;
 	result->feedback_size = 0;
 
 	result->generation = 1;
@@ -105,7 +107,8 @@ EXPORT
 void nck_noack_rec_free(struct nck_noack_rec *recoder)
 {
 	krlnc_delete_decoder(recoder->coder);
-	krlnc_delete_decoder_factory(recoder->factory);
+	kodo_decoder_pool_free(&recoder->pool);
+	kodo_delete_decoder_factory(recoder->factory);
 
 	if (recoder->timeout_handle) {
 		nck_timer_cancel(recoder->timeout_handle);
@@ -116,6 +119,27 @@ void nck_noack_rec_free(struct nck_noack_rec *recoder)
 	free(recoder);
 }
 
+EXPORT
+int nck_noack_rec_reset(struct nck_noack_rec *recoder)
+{
+	if (recoder->timeout_handle) {
+		nck_timer_cancel(recoder->timeout_handle);
+	}
+
+	recoder->generation = 1;
+	recoder->rank = 0;
+	recoder->index = 0;
+	recoder->complete = 0;
+	recoder->limit = 0;
+	recoder->flush = 0;
+
+	kodo_decoder_pool_put(&recoder->pool, recoder->coder);
+	recoder->coder = kodo_decoder_pool_get(&recoder->pool);
+	krlnc_decoder_set_mutable_symbols(recoder->coder, recoder->buffer, krlnc_decoder_block_size(recoder->coder));
+
+	return 0;
+}
+
 
 EXPORT
 int nck_noack_rec_complete(struct nck_noack_rec *recoder)
@@ -170,8 +194,8 @@ int nck_noack_rec_put_coded(struct nck_noack_rec *recoder,
 		recoder->flush = 0;
 		recoder->limit = 0;
 
-		krlnc_delete_decoder(recoder->coder);
-		recoder->coder = kodo_build_decoder(recoder->factory);
+		kodo_decoder_pool_put(&recoder->pool, recoder->coder);
+		recoder->coder = kodo_decoder_pool_get(&recoder->pool);
 		krlnc_decoder_set_mutable_symbols(recoder->coder, recoder->buffer, krlnc_decoder_block_size(recoder->coder));
 	}
 
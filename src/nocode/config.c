@@ -42,14 +42,12 @@ int nck_nocode_rec_set_option(struct nck_nocode_rec *recoder, const char *name,
 EXPORT
 int nck_nocode_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
 {
-	const char *value;
 	uint32_t symbol_size = 1500;
 
 	UNUSED(timer);
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -60,14 +58,12 @@ int nck_nocode_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 EXPORT
 int nck_nocode_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
 {
-	const char *value;
 	uint32_t symbol_size = 1500;
 
 	UNUSED(timer);
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -78,14 +74,12 @@ int nck_nocode_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 EXPORT
 int nck_nocode_create_rec(struct nck_recoder *recoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt)
 {
-	const char *value;
 	uint32_t symbol_size = 1500;
 
 	UNUSED(timer);
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -24,8 +24,24 @@ struct nck_nocode_dec {
 	char buffer[];
 };
 
+/**
+ * nocode_unwrap_coded - pass a coded packet through without copying it
+ * @dec: decoder structure that will be used
+ * @packet: coded packet, it is already the source packet
+ */
+static int nocode_unwrap_coded(void *dec, struct sk_buff *packet)
+{
+	struct nck_nocode_dec *decoder = (struct nck_nocode_dec *)dec;
+
+	// a packet that waits in the buffer must be delivered first
+	if (decoder->len > 0)
+		return -1;
+
+	nck_trace(decoder, "%s", skb_str(packet));
+	return 0;
+}
 
-NCK_DECODER_IMPL(nck_nocode, NULL, NULL, NULL)
+NCK_DECODER_IMPL_INPLACE(nck_nocode, NULL, NULL, NULL, nocode_unwrap_coded)
 
 EXPORT
 struct nck_nocode_dec *nck_nocode_dec(size_t symbol_size)
@@ -51,6 +67,13 @@ void nck_nocode_dec_free(struct nck_nocode_dec *decoder)
 	free(decoder);
 }
 
+EXPORT
+int nck_nocode_dec_reset(struct nck_nocode_dec *decoder)
+{
+	decoder->len = 0;
+	return 0;
+}
+
 EXPORT
 int nck_nocode_dec_has_source(struct nck_nocode_dec *decoder)
 {
@@ -23,7 +23,24 @@ struct nck_nocode_enc {
 	uint8_t buffer[];
 };
 
-NCK_ENCODER_IMPL(nck_nocode, NULL, NULL, NULL)
+/**
+ * nocode_wrap_source - pass a source packet through without copying it
+ * @enc: encoder structure that will be used
+ * @packet: source packet, it is already the coded packet
+ */
+static int nocode_wrap_source(void *enc, struct sk_buff *packet)
+{
+	struct nck_nocode_enc *encoder = (struct nck_nocode_enc *)enc;
+
+	// a packet that waits in the buffer must be sent first
+	if (encoder->len > 0)
+		return -1;
+
+	nck_trace(encoder, "%s", skb_str(packet));
+	return 0;
+}
+
+NCK_ENCODER_IMPL_INPLACE(nck_nocode, NULL, NULL, NULL, nocode_wrap_source)
 
 EXPORT
 struct nck_nocode_enc *nck_nocode_enc(size_t symbol_size)
@@ -48,6 +65,13 @@ void nck_nocode_enc_free(struct nck_nocode_enc *encoder)
 	free(encoder);
 }
 
+EXPORT
+int nck_nocode_enc_reset(struct nck_nocode_enc *encoder)
+{
+	encoder->len = 0;
+	return 0;
+}
+
 EXPORT
 int nck_nocode_enc_has_coded(struct nck_nocode_enc *encoder)
 {
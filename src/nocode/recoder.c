@@ -57,6 +57,15 @@ void nck_nocode_rec_free(struct nck_nocode_rec *recoder)
 	free(recoder);
 }
 
+EXPORT
+int nck_nocode_rec_reset(struct nck_nocode_rec *recoder)
+{
+	recoder->has_source = 0;
+	recoder->has_coded = 0;
+	recoder->len = 0;
+	return 0;
+}
+
 
 EXPORT
 int nck_nocode_rec_complete(struct nck_nocode_rec *recoder)
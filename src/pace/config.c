@@ -44,7 +44,6 @@ int nck_pace_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, vo
 {
 	krlnc_encoder_factory_t factory;
 	struct nck_pace_enc *enc;
-	const char *value;
 	uint16_t pace_redundancy = 120;
 	uint16_t tail_redundancy = 100;
 	struct timeval redundancy_timeout = { 0, 20000 };
@@ -57,33 +56,28 @@ int nck_pace_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, vo
 	enc = nck_pace_enc(factory, timer);
 	nck_pace_enc_api(encoder, enc);
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u16(&pace_redundancy, value)) {
-		fprintf(stderr, "Invalid pace_redundancy: %s\n", value);
+	if (nck_get_opt_u16(&pace_redundancy, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid pace_redundancy: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "pace_redundancy");
-	if (nck_parse_u16(&pace_redundancy, value)) {
-		fprintf(stderr, "Invalid pace_redundancy: %s\n", value);
+	if (nck_get_opt_u16(&pace_redundancy, context, get_opt, "pace_redundancy")) {
+		fprintf(stderr, "Invalid pace_redundancy: %s\n", get_opt(context, "pace_redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "tail_redundancy");
-	if (nck_parse_u16(&tail_redundancy, value)) {
-		fprintf(stderr, "Invalid tail_redundancy: %s\n", value);
+	if (nck_get_opt_u16(&tail_redundancy, context, get_opt, "tail_redundancy")) {
+		fprintf(stderr, "Invalid tail_redundancy: %s\n", get_opt(context, "tail_redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&redundancy_timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid redundancy_timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy_timeout");
-	if (nck_parse_timeval(&redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&redundancy_timeout, context, get_opt, "redundancy_timeout")) {
+		fprintf(stderr, "Invalid redundancy_timeout: %s\n", get_opt(context, "redundancy_timeout"));
 		return -1;
 	}
 
@@ -98,7 +92,6 @@ int nck_pace_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, vo
 {
 	krlnc_decoder_factory_t factory;
 	struct nck_pace_dec *dec;
-	const char *value;
 	struct timeval fb_timeout = { 0, 10000 };
 
 	if (get_kodo_dec_factory(&factory, context, get_opt)) {
@@ -109,9 +102,8 @@ int nck_pace_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, vo
 	dec = nck_pace_dec(factory, timer);
 	nck_pace_dec_api(decoder, dec);
 
-	value = get_opt(context, "fb_timeout");
-	if (nck_parse_timeval(&fb_timeout, value)) {
-		fprintf(stderr, "Invalid fb_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&fb_timeout, context, get_opt, "fb_timeout")) {
+		fprintf(stderr, "Invalid fb_timeout: %s\n", get_opt(context, "fb_timeout"));
 		return -1;
 	}
 
@@ -125,7 +117,6 @@ int nck_pace_create_rec(struct nck_recoder *recoder, struct nck_timer *timer, vo
 {
 	krlnc_decoder_factory_t factory;
 	struct nck_pace_rec *rec;
-	const char *value;
 	uint16_t pace_redundancy = 120;
 	uint16_t tail_redundancy = 100;
 	struct timeval rec_redundancy_timeout = { 0, 20000 };
@@ -139,27 +130,23 @@ int nck_pace_create_rec(struct nck_recoder *recoder, struct nck_timer *timer, vo
 	rec = nck_pace_rec(factory, timer);
 	nck_pace_rec_api(recoder, rec);
 
-	value = get_opt(context, "pace_redundancy");
-	if (nck_parse_u16(&pace_redundancy, value)) {
-		fprintf(stderr, "Invalid pace_redundancy: %s\n", value);
+	if (nck_get_opt_u16(&pace_redundancy, context, get_opt, "pace_redundancy")) {
+		fprintf(stderr, "Invalid pace_redundancy: %s\n", get_opt(context, "pace_redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "tail_redundancy");
-	if (nck_parse_u16(&tail_redundancy, value)) {
-		fprintf(stderr, "Invalid tail_redundancy: %s\n", value);
+	if (nck_get_opt_u16(&tail_redundancy, context, get_opt, "tail_redundancy")) {
+		fprintf(stderr, "Invalid tail_redundancy: %s\n", get_opt(context, "tail_redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy_timeout");
-	if (nck_parse_timeval(&rec_redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid rec_redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&rec_redundancy_timeout, context, get_opt, "redundancy_timeout")) {
+		fprintf(stderr, "Invalid rec_redundancy_timeout: %s\n", get_opt(context, "redundancy_timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "fb_timeout");
-	if (nck_parse_timeval(&rec_fb_timeout, value)) {
-		fprintf(stderr, "Invalid rec_fb_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&rec_fb_timeout, context, get_opt, "fb_timeout")) {
+		fprintf(stderr, "Invalid rec_fb_timeout: %s\n", get_opt(context, "fb_timeout"));
 		return -1;
 	}
 
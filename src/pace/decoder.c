@@ -17,6 +17,7 @@
 
 struct nck_pace_dec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	krlnc_decoder_t coder;
 
 	uint32_t generation;
@@ -66,10 +67,8 @@ static void dec_start_next_generation(struct nck_pace_dec *decoder, uint32_t gen
 	decoder->feedback_rank = 0;
 	decoder->feedback_generation=0;
 
-	if (decoder->coder){
-		krlnc_delete_decoder(decoder->coder);
-	}
-	decoder->coder = kodo_build_decoder(decoder->factory);
+	kodo_decoder_pool_put(&decoder->pool, decoder->coder);
+	decoder->coder = kodo_decoder_pool_get(&decoder->pool);
 	krlnc_decoder_set_status_updater_on(decoder->coder);
 	memset(decoder->buffer, 0, decoder->block_size);
 	krlnc_decoder_set_mutable_symbols(decoder->coder, decoder->buffer, decoder->block_size);
@@ -136,10 +135,12 @@ struct nck_pace_dec *nck_pace_dec(krlnc_decoder_factory_t factory, struct nck_ti
 	result->symbols = krlnc_decoder_factory_symbols(factory);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(dec) + 6;
+	result->coded_size = kodo_decoder_payload_size(dec) + 6;
 	result->feedback_size = 6;
 
 	result->factory = factory;
+	kodo_decoder_pool_init(&result->pool, factory);
+	kodo_decoder_pool_put(&result->pool, dec);
 	result->block_size = block_size;
 
 	result->queue = malloc(result->symbols * result->source_size);
@@ -158,8 +159,6 @@ struct nck_pace_dec *nck_pace_dec(krlnc_decoder_factory_t factory, struct nck_ti
 	nck_pace_set_dec_fb_timeout(result, double_to_tv(0.050, &timeout_fb));
 	nck_pace_set_dec_flush_timeout(result, double_to_tv(60.0, &timeout_flush));
 
-	krlnc_delete_decoder(dec);
-
 	return result;
 }
 
@@ -187,7 +186,8 @@ EXPORT
 void nck_pace_dec_free(struct nck_pace_dec *decoder)
 {
 	krlnc_delete_decoder(decoder->coder);
-	krlnc_delete_decoder_factory(decoder->factory);
+	kodo_decoder_pool_free(&decoder->pool);
+	kodo_delete_decoder_factory(decoder->factory);
 
 	nck_timer_cancel(decoder->dec_fb_timeout_handle);
 	nck_timer_free(decoder->dec_fb_timeout_handle);
@@ -200,6 +200,20 @@ void nck_pace_dec_free(struct nck_pace_dec *decoder)
 	free(decoder);
 }
 
+EXPORT
+int nck_pace_dec_reset(struct nck_pace_dec *decoder)
+{
+	nck_timer_cancel(decoder->dec_fb_timeout_handle);
+	nck_timer_cancel(decoder->dec_flush_timeout_handle);
+
+	decoder->prev_rank = 0;
+	decoder->queue_index = 0;
+	decoder->queue_length = 0;
+
+	dec_start_next_generation(decoder, 1);
+	return 0;
+}
+
 EXPORT
 int nck_pace_dec_has_source(struct nck_pace_dec *decoder)
 {
@@ -21,12 +21,14 @@
 
 struct nck_pace_enc {
 	krlnc_encoder_factory_t factory;
+	struct kodo_encoder_pool pool;
 	krlnc_encoder_t coder;
 
 	uint32_t generation;
 	uint32_t block_size;
 	uint32_t symbols;
 	uint32_t rank;
+	uint32_t uncoded;
 
 	uint32_t pace_redundancy;
 	uint32_t tail_redundancy;
@@ -48,6 +50,7 @@ struct nck_pace_enc {
 	uint32_t to_send;
 
 	uint8_t *buffer;
+	struct kodo_repair_batch repairs;
 };
 
 NCK_ENCODER_IMPL(nck_pace, NULL, NULL, NULL)
@@ -56,15 +59,15 @@ static void enc_start_next_generation(struct nck_pace_enc *encoder, uint32_t gen
 	//fprintf(stderr, "\nEnc - Start next gen: %d", generation);
 	encoder->generation = generation;
 	encoder->rank = 0;
+	encoder->uncoded = 0;
 	encoder->complete = 0;
 	encoder->to_send = 0;
 	encoder->last_fb_rank = 0;
 
-	if (encoder->coder) {
-		krlnc_delete_encoder(encoder->coder);
-	}
-	encoder->coder = kodo_build_encoder(encoder->factory);
+	kodo_encoder_pool_put(&encoder->pool, encoder->coder);
+	encoder->coder = kodo_encoder_pool_get(&encoder->pool);
 	memset(encoder->buffer, 0, krlnc_encoder_block_size(encoder->coder));
+	kodo_repair_batch_clear(&encoder->repairs);
 }
 
 EXPORT
@@ -86,11 +89,14 @@ struct nck_pace_enc *nck_pace_enc(krlnc_encoder_factory_t factory, struct nck_ti
 	result->symbols = krlnc_encoder_factory_symbols(factory);
 
 	result->factory = factory;
+	kodo_encoder_pool_init(&result->pool, factory);
+	kodo_encoder_pool_put(&result->pool, enc);
+	kodo_repair_batch_init(&result->repairs, factory);
 
 	enc_start_next_generation(result, 1);
 
 	result->source_size = krlnc_encoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_encoder_payload_size(enc) + 6;
+	result->coded_size = kodo_encoder_payload_size(result->coder) + 6;
 	result->feedback_size = 6;
 
 	UNUSED(timer);
@@ -105,8 +111,6 @@ struct nck_pace_enc *nck_pace_enc(krlnc_encoder_factory_t factory, struct nck_ti
 	nck_pace_set_enc_redundancy_timeout(result, double_to_tv(0.100, &timeout_redundancy));
 	nck_pace_set_enc_flush_timeout(result, double_to_tv(60.0, &timeout_flush));
 
-	krlnc_delete_encoder(enc);
-
 	return result;
 }
 
@@ -142,7 +146,8 @@ void nck_pace_set_enc_flush_timeout(struct nck_pace_enc *encoder, const struct t
 EXPORT
 void nck_pace_enc_free(struct nck_pace_enc *encoder) {
 	krlnc_delete_encoder(encoder->coder);
-	krlnc_delete_encoder_factory(encoder->factory);
+	kodo_encoder_pool_free(&encoder->pool);
+	kodo_delete_encoder_factory(encoder->factory);
 
 	nck_timer_cancel(encoder->enc_redundancy_timeout_handle);
 	nck_timer_free(encoder->enc_redundancy_timeout_handle);
@@ -150,10 +155,20 @@ void nck_pace_enc_free(struct nck_pace_enc *encoder) {
 	nck_timer_cancel(encoder->enc_flush_timeout_handle);
 	nck_timer_free(encoder->enc_flush_timeout_handle);
 
+	kodo_repair_batch_free(&encoder->repairs);
 	free(encoder->buffer);
 	free(encoder);
 }
 
+EXPORT
+int nck_pace_enc_reset(struct nck_pace_enc *encoder) {
+	nck_timer_cancel(encoder->enc_redundancy_timeout_handle);
+	nck_timer_cancel(encoder->enc_flush_timeout_handle);
+
+	enc_start_next_generation(encoder, 1);
+	return 0;
+}
+
 EXPORT
 int nck_pace_enc_has_coded(struct nck_pace_enc *encoder) {
 	return encoder->to_send >= 100;
@@ -185,7 +200,13 @@ int nck_pace_enc_get_coded(struct nck_pace_enc *encoder, struct sk_buff *packet)
 	}
 
 	skb_reserve(packet, 6);
-	kodo_encoder_get_coded(encoder->coder, packet);
+	if (encoder->uncoded < encoder->rank) {
+		kodo_encoder_get_coded(encoder->coder, packet);
+		encoder->uncoded++;
+	} else {
+		kodo_encoder_get_repair(encoder->coder, &encoder->repairs, encoder->buffer,
+				encoder->rank, encoder->to_send / 100, packet);
+	}
 	skb_push_u16(packet, (uint16_t) encoder->rank);
 	skb_push_u32(packet, encoder->generation);
 
@@ -201,6 +222,7 @@ int nck_pace_enc_put_source(struct nck_pace_enc *encoder, struct sk_buff *packet
 	}
 
 	kodo_put_source(encoder->coder, packet, encoder->buffer, encoder->rank);
+	kodo_repair_batch_clear(&encoder->repairs);
 
 	encoder->rank++;
 	encoder->to_send += encoder->pace_redundancy;
@@ -17,6 +17,7 @@
 
 struct nck_pace_rec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	krlnc_decoder_t coder;
 
 	uint32_t block_size;
@@ -77,10 +78,8 @@ static void rec_start_next_generation(struct nck_pace_rec *recoder, uint32_t gen
 	recoder->feedback_rank = 0;
 	recoder->feedback_generation=0;
 
-	if (recoder->coder){
-		krlnc_delete_decoder(recoder->coder);
-	}
-	recoder->coder = kodo_build_decoder(recoder->factory);
+	kodo_decoder_pool_put(&recoder->pool, recoder->coder);
+	recoder->coder = kodo_decoder_pool_get(&recoder->pool);
 	memset(recoder->buffer, 0, recoder->block_size);
 	krlnc_decoder_set_mutable_symbols(recoder->coder, recoder->buffer, recoder->block_size);
 }
@@ -149,10 +148,12 @@ struct nck_pace_rec *nck_pace_rec(krlnc_decoder_factory_t factory, struct nck_ti
 	result->symbols = krlnc_decoder_factory_symbols(factory);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(dec) + 6;
+	result->coded_size = kodo_decoder_payload_size(dec) + 6;
 	result->feedback_size = 6;
 
 	result->factory = factory;
+	kodo_decoder_pool_init(&result->pool, factory);
+	kodo_decoder_pool_put(&result->pool, dec);
 	result->block_size = block_size;
 
 	result->queue = malloc(result->symbols * result->source_size);
@@ -175,8 +176,6 @@ struct nck_pace_rec *nck_pace_rec(krlnc_decoder_factory_t factory, struct nck_ti
 	nck_pace_set_rec_pace_redundancy(result, 120);
 	nck_pace_set_rec_tail_redundancy(result, 100);
 
-	krlnc_delete_decoder(dec);
-
 	return result;
 }
 
@@ -227,7 +226,8 @@ EXPORT
 void nck_pace_rec_free(struct nck_pace_rec *recoder)
 {
 	krlnc_delete_decoder(recoder->coder);
-	krlnc_delete_decoder_factory(recoder->factory);
+	kodo_decoder_pool_free(&recoder->pool);
+	kodo_delete_decoder_factory(recoder->factory);
 
 	nck_timer_cancel(recoder->rec_fb_timeout_handle);
 	nck_timer_free(recoder->rec_fb_timeout_handle);
@@ -243,6 +243,20 @@ void nck_pace_rec_free(struct nck_pace_rec *recoder)
 	free(recoder);
 }
 
+EXPORT
+int nck_pace_rec_reset(struct nck_pace_rec *recoder)
+{
+	nck_timer_cancel(recoder->rec_fb_timeout_handle);
+	nck_timer_cancel(recoder->rec_redundancy_timeout_handle);
+	nck_timer_cancel(recoder->rec_flush_timeout_handle);
+
+	recoder->queue_index = 0;
+	recoder->queue_length = 0;
+
+	rec_start_next_generation(recoder, 1);
+	return 0;
+}
+
 EXPORT
 int nck_pace_rec_has_source(struct nck_pace_rec *recoder)
 {
@@ -40,7 +40,6 @@ EXPORT
 int nck_pacemg_create_enc(struct nck_encoder *encoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt) {
 	krlnc_encoder_factory_t factory;
 	struct nck_pacemg_enc *enc;
-	const char *value;
 	uint32_t max_active_containers = 8;
 	uint32_t max_history_size = 64;
 	uint16_t coding_ratio = 100;
@@ -56,51 +55,43 @@ int nck_pacemg_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 	enc = nck_pacemg_enc(factory, timer);
 	nck_pacemg_enc_api(encoder, enc);
 
-	value = get_opt(context, "max_active_containers");
-	if (nck_parse_u32(&max_active_containers, value)) {
-		fprintf(stderr, "Invalid max_active_containers: %s\n", value);
+	if (nck_get_opt_u32(&max_active_containers, context, get_opt, "max_active_containers")) {
+		fprintf(stderr, "Invalid max_active_containers: %s\n", get_opt(context, "max_active_containers"));
 		return -1;
 	}
 
-	value = get_opt(context, "max_history");
-	if (nck_parse_u32(&max_history_size, value)) {
-		fprintf(stderr, "Invalid max_history: %s\n", value);
+	if (nck_get_opt_u32(&max_history_size, context, get_opt, "max_history")) {
+		fprintf(stderr, "Invalid max_history: %s\n", get_opt(context, "max_history"));
 		return -1;
 	}
 
-	value = get_opt(context, "coding_ratio");
-	if (nck_parse_u16(&coding_ratio, value)) {
-		fprintf(stderr, "Invalid coding_ratio: %s\n", value);
+	if (nck_get_opt_u16(&coding_ratio, context, get_opt, "coding_ratio")) {
+		fprintf(stderr, "Invalid coding_ratio: %s\n", get_opt(context, "coding_ratio"));
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u16(&coding_ratio, value)) {
-		fprintf(stderr, "Invalid redundancy: %s\n", value);
+	if (nck_get_opt_u16(&coding_ratio, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid redundancy: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "tail_packets");
-	if (nck_parse_u16(&tail_packets, value)) {
-		fprintf(stderr, "Invalid tail_packets: %s\n", value);
+	if (nck_get_opt_u16(&tail_packets, context, get_opt, "tail_packets")) {
+		fprintf(stderr, "Invalid tail_packets: %s\n", get_opt(context, "tail_packets"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&redundancy_timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid redundancy_timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy_timeout");
-	if (nck_parse_timeval(&redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&redundancy_timeout, context, get_opt, "redundancy_timeout")) {
+		fprintf(stderr, "Invalid redundancy_timeout: %s\n", get_opt(context, "redundancy_timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "feedback");
-	if (nck_parse_u8(&feedback, value)) {
-		fprintf(stderr, "Invalid feedback: %s\n", value);
+	if (nck_get_opt_u8(&feedback, context, get_opt, "feedback")) {
+		fprintf(stderr, "Invalid feedback: %s\n", get_opt(context, "feedback"));
 		return -1;
 	}
 
@@ -119,9 +110,8 @@ EXPORT
 int nck_pacemg_create_dec(struct nck_decoder *decoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt) {
 	krlnc_decoder_factory_t factory;
 	struct nck_pacemg_dec *dec;
-	const char *value;
 	struct timeval fb_timeout = {0, 10000};
-	uint16_t max_active_containers = 8;
+	uint32_t max_active_containers = 8;
 
 	if (get_kodo_dec_factory(&factory, context, get_opt)) {
 		fprintf(stderr, "Failed to create the kodo decoder factory.\n");
@@ -131,14 +121,12 @@ int nck_pacemg_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 	dec = nck_pacemg_dec(factory, timer);
 	nck_pacemg_dec_api(decoder, dec);
 
-	value = get_opt(context, "fb_timeout");
-	if (nck_parse_timeval(&fb_timeout, value)) {
-		fprintf(stderr, "Invalid fb_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&fb_timeout, context, get_opt, "fb_timeout")) {
+		fprintf(stderr, "Invalid fb_timeout: %s\n", get_opt(context, "fb_timeout"));
 		return -1;
 	}
-	value = get_opt(context, "max_active_containers");
-	if (nck_parse_u16(&max_active_containers, value)) {
-		fprintf(stderr, "Invalid fb_timeout: %s\n", value);
+	if (nck_get_opt_u32(&max_active_containers, context, get_opt, "max_active_containers")) {
+		fprintf(stderr, "Invalid fb_timeout: %s\n", get_opt(context, "max_active_containers"));
 		return -1;
 	}
 
@@ -152,11 +140,10 @@ EXPORT
 int nck_pacemg_create_rec(struct nck_recoder *recoder, struct nck_timer *timer, void *context, nck_opt_getter get_opt) {
 	krlnc_decoder_factory_t factory;
 	struct nck_pacemg_rec *rec;
-	const char *value;
 	uint16_t coding_ratio = 100;
 	uint16_t tail_packets = 0;
-	uint16_t max_active_containers = 8;
-	uint16_t max_containers = 16;
+	uint32_t max_active_containers = 8;
+	uint32_t max_containers = 16;
 	struct timeval rec_redundancy_timeout = {0, 20000};
 	struct timeval rec_fb_timeout = {0, 10000};
 	struct timeval rec_flush_timeout = {0, 500000};
@@ -169,45 +156,38 @@ int nck_pacemg_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 	rec = nck_pacemg_rec(factory, timer);
 	nck_pacemg_rec_api(recoder, rec);
 
-	value = get_opt(context, "redundancy");
-	if (nck_parse_u16(&coding_ratio, value)) {
-		fprintf(stderr, "Invalid coding_ratio: %s\n", value);
+	if (nck_get_opt_u16(&coding_ratio, context, get_opt, "redundancy")) {
+		fprintf(stderr, "Invalid coding_ratio: %s\n", get_opt(context, "redundancy"));
 		return -1;
 	}
 
-	value = get_opt(context, "coding_ratio");
-	if (nck_parse_u16(&coding_ratio, value)) {
-		fprintf(stderr, "Invalid coding_ratio: %s\n", value);
+	if (nck_get_opt_u16(&coding_ratio, context, get_opt, "coding_ratio")) {
+		fprintf(stderr, "Invalid coding_ratio: %s\n", get_opt(context, "coding_ratio"));
 		return -1;
 	}
 
-	value = get_opt(context, "max_active_containers");
-	if (nck_parse_u16(&max_active_containers, value)) {
-		fprintf(stderr, "Invalid coding_ratio: %s\n", value);
+	if (nck_get_opt_u32(&max_active_containers, context, get_opt, "max_active_containers")) {
+		fprintf(stderr, "Invalid coding_ratio: %s\n", get_opt(context, "max_active_containers"));
 		return -1;
 	}
 
-	value = get_opt(context, "max_containers");
-	if (nck_parse_u16(&max_containers, value)) {
-		fprintf(stderr, "Invalid coding_ratio: %s\n", value);
+	if (nck_get_opt_u32(&max_containers, context, get_opt, "max_containers")) {
+		fprintf(stderr, "Invalid coding_ratio: %s\n", get_opt(context, "max_containers"));
 		return -1;
 	}
 
-	value = get_opt(context, "tail_packets");
-	if (nck_parse_u16(&tail_packets, value)) {
-		fprintf(stderr, "Invalid tail_packets: %s\n", value);
+	if (nck_get_opt_u16(&tail_packets, context, get_opt, "tail_packets")) {
+		fprintf(stderr, "Invalid tail_packets: %s\n", get_opt(context, "tail_packets"));
 		return -1;
 	}
 
-	value = get_opt(context, "redundancy_timeout");
-	if (nck_parse_timeval(&rec_redundancy_timeout, value)) {
-		fprintf(stderr, "Invalid rec_redundancy_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&rec_redundancy_timeout, context, get_opt, "redundancy_timeout")) {
+		fprintf(stderr, "Invalid rec_redundancy_timeout: %s\n", get_opt(context, "redundancy_timeout"));
 		return -1;
 	}
 
-	value = get_opt(context, "fb_timeout");
-	if (nck_parse_timeval(&rec_fb_timeout, value)) {
-		fprintf(stderr, "Invalid rec_fb_timeout: %s\n", value);
+	if (nck_get_opt_timeval(&rec_fb_timeout, context, get_opt, "fb_timeout")) {
+		fprintf(stderr, "Invalid rec_fb_timeout: %s\n", get_opt(context, "fb_timeout"));
 		return -1;
 	}
 
@@ -13,11 +13,11 @@
 #include "../private.h"
 #include "../kodo.h"
 #include "../util/helper.h"
-#include "list.h"
+#include "../util/gen_table.h"
+#include "../util/buffer_pool.h"
 #include "encdec.h"
 
 typedef struct nck_pacemg_dec_container {
-	struct list_head list;
 	struct nck_pacemg_dec *pacemg_decoder;
 	krlnc_decoder_t coder;
 	uint32_t generation;
@@ -37,6 +37,7 @@ typedef struct nck_pacemg_dec_container {
 
 struct nck_pacemg_dec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	uint32_t gen_newest;
 	uint32_t gen_oldest;
 	uint32_t gen_oldest_deleted;
@@ -47,7 +48,7 @@ struct nck_pacemg_dec {
 	dec_container *cont_oldest;
 	dec_container *cont_newest;
 
-	uint16_t max_active_containers;
+	uint32_t max_active_containers;
 	size_t source_size, coded_size, feedback_size;
 	struct nck_timer *timer;                                // should be pointer?
 
@@ -59,7 +60,8 @@ struct nck_pacemg_dec {
 	struct nck_trigger on_source_ready;
 	struct nck_trigger on_feedback_ready;
 
-	struct list_head container_list;
+	struct gen_table containers;
+	struct buffer_pool buffers;
 
 	int has_feedback;
 };
@@ -71,10 +73,10 @@ NCK_DECODER_IMPL(nck_pacemg, nck_pacemg_dec_debug, NULL, NULL)
  * @param decoder pointer to the decoder to work on
  */
 static void nck_pacemg_update_decoder_stat(struct nck_pacemg_dec *decoder) {
-	if (!list_empty(&decoder->container_list)) {
-		decoder->cont_newest = list_entry(decoder->container_list.prev, dec_container, list);
+	if (decoder->containers.count > 0) {
+		decoder->cont_newest = gen_table_newest(&decoder->containers);
 		decoder->gen_newest = decoder->cont_newest->generation;
-		decoder->cont_oldest = list_entry(decoder->container_list.next, dec_container, list);
+		decoder->cont_oldest = gen_table_oldest(&decoder->containers);
 		decoder->gen_oldest = decoder->cont_oldest->generation;
 #ifdef DEC_STATS
 		fprintf(stderr, "decoder->gen_oldest == %d\n", decoder->gen_oldest);
@@ -114,37 +116,32 @@ static void dec_container_timeout_flush(struct nck_timer_entry *entry, void *con
 
 dec_container *nck_pacemg_dec_start_next_generation(struct nck_pacemg_dec *decoder, uint32_t generation) {
 	dec_container *container;
-	dec_container *cont_tmp;
 	container = malloc(sizeof(*container));
 	memset(container, 0, sizeof(*container));
 
+	if (gen_table_insert(&decoder->containers, generation, container)) {
+		free(container);
+		return NULL;
+	}
+
 	container->pacemg_decoder = decoder;
 	container->generation = generation;
 	container->flush = 0;
 	container->index = 0;
-	container->coder = kodo_build_decoder(decoder->factory);
+	container->coder = kodo_decoder_pool_get(&decoder->pool);
 	krlnc_decoder_set_status_updater_on(container->coder);
 
-	container->queue = malloc(decoder->symbols * decoder->source_size);
+	container->queue = buffer_pool_get(&decoder->buffers);
 	container->queue_index = 0;
 	container->queue_length = 0;
 
 
-	container->buffer = malloc(decoder->block_size);
-	memset(container->buffer, 0, decoder->block_size);
+	container->buffer = buffer_pool_get(&decoder->buffers);
 	krlnc_decoder_set_mutable_symbols(container->coder, container->buffer, decoder->block_size);
 
 	container->dec_cont_flush_timeout_handle = nck_timer_add(decoder->timer, NULL, container,
 															 dec_container_timeout_flush);
 
-	INIT_LIST_HEAD(&container->list);
-
-	// We ensure that the containers are placed in ascending order of the generation
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
-		if (cont_tmp->generation > generation) {break;}
-	}
-	list_add_before(&container->list, &cont_tmp->list);
-
 	decoder->num_containers++;
 
 	nck_pacemg_update_decoder_stat(decoder);
@@ -163,14 +160,15 @@ char *nck_pacemg_dec_contdebug(void *dec) {
 	struct nck_pacemg_dec *decoder = dec;
 
 	strcpy(result, "\t\t\t\t");
-	dec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &decoder->container_list, list) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		snprintf(debug_head, sizeof(debug_head) - 1, "GEN IDX FLU RNK QID QLN\t\t");
 		strcat(result, debug_head);
 	}
 	strcat(result, "\n\t\t\t\t");
 
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &decoder->container_list, list) {
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		snprintf(debug, sizeof(debug) - 1, "%*d %*d %*d %*d %*d %*d\t\t",
 				 3, cont_tmp->generation, 3, cont_tmp->index, 3, cont_tmp->flush,
 				 3, krlnc_decoder_rank(cont_tmp->coder),
@@ -197,8 +195,9 @@ char *nck_pacemg_dec_debug(void *dec) {
 	pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"#CONT\":%d,", decoder->num_containers);
 
 	pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"CONT\": {");
-	dec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &decoder->container_list, list) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"GEN\":%d,", cont_tmp->generation);
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"IDX\":%d,", cont_tmp->index);
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"FLU\":%d,", cont_tmp->flush);
@@ -233,15 +232,17 @@ struct nck_pacemg_dec *nck_pacemg_dec(krlnc_decoder_factory_t factory, struct nc
 	result->has_feedback = 0;
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(dec) + nck_pacemg_pkt_header_size;
-	result->feedback_size = nck_pacemg_pkt_feedback_additional
-							+ nck_pacemg_pkt_feedback_size_single * MAX_MAX_ACTIVE_CONTAINERS;
+	result->coded_size = kodo_decoder_payload_size(dec) + nck_pacemg_pkt_header_size;
+	result->feedback_size = nck_pacemg_feedback_size(DEFAULT_MAX_ACTIVE_CONTAINERS);
 
 	result->factory = factory;
+	kodo_decoder_pool_init(&result->pool, factory);
 	result->block_size = block_size;
 	result->gen_oldest_deleted = 0;
 
-	INIT_LIST_HEAD(&(result->container_list));
+	gen_table_init(&result->containers, 8);
+	// the reorder queue of a container has the size of a block
+	buffer_pool_init(&result->buffers, block_size, 8);
 
 	nck_pacemg_dec_start_next_generation(result, 1);
 
@@ -250,7 +251,7 @@ struct nck_pacemg_dec *nck_pacemg_dec(krlnc_decoder_factory_t factory, struct nc
 //	result->dec_fb_timeout_handle = nck_timer_add(timer, NULL, result, decoder_send_feedback);
 //	result->dec_flush_timeout_handle = nck_timer_add(timer, NULL, result, decoder_timeout_flush);
 
-	krlnc_delete_decoder(dec);
+	kodo_decoder_pool_put(&result->pool, dec);
 
 	return result;
 }
@@ -262,10 +263,10 @@ void nck_pacemg_set_dec_fb_timeout(struct nck_pacemg_dec *decoder, const struct
 }
 
 EXPORT
-void nck_pacemg_set_dec_max_active_containers(struct nck_pacemg_dec *decoder, uint16_t max_active_containers) {
+void nck_pacemg_set_dec_max_active_containers(struct nck_pacemg_dec *decoder, uint32_t max_active_containers) {
 	decoder->max_active_containers = max_active_containers;
-	decoder->feedback_size =
-			nck_pacemg_pkt_feedback_size_single * max_active_containers + nck_pacemg_pkt_feedback_additional;
+	decoder->feedback_size = nck_pacemg_feedback_size(max_active_containers);
+	gen_table_set_max_span(&decoder->containers, max_active_containers);
 }
 
 EXPORT
@@ -279,23 +280,27 @@ void nck_pacemg_set_dec_flush_timeout(struct nck_pacemg_dec *decoder, const stru
 }
 
 void nck_pacemg_dec_container_del(dec_container *container) {
-	list_del(&container->list);
-	krlnc_delete_decoder(container->coder);
+	gen_table_remove(&container->pacemg_decoder->containers, container->generation);
+	kodo_decoder_pool_put(&container->pacemg_decoder->pool, container->coder);
 	nck_timer_cancel(container->dec_cont_flush_timeout_handle);
 	nck_timer_free(container->dec_cont_flush_timeout_handle);
-	free(container->buffer);
-	free(container->queue);
+	buffer_pool_put(&container->pacemg_decoder->buffers, container->buffer);
+	buffer_pool_put(&container->pacemg_decoder->buffers, container->queue);
 	free(container);
 }
 
 EXPORT
 void nck_pacemg_dec_free(struct nck_pacemg_dec *decoder) {
-	dec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &decoder->container_list, list) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		nck_pacemg_dec_container_del(cont_tmp);
 	}
+	gen_table_free(&decoder->containers);
+	buffer_pool_free(&decoder->buffers);
 
-	krlnc_delete_decoder_factory(decoder->factory);
+	kodo_decoder_pool_free(&decoder->pool);
+	kodo_delete_decoder_factory(decoder->factory);
 
 	nck_timer_cancel(decoder->dec_fb_timeout_handle);
 	nck_timer_free(decoder->dec_fb_timeout_handle);
@@ -306,12 +311,36 @@ void nck_pacemg_dec_free(struct nck_pacemg_dec *decoder) {
 	free(decoder);
 }
 
+EXPORT
+int nck_pacemg_dec_reset(struct nck_pacemg_dec *decoder) {
+	dec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
+		nck_pacemg_dec_container_del(cont_tmp);
+	}
+	nck_pacemg_update_decoder_stat(decoder);
+
+	nck_timer_cancel(decoder->dec_fb_timeout_handle);
+	nck_timer_cancel(decoder->dec_flush_timeout_handle);
+
+	decoder->num_containers = 0;
+	decoder->gen_newest = 0;
+	decoder->gen_oldest = 0;
+	decoder->gen_oldest_deleted = 0;
+	decoder->oldest_global_seq = 0;
+	decoder->has_feedback = 0;
+
+	nck_pacemg_dec_start_next_generation(decoder, 1);
+
+	return 0;
+}
+
 EXPORT
 int nck_pacemg_dec_has_source(struct nck_pacemg_dec *decoder) {
 	dec_container *oldest_container = decoder->cont_oldest;
 
 	// No containers are present
-	if (list_empty(&decoder->container_list)) {
+	if (decoder->containers.count == 0) {
 #ifdef DEC_HAS_SOURCE
 		fprintf(stderr, "nck_pacemg_dec_has_source %d 0\n", __LINE__);
 #endif
@@ -388,7 +417,8 @@ int nck_pacemg_dec_flush_container(dec_container *container) {
 EXPORT
 void nck_pacemg_dec_flush_source(struct nck_pacemg_dec *decoder) {
 	dec_container *cont_tmp;
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
+	uint32_t gen;
+	gen_table_for_each(&decoder->containers, gen, cont_tmp) {
 		nck_pacemg_dec_flush_container(cont_tmp);
 	}
 }
@@ -411,7 +441,7 @@ void nck_pacemg_dec_add_feedback(struct nck_pacemg_dec *decoder) {
 
 EXPORT
 int nck_pacemg_dec_put_coded(struct nck_pacemg_dec *decoder, struct sk_buff *packet) {
-	dec_container *cont_tmp, *cont = NULL;
+	dec_container *cont;
 
 	if (packet->len < nck_pacemg_pkt_header_size) {
 		return ENOSPC;
@@ -436,28 +466,30 @@ int nck_pacemg_dec_put_coded(struct nck_pacemg_dec *decoder, struct sk_buff *pac
 #endif
 
 	// "cont" will contain the pointer to the container of the gen if exists else NULL
-	list_for_each_entry(cont_tmp, &decoder->container_list, list) {
-		if (cont_tmp->generation == header.generation) {
-			cont = cont_tmp;
-			break;
-		}
-	}
+	cont = gen_table_get(&decoder->containers, header.generation);
 
-	if ((header.generation < decoder->gen_oldest) || (header.generation <= decoder->gen_oldest_deleted)) {
+	if (gen_before(header.generation, decoder->gen_oldest) || !gen_before(decoder->gen_oldest_deleted, header.generation)) {
 		return 0;
 	}
 	// if the packet belongs to a new generation
 	if (!cont) {
-		// Create new conatainer and flush out oldest ones if necessary
-		if (decoder->num_containers >= decoder->max_active_containers) {
-			if (nck_pacemg_dec_flush_container(decoder->cont_oldest) == 0) {
-				decoder->gen_oldest_deleted = decoder->cont_oldest->generation;
-				nck_pacemg_dec_container_del(decoder->cont_oldest);
-				nck_pacemg_update_decoder_stat(decoder);
-				decoder->num_containers--;
-			}
+		// Create new conatainer and flush out oldest ones if necessary.
+		// Containers that are more than max_active_containers generations
+		// behind the new one are no longer sent by the encoder.
+		while (decoder->num_containers >= decoder->max_active_containers ||
+		       (decoder->num_containers > 0 && gen_before(decoder->gen_newest, header.generation) &&
+			!gen_table_fits(&decoder->containers, header.generation))) {
+			if (nck_pacemg_dec_flush_container(decoder->cont_oldest) != 0)
+				break;
+			decoder->gen_oldest_deleted = decoder->cont_oldest->generation;
+			nck_pacemg_dec_container_del(decoder->cont_oldest);
+			nck_pacemg_update_decoder_stat(decoder);
+			decoder->num_containers--;
 		}
 		cont = nck_pacemg_dec_start_next_generation(decoder, header.generation);
+		if (!cont) {
+			return -1;
+		}
 	}
 	assert(cont != NULL);
 
@@ -560,33 +592,60 @@ int nck_pacemg_dec_get_source(struct nck_pacemg_dec *decoder, struct sk_buff *pa
 EXPORT
 int nck_pacemg_dec_get_feedback(struct nck_pacemg_dec *decoder, struct sk_buff *packet) {
 	struct nck_pacemg_dec_container *container;
+	uint32_t gen, prev_gen;
+	size_t budget;
 
 	decoder->has_feedback = 0;
 
 #ifdef DEC_PACKETS_FEEDBACK
 	fprintf(stderr, ANSI_COLOR_GREEN "DEC  FB " ANSI_COLOR_YELLOW "----> %3d %4d: " ANSI_COLOR_GREEN, decoder->gen_oldest, decoder->oldest_global_seq);
 #endif
-	assert(skb_tailroom(packet) >= 4 + 4);
+	assert(skb_tailroom(packet) >= nck_pacemg_pkt_feedback_additional);
 	skb_put_u32(packet, decoder->gen_oldest);
 	skb_put_u32(packet, decoder->oldest_global_seq);
 
+	// records that do not fit are left out, they are the newest generations and
+	// the encoder keeps sending them until a later feedback covers them
+	budget = min_t(size_t, skb_tailroom(packet), decoder->feedback_size - nck_pacemg_pkt_feedback_additional);
+	prev_gen = decoder->gen_oldest;
+
 	//put feedback for each active container in packet
-	list_for_each_entry(container, &decoder->container_list, list) {
-		assert(skb_tailroom(packet) >= nck_pacemg_pkt_feedback_size_single);
-#ifdef DEC_PACKETS_FEEDBACK
-		fprintf(stderr, "%2d %2d %2d      ", container->generation, container->rank_enc_latest, container->rank_dec);
-#endif
-		skb_put_u32(packet, container->generation);
+	gen_table_for_each(&decoder->containers, gen, container) {
+		uint16_t rank_enc, rank_missing, rank_dec = container->rank_dec;
+		uint32_t delta = (container->generation - prev_gen) << 1;
+		size_t size;
+
 		// Put the "latest encoder rank" in the feedback packet if its the newest generation. Otherwise, make it
 		// equal to the full rank. This helps especially when the last x packets of a generation is lost
 		if (container == decoder->cont_newest) {
-			skb_put_u16(packet, container->rank_enc_latest);
+			rank_enc = container->rank_enc_latest;
+		} else {
+			rank_enc = (uint16_t) decoder->symbols;
+		}
+		rank_missing = rank_enc > rank_dec ? rank_enc - rank_dec : 0;
+
+		if (rank_dec == decoder->symbols) {
+			size = skb_varint_size(delta | 1);
+		} else {
+			size = skb_varint_size(delta) + skb_varint_size(rank_dec)
+				   + skb_varint_size(rank_missing);
+		}
+		if (size > budget) {
+			break;
+		}
+		budget -= size;
 
+#ifdef DEC_PACKETS_FEEDBACK
+		fprintf(stderr, "%2d %2d %2d      ", container->generation, rank_enc, rank_dec);
+#endif
+		if (rank_dec == decoder->symbols) {
+			skb_put_varint(packet, delta | 1);
 		} else {
-			skb_put_u16(packet, (uint16_t) decoder->symbols);
+			skb_put_varint(packet, delta);
+			skb_put_varint(packet, rank_dec);
+			skb_put_varint(packet, rank_missing);
 		}
-		skb_put_u16(packet, container->rank_dec);
-		skb_put_u16(packet, container->seqno);
+		prev_gen = container->generation;
 	}
 
 #ifdef DEC_PACKETS_FEEDBACK
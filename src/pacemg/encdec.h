@@ -20,7 +20,7 @@
 //#define DEC_STATS				//shows new value of gen_oldest in nck_pacemg_update_decoder_stat
 //#define DEC_RANK				//shows decoders target and actual rank in nck_pacemg_dec_put_coded
 
-#define MAX_MAX_ACTIVE_CONTAINERS 100	//maximum number for max_active_containers due to simulator restraints
+#define DEFAULT_MAX_ACTIVE_CONTAINERS 100	//number of containers the feedback is sized for until max_active_containers is set
 
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
@@ -39,13 +39,33 @@ struct nck_pacemg_pkt_header{
 };
 static const size_t nck_pacemg_pkt_header_size = 4 + 2 + 2 + 4 + 1;
 
+/*
+ * Feedback packet layout:
+ *
+ *   u32 oldest generation of the decoder
+ *   u32 global seqno of the last packet received
+ *   one record per active container, in ascending generation order:
+ *     varint  (generation - previous generation) << 1 | decoded
+ *     varint  decoder's rank               (omitted if decoded)
+ *     varint  encoder's rank - decoder's   (omitted if decoded)
+ *
+ * The previous generation of the first record is the oldest generation from
+ * the header. A decoded container has full rank on both sides, so its record
+ * is only the generation delta, usually a single byte.
+ */
 struct nck_pacemg_pkt_feedback{
 	uint32_t generation;	//generation no
 	uint16_t rank_enc;		//encoder's rank
 	uint16_t rank_dec;		//decoder's rank
-    uint16_t seqno;			//packet's no in generation (starting at 0)
 };
-static const size_t nck_pacemg_pkt_feedback_size_single = 4 + 2 + 2 + 2;
 static const size_t nck_pacemg_pkt_feedback_additional = 4 + 4;
+static const size_t nck_pacemg_pkt_feedback_size_single_max = SKB_VARINT_MAX + 3 + 3;
+static const size_t nck_pacemg_pkt_feedback_size_max = 1400;	//upper bound of a feedback packet, records that do not fit are left out
+
+static inline size_t nck_pacemg_feedback_size(uint32_t max_active_containers) {
+	size_t size = nck_pacemg_pkt_feedback_additional
+				  + nck_pacemg_pkt_feedback_size_single_max * (size_t) max_active_containers;
+	return size < nck_pacemg_pkt_feedback_size_max ? size : nck_pacemg_pkt_feedback_size_max;
+}
 
 #endif //NCKERNEL_ENCDEC_H
@@ -18,24 +18,27 @@
 #include "../private.h"
 #include "../kodo.h"
 #include "../util/helper.h"
-#include "list.h"
+#include "../util/gen_table.h"
+#include "../util/buffer_pool.h"
 #include "encdec.h"
 
 typedef struct nck_pacemg_enc_container {
-	struct list_head list;
 	struct nck_pacemg_enc *pacemg_encoder;
 	krlnc_encoder_t coder;
 	uint32_t generation;
 	uint16_t rank;
 	uint32_t to_send;
 	uint32_t sent;
+	uint32_t uncoded;
 	uint8_t *buffer;
 	uint32_t *coded_pkts_seq_nos;
 	uint32_t coded_pkt_seq_nos_index;
+	struct kodo_repair_batch repairs;
 } enc_container;
 
 struct nck_pacemg_enc {
 	krlnc_encoder_factory_t factory;
+	struct kodo_encoder_pool pool;
 
 	uint32_t block_size;
 	uint32_t symbols;
@@ -66,7 +69,8 @@ struct nck_pacemg_enc {
 	uint8_t *coded_pkts_per_input;
 	uint8_t *coded_pkts_so_far;
 	uint8_t *rank_per_pkt;
-	struct list_head container_list;
+	struct gen_table containers;
+	struct buffer_pool buffers;
 };
 
 NCK_ENCODER_IMPL(nck_pacemg, NULL, NULL, NULL)
@@ -76,10 +80,10 @@ NCK_ENCODER_IMPL(nck_pacemg, NULL, NULL, NULL)
  * @param encoder pointer to the encoder to work on
  */
 static void nck_pacemg_enc_update_stat(struct nck_pacemg_enc *encoder) {
-	if (!list_empty(&encoder->container_list)) {
-		encoder->cont_newest = list_entry(encoder->container_list.prev, enc_container, list);
+	if (encoder->containers.count > 0) {
+		encoder->cont_newest = gen_table_newest(&encoder->containers);
 		encoder->gen_newest = encoder->cont_newest->generation;
-		encoder->cont_oldest = list_entry(encoder->container_list.next, enc_container, list);
+		encoder->cont_oldest = gen_table_oldest(&encoder->containers);
 		encoder->gen_oldest = encoder->cont_oldest->generation;
 	}
 	else {
@@ -96,14 +100,15 @@ void nck_pacemg_enc_container_del(enc_container *container) {
 #ifdef ENC_ADD_DEL_CONTAINER
 	fprintf(stderr, "\nnck_pacemg_enc_container_del: gen == %d sent == %d\n", container->generation, container->sent);
 #endif
-	list_del(&container->list);
+	gen_table_remove(&container->pacemg_encoder->containers, container->generation);
 
 	container->pacemg_encoder->num_containers -= 1;
 	nck_pacemg_enc_update_stat(container->pacemg_encoder);
 
-	krlnc_delete_encoder(container->coder);
+	kodo_encoder_pool_put(&container->pacemg_encoder->pool, container->coder);
+	kodo_repair_batch_free(&container->repairs);
 	free(container->coded_pkts_seq_nos);
-	free(container->buffer);
+	buffer_pool_put(&container->pacemg_encoder->buffers, container->buffer);
 	free(container);
 }
 
@@ -116,11 +121,8 @@ void nck_pacemg_enc_container_add(struct nck_pacemg_enc *encoder, enc_container
 #ifdef ENC_ADD_DEL_CONTAINER
 	fprintf(stderr  , "nck_pacemg_enc_add_container: gen == %d\n", container->generation);
 #endif
-	enc_container *cont_tmp;
-	list_for_each_entry(cont_tmp, &encoder->container_list, list) {
-		if (cont_tmp->generation > container->generation) {break;}
-	}
-	list_add_before(&container->list, &cont_tmp->list);
+	// generations are created in ascending order, so the span never exceeds the limit
+	gen_table_insert(&encoder->containers, container->generation, container);
 	nck_pacemg_enc_update_stat(encoder);
 }
 
@@ -142,10 +144,11 @@ enc_container *nck_pacemg_enc_start_next_generation(struct nck_pacemg_enc *encod
 	container->rank = 0;
 	container->to_send = 0;
 	container->sent = 0;
-	container->coder = kodo_build_encoder(encoder->factory);
+	container->uncoded = 0;
+	container->coder = kodo_encoder_pool_get(&encoder->pool);
+	kodo_repair_batch_init(&container->repairs, encoder->factory);
 
-	container->buffer = malloc(encoder->block_size);
-	memset(container->buffer, 0, encoder->block_size);
+	container->buffer = buffer_pool_get(&encoder->buffers);
 
 	container->coded_pkts_seq_nos = malloc(encoder->max_cont_coded_history * sizeof(uint32_t));		// Number of seq nos to remember TODO: Make it configurable
 	memset(container->coded_pkts_seq_nos, 0, encoder->max_cont_coded_history * sizeof(uint32_t));
@@ -153,9 +156,6 @@ enc_container *nck_pacemg_enc_start_next_generation(struct nck_pacemg_enc *encod
 
 	encoder->num_containers += 1;
 
-	INIT_LIST_HEAD(&container->list);
-
-	// We ensure that the containers are placed in ascending order of the generation
 	nck_pacemg_enc_container_add(encoder, container);
 
 	return container;
@@ -180,6 +180,7 @@ struct nck_pacemg_enc *nck_pacemg_enc(krlnc_encoder_factory_t factory, struct nc
 	nck_trigger_init(&result->on_coded_ready);
 
 	result->factory = factory;
+	kodo_encoder_pool_init(&result->pool, factory);
 	result->symbols = krlnc_encoder_factory_symbols(factory);
 	result->block_size = krlnc_encoder_block_size(enc);
 	result->coding_ratio = 100; //default value
@@ -199,7 +200,8 @@ struct nck_pacemg_enc *nck_pacemg_enc(krlnc_encoder_factory_t factory, struct nc
 //		result->enc_flush_timeout_handle      = NULL;
 //	}
 
-	INIT_LIST_HEAD(&(result->container_list));
+	gen_table_init(&result->containers, result->max_active_containers);
+	buffer_pool_init(&result->buffers, result->block_size, 4);
 
 	result->coded_pkts_per_input = malloc(sizeof(uint8_t) * result->symbols);
 	memset(result->coded_pkts_per_input, 0, sizeof(uint8_t) * result->symbols);
@@ -211,11 +213,10 @@ struct nck_pacemg_enc *nck_pacemg_enc(krlnc_encoder_factory_t factory, struct nc
 	result->global_seqno = 0;
 
 	result->source_size = krlnc_encoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_encoder_payload_size(enc) + nck_pacemg_pkt_header_size;
-	result->feedback_size = nck_pacemg_pkt_feedback_additional
-							+ nck_pacemg_pkt_feedback_size_single * MAX_MAX_ACTIVE_CONTAINERS;
+	result->coded_size = kodo_encoder_payload_size(enc) + nck_pacemg_pkt_header_size;
+	result->feedback_size = nck_pacemg_feedback_size(DEFAULT_MAX_ACTIVE_CONTAINERS);
 
-	krlnc_delete_encoder(enc);
+	kodo_encoder_pool_put(&result->pool, enc);
 
 	return result;
 }
@@ -236,8 +237,7 @@ void nck_pacemg_reserve_enc_coded_queue(struct nck_pacemg_enc *encoder) {
 EXPORT
 void nck_pacemg_set_enc_max_active_containers(struct nck_pacemg_enc *encoder, uint32_t max_active_containers) {
 	encoder->max_active_containers = max_active_containers;
-	encoder->feedback_size =
-			nck_pacemg_pkt_feedback_size_single * max_active_containers + nck_pacemg_pkt_feedback_additional;
+	encoder->feedback_size = nck_pacemg_feedback_size(max_active_containers);
 }
 
 /**
@@ -401,10 +401,13 @@ void nck_pacemg_set_enc_flush_timeout(struct nck_pacemg_enc *encoder, const stru
  */
 EXPORT
 void nck_pacemg_enc_free(struct nck_pacemg_enc *encoder) {
-	enc_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &encoder->container_list, list) {
+	enc_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&encoder->containers, gen, cont_tmp) {
 		nck_pacemg_enc_container_del(cont_tmp);
 	}
+	gen_table_free(&encoder->containers);
+	buffer_pool_free(&encoder->buffers);
 
 	nck_timer_cancel(encoder->enc_redundancy_timeout_handle);
 	nck_timer_free(encoder->enc_redundancy_timeout_handle);
@@ -412,7 +415,8 @@ void nck_pacemg_enc_free(struct nck_pacemg_enc *encoder) {
 	nck_timer_cancel(encoder->enc_flush_timeout_handle);
 	nck_timer_free(encoder->enc_flush_timeout_handle);
 
-	krlnc_delete_encoder_factory(encoder->factory);
+	kodo_encoder_pool_free(&encoder->pool);
+	kodo_delete_encoder_factory(encoder->factory);
 
 	free(encoder->coded_pkts_per_input);
 	free(encoder->coded_pkts_so_far);
@@ -421,6 +425,30 @@ void nck_pacemg_enc_free(struct nck_pacemg_enc *encoder) {
 	free(encoder);
 }
 
+/**
+ * drops all generations, the buffers are kept in the pool
+ * @param encoder pointer to the encoder to work on
+ *
+ * @return 0 on success
+ */
+EXPORT
+int nck_pacemg_enc_reset(struct nck_pacemg_enc *encoder) {
+	enc_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&encoder->containers, gen, cont_tmp) {
+		nck_pacemg_enc_container_del(cont_tmp);
+	}
+
+	nck_timer_cancel(encoder->enc_redundancy_timeout_handle);
+	nck_timer_cancel(encoder->enc_flush_timeout_handle);
+
+	encoder->gen_newest = 0;
+	encoder->gen_oldest = 0;
+	encoder->global_seqno = 0;
+
+	return 0;
+}
+
 /**
  * checks if the container has coded packets available
  * @param container pointer to the container to work on
@@ -440,7 +468,8 @@ int nck_pacemg_enc_cont_has_coded(struct nck_pacemg_enc_container *container) {
 EXPORT
 int nck_pacemg_enc_has_coded(struct nck_pacemg_enc *encoder) {
 	enc_container *container;
-	list_for_each_entry(container, &encoder->container_list, list) {
+	uint32_t gen;
+	gen_table_for_each(&encoder->containers, gen, container) {
 		if (nck_pacemg_enc_cont_has_coded(container)) {
 			return 1;
 		}
@@ -508,6 +537,7 @@ uint8_t nck_pacemg_enc_calculate_feedback(struct nck_pacemg_enc *encoder) {
 EXPORT
 int nck_pacemg_enc_get_coded(struct nck_pacemg_enc *encoder, struct sk_buff *packet) {
 	enc_container *container;
+	uint32_t gen;
 	int found = 0;
 	int coded = 0;
 
@@ -516,7 +546,7 @@ int nck_pacemg_enc_get_coded(struct nck_pacemg_enc *encoder, struct sk_buff *pac
 	}
 
 	// Skip to the container that has coded pkts
-	list_for_each_entry(container, &encoder->container_list, list) {
+	gen_table_for_each(&encoder->containers, gen, container) {
 		if (nck_pacemg_enc_cont_has_coded(container)) {
 			found = 1;
 			break;
@@ -527,8 +557,12 @@ int nck_pacemg_enc_get_coded(struct nck_pacemg_enc *encoder, struct sk_buff *pac
 
 	skb_reserve(packet, nck_pacemg_pkt_header_size);
 
-	kodo_encoder_get_coded(container->coder, packet);
-	if (packet->data[4] != 0xff) {
+	if (container->uncoded < container->rank) {
+		kodo_encoder_get_coded(container->coder, packet);
+		container->uncoded += 1;
+	} else {
+		kodo_encoder_get_repair(container->coder, &container->repairs, container->buffer,
+				container->rank, container->to_send, packet);
 		coded = 1;
 	}
 
@@ -597,7 +631,7 @@ int nck_pacemg_enc_put_source(struct nck_pacemg_enc *encoder, struct sk_buff *pa
 		return -1;
 	}
 
-	if (list_empty(&encoder->container_list) || encoder->cont_newest->rank == encoder->symbols) {
+	if (encoder->containers.count == 0 || encoder->cont_newest->rank == encoder->symbols) {
 		nck_pacemg_enc_start_next_generation(encoder);
 	}
 
@@ -614,6 +648,7 @@ int nck_pacemg_enc_put_source(struct nck_pacemg_enc *encoder, struct sk_buff *pa
 #endif
 
 	kodo_put_source(container->coder, packet, container->buffer, container->rank);
+	kodo_repair_batch_clear(&container->repairs);
 
 	container->rank = krlnc_encoder_rank(container->coder);
 
@@ -677,7 +712,7 @@ uint32_t nck_pacemg_enc_additional_coded(enc_container *container, uint32_t seqn
 EXPORT
 int nck_pacemg_enc_put_feedback(struct nck_pacemg_enc *encoder, struct sk_buff *packet) {
 	if (encoder->feedback) {
-		enc_container *cont_tmp, *cont_safe;
+		enc_container *cont_tmp;
 
 		//get decoder's oldest generation no
 		assert(packet->len >= nck_pacemg_pkt_feedback_additional);
@@ -688,25 +723,40 @@ int nck_pacemg_enc_put_feedback(struct nck_pacemg_enc *encoder, struct sk_buff *
 #endif
 
 		//delete older containers
-		list_for_each_entry_safe(cont_tmp, cont_safe, &encoder->container_list, list) {
-			if (cont_tmp->generation < oldest_generation) {
+		while ((cont_tmp = gen_table_oldest(&encoder->containers)) != NULL &&
+		       cont_tmp->generation < oldest_generation) {
 #ifdef ENC_PACKETS_FEEDBACK
-				fprintf(stderr, "%2d del        ", cont_tmp->generation);
+			fprintf(stderr, "%2d del        ", cont_tmp->generation);
 #endif
-				nck_pacemg_enc_container_del(cont_tmp);
-			}
+			nck_pacemg_enc_container_del(cont_tmp);
 		}
 
 		//for every feedback
-		while (packet->len >= nck_pacemg_pkt_feedback_size_single) {
-			struct nck_pacemg_pkt_feedback feedback = {
-					.generation = skb_pull_u32(packet),
-					.rank_enc   = skb_pull_u16(packet),
-					.rank_dec   = skb_pull_u16(packet),
-					.seqno      = skb_pull_u16(packet),
-			};
+		uint32_t prev_generation = oldest_generation;
+		while (packet->len > 0) {
+			struct nck_pacemg_pkt_feedback feedback;
+			uint32_t delta, rank_dec, rank_diff;
+
+			if (skb_pull_varint(packet, &delta)) {
+				return -1;
+			}
+			feedback.generation = prev_generation + (delta >> 1);
+			prev_generation = feedback.generation;
+
+			if (delta & 1) {
+				//decoded containers carry no ranks
+				rank_dec = encoder->symbols;
+				rank_diff = 0;
+			} else if (skb_pull_varint(packet, &rank_dec) || skb_pull_varint(packet, &rank_diff)) {
+				return -1;
+			}
+			if (rank_dec > encoder->symbols || rank_diff > encoder->symbols - rank_dec) {
+				return -1;
+			}
+			feedback.rank_dec = (uint16_t) rank_dec;
+			feedback.rank_enc = (uint16_t) (rank_dec + rank_diff);
 #ifdef ENC_PACKETS_FEEDBACK
-			fprintf(stderr, ANSI_COLOR_RED "%2d %2d %2d ", feedback.generation, feedback.seqno, feedback.rank_dec);
+			fprintf(stderr, ANSI_COLOR_RED "%2d %2d ", feedback.generation, feedback.rank_dec);
 #endif
 
 			//calculate diffence between encoder's and decpder's rank
@@ -717,49 +767,47 @@ int nck_pacemg_enc_put_feedback(struct nck_pacemg_enc *encoder, struct sk_buff *
 			int found = 0;
 #endif
 
-			//check for each container if it's generation is matching the feedback's
-			list_for_each_entry_safe(cont_tmp, cont_safe, &encoder->container_list, list) {
-				if (cont_tmp->generation == feedback.generation) {
+			//look up the container of the feedback's generation
+			cont_tmp = gen_table_get(&encoder->containers, feedback.generation);
+			if (cont_tmp) {
 #ifdef ENC_PACKETS_FEEDBACK
-					fprintf(stderr, ANSI_COLOR_MAGENTA "ack" ANSI_COLOR_CYAN);
+				fprintf(stderr, ANSI_COLOR_MAGENTA "ack" ANSI_COLOR_CYAN);
 #endif
-					if (rank_missing == 0) {
-						if (cont_tmp->to_send == 0 && feedback.rank_dec == encoder->symbols) {
-							//generation is fully delivered
-							nck_pacemg_enc_container_del(cont_tmp);
+				if (rank_missing == 0) {
+					if (cont_tmp->to_send == 0 && feedback.rank_dec == encoder->symbols) {
+						//generation is fully delivered
+						nck_pacemg_enc_container_del(cont_tmp);
 #ifdef ENC_PACKETS_FEEDBACK
-							fprintf(stderr, "d ");
-						}
-						else {
-							fprintf(stderr, "  ");
-#endif
-						}
+						fprintf(stderr, "d ");
 					}
 					else {
-#ifdef ENC_PACKETS_FEEDBACK
 						fprintf(stderr, "  ");
 #endif
-						//subtract number of coded packets send since the packet the feedback is reacting to
-						int coded_pkts_sent_after_seqno = 0;
-						for (uint32_t idx=0; idx<encoder->max_cont_coded_history ; idx++) {
-							if (cont_tmp->coded_pkts_seq_nos[idx] > oldest_dec_global_seqno) {
-								coded_pkts_sent_after_seqno ++;
-							}
+					}
+				}
+				else {
+#ifdef ENC_PACKETS_FEEDBACK
+					fprintf(stderr, "  ");
+#endif
+					//subtract number of coded packets send since the packet the feedback is reacting to
+					int coded_pkts_sent_after_seqno = 0;
+					for (uint32_t idx=0; idx<encoder->max_cont_coded_history ; idx++) {
+						if (cont_tmp->coded_pkts_seq_nos[idx] > oldest_dec_global_seqno) {
+							coded_pkts_sent_after_seqno ++;
 						}
-						rank_missing -= coded_pkts_sent_after_seqno;
+					}
+					rank_missing -= coded_pkts_sent_after_seqno;
 //						rank_missing -= nck_pacemg_enc_additional_coded(cont_tmp, feedback.seqno);
 
-						if (rank_missing > 0) {
-							//increase number of packets to send
-							cont_tmp->to_send += rank_missing;
-                            nck_trigger_call(&encoder->on_coded_ready);
-						}
+					if (rank_missing > 0) {
+						//increase number of packets to send
+						cont_tmp->to_send += rank_missing;
+                        nck_trigger_call(&encoder->on_coded_ready);
 					}
+				}
 #ifdef ENC_PACKETS_FEEDBACK
-					found = 1;
+				found = 1;
 #endif
-					break;
-				}
 			}
 #ifdef ENC_PACKETS_FEEDBACK
 			if (!found) {
@@ -14,10 +14,10 @@
 #include "../private.h"
 #include "../kodo.h"
 #include "../util/helper.h"
-#include "list.h"
+#include "../util/gen_table.h"
+#include "../util/buffer_pool.h"
 
 typedef struct nck_pacemg_rec_container {
-	struct list_head list;
 	struct nck_pacemg_rec *pacemg_recoder;
 	krlnc_decoder_t coder;
 	uint32_t generation;
@@ -43,6 +43,7 @@ typedef struct nck_pacemg_rec_container {
 
 struct nck_pacemg_rec {
 	krlnc_decoder_factory_t factory;
+	struct kodo_decoder_pool pool;
 	uint32_t gen_newest;
 	uint32_t gen_oldest;
 	uint32_t gen_oldest_deleted;
@@ -60,8 +61,8 @@ struct nck_pacemg_rec {
 	uint16_t coding_ratio;
 	uint16_t tail_packets;
 
-	uint16_t max_active_containers;
-	uint16_t max_containers;
+	uint32_t max_active_containers;
+	uint32_t max_containers;
 
 	size_t source_size, coded_size, feedback_size;
 	uint8_t to_send_rec;
@@ -75,17 +76,18 @@ struct nck_pacemg_rec {
 	struct nck_timer_entry *rec_redundancy_timeout_handle;
 
 	struct nck_trigger on_source_ready, on_coded_ready, on_feedback_ready;
-	struct list_head container_list;
+	struct gen_table containers;
+	struct buffer_pool buffers;
 
 };
 
 NCK_RECODER_IMPL(nck_pacemg, nck_pacemg_rec_debug, NULL, NULL)
 
 static void nck_pacemg_update_recoder_stat(struct nck_pacemg_rec *recoder) {
-	if (!list_empty(&recoder->container_list)) {
-		recoder->cont_newest = list_entry(recoder->container_list.prev, rec_container, list);
+	if (recoder->containers.count > 0) {
+		recoder->cont_newest = gen_table_newest(&recoder->containers);
 		recoder->gen_newest = recoder->cont_newest->generation;
-		recoder->cont_oldest = list_entry(recoder->container_list.next, rec_container, list);
+		recoder->cont_oldest = gen_table_oldest(&recoder->containers);
 		recoder->gen_oldest = recoder->cont_oldest->generation;
 	} else {
 		recoder->cont_newest = NULL;
@@ -120,20 +122,24 @@ static void rec_container_timeout_flush(struct nck_timer_entry *entry, void *con
 EXPORT
 rec_container *nck_pacemg_rec_start_next_generation(struct nck_pacemg_rec *recoder, uint32_t generation) {
 	rec_container *container;
-	rec_container *cont_tmp;
 	container = malloc(sizeof(*container));
 	memset(container, 0, sizeof(*container));
 
+	if (gen_table_insert(&recoder->containers, generation, container)) {
+		free(container);
+		return NULL;
+	}
+
 	container->pacemg_recoder = recoder;
 	container->generation = generation;
 	container->rank = 0;
 	container->prev_rank = 0;
 	container->flush = 0;
 	container->index = 0;
-	container->coder = kodo_build_decoder(recoder->factory);
+	container->coder = kodo_decoder_pool_get(&recoder->pool);
 	krlnc_decoder_set_status_updater_on(container->coder);
 
-	container->queue = malloc(recoder->symbols * recoder->source_size);
+	container->queue = buffer_pool_get(&recoder->buffers);
 	container->queue_index = 0;
 	container->queue_length = 0;
 	container->coded_queue_length = 0;
@@ -142,21 +148,12 @@ rec_container *nck_pacemg_rec_start_next_generation(struct nck_pacemg_rec *recod
 	container->to_send = 0;
 	container->last_fb_rank = 0;
 
-	container->buffer = malloc(recoder->block_size);
-	memset(container->buffer, 0, recoder->block_size);
+	container->buffer = buffer_pool_get(&recoder->buffers);
 	krlnc_decoder_set_mutable_symbols(container->coder, container->buffer, recoder->block_size);
 
 	container->rec_cont_flush_timeout_handle = nck_timer_add(recoder->timer, NULL, container,
 								 rec_container_timeout_flush);
 
-	INIT_LIST_HEAD(&container->list);
-
-	// We ensure that the containers are placed in ascending order of the generation
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
-		if (cont_tmp->generation > generation) break;
-	}
-	list_add_before(&container->list, &cont_tmp->list);
-
 	recoder->num_containers++;
 
 	nck_pacemg_update_recoder_stat(recoder);
@@ -175,14 +172,15 @@ char *nck_pacemg_rec_contdebug(void *rec) {
 	struct nck_pacemg_rec *recoder = rec;
 
 	strcpy(result, "\t\t\t\t");
-	rec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &recoder->container_list, list) {
+	rec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		snprintf(debug_head, sizeof(debug_head) - 1, "GEN IDX FLU RNK QID QLN CQL TSE\t\t");
 		strcat(result, debug_head);
 	}
 	strcat(result,"\n\t\t\t\t");
 
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &recoder->container_list, list) {
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		snprintf(debug, sizeof(debug) - 1, "%*d %*d %*d %*d %*d %*d%*d%*d\t\t",
 			 3, cont_tmp->generation, 3, cont_tmp->index, 3, cont_tmp->flush,
 			 3, krlnc_decoder_rank(cont_tmp->coder),
@@ -204,8 +202,9 @@ char *nck_pacemg_rec_debug(void *rec) {
 	struct nck_pacemg_rec *recoder = rec;
 	int len = sizeof(debug), pos = 0;
 
-	rec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &recoder->container_list, list) {
+	rec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"GEN\":%d,", cont_tmp->generation);
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"IDX\":%d,", cont_tmp->index);
 		pos += snprintf(&debug[pos], CHK_ZERO(len - pos), "\"FLU\":%d,", cont_tmp->flush);
@@ -259,10 +258,11 @@ struct nck_pacemg_rec *nck_pacemg_rec(krlnc_decoder_factory_t factory, struct nc
 	result->symbols = krlnc_decoder_factory_symbols(factory);
 
 	result->source_size = krlnc_decoder_factory_symbol_size(factory);
-	result->coded_size = krlnc_decoder_payload_size(dec) + 6;
+	result->coded_size = kodo_decoder_payload_size(dec) + 6;
 	result->feedback_size = 6;
 
 	result->factory = factory;
+	kodo_decoder_pool_init(&result->pool, factory);
 	result->block_size = block_size;
 	result->gen_oldest_deleted = 0;
 	result->num_containers = 0;
@@ -271,7 +271,9 @@ struct nck_pacemg_rec *nck_pacemg_rec(krlnc_decoder_factory_t factory, struct nc
 	result->coded_pkts_per_input = malloc(sizeof(uint8_t) * result->symbols);
 	memset(result->coded_pkts_per_input, 0, sizeof(uint8_t) * result->symbols);
 
-	INIT_LIST_HEAD(&(result->container_list));
+	gen_table_init(&result->containers, 8);
+	// the reorder queue of a container has the size of a block
+	buffer_pool_init(&result->buffers, block_size, 8);
 
 	result->timer = timer;
 
@@ -279,7 +281,7 @@ struct nck_pacemg_rec *nck_pacemg_rec(krlnc_decoder_factory_t factory, struct nc
 //	result->rec_redundancy_timeout_handle = nck_timer_add(timer, &result->rec_redundancy_timeout, result, recoder_send_redundancy);
 //	result->rec_flush_timeout_handle = nck_timer_add(timer, &result->rec_flush_timeout, result, recoder_timeout_flush);
 
-	krlnc_delete_decoder(dec);
+	kodo_decoder_pool_put(&result->pool, dec);
 
 	return result;
 }
@@ -381,23 +383,24 @@ void nck_pacemg_set_rec_tail_packets(struct nck_pacemg_rec *recoder, uint16_t ta
 }
 
 EXPORT
-void nck_pacemg_set_rec_max_active_containers(struct nck_pacemg_rec *recoder, uint16_t max_active_containers) {
+void nck_pacemg_set_rec_max_active_containers(struct nck_pacemg_rec *recoder, uint32_t max_active_containers) {
 	recoder->max_active_containers = max_active_containers;
 }
 
 EXPORT
-void nck_pacemg_set_rec_max_containers(struct nck_pacemg_rec *recoder, uint16_t max_containers) {
+void nck_pacemg_set_rec_max_containers(struct nck_pacemg_rec *recoder, uint32_t max_containers) {
 	recoder->max_containers = max_containers;
+	gen_table_set_max_span(&recoder->containers, max_containers);
 }
 
 void nck_pacemg_rec_container_del(rec_container *container) {
 	container->pacemg_recoder->to_send_rec -= container->to_send;
-	list_del(&container->list);
-	krlnc_delete_decoder(container->coder);
+	gen_table_remove(&container->pacemg_recoder->containers, container->generation);
+	kodo_decoder_pool_put(&container->pacemg_recoder->pool, container->coder);
 	nck_timer_cancel(container->rec_cont_flush_timeout_handle);
 	nck_timer_free(container->rec_cont_flush_timeout_handle);
-	free(container->buffer);
-	free(container->queue);
+	buffer_pool_put(&container->pacemg_recoder->buffers, container->buffer);
+	buffer_pool_put(&container->pacemg_recoder->buffers, container->queue);
 	free(container->coded_queue_addr);
 	free(container);
 }
@@ -405,11 +408,15 @@ void nck_pacemg_rec_container_del(rec_container *container) {
 
 EXPORT
 void nck_pacemg_rec_free(struct nck_pacemg_rec *recoder) {
-	rec_container *cont_tmp, *cont_tmp_safe;
-	list_for_each_entry_safe(cont_tmp, cont_tmp_safe, &recoder->container_list, list) {
+	rec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		nck_pacemg_rec_container_del(cont_tmp);
 	}
-	krlnc_delete_decoder_factory(recoder->factory);
+	gen_table_free(&recoder->containers);
+	buffer_pool_free(&recoder->buffers);
+	kodo_decoder_pool_free(&recoder->pool);
+	kodo_delete_decoder_factory(recoder->factory);
 
 	nck_timer_cancel(recoder->rec_fb_timeout_handle);
 	nck_timer_free(recoder->rec_fb_timeout_handle);
@@ -425,6 +432,31 @@ void nck_pacemg_rec_free(struct nck_pacemg_rec *recoder) {
 	free(recoder);
 }
 
+EXPORT
+int nck_pacemg_rec_reset(struct nck_pacemg_rec *recoder) {
+	rec_container *cont_tmp;
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
+		nck_pacemg_rec_container_del(cont_tmp);
+	}
+
+	nck_timer_cancel(recoder->rec_fb_timeout_handle);
+	nck_timer_cancel(recoder->rec_redundancy_timeout_handle);
+	nck_timer_cancel(recoder->rec_flush_timeout_handle);
+
+	recoder->cont_newest = NULL;
+	recoder->cont_oldest = NULL;
+	recoder->cont_oldest_flushed = NULL;
+	recoder->gen_newest = 0;
+	recoder->gen_oldest = 0;
+	recoder->gen_oldest_deleted = 0;
+	recoder->num_containers = 0;
+	recoder->num_flushed_containers = 0;
+	recoder->to_send_rec = 0;
+
+	return 0;
+}
+
 static int rec_cont_has_source(rec_container *container) {
 	if (container->index == container->pacemg_recoder->symbols)
 		return 2;
@@ -441,13 +473,14 @@ static int rec_cont_has_source(rec_container *container) {
 EXPORT
 int nck_pacemg_rec_has_source(struct nck_pacemg_rec *recoder) {
 	// No containers are present
-	if (list_empty(&recoder->container_list))
+	if (recoder->containers.count == 0)
 		return 0;
 
 	rec_container *cont_tmp;
+	uint32_t gen;
 
 	// Skip to the container that has source pkts
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		if (rec_cont_has_source(cont_tmp) == 2)
 			continue;
 		if (cont_tmp->flush == 0)
@@ -494,7 +527,8 @@ int nck_pacemg_rec_flush_container(rec_container *container) {
 EXPORT
 void nck_pacemg_rec_flush_source(struct nck_pacemg_rec *recoder) {
 	rec_container *cont_tmp;
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		nck_pacemg_rec_flush_container(cont_tmp);
 	}
 }
@@ -526,7 +560,8 @@ void nck_pacemg_rec_cont_flush_coded(rec_container *container){
 EXPORT
 void nck_pacemg_rec_flush_coded(struct nck_pacemg_rec *recoder) {
 	rec_container *cont_tmp;
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
+	uint32_t gen;
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		nck_pacemg_rec_cont_flush_coded(cont_tmp);
 	}
 	nck_trigger_call(&recoder->on_coded_ready);
@@ -552,8 +587,8 @@ void nck_pacemg_rec_put_coded_to_queue(rec_container *container){
 
 EXPORT
 int nck_pacemg_rec_put_coded(struct nck_pacemg_rec *recoder, struct sk_buff *packet) {
-	uint32_t generation, rank;
-	rec_container *cont_tmp, *cont = NULL, *oldest_unflushed_container = NULL, *cont_tmp2;
+	uint32_t generation, rank, gen;
+	rec_container *cont, *oldest_unflushed_container = NULL, *cont_tmp2;
 
 	if (packet->len < 6) {
 		return ENOSPC;
@@ -564,25 +599,20 @@ int nck_pacemg_rec_put_coded(struct nck_pacemg_rec *recoder, struct sk_buff *pac
 	UNUSED(rank);
 
 	// "cont" will contain the pointer to the container of the gen if exists else NULL
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
-		if (cont_tmp->generation != generation)
-			continue;
-		cont = cont_tmp;
-		break;
-	}
+	cont = gen_table_get(&recoder->containers, generation);
 
-	if ((generation < recoder->gen_oldest) || (generation <= recoder->gen_oldest_deleted)) {
+	if (gen_before(generation, recoder->gen_oldest) || !gen_before(recoder->gen_oldest_deleted, generation)) {
 		// Encoder sending old gen packets. Should send feedback for each such packet??+
 		// Right now, doing nothing.
 		return 0;
 	}
 	if(!cont){
-		if (recoder->gen_newest < generation ||
-		    (recoder->gen_oldest_deleted < generation && generation < recoder->gen_newest)) {
+		if (gen_before(recoder->gen_newest, generation) ||
+		    (gen_before(recoder->gen_oldest_deleted, generation) && gen_before(generation, recoder->gen_newest))) {
 			// Create new container and flush out oldest ones if necessary
 			if (recoder->num_containers >= recoder->max_active_containers) {
 				// "cont" will contain the pointer to the container
-				list_for_each_entry(cont_tmp2, &recoder->container_list, list) {
+				gen_table_for_each(&recoder->containers, gen, cont_tmp2) {
 					if (cont_tmp2->flush == 1)
 						continue;
 					oldest_unflushed_container = cont_tmp2;
@@ -600,7 +630,11 @@ int nck_pacemg_rec_put_coded(struct nck_pacemg_rec *recoder, struct sk_buff *pac
 				}
 			}
 
-			if (recoder->num_containers >= recoder->max_containers) {
+			// containers that are more than max_containers generations behind
+			// the new one are dropped as well
+			while (recoder->num_containers > 0 &&
+			       (recoder->num_containers >= recoder->max_containers ||
+				!gen_table_fits(&recoder->containers, generation))) {
 				recoder->gen_oldest_deleted = recoder->cont_oldest->generation;
 				nck_pacemg_rec_container_del(recoder->cont_oldest);
 				nck_pacemg_update_recoder_stat(recoder);
@@ -610,7 +644,8 @@ int nck_pacemg_rec_put_coded(struct nck_pacemg_rec *recoder, struct sk_buff *pac
 			//printf("Containers: %d\n",recoder->num_containers);
 		}
 	}
-	assert(cont != NULL);
+	if (!cont)
+		return -1;
 
 	if (cont->flush == 1)
 		// Trying to put_coded to an already flushed container
@@ -674,9 +709,10 @@ int nck_pacemg_rec_get_source(struct nck_pacemg_rec *recoder, struct sk_buff *pa
 		return -1;
 
 	rec_container *cont_tmp, *oldest_container = NULL;
+	uint32_t gen;
 
 	// Skip to the container that has source pkts
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		if (rec_cont_has_source(cont_tmp) == 2)
 			continue;
 		if (cont_tmp->flush == 0) {
@@ -737,13 +773,14 @@ int nck_pacemg_rec_has_feedback(struct nck_pacemg_rec *recoder) {
 
 EXPORT
 int nck_pacemg_rec_has_coded(struct nck_pacemg_rec *recoder) {
-	if (list_empty(&recoder->container_list))
+	if (recoder->containers.count == 0)
 		return 0;
 
 	rec_container *cont_tmp;
+	uint32_t gen;
 
 	// Skip to the container that has source pkts
-	list_for_each_entry(cont_tmp, &recoder->container_list, list) {
+	gen_table_for_each(&recoder->containers, gen, cont_tmp) {
 		if (nck_pacemg_rec_cont_has_coded(cont_tmp))
 			return 1;
 	}
@@ -764,10 +801,13 @@ int nck_pacemg_rec_get_coded(struct nck_pacemg_rec *recoder, struct sk_buff *pac
 		return -1;
 	}
 	rec_container *container;
+	uint32_t gen;
 	// Skip to the container that has coded pkts
-	list_for_each_entry(container, &recoder->container_list, list) {
+	gen_table_for_each(&recoder->containers, gen, container) {
 		if (nck_pacemg_rec_cont_has_coded(container)) break;
 	}
+	if (!container)
+		return -1;
 
 	if (container->coded_queue_length > 0) {
 		uint8_t *payload = skb_put(packet, (unsigned) recoder->coded_size);
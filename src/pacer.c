@@ -0,0 +1,109 @@
+#include <assert.h>
+#include <math.h>
+
+#include <sys/time.h>
+
+#include <nckernel/pacer.h>
+
+#include "private.h"
+
+static void pacer_wakeup(struct nck_timer_entry *entry, void *context, int success)
+{
+	UNUSED(entry);
+
+	struct nck_pacer *pacer = (struct nck_pacer *)context;
+	if (success) {
+		nck_trigger_call(&pacer->on_ready);
+	}
+}
+
+static void pacer_refill(struct nck_pacer *pacer)
+{
+	struct timeval now, elapsed;
+
+	nck_timer_gettime(pacer->timer, &now);
+	if (!timercmp(&now, &pacer->last, >)) {
+		return;
+	}
+
+	timersub(&now, &pacer->last, &elapsed);
+	pacer->last = now;
+
+	pacer->tokens += (elapsed.tv_sec + elapsed.tv_usec / 1000000.0) * pacer->rate;
+	pacer->tokens = min_t(double, pacer->tokens, pacer->burst);
+}
+
+EXPORT
+void nck_pacer_init(struct nck_pacer *pacer, struct nck_timer *timer, uint64_t rate, uint32_t burst)
+{
+	*pacer = (struct nck_pacer) {
+		.timer = timer,
+		.wakeup = nck_timer_add(timer, NULL, pacer, pacer_wakeup),
+		.rate = rate,
+		.burst = burst,
+		.tokens = burst,
+	};
+
+	nck_trigger_init(&pacer->on_ready);
+	nck_timer_gettime(timer, &pacer->last);
+}
+
+EXPORT
+void nck_pacer_set_rate(struct nck_pacer *pacer, uint64_t rate, uint32_t burst)
+{
+	// collect the tokens at the old rate before switching
+	pacer_refill(pacer);
+
+	pacer->rate = rate;
+	pacer->burst = burst;
+	pacer->tokens = min_t(double, pacer->tokens, burst);
+
+	if (rate == 0) {
+		pacer->tokens = burst;
+	}
+}
+
+EXPORT
+int nck_pacer_ready(struct nck_pacer *pacer)
+{
+	struct timeval delay;
+	double wait;
+
+	if (pacer->rate == 0) {
+		return 1;
+	}
+
+	pacer_refill(pacer);
+	if (pacer->tokens >= 0) {
+		return 1;
+	}
+
+	if (!nck_timer_pending(pacer->wakeup)) {
+		// round up, a wakeup one microsecond too early would find an empty bucket again
+		wait = ceil(-pacer->tokens * 1000000.0 / pacer->rate);
+		delay.tv_sec = (time_t)(wait / 1000000);
+		delay.tv_usec = (suseconds_t)(wait - delay.tv_sec * 1000000.0);
+		nck_timer_rearm(pacer->wakeup, &delay);
+	}
+
+	return 0;
+}
+
+EXPORT
+void nck_pacer_sent(struct nck_pacer *pacer, size_t len)
+{
+	if (pacer->rate == 0) {
+		return;
+	}
+
+	pacer_refill(pacer);
+	pacer->tokens -= len;
+}
+
+EXPORT
+void nck_pacer_free(struct nck_pacer *pacer)
+{
+	nck_timer_cancel(pacer->wakeup);
+	nck_timer_free(pacer->wakeup);
+	pacer->wakeup = NULL;
+}
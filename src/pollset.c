@@ -0,0 +1,127 @@
+#include <stddef.h>
+
+#include <nckernel/pollset.h>
+
+#include "private.h"
+
+static void pollset_mark(struct nck_poll_handle *handle, uint32_t event)
+{
+	struct nck_pollset *set = handle->set;
+
+	handle->ready |= event;
+	if (handle->pprev)
+		return;
+
+	// every coder is queued once, further events are only merged
+	handle->next = NULL;
+	handle->pprev = set->tail;
+	*set->tail = handle;
+	set->tail = &handle->next;
+	set->count += 1;
+}
+
+static void pollset_unlink(struct nck_poll_handle *handle)
+{
+	struct nck_pollset *set = handle->set;
+
+	if (!handle->pprev)
+		return;
+
+	*handle->pprev = handle->next;
+	if (handle->next)
+		handle->next->pprev = handle->pprev;
+	else
+		set->tail = handle->pprev;
+
+	handle->next = NULL;
+	handle->pprev = NULL;
+	set->count -= 1;
+}
+
+static void pollset_source_ready(void *context)
+{
+	pollset_mark((struct nck_poll_handle *)context, NCK_POLL_SOURCE);
+}
+
+static void pollset_coded_ready(void *context)
+{
+	pollset_mark((struct nck_poll_handle *)context, NCK_POLL_CODED);
+}
+
+static void pollset_feedback_ready(void *context)
+{
+	pollset_mark((struct nck_poll_handle *)context, NCK_POLL_FEEDBACK);
+}
+
+EXPORT
+void nck_pollset_init(struct nck_pollset *set)
+{
+	set->head = NULL;
+	set->tail = &set->head;
+	set->count = 0;
+}
+
+EXPORT
+int nck_pollset_add(struct nck_pollset *set, struct nck_poll_handle *handle,
+		    struct nck_coder *coder, uint32_t events, void *context)
+{
+	handle->set = set;
+	handle->context = context;
+	handle->events = 0;
+	handle->ready = 0;
+	handle->next = NULL;
+	handle->pprev = NULL;
+
+	if ((events & NCK_POLL_SOURCE) && coder->on_source_ready) {
+		nck_trigger_set(coder->on_source_ready, handle, pollset_source_ready);
+		handle->events |= NCK_POLL_SOURCE;
+	}
+
+	if ((events & NCK_POLL_CODED) && coder->on_coded_ready) {
+		nck_trigger_set(coder->on_coded_ready, handle, pollset_coded_ready);
+		handle->events |= NCK_POLL_CODED;
+	}
+
+	if ((events & NCK_POLL_FEEDBACK) && coder->on_feedback_ready) {
+		nck_trigger_set(coder->on_feedback_ready, handle, pollset_feedback_ready);
+		handle->events |= NCK_POLL_FEEDBACK;
+	}
+
+	return handle->events ? 0 : -1;
+}
+
+EXPORT
+void nck_pollset_del(struct nck_poll_handle *handle, struct nck_coder *coder)
+{
+	if (handle->events & NCK_POLL_SOURCE)
+		nck_trigger_init(coder->on_source_ready);
+
+	if (handle->events & NCK_POLL_CODED)
+		nck_trigger_init(coder->on_coded_ready);
+
+	if (handle->events & NCK_POLL_FEEDBACK)
+		nck_trigger_init(coder->on_feedback_ready);
+
+	pollset_unlink(handle);
+	handle->events = 0;
+	handle->ready = 0;
+}
+
+EXPORT
+size_t nck_pollset_drain(struct nck_pollset *set, struct nck_poll_event *events, size_t max_events)
+{
+	struct nck_poll_handle *handle;
+	size_t count = 0;
+
+	while (count < max_events && set->head) {
+		handle = set->head;
+		pollset_unlink(handle);
+
+		events[count].context = handle->context;
+		events[count].events = handle->ready;
+		handle->ready = 0;
+		count += 1;
+	}
+
+	return count;
+}
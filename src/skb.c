@@ -165,6 +165,51 @@ uint32_t skb_pull_u32(struct sk_buff *skb)
 	return ntohl(value);
 }
 
+void skb_put_varint(struct sk_buff *skb, uint32_t value)
+{
+	uint8_t *buffer = skb_put(skb, skb_varint_size(value));
+
+	while (value >= 0x80) {
+		*buffer++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*buffer = (uint8_t)value;
+}
+
+int skb_pull_varint(struct sk_buff *skb, uint32_t *value)
+{
+	uint32_t result = 0;
+	unsigned i;
+
+	for (i = 0; i < skb->len && i < SKB_VARINT_MAX; ++i) {
+		uint8_t byte = skb->data[i];
+
+		if (i == SKB_VARINT_MAX - 1 && byte > 0x0f) {
+			return -1;
+		}
+
+		result |= (uint32_t)(byte & 0x7f) << (7 * i);
+		if (!(byte & 0x80)) {
+			skb_pull(skb, i + 1);
+			*value = result;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+unsigned skb_varint_size(uint32_t value)
+{
+	unsigned size = 1;
+
+	while (value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
 void skb_trim_zeros(struct sk_buff *skb)
 {
 	for (unsigned i = skb->len-1; i > 0; --i) {
@@ -25,6 +25,27 @@ int nck_sw_enc_set_option(struct nck_sw_enc *encoder, const char *name, const ch
 		}
 
 		nck_sw_enc_set_redundancy(encoder, redundancy);
+	} else if (!strcmp("adaptive_redundancy", name)) {
+		int32_t min_redundancy = 0, max_redundancy = 0;
+		if (nck_parse_s32_range(&min_redundancy, &max_redundancy, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_adaptive_redundancy(encoder, min_redundancy, max_redundancy);
+	} else if (!strcmp("adaptive_timeout", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_adaptive_timeout(encoder, enable);
+	} else if (!strcmp("congestion_control", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_congestion_control(encoder, enable);
 	} else if (!strcmp("systematic", name)) {
 		uint32_t systematic = 0;
 		if (nck_parse_u32(&systematic, value)) {
@@ -92,6 +113,27 @@ int nck_sw_enc_set_option(struct nck_sw_enc *encoder, const char *name, const ch
 		}
 
 		nck_sw_enc_set_feedback_only_on_repair(encoder, feedback_only_on_repair);
+	} else if (!strcmp("incremental_repair", name)) {
+		uint32_t accumulators = 0;
+		if (nck_parse_u32(&accumulators, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_incremental_repair(encoder, accumulators);
+	} else if (!strcmp("seed_header", name)) {
+		uint32_t seed_header = 0;
+		if (nck_parse_u32(&seed_header, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_seed_header(encoder, seed_header);
+	} else if (!strcmp("histograms", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_enc_set_histograms(encoder, enable);
 	} else {
 		return ENOTSUP;
 	}
@@ -109,6 +151,13 @@ int nck_sw_rec_set_option(struct nck_sw_rec *recoder, const char *name, const ch
 		}
 
 		nck_sw_rec_set_redundancy(recoder, redundancy);
+	} else if (!strcmp("adaptive_redundancy", name)) {
+		int32_t min_redundancy = 0, max_redundancy = 0;
+		if (nck_parse_s32_range(&min_redundancy, &max_redundancy, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_rec_set_adaptive_redundancy(recoder, min_redundancy, max_redundancy);
 	} else if (!strcmp("feedback", name)) {
 		uint32_t enable = 0;
 		if (nck_parse_u32(&enable, value)) {
@@ -130,6 +179,13 @@ int nck_sw_rec_set_option(struct nck_sw_rec *recoder, const char *name, const ch
 		}
 
 		nck_sw_rec_set_forward_code_window(recoder, forward_code_window);
+	} else if (!strcmp("histograms", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_rec_set_histograms(recoder, enable);
 	} else {
 		return ENOTSUP;
 	}
@@ -160,6 +216,34 @@ int nck_sw_dec_set_option(struct nck_sw_dec *decoder, const char *name, const ch
 		}
 
 		nck_sw_dec_set_feedback(decoder, enable);
+	} else if (!strcmp("feedback_interval", name)) {
+		struct timeval interval;
+		if (nck_parse_timeval(&interval, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_dec_set_feedback_interval(decoder, &interval);
+	} else if (!strcmp("feedback_min_packets", name)) {
+		uint32_t packets = 0;
+		if (nck_parse_u32(&packets, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_dec_set_feedback_min_packets(decoder, packets);
+	} else if (!strcmp("feedback_on_gap", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_dec_set_feedback_on_gap(decoder, enable);
+	} else if (!strcmp("histograms", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_sw_dec_set_histograms(decoder, enable);
 	} else {
 		return ENOTSUP;
 	}
@@ -175,15 +259,13 @@ int nck_sw_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 	struct timeval timeout = { 0, 100000 };
 	struct nck_sw_enc *enc;
 
-	value = get_opt(context, "symbols");
-	if (nck_parse_u32(&symbols, value)) {
-		fprintf(stderr, "Invalid symbol count: %s\n", value);
+	if (nck_get_opt_u32(&symbols, context, get_opt, "symbols")) {
+		fprintf(stderr, "Invalid symbol count: %s\n", get_opt(context, "symbols"));
 		return -1;
 	}
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -210,6 +292,21 @@ int nck_sw_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 		nck_sw_enc_set_option(enc, "redundancy", value);
 	}
 
+	value = get_opt(context, "adaptive_redundancy");
+	if (value) {
+		nck_sw_enc_set_option(enc, "adaptive_redundancy", value);
+	}
+
+	value = get_opt(context, "adaptive_timeout");
+	if (value) {
+		nck_sw_enc_set_option(enc, "adaptive_timeout", value);
+	}
+
+	value = get_opt(context, "congestion_control");
+	if (value) {
+		nck_sw_enc_set_option(enc, "congestion_control", value);
+	}
+
 	value = get_opt(context, "systematic");
 	if (value) {
 		nck_sw_enc_set_option(enc, "systematic", value);
@@ -240,6 +337,21 @@ int nck_sw_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 		nck_sw_enc_set_option(enc, "tx_attempts", value);
 	}
 
+	value = get_opt(context, "incremental_repair");
+	if (value) {
+		nck_sw_enc_set_option(enc, "incremental_repair", value);
+	}
+
+	value = get_opt(context, "seed_header");
+	if (value) {
+		nck_sw_enc_set_option(enc, "seed_header", value);
+	}
+
+	value = get_opt(context, "histograms");
+	if (value) {
+		nck_sw_enc_set_option(enc, "histograms", value);
+	}
+
 	nck_sw_enc_api(encoder, enc);
 	return 0;
 }
@@ -257,15 +369,13 @@ int nck_sw_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 
 	UNUSED(timer);
 
-	value = get_opt(context, "symbols");
-	if (nck_parse_u32(&symbols, value)) {
-		fprintf(stderr, "Invalid symbol count: %s\n", value);
+	if (nck_get_opt_u32(&symbols, context, get_opt, "symbols")) {
+		fprintf(stderr, "Invalid symbol count: %s\n", get_opt(context, "symbols"));
 		return -1;
 	}
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
@@ -302,6 +412,25 @@ int nck_sw_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 		nck_sw_dec_set_option(dec, "tx_attempts", value);
 	}
 
+	value = get_opt(context, "feedback_interval");
+	if (value) {
+		assert(timer != NULL);
+		if (nck_sw_dec_set_option(dec, "feedback_interval", value)) {
+			fprintf(stderr, "Invalid feedback_interval: %s\n", value);
+			return -1;
+		}
+	}
+
+	value = get_opt(context, "feedback_min_packets");
+	if (value) {
+		nck_sw_dec_set_option(dec, "feedback_min_packets", value);
+	}
+
+	value = get_opt(context, "feedback_on_gap");
+	if (value) {
+		nck_sw_dec_set_option(dec, "feedback_on_gap", value);
+	}
+
 	value = get_opt(context, "fb_timeout");
 	if (!timer) {
 		assert(value == NULL);
@@ -314,6 +443,11 @@ int nck_sw_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 		nck_sw_dec_set_fb_timeout(dec, &fb_timeout);
 	}
 
+	value = get_opt(context, "histograms");
+	if (value) {
+		nck_sw_dec_set_option(dec, "histograms", value);
+	}
+
 	nck_sw_dec_api(decoder, dec);
 	return 0;
 }
@@ -329,21 +463,18 @@ int nck_sw_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 
 	UNUSED(timer);
 
-	value = get_opt(context, "symbols");
-	if (nck_parse_u32(&symbols, value)) {
-		fprintf(stderr, "Invalid symbol count: %s\n", value);
+	if (nck_get_opt_u32(&symbols, context, get_opt, "symbols")) {
+		fprintf(stderr, "Invalid symbol count: %s\n", get_opt(context, "symbols"));
 		return -1;
 	}
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
-	value = get_opt(context, "timeout");
-	if (nck_parse_timeval(&timeout, value)) {
-		fprintf(stderr, "Invalid timeout: %s\n", value);
+	if (nck_get_opt_timeval(&timeout, context, get_opt, "timeout")) {
+		fprintf(stderr, "Invalid timeout: %s\n", get_opt(context, "timeout"));
 		return -1;
 	}
 
@@ -359,6 +490,11 @@ int nck_sw_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 		nck_sw_rec_set_option(rec, "redundancy", value);
 	}
 
+	value = get_opt(context, "adaptive_redundancy");
+	if (value) {
+		nck_sw_rec_set_option(rec, "adaptive_redundancy", value);
+	}
+
 	value = get_opt(context, "tx_attempts");
 	if (value) {
 		nck_sw_rec_set_option(rec, "tx_attempts", value);
@@ -369,6 +505,11 @@ int nck_sw_create_rec(struct nck_recoder *recoder, struct nck_timer *timer,
 		nck_sw_rec_set_option(rec, "forward_code_window", value);
 	}
 
+	value = get_opt(context, "histograms");
+	if (value) {
+		nck_sw_rec_set_option(rec, "histograms", value);
+	}
+
 	nck_sw_rec_api(recoder, rec);
 	return 0;
 }
@@ -21,6 +21,8 @@
 #include <kodo_sliding_window/header_type.hpp>
 
 #include "../private.h"
+#include "../util/bitmap.h"
+#include "../util/feedback_policy.h"
 #include "packet.h"
 #include "common.h"
 
@@ -31,15 +33,17 @@ typedef factory_t::pointer coder_t;
 typedef kodo_sliding_window::header_type<uint32_t, uint8_t> header_t;
 
 struct nck_sw_dec {
-	nck_sw_dec(coder_t coder, int ord) :
-		coder(coder), source_size(coder->symbol_size()),
+	nck_sw_dec(uint32_t symbols, uint32_t symbol_size, int ord) :
+		factory(fifi::api::field::binary8, symbols, symbol_size),
+		coder(factory.build()), source_size(coder->symbol_size()),
 		coded_size(sizeof(struct sw_coded_packet) + coder->payload_size()),
 		feedback_size(sizeof(struct sw_feedback_packet) + DIV_ROUND_UP(coder->symbols(), 8)),
-		initialized(0), flush(0), order(ord), feedback(1), has_source(0), has_feedback(0), feedback_packet_no(0), feedback_no(0),
+		initialized(0), flush(0), order(ord), feedback(1), has_source(0), has_feedback(0), feedback_packet_no(0), feedback_no(0), feedback_packet_time(), received(0), loss_runs(0),
 		max_feedback_tx_attempts(UINT8_MAX), feedback_tx_attempts(0),
-		timeout(), timeout_handle(), fb_timeout(), fb_timeout_handle(NULL),
+		timeout(), timeout_handle(), fb_timeout(), fb_timeout_handle(NULL), timer(NULL), hist(NULL),
 		on_source_ready(), buffer(coder->block_size()),
-		queue(coder->symbols() * coder->symbol_size()), queue_index(0), queue_length(0)
+		queue(coder->symbols() * coder->symbol_size()), queue_index(0), queue_length(0),
+		missing(BITMAP_WORDS(coder->symbols())), undecoded(BITMAP_WORDS(coder->symbols()))
 	{
 		nck_trigger_init(&on_source_ready);
 		nck_trigger_init(&on_feedback_ready);
@@ -50,6 +54,7 @@ struct nck_sw_dec {
 		memset(&stats, 0, sizeof(stats));
 	}
 
+	factory_t factory;
 	coder_t coder;
 
 	size_t source_size, coded_size, feedback_size;
@@ -67,6 +72,12 @@ struct nck_sw_dec {
 	int has_feedback;
 	uint16_t feedback_packet_no;
 	uint16_t feedback_no;
+	// arrival of feedback_packet_no, to report how long feedback was held back
+	struct timeval feedback_packet_time;
+
+	// reception statistics for the sender's loss estimation
+	uint8_t received;
+	uint8_t loss_runs;
 
 	uint8_t max_feedback_tx_attempts;
 	uint8_t feedback_tx_attempts;
@@ -80,20 +91,39 @@ struct nck_sw_dec {
 	struct timeval fb_timeout;
 	struct nck_timer_entry *fb_timeout_handle;
 
+	/* limits the rate of automatic feedback */
+	struct feedback_policy fb_policy;
+
+	/* optional histograms, with the time each slot entered the window */
+	struct nck_timer *timer;
+	struct nck_histograms *hist;
+	std::vector<struct timeval> hist_arrival;
+
 	struct nck_trigger on_source_ready;
 	struct nck_trigger on_feedback_ready;
 
 	std::vector<uint8_t> buffer;
 
+	// packets with a seed header are rebuilt here
+	std::vector<uint8_t> seed_buffer;
+
 	std::vector<uint8_t> queue;
 	unsigned int queue_index;
 	unsigned int queue_length;
+
+	// slots that are not pivot / not yet decoded, maintained by put_coded
+	// so that get_feedback does not need to query every slot of the coder
+	std::vector<uint64_t> missing;
+	std::vector<uint64_t> undecoded;
 };
 
 char *nck_sw_dec_describe_packet(void *decoder, struct sk_buff *packet);
 struct nck_stats *nck_sw_dec_get_stats(void *decoder);
+struct nck_histograms *nck_sw_dec_get_histograms(void *decoder);
+static int nck_sw_dec_unwrap_coded(void *decoder, struct sk_buff *packet);
 
-NCK_DECODER_IMPL(nck_sw, NULL, nck_sw_dec_describe_packet, nck_sw_dec_get_stats)
+NCK_DECODER_IMPL_EXT(nck_sw, NULL, nck_sw_dec_describe_packet, nck_sw_dec_get_stats,
+		     nck_sw_dec_get_histograms, nck_sw_dec_unwrap_coded)
 
 EXPORT
 void nck_sw_dec_set_sequence(struct nck_sw_dec *decoder, uint32_t sequence)
@@ -165,6 +195,18 @@ static void decoder_fb_timeout(struct nck_timer_entry *entry, void *context, int
 	}
 }
 
+/**
+ * decoder_fb_release - send a feedback that was held back
+ * @context: pointer to decoder context
+ */
+static void decoder_fb_release(void *context)
+{
+	struct nck_sw_dec *decoder = (struct nck_sw_dec *)context;
+
+	decoder->has_feedback = 1;
+	nck_trigger_call(&decoder->on_feedback_ready);
+}
+
 EXPORT
 struct nck_sw_dec *nck_sw_dec(uint32_t symbols, uint32_t symbol_size, struct nck_timer *timer, const struct timeval *timeout, const char *matrix_form)
 {
@@ -179,11 +221,9 @@ struct nck_sw_dec *nck_sw_dec(uint32_t symbols, uint32_t symbol_size, struct nck
 		return NULL;
 	}
 
-	factory_t factory(fifi::api::field::binary8, symbols, symbol_size);
-	coder_t coder = factory.build();
-
-	struct nck_sw_dec *result = new struct nck_sw_dec(coder, ord);
+	struct nck_sw_dec *result = new struct nck_sw_dec(symbols, symbol_size, ord);
 	result->header_size = 4+1;
+	result->timer = timer;
 
 	if (timeout && timerisset(timeout)) {
 		assert(timer != NULL);
@@ -194,6 +234,9 @@ struct nck_sw_dec *nck_sw_dec(uint32_t symbols, uint32_t symbol_size, struct nck
 	if (timer)
 		result->fb_timeout_handle = nck_timer_add(timer, NULL, result, decoder_fb_timeout);
 
+	feedback_policy_init(&result->fb_policy, timer);
+	nck_trigger_set(&result->fb_policy.on_release, result, decoder_fb_release);
+
 	return result;
 }
 
@@ -203,6 +246,40 @@ void nck_sw_dec_set_feedback(struct nck_sw_dec *decoder, uint32_t enable)
 	decoder->feedback = enable;
 }
 
+EXPORT
+void nck_sw_dec_set_feedback_interval(struct nck_sw_dec *decoder, const struct timeval *interval)
+{
+	decoder->fb_policy.min_interval = *interval;
+}
+
+EXPORT
+void nck_sw_dec_set_feedback_min_packets(struct nck_sw_dec *decoder, uint32_t packets)
+{
+	decoder->fb_policy.min_packets = packets;
+}
+
+EXPORT
+void nck_sw_dec_set_feedback_on_gap(struct nck_sw_dec *decoder, int enable)
+{
+	decoder->fb_policy.on_gap = enable;
+}
+
+EXPORT
+void nck_sw_dec_set_histograms(struct nck_sw_dec *decoder, int enable)
+{
+	if (!enable) {
+		free(decoder->hist);
+		decoder->hist = NULL;
+		return;
+	}
+
+	if (decoder->hist)
+		return;
+
+	decoder->hist = (struct nck_histograms *)calloc(1, sizeof(*decoder->hist));
+	decoder->hist_arrival.resize(decoder->coder->symbols());
+}
+
 EXPORT
 void nck_sw_dec_set_tx_attempts(struct nck_sw_dec *decoder, uint8_t tx_attempts)
 {
@@ -222,9 +299,50 @@ void nck_sw_dec_free(struct nck_sw_dec *decoder)
 		nck_timer_free(decoder->fb_timeout_handle);
 	}
 
+	feedback_policy_free(&decoder->fb_policy);
+	free(decoder->hist);
+
 	delete decoder;
 }
 
+EXPORT
+int nck_sw_dec_reset(struct nck_sw_dec *decoder)
+{
+	uint32_t symbols = decoder->coder->symbols();
+
+	nck_timer_cancel(decoder->timeout_handle);
+	nck_timer_cancel(decoder->fb_timeout_handle);
+	feedback_policy_reset(&decoder->fb_policy);
+
+	/* kodo has no way to empty a sliding window decoder, we build a fresh
+	 * one from the factory of the decoder that decodes into the same buffer
+	 */
+	decoder->coder = decoder->factory.build();
+	decoder->coder->set_mutable_symbols(storage::storage(decoder->buffer));
+	rbufmgr_init(&decoder->rbufmgr, symbols, 1);
+
+	decoder->initialized = 0;
+	decoder->flush = 0;
+	decoder->has_source = 0;
+	decoder->has_feedback = 0;
+	decoder->feedback_packet_no = 0;
+	decoder->feedback_no = 0;
+	timerclear(&decoder->feedback_packet_time);
+	decoder->received = 0;
+	decoder->loss_runs = 0;
+	decoder->feedback_tx_attempts = 0;
+	decoder->queue_index = 0;
+	decoder->queue_length = 0;
+
+	decoder->missing.assign(decoder->missing.size(), 0);
+	decoder->undecoded.assign(decoder->undecoded.size(), 0);
+
+	memset(&decoder->stats, 0, sizeof(decoder->stats));
+	if (decoder->hist)
+		memset(decoder->hist, 0, sizeof(*decoder->hist));
+	return 0;
+}
+
 EXPORT
 int nck_sw_dec_has_source(struct nck_sw_dec *decoder)
 {
@@ -238,16 +356,17 @@ int nck_sw_dec_complete(struct nck_sw_dec *decoder)
 	return rbufmgr_empty(&decoder->rbufmgr);
 }
 
-static void move_to_next_source(struct nck_sw_dec *decoder)
+static uint32_t move_to_next_source(struct nck_sw_dec *decoder)
 {
 	auto coder = decoder->coder;
+	uint32_t skipped = 0;
 
 	//  1. `index` is the next symbol that will be output
 	//  2. `sequence` points just after the last known symbol
 	//  3. `flush` marks the point up until we must get the packets out
 	if (rbufmgr_empty(&decoder->rbufmgr)) {
 		assert(!decoder->has_source);
-		return;
+		return 0;
 	}
 
 	// we move the `index` further until:
@@ -273,12 +392,15 @@ static void move_to_next_source(struct nck_sw_dec *decoder)
 
 			/* consume undecodable */
 			rbufmgr_read(&decoder->rbufmgr);
+			skipped += 1;
 		}
 	}
 
 
 	if (rbufmgr_empty(&decoder->rbufmgr))
 		decoder->has_source = 0;
+
+	return skipped;
 }
 
 EXPORT
@@ -295,7 +417,9 @@ void nck_sw_dec_flush_source(struct nck_sw_dec *decoder)
 	// we move the flush pointer to the end
 	decoder->flush = sequence;
 	if (!decoder->has_source) {
-		move_to_next_source(decoder);
+		uint32_t skipped = move_to_next_source(decoder);
+		if (decoder->hist)
+			nck_histogram_record(&decoder->hist->h[NCK_HISTOGRAM_FLUSH_DEFICIT], skipped);
 	}
 
 	if (_has_source(decoder)) {
@@ -452,14 +576,102 @@ static bool nck_sw_feedback_required(struct nck_sw_dec *decoder, uint32_t rank,
 	return false;
 }
 
-EXPORT
-int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
+/**
+ * nck_sw_dec_mark_new_symbols - add symbols entering the window to the bitmaps
+ * @decoder: decoder structure that will be used
+ * @from: coder sequence number before the packet was inserted
+ * @to: coder sequence number after the packet was inserted
+ *
+ * Slots of new sequence numbers are reused, so they start out missing and
+ * undecoded until nck_sw_dec_update_missing() finds them otherwise.
+ */
+static void nck_sw_dec_mark_new_symbols(struct nck_sw_dec *decoder, uint32_t from, uint32_t to)
+{
+	uint32_t symbols = decoder->coder->symbols();
+	uint32_t count = min_t(uint32_t, to - from, symbols);
+
+	for (uint32_t seqno = to - count; seqno != to; ++seqno) {
+		bitmap_set(decoder->missing.data(), seqno % symbols);
+		bitmap_set(decoder->undecoded.data(), seqno % symbols);
+	}
+}
+
+/**
+ * nck_sw_dec_hist_arrival - remember when symbols entered the window
+ * @decoder: decoder structure that will be used
+ * @from: coder sequence number before the packet was inserted
+ * @to: coder sequence number after the packet was inserted
+ */
+static void nck_sw_dec_hist_arrival(struct nck_sw_dec *decoder, uint32_t from, uint32_t to)
+{
+	uint32_t symbols = decoder->coder->symbols();
+	uint32_t count = min_t(uint32_t, to - from, symbols);
+	struct timeval now;
+
+	nck_timer_gettime(decoder->timer, &now);
+	for (uint32_t seqno = to - count; seqno != to; ++seqno) {
+		decoder->hist_arrival[seqno % symbols] = now;
+	}
+}
+
+/**
+ * nck_sw_dec_update_missing - clear the bits of symbols that became available
+ * @decoder: decoder structure that will be used
+ *
+ * Only slots that are still marked are checked, so the cost follows the
+ * number of missing symbols rather than the window size.
+ */
+static void nck_sw_dec_update_missing(struct nck_sw_dec *decoder)
+{
+	auto coder = decoder->coder;
+
+	for (uint32_t word = 0; word < decoder->missing.size(); ++word) {
+		for (uint64_t bits = decoder->missing[word]; bits; bits = bitmap_drop_first(bits)) {
+			uint32_t index = word * 64 + bitmap_first(bits);
+			if (coder->is_symbol_pivot(index))
+				bitmap_clear(decoder->missing.data(), index);
+		}
+		for (uint64_t bits = decoder->undecoded[word]; bits; bits = bitmap_drop_first(bits)) {
+			uint32_t index = word * 64 + bitmap_first(bits);
+			if (coder->is_symbol_uncoded(index) || coder->check_symbol_status(index))
+				bitmap_clear(decoder->undecoded.data(), index);
+		}
+	}
+}
+
+/**
+ * nck_sw_dec_reset_missing - recompute the bitmaps for every slot
+ * @decoder: decoder structure that will be used
+ */
+static void nck_sw_dec_reset_missing(struct nck_sw_dec *decoder)
+{
+	uint32_t symbols = decoder->coder->symbols();
+
+	for (uint32_t index = 0; index < symbols; ++index) {
+		bitmap_set(decoder->missing.data(), index);
+		bitmap_set(decoder->undecoded.data(), index);
+	}
+	nck_sw_dec_update_missing(decoder);
+}
+
+/**
+ * nck_sw_dec_read_coded - give a coded packet to the decoder
+ * @decoder: decoder structure that will be used
+ * @packet: coded packet, the data points to the kodo header afterwards
+ * @unwrap: the packet is the next source symbol and is handed out in place
+ *
+ * Return: 0 on success, -1 if the packet is malformed
+ */
+static int nck_sw_dec_read_coded(struct nck_sw_dec *decoder, struct sk_buff *packet, bool unwrap)
 {
 	struct sw_coded_packet *sw_coded_packet;
+	struct sk_buff expanded;
 	auto coder = decoder->coder;
 	uint32_t symbols = coder->symbols();
 	uint32_t pos;
 	int read_payload_retcode;
+	enum feedback_reason reason = FEEDBACK_REASON_NORMAL;
+	bool send_feedback;
 
 	if (!pskb_may_pull(packet, sizeof(*sw_coded_packet)))
 		return -1;
@@ -470,6 +682,15 @@ int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
 	if (sw_coded_packet->packet_type != SW_PACKET_TYPE_CODED)
 		return -1;
 
+	/* rebuild the kodo header if the coefficients were sent as a seed */
+	if (sw_coded_packet->flags & SW_CODED_PACKET_SEED) {
+		decoder->seed_buffer.resize(coder->payload_size());
+		if (nck_sw_common_expand_seed(packet, &expanded, decoder->seed_buffer.data(),
+					      decoder->seed_buffer.size(), symbols))
+			return -1;
+		packet = &expanded;
+	}
+
 	/* should hold a least the sequence number + systematic flag */
 	if (!pskb_may_pull(packet, decoder->header_size))
 		return -1;
@@ -479,6 +700,14 @@ int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
 	header_t header;
 	decoder->coder->read_header(packet->data, header);
 
+	if (decoder->initialized &&
+	    (int16_t)(ntohs(sw_coded_packet->packet_no) - decoder->feedback_packet_no) > 1) {
+		// at least one packet was lost since the previous one
+		decoder->loss_runs++;
+		reason = FEEDBACK_REASON_GAP;
+	}
+	decoder->received++;
+
 	if (!decoder->initialized) {
 		// initialize decoder
 		nck_sw_dec_set_sequence(decoder, header.sequence);
@@ -509,18 +738,59 @@ int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
 		decoder->stats.s[NCK_STATS_PUT_CODED_CONFLICT]++;
 		break;
 	}
+
+	if (read_payload_retcode == READ_PAYLOAD_CONFLICT) {
+		// we do not know which slots the coder dropped
+		nck_sw_dec_reset_missing(decoder);
+	} else if (read_payload_retcode == READ_PAYLOAD_INNOVATIVE || coder->sequence_number() != sequence) {
+		if (coder->sequence_compare(coder->sequence_number(), sequence) > 0)
+			nck_sw_dec_mark_new_symbols(decoder, sequence, coder->sequence_number());
+		nck_sw_dec_update_missing(decoder);
+	}
+
+	if (decoder->hist && decoder->timer &&
+	    coder->sequence_compare(coder->sequence_number(), sequence) > 0)
+		nck_sw_dec_hist_arrival(decoder, sequence, coder->sequence_number());
+
 	rbufmgr_insert(&decoder->rbufmgr, header.sequence);
 
 	decoder->feedback_packet_no = ntohs(sw_coded_packet->packet_no);
+	if (decoder->timer)
+		nck_timer_gettime(decoder->timer, &decoder->feedback_packet_time);
+	if (sw_coded_packet->flags & SW_CODED_PACKET_FLUSH)
+		reason = FEEDBACK_REASON_FLUSH;
+
+	// a feedback that was held back may be due now
+	send_feedback = feedback_policy_packet(&decoder->fb_policy);
 	if ((sw_coded_packet->flags & SW_CODED_PACKET_FEEDBACK_REQUESTED) ||
 	    (sw_coded_packet->flags & SW_CODED_PACKET_FLUSH) ||
 	    nck_sw_feedback_required(decoder, rank, sequence)) {
-		// feedback requested
+		// feedback requested, the policy may hold it back
+		if (feedback_policy_request(&decoder->fb_policy, reason))
+			send_feedback = true;
+	}
+
+	if (send_feedback) {
 		decoder->has_feedback = 1;
 		nck_trigger_call(&decoder->on_feedback_ready);
 	}
 
-	if (rbufmgr_empty(&decoder->rbufmgr)) {
+	if (unwrap) {
+		// account for the symbol as if it was retrieved with get_source
+		assert(rbufmgr_read_seqno(&decoder->rbufmgr) == header.sequence);
+		if (decoder->flush == header.sequence)
+			decoder->flush += 1;
+
+		pos = rbufmgr_read(&decoder->rbufmgr);
+		decoder->stats.s[NCK_STATS_GET_SOURCE]++;
+
+		if (decoder->hist && decoder->timer) {
+			struct timeval now;
+			nck_timer_gettime(decoder->timer, &now);
+			nck_histogram_record_delay(&decoder->hist->h[NCK_HISTOGRAM_DECODE_DELAY],
+						   &decoder->hist_arrival[pos], &now);
+		}
+	} else if (rbufmgr_empty(&decoder->rbufmgr)) {
 		assert(!decoder->has_source);
 	} else {
 		pos = rbufmgr_peek(&decoder->rbufmgr);
@@ -556,6 +826,58 @@ int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
 	return 0;
 }
 
+EXPORT
+int nck_sw_dec_put_coded(struct nck_sw_dec *decoder, struct sk_buff *packet)
+{
+	return nck_sw_dec_read_coded(decoder, packet, false);
+}
+
+/**
+ * nck_sw_dec_unwrap_coded - hand out a systematic packet in place
+ * @dec: decoder structure that will be used
+ * @packet: coded packet that becomes the source packet
+ *
+ * A systematic packet with the symbol that the consumer waits for already
+ * holds the source symbol behind the kodo header. The coder still reads it
+ * for the repair packets that follow, but the symbol is not copied out of
+ * the coder again and does not wait in the ring buffer for get_source.
+ *
+ * Return: 0 if the packet was unwrapped, -1 if nck_sw_dec_put_coded() must
+ *  be used
+ */
+static int nck_sw_dec_unwrap_coded(void *dec, struct sk_buff *packet)
+{
+	struct nck_sw_dec *decoder = (struct nck_sw_dec *)dec;
+	struct sw_coded_packet *sw_coded_packet;
+	uint32_t symbol_size = decoder->coder->symbol_size();
+	header_t header;
+
+	// earlier symbols must be delivered first
+	if (!decoder->initialized || nck_sw_dec_has_source(decoder) ||
+	    !rbufmgr_empty(&decoder->rbufmgr))
+		return -1;
+
+	if (!pskb_may_pull(packet, sizeof(*sw_coded_packet) + decoder->header_size))
+		return -1;
+
+	sw_coded_packet = (struct sw_coded_packet *)packet->data;
+	if (sw_coded_packet->packet_type != SW_PACKET_TYPE_CODED ||
+	    (sw_coded_packet->flags & SW_CODED_PACKET_SEED))
+		return -1;
+
+	decoder->coder->read_header(packet->data + sizeof(*sw_coded_packet), header);
+	if (!header.systematic_flag || header.sequence != decoder->rbufmgr.write_seqno + 1)
+		return -1;
+
+	if (nck_sw_dec_read_coded(decoder, packet, true))
+		return -1;
+
+	// the padded payload is the kodo header followed by the symbol
+	skb_pull(packet, decoder->header_size);
+	skb_trim(packet, packet->len - symbol_size);
+	return 0;
+}
+
 EXPORT
 int nck_sw_dec_get_source(struct nck_sw_dec *decoder, struct sk_buff *packet)
 {
@@ -578,6 +900,13 @@ int nck_sw_dec_get_source(struct nck_sw_dec *decoder, struct sk_buff *packet)
 		symbol = &decoder->buffer[pos * symbol_size];
 		decoder->has_source = 0;
 
+		if (decoder->hist && decoder->timer) {
+			struct timeval now;
+			nck_timer_gettime(decoder->timer, &now);
+			nck_histogram_record_delay(&decoder->hist->h[NCK_HISTOGRAM_DECODE_DELAY],
+						   &decoder->hist_arrival[pos], &now);
+		}
+
 		move_to_next_source(decoder);
 	}
 
@@ -603,13 +932,45 @@ struct nck_stats *nck_sw_dec_get_stats(void *dec)
 	return &decoder->stats;
 }
 
+EXPORT
+struct nck_histograms *nck_sw_dec_get_histograms(void *dec)
+{
+	struct nck_sw_dec *decoder = (struct nck_sw_dec*)dec;
+
+	return decoder->hist;
+}
+
+/**
+ * nck_sw_dec_feedback_delay - time since the echoed packet arrived
+ * @decoder: decoder structure that will be used
+ *
+ * Return: the delay in microseconds, 0 without a timer
+ */
+static uint32_t nck_sw_dec_feedback_delay(struct nck_sw_dec *decoder)
+{
+	struct timeval now, delay;
+
+	if (!decoder->timer || !timerisset(&decoder->feedback_packet_time))
+		return 0;
+
+	nck_timer_gettime(decoder->timer, &now);
+	if (!timercmp(&now, &decoder->feedback_packet_time, >))
+		return 0;
+
+	timersub(&now, &decoder->feedback_packet_time, &delay);
+	if (delay.tv_sec >= UINT32_MAX / 1000000)
+		return UINT32_MAX;
+
+	return delay.tv_sec * 1000000 + delay.tv_usec;
+}
+
 EXPORT
 int nck_sw_dec_get_feedback(struct nck_sw_dec *decoder, struct sk_buff *packet)
 {
 	struct sw_feedback_packet *sw_feedback_packet;
 	auto coder = decoder->coder;
-	int bytes, index, symbols = decoder->coder->symbols();
-	uint32_t seqno;
+	int bytes, symbols = decoder->coder->symbols();
+	uint32_t seqno, remaining, span;
 	uint32_t first_missing;
 
 	decoder->stats.s[NCK_STATS_GET_FEEDBACK]++;
@@ -634,16 +995,21 @@ int nck_sw_dec_get_feedback(struct nck_sw_dec *decoder, struct sk_buff *packet)
 	first_missing = coder->sequence_number();
 	assert(((uint32_t) coder->sequence_number() - rbufmgr_read_seqno(&decoder->rbufmgr)) <= (uint32_t)symbols);
 
-	for (seqno = rbufmgr_read_seqno(&decoder->rbufmgr); seqno != coder->sequence_number(); seqno++) {
-		index = seqno % symbols;
-		if (!decoder->coder->is_symbol_pivot(index)) {
-			packet->data[index/8] |= 1<<(index%8);
-		}
+	seqno = rbufmgr_read_seqno(&decoder->rbufmgr);
+	remaining = coder->sequence_number() - seqno;
+	for (; remaining > 0; seqno += span, remaining -= span) {
+		uint32_t index = seqno % symbols;
+		uint32_t word = index / 64;
+		uint32_t offset = index % 64;
+		span = min_t(uint32_t, min_t(uint32_t, 64 - offset, symbols - index), remaining);
+
+		uint64_t range = bitmap_range(offset, offset + span);
+		bitmap_store(payload, bytes, word, decoder->missing[word] & range);
+
 		if (first_missing == coder->sequence_number()) {
-			// if we have not yet found a missing symbol we might want to check
-			if (!coder->is_symbol_uncoded(index) && !coder->check_symbol_status(index)) {
-				first_missing = seqno;
-			}
+			uint64_t undecoded = decoder->undecoded[word] & range;
+			if (undecoded)
+				first_missing = seqno + bitmap_first(undecoded) - offset;
 		}
 	}
 
@@ -659,10 +1025,14 @@ int nck_sw_dec_get_feedback(struct nck_sw_dec *decoder, struct sk_buff *packet)
 	sw_feedback_packet->packet_no = htons(decoder->feedback_packet_no);
 	sw_feedback_packet->sequence = htonl(decoder->coder->sequence_number());
 	sw_feedback_packet->feedback_no = htons(decoder->feedback_no++);
+	sw_feedback_packet->received = decoder->received;
+	sw_feedback_packet->loss_runs = decoder->loss_runs;
 	sw_feedback_packet->first_missing = htonl(first_missing);
+	sw_feedback_packet->delay = htonl(nck_sw_dec_feedback_delay(decoder));
 
 	// stop sending feedback
 	decoder->has_feedback = 0;
+	feedback_policy_sent(&decoder->fb_policy);
 
 	if (timerisset(&decoder->fb_timeout)) {
 		if (!_complete(decoder))
@@ -33,29 +33,55 @@ struct sw_coded_packet {
 /**
  * sw_coded_packet_flags - flags sent by the encoder
  * @SW_CODED_PACKET_FEEDBACK_REQUESTED: requests a feedback from the decoder
+ * @SW_CODED_PACKET_SEED: the coefficients are given by a struct sw_seed_header
+ *    instead of the kodo header
  */
 enum sw_coded_packet_flags {
 	SW_CODED_PACKET_FEEDBACK_REQUESTED = 0x01,
 	SW_CODED_PACKET_FLUSH = 0x02,
+	SW_CODED_PACKET_SEED = 0x04,
 };
 
+/**
+ * sw_seed_header - compact header of a coded packet with SW_CODED_PACKET_SEED
+ * @seqno: sequence number of the encoder, as in the kodo header
+ * @seed: seed of the coefficients, see nck_sw_common_seed_coefficients()
+ * @first: window slot of the first symbol in the linear combination
+ * @count: number of consecutive window slots in the linear combination
+ *
+ * The coded symbol follows the header. Slots outside of the range have a
+ * zero coefficient.
+ */
+struct sw_seed_header {
+	uint32_t seqno;
+	uint32_t seed;
+	uint16_t first;
+	uint16_t count;
+} __packed;
+
 /**
  * sw_feedback_packet - sliding window feedback packet
  * @packet_type: should be set to SW_PACKET_TYPE_FEEDBACK
  * @order: window size is 2^order
  * @packet_no: number of the last received packet_no
  * @feedback_no: incremental number of the feedback
- * @reserved: currently unused fields
+ * @received: number of coded packets received by the decoder, modulo 256
+ * @loss_runs: number of gaps in the received packet_no sequence, modulo 256
  * @sequence: latest sequence number of the decoder
  * @first_missing: sequence number of the first missing packet
+ * @delay: microseconds between the arrival of @packet_no and sending the
+ *    feedback, saturates at UINT32_MAX. The encoder subtracts it from its
+ *    round trip time samples.
  */
 struct sw_feedback_packet {
 	uint8_t packet_type;
 	uint8_t order;
 	uint16_t packet_no;
 	uint16_t feedback_no;
-	uint16_t reserved;
+	uint8_t received;
+	uint8_t loss_runs;
 	uint32_t sequence;
 	uint32_t first_missing;
+	uint32_t delay;
 } __packed;
 
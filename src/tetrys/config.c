@@ -31,6 +31,13 @@ int nck_tetrys_enc_set_option(struct nck_tetrys_enc *encoder, const char *name,
 		}
 
 		nck_tetrys_enc_set_coded_phase(encoder, coded);
+	} else if (!strcmp("adaptive_redundancy", name)) {
+		int32_t min_redundancy = 0, max_redundancy = 0;
+		if (nck_parse_s32_range(&min_redundancy, &max_redundancy, value)) {
+			return EINVAL;
+		}
+
+		nck_tetrys_enc_set_adaptive_redundancy(encoder, min_redundancy, max_redundancy);
 	} else {
 		return ENOTSUP;
 	}
@@ -41,9 +48,31 @@ int nck_tetrys_enc_set_option(struct nck_tetrys_enc *encoder, const char *name,
 EXPORT
 int nck_tetrys_dec_set_option(struct nck_tetrys_dec *decoder, const char *name, const char *value)
 {
-	UNUSED(decoder);
-	UNUSED(name);
-	UNUSED(value);
+	if (!strcmp("feedback_interval", name)) {
+		struct timeval interval;
+		if (nck_parse_timeval(&interval, value)) {
+			return EINVAL;
+		}
+
+		nck_tetrys_dec_set_feedback_interval(decoder, &interval);
+	} else if (!strcmp("feedback_min_packets", name)) {
+		uint32_t packets = 0;
+		if (nck_parse_u32(&packets, value)) {
+			return EINVAL;
+		}
+
+		nck_tetrys_dec_set_feedback_min_packets(decoder, packets);
+	} else if (!strcmp("feedback_on_gap", name)) {
+		uint32_t enable = 0;
+		if (nck_parse_u32(&enable, value)) {
+			return EINVAL;
+		}
+
+		nck_tetrys_dec_set_feedback_on_gap(decoder, enable);
+	} else {
+		return ENOTSUP;
+	}
+
 	return 0;
 }
 
@@ -55,15 +84,13 @@ int nck_tetrys_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 	struct timeval timeout = { 0, 100000 };
 	struct nck_tetrys_enc *enc;
 
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
-	value = get_opt(context, "window_size");
-	if (nck_parse_u32(&window_size, value)) {
-		fprintf(stderr, "Invalid window: %s\n", value);
+	if (nck_get_opt_u32(&window_size, context, get_opt, "window_size")) {
+		fprintf(stderr, "Invalid window: %s\n", get_opt(context, "window_size"));
 		return -1;
 	}
 
@@ -90,6 +117,11 @@ int nck_tetrys_create_enc(struct nck_encoder *encoder, struct nck_timer *timer,
 		nck_tetrys_enc_set_option(enc, "coded", value);
 	}
 
+	value = get_opt(context, "adaptive_redundancy");
+	if (value) {
+		nck_tetrys_enc_set_option(enc, "adaptive_redundancy", value);
+	}
+
 	nck_tetrys_enc_api(encoder, enc);
 
 	return 0;
@@ -100,21 +132,39 @@ int nck_tetrys_create_dec(struct nck_decoder *decoder, struct nck_timer *timer,
 {
 	const char *value;
 	uint32_t symbol_size = 1500, window_size = 16;
+	struct nck_tetrys_dec *dec;
 
-	UNUSED(timer);
-
-	value = get_opt(context, "symbol_size");
-	if (nck_parse_u32(&symbol_size, value)) {
-		fprintf(stderr, "Invalid symbol_size: %s\n", value);
+	if (nck_get_opt_u32(&symbol_size, context, get_opt, "symbol_size")) {
+		fprintf(stderr, "Invalid symbol_size: %s\n", get_opt(context, "symbol_size"));
 		return -1;
 	}
 
-	value = get_opt(context, "window_size");
-	if (nck_parse_u32(&window_size, value)) {
-		fprintf(stderr, "Invalid window_size: %s\n", value);
+	if (nck_get_opt_u32(&window_size, context, get_opt, "window_size")) {
+		fprintf(stderr, "Invalid window_size: %s\n", get_opt(context, "window_size"));
 		return -1;
 	}
 
-	nck_tetrys_dec_api(decoder, nck_tetrys_dec(symbol_size, window_size));
+	dec = nck_tetrys_dec(symbol_size, window_size, timer);
+
+	value = get_opt(context, "feedback_interval");
+	if (value) {
+		assert(timer != NULL);
+		if (nck_tetrys_dec_set_option(dec, "feedback_interval", value)) {
+			fprintf(stderr, "Invalid feedback_interval: %s\n", value);
+			return -1;
+		}
+	}
+
+	value = get_opt(context, "feedback_min_packets");
+	if (value) {
+		nck_tetrys_dec_set_option(dec, "feedback_min_packets", value);
+	}
+
+	value = get_opt(context, "feedback_on_gap");
+	if (value) {
+		nck_tetrys_dec_set_option(dec, "feedback_on_gap", value);
+	}
+
+	nck_tetrys_dec_api(decoder, dec);
 	return 0;
 }
@@ -11,11 +11,13 @@
 #include <nckernel/tetrys.h>
 #include <nckernel/api.h>
 #include <nckernel/skb.h>
+#include <nckernel/timer.h>
 #include <nckernel/trace.h>
 
 #include <list.h>
 
 #include "../private.h"
+#include "../util/feedback_policy.h"
 #include "../util/finite_field.h"
 
 #define for_each_symbol(s, l) list_for_each_entry((s), (l), list)
@@ -51,6 +53,7 @@ struct nck_tetrys_dec {
 	struct nck_trigger on_feedback_ready;
 
 	int has_feedback;
+	struct feedback_policy fb_policy;
 
 	struct list_head symbols;
 	struct symbol *next;
@@ -62,8 +65,16 @@ struct nck_tetrys_dec {
 
 NCK_DECODER_IMPL(nck_tetrys, NULL, NULL, NULL)
 
+static void decoder_fb_release(void *context)
+{
+	struct nck_tetrys_dec *decoder = (struct nck_tetrys_dec *)context;
+
+	decoder->has_feedback = 1;
+	nck_trigger_call(&decoder->on_feedback_ready);
+}
+
 EXPORT
-struct nck_tetrys_dec *nck_tetrys_dec(size_t symbol_size, int window_size)
+struct nck_tetrys_dec *nck_tetrys_dec(size_t symbol_size, int window_size, struct nck_timer *timer)
 {
 	struct nck_tetrys_dec *result;
 
@@ -83,9 +94,30 @@ struct nck_tetrys_dec *nck_tetrys_dec(size_t symbol_size, int window_size)
 	result->next = NULL;
 	result->next_id = 0;
 
+	feedback_policy_init(&result->fb_policy, timer);
+	nck_trigger_set(&result->fb_policy.on_release, result, decoder_fb_release);
+
 	return result;
 }
 
+EXPORT
+void nck_tetrys_dec_set_feedback_interval(struct nck_tetrys_dec *decoder, const struct timeval *interval)
+{
+	decoder->fb_policy.min_interval = *interval;
+}
+
+EXPORT
+void nck_tetrys_dec_set_feedback_min_packets(struct nck_tetrys_dec *decoder, uint32_t packets)
+{
+	decoder->fb_policy.min_packets = packets;
+}
+
+EXPORT
+void nck_tetrys_dec_set_feedback_on_gap(struct nck_tetrys_dec *decoder, int enable)
+{
+	decoder->fb_policy.on_gap = enable;
+}
+
 static void add_coded(struct nck_tetrys_dec *decoder, struct symbol *symbol);
 
 static void print_symbol(FILE *file, struct symbol *s, size_t length)
@@ -124,9 +156,30 @@ void nck_tetrys_dec_free(struct nck_tetrys_dec *decoder)
 		list_del(&s->list);
 		symbol_free(s);
 	}
+	feedback_policy_free(&decoder->fb_policy);
 	free(decoder);
 }
 
+EXPORT
+int nck_tetrys_dec_reset(struct nck_tetrys_dec *decoder)
+{
+	struct symbol *s;
+	while (!list_empty(&decoder->symbols)) {
+		s = first_symbol(&decoder->symbols);
+		list_del(&s->list);
+		symbol_free(s);
+	}
+	feedback_policy_reset(&decoder->fb_policy);
+
+	decoder->has_feedback = 0;
+	decoder->next = NULL;
+	decoder->next_id = 0;
+	decoder->oldest_id = 0;
+	decoder->newest_id = 0;
+
+	return 0;
+}
+
 EXPORT
 int nck_tetrys_dec_has_source(struct nck_tetrys_dec *decoder)
 {
@@ -512,6 +565,8 @@ int nck_tetrys_dec_put_coded(struct nck_tetrys_dec *decoder, struct sk_buff *pac
 	uint8_t type;
 	uint32_t id;
 	uint32_t count;
+	enum feedback_reason reason = FEEDBACK_REASON_NORMAL;
+	bool send_feedback;
 
 	type = skb_pull_u8(packet);
 	id = skb_pull_u32(packet);
@@ -529,6 +584,9 @@ int nck_tetrys_dec_put_coded(struct nck_tetrys_dec *decoder, struct sk_buff *pac
 		INIT_LIST_HEAD(&symbol->coefficients.list);
 
 		if (id > decoder->newest_id) {
+			// source packets are sent in order, a skipped id was lost
+			if (id - decoder->newest_id > 1)
+				reason = FEEDBACK_REASON_GAP;
 			decoder->newest_id = id;
 		}
 
@@ -572,8 +630,15 @@ int nck_tetrys_dec_put_coded(struct nck_tetrys_dec *decoder, struct sk_buff *pac
 		return -1;
 	}
 
-	decoder->has_feedback = 1;
-	nck_trigger_call(&decoder->on_feedback_ready);
+	// a feedback that was held back may be due now
+	send_feedback = feedback_policy_packet(&decoder->fb_policy);
+	if (feedback_policy_request(&decoder->fb_policy, reason))
+		send_feedback = true;
+
+	if (send_feedback) {
+		decoder->has_feedback = 1;
+		nck_trigger_call(&decoder->on_feedback_ready);
+	}
 
 	if (_has_source(decoder)) {
 		nck_trigger_call(&decoder->on_source_ready);
@@ -625,19 +690,18 @@ EXPORT
 int nck_tetrys_dec_get_feedback(struct nck_tetrys_dec *decoder, struct sk_buff *packet)
 {
 	struct symbol *symbol;
-	uint32_t missing;
+	uint32_t missing = decoder->next_id;
 
 	assert(decoder->has_feedback);
 	if (!decoder->has_feedback) {
 		return -1;
 	}
 	decoder->has_feedback = 0;
+	feedback_policy_sent(&decoder->fb_policy);
 
 	skb_reserve(packet, 5);
 
 	if (!list_empty(&decoder->symbols)) {
-		missing = decoder->next_id;
-
 		for_each_symbol(symbol, &decoder->symbols) {
 			if ((int)(symbol->coefficients.id - decoder->next_id) < 0) {
 				// we report nothing before decoder->next_id
@@ -12,19 +12,15 @@
 #include <nckernel/timer.h>
 #include <nckernel/trace.h>
 
-#include <list.h>
-
 #include "../private.h"
 #include "../util/rate.h"
 #include "../util/finite_field.h"
 
-struct source_symbol
+struct window_slot
 {
-	struct list_head list;
-
-	uint32_t id;
 	size_t len;
-	uint8_t data[];
+	int present;
+	int sent;
 };
 
 struct nck_tetrys_enc {
@@ -38,17 +34,85 @@ struct nck_tetrys_enc {
 	int max_window_size;
 	int window_size;
 
-	struct list_head window;
-	struct source_symbol *next;
+	/* The window is a ring of ring_size slots, each slot holding
+	 * source_size bytes. A source symbol with a given id is stored in
+	 * slot id % ring_size. The window covers the ids from window_start
+	 * to source_id, acknowledged symbols are marked as not present.
+	 * The ring is larger than the window so that symbols that are still
+	 * missing at the decoder survive while newer ones get acknowledged. */
+	uint32_t ring_size;
+	struct window_slot *slots;
+	uint8_t *storage;
+	uint32_t window_start;
+	uint32_t next_id;
 
 	uint32_t coded_id;
 	uint32_t source_id;
 
+	/* first id that was not evaluated for the adaptive redundancy yet */
+	uint32_t fb_next;
+
 	struct timeval timeout;
 	struct nck_timer_entry *timeout_handle;
 };
 
-NCK_ENCODER_IMPL(nck_tetrys, NULL, NULL, NULL)
+static int tetrys_wrap_source(void *enc, struct sk_buff *packet);
+
+NCK_ENCODER_IMPL_INPLACE(nck_tetrys, NULL, NULL, NULL, tetrys_wrap_source)
+
+static inline struct window_slot *window_slot(struct nck_tetrys_enc *encoder, uint32_t id)
+{
+	return &encoder->slots[id % encoder->ring_size];
+}
+
+static inline uint8_t *window_data(struct nck_tetrys_enc *encoder, uint32_t id)
+{
+	return &encoder->storage[(id % encoder->ring_size) * encoder->source_size];
+}
+
+/* number of source symbols that still wait for their systematic packet */
+static inline int window_unsent(struct nck_tetrys_enc *encoder)
+{
+	return encoder->source_id - encoder->next_id;
+}
+
+static void window_remove(struct nck_tetrys_enc *encoder, uint32_t id)
+{
+	struct window_slot *slot = window_slot(encoder, id);
+
+	if (slot->present) {
+		slot->present = 0;
+		--encoder->window_size;
+	}
+}
+
+/* Advance the window start and the next systematic symbol past all slots
+ * that do not hold a symbol anymore. */
+static void window_trim(struct nck_tetrys_enc *encoder)
+{
+	uint32_t skipped = encoder->next_id;
+
+	while (encoder->window_start != encoder->source_id &&
+	       !window_slot(encoder, encoder->window_start)->present) {
+		++encoder->window_start;
+	}
+
+	if ((int32_t)(encoder->next_id - encoder->window_start) < 0) {
+		encoder->next_id = encoder->window_start;
+	}
+
+	while (encoder->next_id != encoder->source_id &&
+	       !window_slot(encoder, encoder->next_id)->present) {
+		++encoder->next_id;
+	}
+
+	// symbols that are dropped before they were sent take their credit
+	// along, the dual phases only count the packets that are sent
+	if (encoder->rc.algo != RATE_CONTROL_DUAL) {
+		for (skipped = encoder->next_id - skipped; skipped > 0; --skipped)
+			rate_control_step(&encoder->rc, 1);
+	}
+}
 
 static void encoder_timeout_flush(struct nck_timer_entry *entry, void *context, int success)
 {
@@ -75,8 +139,11 @@ struct nck_tetrys_enc *nck_tetrys_enc(size_t symbol_size, int window_size, struc
 
 	result->max_window_size = window_size;
 	result->window_size = 0;
-	INIT_LIST_HEAD(&result->window);
-	result->next = NULL;
+	result->ring_size = 2*window_size;
+	result->slots = calloc(result->ring_size, sizeof(*result->slots));
+	result->storage = malloc(result->ring_size * symbol_size);
+	result->window_start = 0;
+	result->next_id = 0;
 
 	result->coded_id = 0;
 
@@ -93,42 +160,94 @@ struct nck_tetrys_enc *nck_tetrys_enc(size_t symbol_size, int window_size, struc
 	return result;
 }
 
+/* Switch back to the default dual phases, which is only possible before
+ * the first source symbol. */
+static int encoder_dual_phases(struct nck_tetrys_enc *encoder)
+{
+	if (encoder->rc.algo == RATE_CONTROL_DUAL)
+		return 0;
+
+	/* reject setting when already initialized */
+	if (encoder->source_id != 0)
+		return -1;
+
+	rate_control_dual_init(&encoder->rc, encoder->max_window_size/2, 1);
+	return 0;
+}
+
 EXPORT
 void nck_tetrys_enc_set_systematic_phase(struct nck_tetrys_enc *encoder, uint32_t phase_length)
 {
+	if (encoder_dual_phases(encoder))
+		return;
+
 	rate_control_dual_change(&encoder->rc, phase_length, encoder->rc.dual.repair_phase);
 }
 
 EXPORT
 void nck_tetrys_enc_set_coded_phase(struct nck_tetrys_enc *encoder, uint32_t phase_length)
 {
+	if (encoder_dual_phases(encoder))
+		return;
+
 	rate_control_dual_change(&encoder->rc, encoder->rc.dual.source_phase, phase_length);
 }
 
 EXPORT
-void nck_tetrys_enc_free(struct nck_tetrys_enc *encoder)
+void nck_tetrys_enc_set_adaptive_redundancy(struct nck_tetrys_enc *encoder, int32_t min_redundancy, int32_t max_redundancy)
 {
-	struct source_symbol *symbol;
+	/* every source symbol is sent systematically at least once */
+	min_redundancy = max_t(int32_t, 0, min_redundancy);
+
+	if (encoder->rc.algo != RATE_CONTROL_ADAPTIVE) {
+		/* reject setting when already initialized */
+		if (encoder->source_id != 0)
+			return;
+
+		rate_control_adaptive_init(&encoder->rc, encoder->max_window_size, min_redundancy, max_redundancy);
+		return;
+	}
 
+	rate_control_adaptive_change(&encoder->rc, min_redundancy, max_redundancy);
+}
+
+EXPORT
+void nck_tetrys_enc_free(struct nck_tetrys_enc *encoder)
+{
 	if (encoder->timeout_handle) {
 		nck_timer_cancel(encoder->timeout_handle);
 		nck_timer_free(encoder->timeout_handle);
 	}
-	while (!list_empty(&encoder->window)) {
-		symbol = list_first_entry(&encoder->window, struct source_symbol, list);
+	free(encoder->slots);
+	free(encoder->storage);
+	free(encoder);
+}
 
-		list_del(&symbol->list);
-		free(symbol);
-		--encoder->window_size;
+EXPORT
+int nck_tetrys_enc_reset(struct nck_tetrys_enc *encoder)
+{
+	if (encoder->timeout_handle) {
+		nck_timer_cancel(encoder->timeout_handle);
 	}
-	assert(encoder->window_size == 0);
-	free(encoder);
+
+	// the phase lengths and redundancy bounds are options and stay as they are
+	rate_control_restart(&encoder->rc);
+
+	memset(encoder->slots, 0, encoder->ring_size * sizeof(*encoder->slots));
+	encoder->window_size = 0;
+	encoder->window_start = 0;
+	encoder->next_id = 0;
+	encoder->coded_id = 0;
+	encoder->source_id = 0;
+	encoder->fb_next = 0;
+
+	return 0;
 }
 
 EXPORT
 int nck_tetrys_enc_has_coded(struct nck_tetrys_enc *encoder)
 {
-	return !list_empty(&encoder->window) && (encoder->next != NULL || (rate_control_next_repair(&encoder->rc, 0 /* TODO */)));
+	return encoder->window_size > 0 && (encoder->next_id != encoder->source_id || (rate_control_next_repair(&encoder->rc, window_unsent(encoder))));
 }
 
 EXPORT
@@ -140,51 +259,65 @@ int nck_tetrys_enc_full(struct nck_tetrys_enc *encoder)
 EXPORT
 int nck_tetrys_enc_complete(struct nck_tetrys_enc *encoder)
 {
-	return list_empty(&encoder->window);
+	return encoder->window_size == 0;
 }
 
 EXPORT
 void nck_tetrys_enc_flush_coded(struct nck_tetrys_enc *encoder)
 {
-	if (!list_empty(&encoder->window)) {
-		rate_control_dual_reset(&encoder->rc, 1, encoder->window_size);
+	if (encoder->window_size > 0) {
+		if (encoder->rc.algo == RATE_CONTROL_DUAL)
+			rate_control_dual_reset(&encoder->rc, 1, encoder->window_size);
+		else
+			rate_control_reset_repair(&encoder->rc);
 		nck_trigger_call(&encoder->on_coded_ready);
 	}
 }
 
-EXPORT
-int nck_tetrys_enc_put_source(struct nck_tetrys_enc *encoder, struct sk_buff *packet)
+/* Store a source symbol in the window and return its id. */
+static uint32_t window_add(struct nck_tetrys_enc *encoder, struct sk_buff *packet)
 {
-	struct source_symbol *symbol, *evict;
+	struct window_slot *slot;
+	uint8_t *data;
+	uint32_t id;
 
 	assert(packet->len <= encoder->source_size);
 
-	symbol = malloc(sizeof(*symbol) + packet->len);
-	symbol->id = encoder->source_id++;
-	symbol->len = packet->len;
-	memcpy(symbol->data, packet->data, packet->len);
+	id = encoder->source_id++;
 
-	list_add_tail(&symbol->list, &encoder->window);
-	if (encoder->next == NULL) {
-		encoder->next = symbol;
+	// the slot of the new symbol might still be occupied by the symbol
+	// that is ring_size ids older, which falls out of the window now
+	while (encoder->source_id - encoder->window_start > encoder->ring_size) {
+		window_remove(encoder, encoder->window_start);
+		++encoder->window_start;
 	}
 
-	encoder->window_size++;
-	while (encoder->window_size > encoder->max_window_size) {
-		evict = list_first_entry(&encoder->window, typeof(*evict), list);
-		if (encoder->next == evict) {
-			if (evict->list.next == &encoder->window) {
-				encoder->next = NULL;
-			} else {
-				encoder->next = list_first_entry(&evict->list, typeof(*encoder->next), list);
-			}
-		}
+	slot = window_slot(encoder, id);
+	slot->len = packet->len;
+	slot->present = 1;
+	slot->sent = 0;
+	++encoder->window_size;
+	rate_control_insert(&encoder->rc, false);
 
-		list_del(&evict->list);
-		free(evict);
-		--encoder->window_size;
+	// pad with zeros so repair symbols can combine all slots with the same length
+	data = window_data(encoder, id);
+	memcpy(data, packet->data, packet->len);
+	memset(data + packet->len, 0, encoder->source_size - packet->len);
+
+	window_trim(encoder);
+	while (encoder->window_size > encoder->max_window_size) {
+		window_remove(encoder, encoder->window_start);
+		window_trim(encoder);
 	}
 
+	return id;
+}
+
+EXPORT
+int nck_tetrys_enc_put_source(struct nck_tetrys_enc *encoder, struct sk_buff *packet)
+{
+	window_add(encoder, packet);
+
 	if (encoder->timeout_handle) {
 		// we definitelly have something to send now, so we cancel the timeout
 		nck_timer_cancel(encoder->timeout_handle);
@@ -195,67 +328,106 @@ int nck_tetrys_enc_put_source(struct nck_tetrys_enc *encoder, struct sk_buff *pa
 	return 0;
 }
 
+/*
+ * A source packet can be sent in place if it would be the next packet of
+ * nck_tetrys_enc_get_coded() anyway: nothing else is waiting and the rate
+ * control does not ask for a repair packet. The window keeps a copy for the
+ * repair packets, only the systematic header is pushed into the packet.
+ */
+static int tetrys_wrap_source(void *enc, struct sk_buff *packet)
+{
+	struct nck_tetrys_enc *encoder = (struct nck_tetrys_enc *)enc;
+	uint32_t id;
+
+	if (nck_tetrys_enc_has_coded(encoder) || rate_control_next_repair(&encoder->rc, window_unsent(encoder)))
+		return -1;
+
+	id = window_add(encoder, packet);
+	assert(id == encoder->next_id);
+
+	// account for the systematic packet like nck_tetrys_enc_get_coded()
+	rate_control_step(&encoder->rc, window_unsent(encoder));
+	window_slot(encoder, id)->sent = 1;
+	skb_push_u32(packet, id);
+	skb_push_u8(packet, 0);
+
+	++encoder->next_id;
+	window_trim(encoder);
+
+	if (encoder->timeout_handle) {
+		if (_has_coded(encoder)) {
+			nck_timer_cancel(encoder->timeout_handle);
+		} else {
+			nck_timer_rearm(encoder->timeout_handle, &encoder->timeout);
+		}
+	}
+
+	return 0;
+}
+
 EXPORT
 int nck_tetrys_enc_get_coded(struct nck_tetrys_enc *encoder, struct sk_buff *packet)
 {
-	struct source_symbol *symbol;
-	uint8_t payload[encoder->source_size], *pos;
-	uint8_t coeff;
+	struct window_slot *slot;
+	uint8_t *srcs[encoder->max_window_size];
+	uint8_t coeffs[encoder->max_window_size];
+	uint8_t *pos;
 	size_t len;
-	uint32_t count;
+	uint32_t count, id;
 
 	assert(nck_tetrys_enc_has_coded(encoder));
 	if (!nck_tetrys_enc_has_coded(encoder))
 		return -1;
 
-	if (rate_control_step(&encoder->rc, 0 /* TODO */) || encoder->next == NULL) {
-		assert(!list_empty(&encoder->window));
+	if (rate_control_step(&encoder->rc, window_unsent(encoder)) || encoder->next_id == encoder->source_id) {
+		assert(encoder->window_size > 0);
 
 		// reserve space for the flag, id and window size
 		skb_reserve(packet, 9);
 
 		// produce a coded packet
-		memset(payload, 0, encoder->source_size);
 		len = 0;
 		count = 0;
 
-		list_for_each_entry(symbol, &encoder->window, list) {
-			coeff = rand_r(&encoder->seed)&0xff;
-			binary8_region_multiply_add(payload, symbol->data, coeff, symbol->len);
-			if (symbol->len > len) {
-				len = symbol->len;
+		for (id = encoder->window_start; id != encoder->source_id; ++id) {
+			slot = window_slot(encoder, id);
+			if (!slot->present)
+				continue;
+
+			srcs[count] = window_data(encoder, id);
+			coeffs[count] = rand_r(&encoder->seed)&0xff;
+			if (slot->len > len) {
+				len = slot->len;
 			}
-			skb_put_u32(packet, symbol->id);
-			skb_put_u8(packet, coeff);
+			skb_put_u32(packet, id);
+			skb_put_u8(packet, coeffs[count]);
 			++count;
 		}
 
 		assert(count);
 		assert(len <= encoder->source_size);
 
-		pos = skb_put(packet, encoder->source_size);
-		memcpy(pos, payload, encoder->source_size);
-
-		skb_trim(packet, encoder->source_size - len);
+		pos = skb_put(packet, len);
+		memset(pos, 0, len);
+		binary8_region_multiply_sum(pos, srcs, coeffs, count, len);
 
 		skb_push_u32(packet, count);
 		skb_push_u32(packet, encoder->coded_id++);
 		skb_push_u8(packet, 1);
 	} else {
 		/* produce a systematic packet */
-		symbol = encoder->next;
+		id = encoder->next_id;
+		slot = window_slot(encoder, id);
+		slot->sent = 1;
 
 		skb_reserve(packet, 5);
-		pos = skb_put(packet, symbol->len);
-		memcpy(pos, symbol->data, symbol->len);
-		skb_push_u32(packet, symbol->id);
+		pos = skb_put(packet, slot->len);
+		memcpy(pos, window_data(encoder, id), slot->len);
+		skb_push_u32(packet, id);
 		skb_push_u8(packet, 0);
 
-		if (symbol->list.next == &encoder->window) {
-			encoder->next = NULL;
-		} else {
-			encoder->next = list_entry(symbol->list.next, struct source_symbol, list);
-		}
+		++encoder->next_id;
+		window_trim(encoder);
 	}
 
 	if (encoder->timeout_handle && !_has_coded(encoder)) {
@@ -268,11 +440,68 @@ int nck_tetrys_enc_get_coded(struct nck_tetrys_enc *encoder, struct sk_buff *pac
 	return 0;
 }
 
+static inline uint32_t feedback_id(const struct sk_buff *packet, uint32_t index)
+{
+	uint32_t id;
+
+	memcpy(&id, packet->data + index * sizeof(id), sizeof(id));
+	return ntohl(id);
+}
+
+/*
+ * Pass the losses of the systematic packets reported by a feedback to the
+ * adaptive redundancy. The feedback lists the missing ids of the decoder and
+ * ends with the id after its newest symbol, all other ids before it arrived.
+ * Symbols that the decoder already recovered are not listed anymore, so the
+ * estimate is a lower bound of the losses.
+ */
+static void feedback_loss(struct nck_tetrys_enc *encoder, const struct sk_buff *packet)
+{
+	uint32_t count = packet->len / sizeof(uint32_t);
+	uint32_t index = 0, id, end;
+	uint32_t received = 0, lost = 0, bursts = 0;
+	int in_burst = 0;
+
+	if (encoder->rc.algo != RATE_CONTROL_ADAPTIVE || count == 0)
+		return;
+
+	end = feedback_id(packet, count - 1);
+	if ((int32_t)(end - encoder->next_id) > 0)
+		end = encoder->next_id;
+
+	// older slots might already be reused for newer symbols
+	id = encoder->fb_next;
+	if (encoder->source_id - id > encoder->ring_size)
+		id = encoder->source_id - encoder->ring_size;
+
+	for (; (int32_t)(end - id) > 0; ++id) {
+		while (index + 1 < count && (int32_t)(feedback_id(packet, index) - id) < 0)
+			++index;
+
+		if (!window_slot(encoder, id)->sent)
+			continue;
+
+		if (index + 1 < count && feedback_id(packet, index) == id) {
+			if (!in_burst)
+				++bursts;
+			in_burst = 1;
+			++lost;
+		} else {
+			in_burst = 0;
+			++received;
+		}
+	}
+
+	if ((int32_t)(end - encoder->fb_next) > 0)
+		encoder->fb_next = end;
+
+	rate_control_adaptive_update(&encoder->rc, received, lost, bursts);
+}
+
 EXPORT
 int nck_tetrys_enc_put_feedback(struct nck_tetrys_enc *encoder, struct sk_buff *packet)
 {
 	uint32_t id, missing_id;
-	struct source_symbol *symbol, *next;
 	int packet_type;
 
 	packet_type = skb_pull_u8(packet);
@@ -282,18 +511,26 @@ int nck_tetrys_enc_put_feedback(struct nck_tetrys_enc *encoder, struct sk_buff *
 	assert(packet->len%sizeof(id) == 0);
 	assert(packet->len != 0);	/* decoder isn't designed to send empty feedback  */
 
+	feedback_loss(encoder, packet);
+
 	missing_id = skb_pull_u32(packet);
 
-	/* assuming that ids are rising in the list */
-	list_for_each_entry_safe(symbol, next, &encoder->window, list) {
-		assert(symbol->id <= missing_id);
+	/* assuming that ids are rising in the window */
+	for (id = encoder->window_start; id != encoder->source_id; ++id) {
+		if (!window_slot(encoder, id)->present)
+			continue;
+
+		/* symbols reported missing might already have been evicted from the ring */
+		while (id > missing_id && packet->len >= 4) {
+			missing_id = skb_pull_u32(packet);
+		}
 
 		/* keep the missing symbol, and pull out the next */
-		if (symbol->id >= missing_id) {
+		if (id >= missing_id) {
 			if (packet->len <= 0)
 				break;
 
-			while (symbol->id >= missing_id && packet->len >= 4) {
+			while (id >= missing_id && packet->len >= 4) {
 				missing_id = skb_pull_u32(packet);
 			}
 
@@ -301,27 +538,17 @@ int nck_tetrys_enc_put_feedback(struct nck_tetrys_enc *encoder, struct sk_buff *
 		}
 
 		/* if we happen to not have sent out a packet systematically but already got
-		 * it acknowledged, we still remove it but move on to the next pointer. This can
-		 * happen if a feedback is received during a flush and another packet is then
-		 * admitted.
+		 * it acknowledged, we still remove it and window_trim moves on to the next
+		 * systematic symbol. This can happen if a feedback is received during a flush
+		 * and another packet is then admitted.
 		 */
-		if (symbol == encoder->next) {
-			if (symbol->list.next == &encoder->window) {
-				encoder->next = NULL;
-			} else {
-				encoder->next = list_entry(symbol->list.next, struct source_symbol, list);
-			}
-
-			encoder->next = NULL;
-		}
-
-		list_del(&symbol->list);
-		free(symbol);
-		--encoder->window_size;
+		window_remove(encoder, id);
 	}
 
+	window_trim(encoder);
+
 	if (encoder->timeout_handle) {
-		if (list_empty(&encoder->window)) {
+		if (encoder->window_size == 0) {
 			nck_timer_cancel(encoder->timeout_handle);
 		} else if (!nck_timer_pending(encoder->timeout_handle)) {
 			nck_timer_rearm(encoder->timeout_handle, &encoder->timeout);
@@ -68,3 +68,13 @@ void nck_timer_free(struct nck_timer_entry *handle)
 		handle->timer->free(handle);
 	}
 }
+
+EXPORT
+void nck_timer_gettime(struct nck_timer *timer, struct timeval *now)
+{
+	if (timer && timer->gettime) {
+		timer->gettime(timer, now);
+	} else {
+		gettimeofday(now, NULL);
+	}
+}
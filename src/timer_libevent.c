@@ -76,6 +76,11 @@ static void libevent_free(struct nck_timer_entry *handle)
 	event_free(timer->ev);
 }
 
+static void libevent_gettime(struct nck_timer *timer, struct timeval *now)
+{
+	event_base_gettimeofday_cached(timer->backend, now);
+}
+
 EXPORT
 void nck_libevent_timer(struct event_base *ev, struct nck_timer *timer)
 {
@@ -85,6 +90,7 @@ void nck_libevent_timer(struct event_base *ev, struct nck_timer *timer)
 		.cancel = libevent_cancel,
 		.pending = libevent_pending,
 		.rearm = libevent_rearm,
-		.free = libevent_free
+		.free = libevent_free,
+		.gettime = libevent_gettime
 	};
 }
@@ -154,6 +154,12 @@ static void schedule_free(struct nck_timer_entry *handle)
 	free(handle);
 }
 
+static void schedule_gettime(struct nck_timer *timer, struct timeval *now)
+{
+	struct nck_schedule *schedule = (struct nck_schedule *) timer->backend;
+	*now = schedule->time;
+}
+
 EXPORT
 void nck_schedule_timer(struct nck_schedule *schedule,
 			struct nck_timer *timer)
@@ -164,7 +170,8 @@ void nck_schedule_timer(struct nck_schedule *schedule,
 		.cancel = schedule_cancel,
 		.pending = schedule_pending,
 		.rearm = schedule_rearm,
-		.free =	schedule_free
+		.free =	schedule_free,
+		.gettime = schedule_gettime
 	};
 }
 
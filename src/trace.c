@@ -1,42 +1,173 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include <nckernel/config.h>
 #include <nckernel/trace.h>
 
 #include <fnmatch.h>
 
-static void nck_trace_stderr(void *context, const char *file, int line, const char *func, const char *format, ...)
-{
-	static const char *file_pattern = NULL;
-	static const char *func_pattern = NULL;
-	const char *header;
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+#endif
 
-	if (!file_pattern) {
-		file_pattern = getenv("NCK_TRACE");
-		if (!file_pattern) {
-			// by default we trace no file
-			// tracing needs to be explicitly turned on
-			file_pattern = "";
-		}
-	}
+#include "private.h"
 
-	if (!func_pattern) {
-		func_pattern = getenv("NCK_TRACE_FUNC");
-		if (!func_pattern) {
-			// by default we trace all functions
-			func_pattern = "*";
-		}
-	}
+#define TRACE_MAX_ARGS 16
+#define TRACE_DEFAULT_RECORDS 4096
+#define TRACE_TEXT_SIZE 1024
 
-	if (fnmatch(file_pattern, file, FNM_NOESCAPE)) {
-		return;
-	}
+/* precision of a conversion that has none or takes it from an argument */
+#define TRACE_PRECISION_NONE -1
+#define TRACE_PRECISION_ARG  -2
 
-	if (fnmatch(func_pattern, func, FNM_NOESCAPE)) {
-		return;
-	}
+#define TRACE_MAGIC "NCKTRACE"
+#define TRACE_VERSION 1
+
+enum trace_arg {
+	TRACE_ARG_NONE,
+	TRACE_ARG_INT,
+	TRACE_ARG_LONG,
+	TRACE_ARG_DOUBLE,
+	TRACE_ARG_LDOUBLE,
+	TRACE_ARG_PTR,
+	TRACE_ARG_STR,
+	TRACE_ARG_SKIP,
+};
+
+/**
+ * struct trace_spec - a single conversion of a printf format
+ * @start: the '%' that starts the conversion
+ * @end: the character after the conversion
+ * @stars: number of widths and precisions that are given as int arguments
+ * @precision: precision of the conversion, TRACE_PRECISION_NONE or
+ *             TRACE_PRECISION_ARG if it is given as the last star
+ * @type: type of the converted argument
+ */
+struct trace_spec {
+	const char *start;
+	const char *end;
+	int stars;
+	int precision;
+	enum trace_arg type;
+};
+
+/**
+ * struct nck_trace_format - registered tracepoint with its argument layout
+ * @id: number of the tracepoint in the binary trace
+ * @file: source file of the tracepoint
+ * @func: function of the tracepoint
+ * @line: source line of the tracepoint
+ * @format: format string of the first call
+ * @nargs: number of arguments, -1 if the format can only be stored as text
+ * @types: types of the arguments in the order they are passed
+ * @precisions: precisions of the string arguments, at most this many bytes
+ *              of a string are read
+ */
+struct nck_trace_format {
+	uint32_t id;
+	const char *file;
+	const char *func;
+	int line;
+	const char *format;
+	int nargs;
+	uint8_t types[TRACE_MAX_ARGS];
+	int precisions[TRACE_MAX_ARGS];
+};
+
+#define TRACE_SLOT_TRUNCATED 0x1
+#define TRACE_SLOT_TEXT      0x2
+
+/**
+ * struct trace_slot - a record in the ring buffer
+ * @seq: index of the record plus one, 0 while the record is written
+ * @time: CLOCK_MONOTONIC time of the record in nanoseconds
+ * @context: context pointer of the call
+ * @id: id of the tracepoint
+ * @len: number of used bytes in @data
+ * @flags: TRACE_SLOT_TRUNCATED if arguments did not fit, TRACE_SLOT_TEXT if
+ *         @data holds the formatted message instead of the arguments
+ * @data: numbers are stored in 8 bytes, strings with a 2 byte length
+ */
+struct trace_slot {
+	uint64_t seq;
+	uint64_t time;
+	uint64_t context;
+	uint32_t id;
+	uint16_t len;
+	uint16_t flags;
+	uint8_t data[224];
+};
+
+/**
+ * struct trace_ring - ring buffer of a single thread
+ * @next: next ring in the list of all rings
+ * @tid: thread that writes to the ring
+ * @mask: number of slots minus one
+ * @head: index of the next record
+ * @slots: the records
+ *
+ * Only the owning thread writes to the ring, so recording does not need any
+ * locks. The oldest records are overwritten when the ring is full.
+ */
+struct trace_ring {
+	struct trace_ring *next;
+	uint32_t tid;
+	uint32_t mask;
+	uint64_t head;
+	struct trace_slot slots[];
+};
+
+struct trace_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t slot_size;
+	uint64_t monotonic;
+	uint64_t realtime;
+	uint32_t tracepoints;
+	uint32_t rings;
+};
+
+struct trace_file_tracepoint {
+	uint32_t id;
+	int32_t line;
+	uint32_t file_len;
+	uint32_t func_len;
+	uint32_t format_len;
+};
+
+struct trace_file_ring {
+	uint32_t tid;
+	uint32_t count;
+};
+
+uint32_t nck_trace_generation = 1;
+
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t trace_mask = NCK_TRACE_TEXT;
+static char *trace_file_pattern = NULL;
+static char *trace_func_pattern = NULL;
+static uint32_t trace_records = TRACE_DEFAULT_RECORDS;
+static char *trace_dump_path = NULL;
+
+static struct nck_trace_format **trace_table = NULL;
+static uint32_t trace_count = 0;
+static uint32_t trace_capacity = 0;
+
+static struct trace_ring *trace_rings = NULL;
+static __thread struct trace_ring *trace_local = NULL;
+
+static void nck_trace_stderr(void *context, const char *file, int line, const char *func, const char *format, ...)
+{
+	const char *header;
 
 	if (isatty(fileno(stderr))) {
 		header = "\033[35m%s\033[0m:\033[32m%d\033[0m %s [\033[91m%p\033[0m] - ";
@@ -54,3 +185,789 @@ static void nck_trace_stderr(void *context, const char *file, int line, const ch
 }
 
 void (*nck_trace_print)(void *context, const char *file, int line, const char *func, const char *format, ...) = nck_trace_stderr;
+
+static uint64_t trace_clock(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void trace_dump_exit(void)
+{
+	FILE *out = fopen(trace_dump_path, "wb");
+
+	if (!out) {
+		perror("fopen");
+		return;
+	}
+
+	nck_trace_dump(out);
+	fclose(out);
+}
+
+static uint32_t trace_parse_output(const char *output)
+{
+	uint32_t mask = 0;
+	size_t len;
+
+	while (*output) {
+		len = strcspn(output, ",");
+		if (len == 4 && !strncmp(output, "text", len))
+			mask |= NCK_TRACE_TEXT;
+		else if (len == 6 && !strncmp(output, "binary", len))
+			mask |= NCK_TRACE_BINARY;
+		else if (len == 5 && !strncmp(output, "probe", len))
+			mask |= NCK_TRACE_PROBE;
+
+		output += len;
+		if (*output == ',')
+			output += 1;
+	}
+
+	return mask;
+}
+
+static uint32_t trace_round_records(size_t records)
+{
+	uint32_t result = 1;
+
+	while (result < records && result < (UINT32_C(1) << 31))
+		result <<= 1;
+
+	return result;
+}
+
+static void trace_init(void)
+{
+	const char *env;
+
+	// by default we trace no file
+	// tracing needs to be explicitly turned on
+	env = getenv("NCK_TRACE");
+	trace_file_pattern = strdup(env ? env : "");
+
+	// by default we trace all functions
+	env = getenv("NCK_TRACE_FUNC");
+	trace_func_pattern = strdup(env ? env : "*");
+
+	env = getenv("NCK_TRACE_OUTPUT");
+	if (env)
+		trace_mask = trace_parse_output(env);
+
+	env = getenv("NCK_TRACE_BUFFER");
+	if (env && strtoul(env, NULL, 0) > 0)
+		trace_records = trace_round_records(strtoul(env, NULL, 0));
+
+	env = getenv("NCK_TRACE_FILE");
+	if (env && *env) {
+		trace_dump_path = strdup(env);
+		atexit(trace_dump_exit);
+	}
+}
+
+static void trace_changed(void)
+{
+	__atomic_add_fetch(&nck_trace_generation, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * trace_spec_next - find the next conversion of a format string
+ * @p: position in the format, moved behind the conversion
+ * @spec: receives the conversion
+ *
+ * Return: 1 if a conversion was found; 0 at the end of the format; -1 if the
+ *         conversion is not supported
+ */
+static int trace_spec_next(const char **p, struct trace_spec *spec)
+{
+	const char *pos = strchr(*p, '%');
+	int wide = 0, ldouble = 0;
+
+	if (!pos) {
+		*p += strlen(*p);
+		return 0;
+	}
+
+	spec->start = pos++;
+	spec->stars = 0;
+	spec->precision = TRACE_PRECISION_NONE;
+
+	pos += strspn(pos, "-+ #0'");
+	if (*pos == '*') {
+		spec->stars += 1;
+		pos += 1;
+	} else {
+		pos += strspn(pos, "0123456789");
+	}
+
+	if (*pos == '.') {
+		pos += 1;
+		if (*pos == '*') {
+			spec->stars += 1;
+			spec->precision = TRACE_PRECISION_ARG;
+			pos += 1;
+		} else {
+			spec->precision = atoi(pos);
+			pos += strspn(pos, "0123456789");
+		}
+	}
+
+	while (*pos && strchr("hlLqjzt", *pos)) {
+		if (*pos == 'L')
+			ldouble = 1;
+		else if (*pos != 'h')
+			wide = 1;
+		pos += 1;
+	}
+
+	switch (*pos) {
+	case '%':
+		spec->type = TRACE_ARG_NONE;
+		break;
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+		spec->type = wide ? TRACE_ARG_LONG : TRACE_ARG_INT;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		spec->type = ldouble ? TRACE_ARG_LDOUBLE : TRACE_ARG_DOUBLE;
+		break;
+	case 'p':
+		spec->type = TRACE_ARG_PTR;
+		break;
+	case 's':
+		spec->type = TRACE_ARG_STR;
+		break;
+	case 'n':
+		spec->type = TRACE_ARG_SKIP;
+		break;
+	default:
+		return -1;
+	}
+
+	spec->end = pos + 1;
+	*p = spec->end;
+	return 1;
+}
+
+static struct nck_trace_format *trace_register(struct nck_tracepoint *tp, const char *format)
+{
+	struct nck_trace_format *result;
+	struct nck_trace_format **table;
+	struct trace_spec spec;
+	const char *pos = format;
+	int found, i;
+
+	result = malloc(sizeof(*result));
+	result->file = tp->file;
+	result->func = tp->func;
+	result->line = tp->line;
+	result->format = format;
+	result->nargs = 0;
+
+	while ((found = trace_spec_next(&pos, &spec)) > 0) {
+		if (spec.type == TRACE_ARG_NONE)
+			continue;
+
+		if (result->nargs + spec.stars + 1 > TRACE_MAX_ARGS) {
+			found = -1;
+			break;
+		}
+
+		for (i = 0; i < spec.stars; ++i)
+			result->types[result->nargs++] = TRACE_ARG_INT;
+		result->precisions[result->nargs] = spec.precision;
+		result->types[result->nargs++] = spec.type;
+	}
+
+	// unsupported formats are recorded as formatted text
+	if (found < 0)
+		result->nargs = -1;
+
+	pthread_mutex_lock(&trace_lock);
+	if (tp->format) {
+		// another thread was faster
+		pthread_mutex_unlock(&trace_lock);
+		free(result);
+		return tp->format;
+	}
+
+	if (trace_count == trace_capacity) {
+		trace_capacity = trace_capacity ? 2 * trace_capacity : 64;
+		table = realloc(trace_table, trace_capacity * sizeof(*table));
+		trace_table = table;
+	}
+
+	trace_table[trace_count++] = result;
+	result->id = trace_count;
+	__atomic_store_n(&tp->format, result, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&trace_lock);
+
+	return result;
+}
+
+static struct trace_ring *trace_ring_get(void)
+{
+	struct trace_ring *ring = trace_local;
+	uint32_t records;
+
+	if (ring)
+		return ring;
+
+	records = __atomic_load_n(&trace_records, __ATOMIC_RELAXED);
+	ring = calloc(1, sizeof(*ring) + records * sizeof(ring->slots[0]));
+	if (!ring)
+		return NULL;
+
+	ring->tid = syscall(SYS_gettid);
+	ring->mask = records - 1;
+
+	// rings are never freed, they keep the trace of finished threads
+	ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, 1,
+					    __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+
+	trace_local = ring;
+	return ring;
+}
+
+static void trace_record(struct nck_tracepoint *tp, struct nck_trace_format *fmt,
+			 void *context, const char *format, va_list args)
+{
+	struct trace_ring *ring = trace_ring_get();
+	struct trace_slot *slot;
+	uint64_t index, value = 0;
+	const char *str;
+	size_t len, pos = 0;
+	double real;
+	uint16_t slen;
+	int i, precision;
+
+	UNUSED(tp);
+
+	if (!ring)
+		return;
+
+	index = ring->head;
+	slot = &ring->slots[index & ring->mask];
+
+	__atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->time = trace_clock(CLOCK_MONOTONIC);
+	slot->context = (uintptr_t)context;
+	slot->id = fmt->id;
+	slot->flags = 0;
+
+	if (fmt->nargs < 0) {
+		len = vsnprintf((char *)slot->data, sizeof(slot->data), format, args);
+		if (len >= sizeof(slot->data)) {
+			len = sizeof(slot->data) - 1;
+			slot->flags |= TRACE_SLOT_TRUNCATED;
+		}
+		pos = len;
+		slot->flags |= TRACE_SLOT_TEXT;
+	}
+
+	for (i = 0; i < fmt->nargs; ++i) {
+		if (fmt->types[i] == TRACE_ARG_SKIP) {
+			va_arg(args, void *);
+			continue;
+		}
+
+		if (fmt->types[i] == TRACE_ARG_STR) {
+			str = va_arg(args, const char *);
+			if (!str)
+				str = "(null)";
+
+			if (pos + sizeof(slen) > sizeof(slot->data)) {
+				slot->flags |= TRACE_SLOT_TRUNCATED;
+				break;
+			}
+
+			// a precision limits how much of the string is read, the
+			// string does not even need to be terminated then
+			precision = fmt->precisions[i];
+			if (precision == TRACE_PRECISION_ARG)
+				precision = (int)(int64_t)value;
+			len = precision >= 0 ? strnlen(str, precision) : strlen(str);
+			if (len > sizeof(slot->data) - pos - sizeof(slen)) {
+				len = sizeof(slot->data) - pos - sizeof(slen);
+				slot->flags |= TRACE_SLOT_TRUNCATED;
+			}
+
+			slen = len;
+			memcpy(&slot->data[pos], &slen, sizeof(slen));
+			memcpy(&slot->data[pos + sizeof(slen)], str, len);
+			pos += sizeof(slen) + len;
+			continue;
+		}
+
+		switch (fmt->types[i]) {
+		case TRACE_ARG_INT:
+			value = (int64_t)va_arg(args, int);
+			break;
+		case TRACE_ARG_LONG:
+			value = (uint64_t)va_arg(args, long long);
+			break;
+		case TRACE_ARG_DOUBLE:
+			real = va_arg(args, double);
+			memcpy(&value, &real, sizeof(value));
+			break;
+		case TRACE_ARG_LDOUBLE:
+			real = (double)va_arg(args, long double);
+			memcpy(&value, &real, sizeof(value));
+			break;
+		default:
+			value = (uintptr_t)va_arg(args, void *);
+			break;
+		}
+
+		if (pos + sizeof(value) > sizeof(slot->data)) {
+			slot->flags |= TRACE_SLOT_TRUNCATED;
+			break;
+		}
+
+		memcpy(&slot->data[pos], &value, sizeof(value));
+		pos += sizeof(value);
+	}
+
+	slot->len = pos;
+
+	__atomic_store_n(&slot->seq, index + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->head, index + 1, __ATOMIC_RELEASE);
+}
+
+EXPORT
+uint32_t nck_trace_check(struct nck_tracepoint *tp)
+{
+	uint32_t generation, state;
+
+	pthread_once(&trace_once, trace_init);
+
+	pthread_mutex_lock(&trace_lock);
+	generation = __atomic_load_n(&nck_trace_generation, __ATOMIC_RELAXED);
+	state = generation << 1;
+
+	if (trace_mask &&
+	    !fnmatch(trace_file_pattern, tp->file, FNM_NOESCAPE) &&
+	    !fnmatch(trace_func_pattern, tp->func, FNM_NOESCAPE))
+		state |= 1;
+	pthread_mutex_unlock(&trace_lock);
+
+	__atomic_store_n(&tp->state, state, __ATOMIC_RELAXED);
+	return state;
+}
+
+EXPORT
+void nck_trace_emit(struct nck_tracepoint *tp, void *context, const char *format, ...)
+{
+	struct nck_trace_format *fmt;
+	char text[TRACE_TEXT_SIZE];
+	uint32_t mask = __atomic_load_n(&trace_mask, __ATOMIC_RELAXED);
+	va_list args;
+
+	if (mask & NCK_TRACE_TEXT) {
+		va_start(args, format);
+		vsnprintf(text, sizeof(text), format, args);
+		va_end(args);
+
+		nck_trace_print(context, tp->file, tp->line, tp->func, "%s", text);
+	}
+
+	if (mask & NCK_TRACE_BINARY) {
+		fmt = __atomic_load_n(&tp->format, __ATOMIC_ACQUIRE);
+		if (!fmt)
+			fmt = trace_register(tp, format);
+
+		va_start(args, format);
+		trace_record(tp, fmt, context, format, args);
+		va_end(args);
+	}
+
+#ifdef ENABLE_USDT
+	if (mask & NCK_TRACE_PROBE)
+		DTRACE_PROBE5(nckernel, trace, tp->file, tp->line, tp->func, context, format);
+#endif
+}
+
+EXPORT
+void nck_trace_set_mask(uint32_t mask)
+{
+	pthread_once(&trace_once, trace_init);
+
+	pthread_mutex_lock(&trace_lock);
+	__atomic_store_n(&trace_mask, mask, __ATOMIC_RELAXED);
+	trace_changed();
+	pthread_mutex_unlock(&trace_lock);
+}
+
+EXPORT
+uint32_t nck_trace_get_mask(void)
+{
+	pthread_once(&trace_once, trace_init);
+	return __atomic_load_n(&trace_mask, __ATOMIC_RELAXED);
+}
+
+EXPORT
+void nck_trace_set_filter(const char *file_pattern, const char *func_pattern)
+{
+	pthread_once(&trace_once, trace_init);
+
+	pthread_mutex_lock(&trace_lock);
+	free(trace_file_pattern);
+	free(trace_func_pattern);
+	trace_file_pattern = strdup(file_pattern ? file_pattern : "");
+	trace_func_pattern = strdup(func_pattern ? func_pattern : "*");
+	trace_changed();
+	pthread_mutex_unlock(&trace_lock);
+}
+
+EXPORT
+int nck_trace_set_buffer(size_t records)
+{
+	if (records == 0)
+		return -1;
+
+	pthread_once(&trace_once, trace_init);
+	__atomic_store_n(&trace_records, trace_round_records(records), __ATOMIC_RELAXED);
+	return 0;
+}
+
+/**
+ * trace_ring_copy - copy the valid records of a ring
+ * @ring: ring to copy
+ * @slots: receives the records, must have space for the whole ring
+ *
+ * Return: number of copied records
+ */
+static uint32_t trace_ring_copy(struct trace_ring *ring, struct trace_slot *slots)
+{
+	uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	uint64_t index = head > ring->mask + 1 ? head - ring->mask - 1 : 0;
+	struct trace_slot *slot;
+	uint32_t count = 0;
+	uint64_t seq;
+
+	for (; index < head; ++index) {
+		slot = &ring->slots[index & ring->mask];
+
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq != index + 1)
+			continue;
+
+		memcpy(&slots[count], slot, sizeof(*slot));
+
+		// the record was overwritten while we copied it
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+			continue;
+
+		count += 1;
+	}
+
+	return count;
+}
+
+static int trace_write_string(FILE *out, const char *str)
+{
+	return fwrite(str, 1, strlen(str), out) == strlen(str) ? 0 : -1;
+}
+
+EXPORT
+int nck_trace_dump(FILE *out)
+{
+	struct trace_file_header header;
+	struct trace_file_tracepoint entry;
+	struct trace_file_ring file_ring;
+	struct trace_ring *ring, *rings;
+	struct trace_slot *slots;
+	struct nck_trace_format *fmt;
+	uint32_t i;
+	int result = 0;
+
+	rings = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	header.version = TRACE_VERSION;
+	header.slot_size = sizeof(struct trace_slot);
+	header.monotonic = trace_clock(CLOCK_MONOTONIC);
+	header.realtime = trace_clock(CLOCK_REALTIME);
+
+	for (ring = rings; ring; ring = ring->next)
+		header.rings += 1;
+
+	pthread_mutex_lock(&trace_lock);
+	header.tracepoints = trace_count;
+	if (fwrite(&header, sizeof(header), 1, out) != 1)
+		result = -1;
+
+	for (i = 0; result == 0 && i < trace_count; ++i) {
+		fmt = trace_table[i];
+		entry.id = fmt->id;
+		entry.line = fmt->line;
+		entry.file_len = strlen(fmt->file);
+		entry.func_len = strlen(fmt->func);
+		entry.format_len = strlen(fmt->format);
+
+		if (fwrite(&entry, sizeof(entry), 1, out) != 1 ||
+		    trace_write_string(out, fmt->file) ||
+		    trace_write_string(out, fmt->func) ||
+		    trace_write_string(out, fmt->format))
+			result = -1;
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	for (ring = rings; result == 0 && ring; ring = ring->next) {
+		slots = malloc((ring->mask + 1) * sizeof(*slots));
+		if (!slots)
+			return -1;
+
+		file_ring.tid = ring->tid;
+		file_ring.count = trace_ring_copy(ring, slots);
+
+		if (fwrite(&file_ring, sizeof(file_ring), 1, out) != 1 ||
+		    fwrite(slots, sizeof(*slots), file_ring.count, out) != file_ring.count)
+			result = -1;
+
+		free(slots);
+	}
+
+	if (fflush(out))
+		result = -1;
+
+	return result;
+}
+
+struct trace_decoded {
+	uint32_t tid;
+	struct trace_slot slot;
+};
+
+static int trace_decoded_cmp(const void *a, const void *b)
+{
+	const struct trace_decoded *x = a, *y = b;
+
+	if (x->slot.time != y->slot.time)
+		return x->slot.time < y->slot.time ? -1 : 1;
+	if (x->tid != y->tid)
+		return x->tid < y->tid ? -1 : 1;
+	return x->slot.seq < y->slot.seq ? -1 : (x->slot.seq > y->slot.seq);
+}
+
+static char *trace_read_string(FILE *in, uint32_t len)
+{
+	char *result = malloc(len + 1);
+
+	if (fread(result, 1, len, in) != len) {
+		free(result);
+		return NULL;
+	}
+
+	result[len] = '\0';
+	return result;
+}
+
+/**
+ * trace_print_message - format the message of a record
+ * @out: file that receives the message
+ * @format: format string of the tracepoint
+ * @slot: record with the raw arguments
+ */
+static void trace_print_message(FILE *out, const char *format, const struct trace_slot *slot)
+{
+	char spec_format[64], str[sizeof(slot->data) + 1];
+	const char *pos = format, *literal, *c;
+	struct trace_spec spec;
+	size_t data = 0, len;
+	uint64_t value;
+	int64_t stars[2];
+	uint16_t slen;
+	double real;
+	int i, n;
+
+	if (slot->flags & TRACE_SLOT_TEXT) {
+		fwrite(slot->data, 1, slot->len, out);
+		goto done;
+	}
+
+	for (;;) {
+		literal = pos;
+		n = trace_spec_next(&pos, &spec);
+		fwrite(literal, 1, (n > 0 ? spec.start : pos) - literal, out);
+		if (n <= 0)
+			break;
+
+		if (spec.type == TRACE_ARG_NONE) {
+			fputc('%', out);
+			continue;
+		}
+
+		for (i = 0; i < spec.stars; ++i) {
+			if (data + sizeof(value) > slot->len)
+				goto done;
+			memcpy(&value, &slot->data[data], sizeof(value));
+			stars[i] = (int64_t)value;
+			data += sizeof(value);
+		}
+
+		if (spec.type == TRACE_ARG_SKIP)
+			continue;
+
+		// rebuild the conversion with the stars resolved and the length
+		// modifiers replaced by the type that was stored
+		len = 0;
+		i = 0;
+		for (c = spec.start; c < spec.end - 1 && len + 24 < sizeof(spec_format); ++c) {
+			if (*c == '*')
+				len += snprintf(&spec_format[len], sizeof(spec_format) - len,
+						"%lld", (long long)stars[i++]);
+			else if (!strchr("hlLqjzt", *c))
+				spec_format[len++] = *c;
+		}
+		if (spec.type == TRACE_ARG_LONG) {
+			spec_format[len++] = 'l';
+			spec_format[len++] = 'l';
+		}
+		spec_format[len++] = *c;
+		spec_format[len] = '\0';
+
+		if (spec.type == TRACE_ARG_STR) {
+			if (data + sizeof(slen) > slot->len)
+				break;
+			memcpy(&slen, &slot->data[data], sizeof(slen));
+			data += sizeof(slen);
+			if (slen > slot->len - data)
+				break;
+			memcpy(str, &slot->data[data], slen);
+			str[slen] = '\0';
+			data += slen;
+			fprintf(out, spec_format, str);
+			continue;
+		}
+
+		if (data + sizeof(value) > slot->len)
+			break;
+		memcpy(&value, &slot->data[data], sizeof(value));
+		data += sizeof(value);
+
+		switch (spec.type) {
+		case TRACE_ARG_INT:
+			fprintf(out, spec_format, (int)value);
+			break;
+		case TRACE_ARG_LONG:
+			fprintf(out, spec_format, (long long)value);
+			break;
+		case TRACE_ARG_DOUBLE:
+		case TRACE_ARG_LDOUBLE:
+			memcpy(&real, &value, sizeof(real));
+			fprintf(out, spec_format, real);
+			break;
+		default:
+			fprintf(out, spec_format, (void *)(uintptr_t)value);
+			break;
+		}
+	}
+
+done:
+	if (slot->flags & TRACE_SLOT_TRUNCATED)
+		fputs("...", out);
+}
+
+EXPORT
+int nck_trace_decode(FILE *in, FILE *out)
+{
+	struct trace_file_header header;
+	struct trace_file_tracepoint entry;
+	struct trace_file_ring file_ring;
+	struct nck_trace_format **table = NULL, *fmt;
+	struct trace_decoded *records = NULL, *record;
+	size_t count = 0, capacity = 0;
+	uint64_t realtime;
+	uint32_t i, j;
+	int result = -1;
+
+	if (fread(&header, sizeof(header), 1, in) != 1 ||
+	    memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) ||
+	    header.version != TRACE_VERSION ||
+	    header.slot_size != sizeof(struct trace_slot)) {
+		fprintf(stderr, "Invalid trace file\n");
+		return -1;
+	}
+
+	table = calloc(header.tracepoints + 1, sizeof(*table));
+
+	for (i = 0; i < header.tracepoints; ++i) {
+		if (fread(&entry, sizeof(entry), 1, in) != 1 ||
+		    entry.id == 0 || entry.id > header.tracepoints || table[entry.id])
+			goto out;
+
+		fmt = calloc(1, sizeof(*fmt));
+		table[entry.id] = fmt;
+		fmt->id = entry.id;
+		fmt->line = entry.line;
+		fmt->file = trace_read_string(in, entry.file_len);
+		fmt->func = trace_read_string(in, entry.func_len);
+		fmt->format = trace_read_string(in, entry.format_len);
+		if (!fmt->file || !fmt->func || !fmt->format)
+			goto out;
+	}
+
+	for (i = 0; i < header.rings; ++i) {
+		if (fread(&file_ring, sizeof(file_ring), 1, in) != 1)
+			goto out;
+
+		if (count + file_ring.count > capacity) {
+			capacity = count + file_ring.count;
+			records = realloc(records, capacity * sizeof(*records));
+		}
+
+		for (j = 0; j < file_ring.count; ++j) {
+			record = &records[count];
+			if (fread(&record->slot, sizeof(record->slot), 1, in) != 1)
+				goto out;
+			if (record->slot.id == 0 || record->slot.id > header.tracepoints ||
+			    record->slot.len > sizeof(record->slot.data))
+				continue;
+			record->tid = file_ring.tid;
+			count += 1;
+		}
+	}
+
+	qsort(records, count, sizeof(*records), trace_decoded_cmp);
+
+	for (i = 0; i < count; ++i) {
+		record = &records[i];
+		fmt = table[record->slot.id];
+		realtime = header.realtime - (header.monotonic - record->slot.time);
+
+		fprintf(out, "%llu.%09llu %u %s:%d %s [%p] - ",
+			(unsigned long long)(realtime / 1000000000),
+			(unsigned long long)(realtime % 1000000000),
+			record->tid, fmt->file, fmt->line, fmt->func,
+			(void *)(uintptr_t)record->slot.context);
+		trace_print_message(out, fmt->format, &record->slot);
+		fputc('\n', out);
+	}
+
+	result = 0;
+
+out:
+	if (result)
+		fprintf(stderr, "Truncated trace file\n");
+
+	for (i = 0; i <= header.tracepoints; ++i) {
+		if (!table[i])
+			continue;
+		free((char *)table[i]->file);
+		free((char *)table[i]->func);
+		free((char *)table[i]->format);
+		free(table[i]);
+	}
+	free(table);
+	free(records);
+
+	return result;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Helpers for bitmaps stored in 64 bit words. Bit n lives in word n / 64 at
+ * position n % 64, so a word can be scanned with bitmap_first() and
+ * bitmap_drop_first() instead of testing every bit.
+ */
+
+#define BITMAP_WORDS(bits) (((bits) + 63) / 64)
+
+static inline void bitmap_set(uint64_t *map, uint32_t bit)
+{
+	map[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+static inline void bitmap_clear(uint64_t *map, uint32_t bit)
+{
+	map[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+}
+
+static inline int bitmap_test(const uint64_t *map, uint32_t bit)
+{
+	return (map[bit / 64] >> (bit % 64)) & 1;
+}
+
+/**
+ * bitmap_range() - Mask of the bits [@from, @to) of a word
+ * @from: first bit, smaller than @to
+ * @to: bit after the last bit, at most 64
+ */
+static inline uint64_t bitmap_range(uint32_t from, uint32_t to)
+{
+	uint64_t upper = to == 64 ? ~(uint64_t)0 : ((uint64_t)1 << to) - 1;
+	return upper & ~(((uint64_t)1 << from) - 1);
+}
+
+/**
+ * bitmap_first() - Position of the lowest set bit of a non-zero word
+ */
+static inline uint32_t bitmap_first(uint64_t word)
+{
+	return (uint32_t)__builtin_ctzll(word);
+}
+
+/**
+ * bitmap_drop_first() - Clear the lowest set bit of a word
+ */
+static inline uint64_t bitmap_drop_first(uint64_t word)
+{
+	return word & (word - 1);
+}
+
+/**
+ * bitmap_load() - Read a word of a byte oriented bitmap
+ * @bytes: bitmap where bit n is stored as (1 << n % 8) in byte n / 8
+ * @len: length of @bytes
+ * @word: index of the 64 bit word to read
+ *
+ * Bytes beyond @len read as zero, so the last word of a short bitmap can be
+ * read without overrunning the packet.
+ */
+static inline uint64_t bitmap_load(const uint8_t *bytes, size_t len, uint32_t word)
+{
+	size_t start = (size_t)word * 8;
+	uint64_t result = 0;
+
+	for (size_t i = 0; i < 8 && start + i < len; ++i) {
+		result |= (uint64_t)bytes[start + i] << (8 * i);
+	}
+
+	return result;
+}
+
+/**
+ * bitmap_store() - Merge a word into a byte oriented bitmap
+ * @bytes: bitmap in the layout of bitmap_load()
+ * @len: length of @bytes
+ * @word: index of the 64 bit word to write
+ * @value: bits to set, bits beyond @len are dropped
+ */
+static inline void bitmap_store(uint8_t *bytes, size_t len, uint32_t word, uint64_t value)
+{
+	size_t start = (size_t)word * 8;
+
+	for (size_t i = 0; i < 8 && start + i < len; ++i) {
+		bytes[start + i] |= (uint8_t)(value >> (8 * i));
+	}
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_pool.h"
+
+void buffer_pool_init(struct buffer_pool *pool, size_t size, uint32_t capacity)
+{
+	pool->size = size;
+	pool->count = 0;
+	pool->capacity = capacity;
+	pool->buffers = calloc(capacity, sizeof(*pool->buffers));
+}
+
+void buffer_pool_free(struct buffer_pool *pool)
+{
+	while (pool->count > 0) {
+		free(pool->buffers[--pool->count]);
+	}
+
+	free(pool->buffers);
+	memset(pool, 0, sizeof(*pool));
+}
+
+void *buffer_pool_get(struct buffer_pool *pool)
+{
+	void *buffer;
+
+	if (pool->count == 0) {
+		return calloc(1, pool->size);
+	}
+
+	buffer = pool->buffers[--pool->count];
+	memset(buffer, 0, pool->size);
+	return buffer;
+}
+
+void buffer_pool_put(struct buffer_pool *pool, void *buffer)
+{
+	if (buffer == NULL) {
+		return;
+	}
+
+	if (pool->count == pool->capacity) {
+		free(buffer);
+		return;
+	}
+
+	pool->buffers[pool->count++] = buffer;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * struct buffer_pool - free list of equally sized buffers
+ * @size: size of every buffer in bytes
+ * @count: number of idle buffers in the pool
+ * @capacity: maximum number of idle buffers kept in the pool
+ * @buffers: idle buffers
+ *
+ * Generations are created and retired at the same rate, so a few idle
+ * buffers are enough to serve every new generation without going through
+ * the allocator. Buffers returned to a full pool are freed.
+ */
+struct buffer_pool {
+	size_t size;
+	uint32_t count;
+	uint32_t capacity;
+	void **buffers;
+};
+
+/**
+ * buffer_pool_init() - Create an empty pool
+ * @pool: buffer_pool object to initialize
+ * @size: size of every buffer in bytes
+ * @capacity: maximum number of idle buffers kept in the pool
+ */
+void buffer_pool_init(struct buffer_pool *pool, size_t size, uint32_t capacity);
+
+/**
+ * buffer_pool_free() - Free the pool and all idle buffers
+ * @pool: buffer_pool object to free
+ */
+void buffer_pool_free(struct buffer_pool *pool);
+
+/**
+ * buffer_pool_get() - Take a zeroed buffer from the pool
+ * @pool: buffer_pool object to use
+ *
+ * A new buffer is allocated if the pool is empty.
+ *
+ * Return: a buffer of @pool->size bytes
+ */
+void *buffer_pool_get(struct buffer_pool *pool);
+
+/**
+ * buffer_pool_put() - Give a buffer back to the pool
+ * @pool: buffer_pool object to use
+ * @buffer: buffer from buffer_pool_get(), may be NULL
+ */
+void buffer_pool_put(struct buffer_pool *pool, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,228 @@
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "congestion.h"
+#include "../private.h"
+
+/* window used before the first round trip time was measured */
+#define CONGESTION_INITIAL_WINDOW 10
+/* the startup doubles the delivery rate every round trip */
+#define CONGESTION_HIGH_GAIN 2.885
+/* the startup ends after this many rounds without 25% more bandwidth */
+#define CONGESTION_FULL_BW_ROUNDS 3
+#define CONGESTION_FULL_BW_GROWTH 1.25
+/* window gain while probing, leaves room for delayed feedback */
+#define CONGESTION_WINDOW_GAIN 2.0
+/* the minimum round trip time is measured again after this many seconds */
+#define CONGESTION_MIN_RTT_EXPIRY 10
+
+static const double congestion_gain_cycle[] = { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+#define CONGESTION_GAIN_CYCLE_LEN (sizeof(congestion_gain_cycle) / sizeof(congestion_gain_cycle[0]))
+
+static double timeval_seconds(const struct timeval *tv)
+{
+	return tv->tv_sec + tv->tv_usec / 1000000.0;
+}
+
+static double congestion_max_bw(const struct congestion_control *cc)
+{
+	double result = 0;
+
+	for (int i = 0; i < CONGESTION_BW_ROUNDS; ++i) {
+		result = max_t(double, result, cc->bw[i]);
+	}
+
+	return result;
+}
+
+/* bandwidth-delay product in packets */
+static double congestion_bdp(const struct congestion_control *cc)
+{
+	return congestion_max_bw(cc) * timeval_seconds(&cc->min_rtt);
+}
+
+static void congestion_enter_startup(struct congestion_control *cc)
+{
+	cc->mode = CONGESTION_STARTUP;
+	cc->full_bw = 0;
+	cc->full_bw_rounds = 0;
+	cc->pacing_gain = CONGESTION_HIGH_GAIN;
+	cc->window_gain = CONGESTION_HIGH_GAIN;
+}
+
+static void congestion_enter_probe_bw(struct congestion_control *cc, const struct timeval *now)
+{
+	cc->mode = CONGESTION_PROBE_BW;
+	// start cruising, probing for more right after the drain would
+	// build up the queue again
+	cc->cycle_index = 2;
+	cc->cycle_stamp = *now;
+	cc->pacing_gain = congestion_gain_cycle[cc->cycle_index];
+	cc->window_gain = CONGESTION_WINDOW_GAIN;
+}
+
+static void congestion_update_mode(struct congestion_control *cc, bool round_start,
+				   const struct timeval *now)
+{
+	struct timeval elapsed;
+	double bw;
+
+	switch (cc->mode) {
+	case CONGESTION_STARTUP:
+		if (!round_start)
+			break;
+
+		bw = congestion_max_bw(cc);
+		if (bw >= cc->full_bw * CONGESTION_FULL_BW_GROWTH) {
+			cc->full_bw = bw;
+			cc->full_bw_rounds = 0;
+		} else if (++cc->full_bw_rounds >= CONGESTION_FULL_BW_ROUNDS) {
+			cc->mode = CONGESTION_DRAIN;
+			cc->pacing_gain = 1 / CONGESTION_HIGH_GAIN;
+			cc->window_gain = CONGESTION_HIGH_GAIN;
+		}
+		break;
+	case CONGESTION_DRAIN:
+		if (congestion_in_flight(cc) <= congestion_bdp(cc))
+			congestion_enter_probe_bw(cc, now);
+		break;
+	case CONGESTION_PROBE_BW:
+		timersub(now, &cc->cycle_stamp, &elapsed);
+		// a phase lasts one round trip, the draining phase ends early
+		// once the queue it is meant to drain is gone
+		if (timercmp(&elapsed, &cc->min_rtt, >) ||
+		    (cc->pacing_gain < 1 && congestion_in_flight(cc) <= congestion_bdp(cc))) {
+			cc->cycle_index = (cc->cycle_index + 1) % CONGESTION_GAIN_CYCLE_LEN;
+			cc->cycle_stamp = *now;
+			cc->pacing_gain = congestion_gain_cycle[cc->cycle_index];
+		}
+		break;
+	}
+}
+
+void congestion_init(struct congestion_control *cc, uint32_t packet_size, uint32_t min_window)
+{
+	memset(cc, 0, sizeof(*cc));
+
+	cc->packet_size = packet_size;
+	cc->min_window = max_t(uint32_t, min_window, 1);
+	congestion_enter_startup(cc);
+}
+
+void congestion_sent(struct congestion_control *cc, uint16_t packet_no, const struct timeval *now)
+{
+	struct congestion_packet *packet = &cc->packets[packet_no % CONGESTION_HISTORY];
+
+	if (congestion_in_flight(cc) == 0) {
+		// nothing is outstanding, so we can follow any packet numbering
+		cc->acked_no = packet_no - 1;
+		cc->round_end = packet_no;
+	}
+
+	if (!timerisset(&cc->delivered_time))
+		cc->delivered_time = *now;
+
+	cc->sent_no = packet_no;
+	packet->sent = *now;
+	packet->delivered = cc->delivered;
+	packet->delivered_time = cc->delivered_time;
+}
+
+void congestion_feedback(struct congestion_control *cc, uint16_t packet_no, uint8_t received,
+			 const struct timeval *now)
+{
+	struct congestion_packet *packet = &cc->packets[packet_no % CONGESTION_HISTORY];
+	struct timeval rtt, interval, age;
+	bool round_start = false;
+	double rate;
+
+	// feedback for packets we did not send yet is bogus
+	if ((int16_t)(packet_no - cc->sent_no) > 0)
+		return;
+
+	// reordered or repeated feedback carries no new information
+	if ((int16_t)(packet_no - cc->acked_no) <= 0)
+		return;
+
+	if (cc->fb_valid)
+		cc->delivered += (uint8_t)(received - cc->received);
+	else
+		cc->delivered += 1;
+	cc->delivered_time = *now;
+	cc->received = received;
+	cc->fb_valid = true;
+
+	if ((uint16_t)(cc->sent_no - packet_no) < CONGESTION_HISTORY) {
+		timersub(now, &packet->sent, &rtt);
+		timersub(now, &cc->min_rtt_stamp, &age);
+		if (!timerisset(&cc->min_rtt) || timercmp(&rtt, &cc->min_rtt, <) ||
+		    age.tv_sec >= CONGESTION_MIN_RTT_EXPIRY) {
+			cc->min_rtt = rtt;
+			cc->min_rtt_stamp = *now;
+		}
+
+		timersub(now, &packet->delivered_time, &interval);
+		if (timerisset(&interval)) {
+			rate = (cc->delivered - packet->delivered) / timeval_seconds(&interval);
+
+			if ((int16_t)(packet_no - cc->round_end) >= 0) {
+				cc->round += 1;
+				cc->round_end = cc->sent_no;
+				cc->bw[cc->round % CONGESTION_BW_ROUNDS] = 0;
+				round_start = true;
+			}
+
+			cc->bw[cc->round % CONGESTION_BW_ROUNDS] =
+				max_t(double, cc->bw[cc->round % CONGESTION_BW_ROUNDS], rate);
+		}
+	}
+
+	cc->acked_no = packet_no;
+	congestion_update_mode(cc, round_start, now);
+}
+
+void congestion_timeout(struct congestion_control *cc)
+{
+	// the path may have changed completely, so we forget the bandwidth
+	// and probe from the start again
+	cc->acked_no = cc->sent_no;
+	memset(cc->bw, 0, sizeof(cc->bw));
+	congestion_enter_startup(cc);
+}
+
+uint32_t congestion_window(const struct congestion_control *cc)
+{
+	double bdp = congestion_bdp(cc);
+	uint32_t window;
+
+	if (bdp <= 0) {
+		window = max_t(uint32_t, cc->min_window, CONGESTION_INITIAL_WINDOW);
+	} else {
+		window = max_t(uint32_t, cc->min_window, (uint32_t)ceil(cc->window_gain * bdp));
+	}
+
+	// we can not take round trip samples for older packets
+	return min_t(uint32_t, window, CONGESTION_HISTORY - 1);
+}
+
+uint64_t congestion_pacing_rate(const struct congestion_control *cc)
+{
+	return (uint64_t)(cc->pacing_gain * congestion_max_bw(cc) * cc->packet_size);
+}
+
+void congestion_timeout_delay(const struct congestion_control *cc, struct timeval *delay)
+{
+	struct timeval minimum = { .tv_sec = 0, .tv_usec = 200000 };
+
+	if (!timerisset(&cc->min_rtt)) {
+		*delay = (struct timeval){ .tv_sec = 1, .tv_usec = 0 };
+		return;
+	}
+
+	// feedback is often delayed by the receiver, so we give it plenty of time
+	timeradd(&cc->min_rtt, &cc->min_rtt, delay);
+	timeradd(delay, delay, delay);
+	if (timercmp(delay, &minimum, <))
+		*delay = minimum;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/time.h>
+
+/*
+ * Number of sent packets whose send time is remembered, the in-flight window
+ * can not grow beyond this. Must be a power of 2 that divides 2^16, so that
+ * the 16 bit packet numbers can be used as index.
+ */
+#define CONGESTION_HISTORY 1024
+/* number of round trips the bandwidth maximum filter covers */
+#define CONGESTION_BW_ROUNDS 10
+
+/**
+ * enum congestion_mode - phase of the congestion controller
+ * @CONGESTION_STARTUP: grow the sending rate exponentially until the
+ *  bandwidth estimate stops growing
+ * @CONGESTION_DRAIN: drain the queue that was built up during startup
+ * @CONGESTION_PROBE_BW: send at the estimated bandwidth and periodically
+ *  probe for more
+ */
+enum congestion_mode {
+	CONGESTION_STARTUP,
+	CONGESTION_DRAIN,
+	CONGESTION_PROBE_BW,
+};
+
+/**
+ * struct congestion_packet - state remembered for every sent packet
+ * @sent: time when the packet was sent
+ * @delivered: value of congestion_control.delivered when the packet was sent
+ * @delivered_time: value of congestion_control.delivered_time when the
+ *  packet was sent
+ */
+struct congestion_packet {
+	struct timeval sent;
+	uint32_t delivered;
+	struct timeval delivered_time;
+};
+
+/**
+ * struct congestion_control - bandwidth and round trip time model
+ * @packet_size: size of a packet in bytes, used for the pacing rate
+ * @min_window: lower bound of the in-flight window in packets
+ * @mode: current phase, see enum congestion_mode
+ * @sent_no: packet number of the last sent packet
+ * @acked_no: newest packet number echoed by the receiver
+ * @received: last reception counter reported by the receiver, modulo 256
+ * @fb_valid: whether @acked_no and @received were initialized by a feedback
+ * @delivered: total number of packets known to be delivered
+ * @delivered_time: time when @delivered was last increased
+ * @round: number of round trips seen so far
+ * @round_end: packet number whose acknowledgement ends the current round
+ * @bw: delivery rate maximum per round in packets per second
+ * @full_bw: bandwidth seen when the startup last made progress
+ * @full_bw_rounds: rounds in startup without significant bandwidth growth
+ * @min_rtt: smallest round trip time seen in the last 10 seconds
+ * @min_rtt_stamp: time when @min_rtt was measured
+ * @cycle_index: position in the gain cycle of CONGESTION_PROBE_BW
+ * @cycle_stamp: time when the current gain cycle phase was entered
+ * @pacing_gain: factor applied to the bandwidth for the pacing rate
+ * @window_gain: factor applied to the bandwidth-delay product for the window
+ * @packets: send times of the recently sent packets
+ *
+ * The model follows BBR: the bottleneck bandwidth is the maximum delivery
+ * rate over the last CONGESTION_BW_ROUNDS round trips and the propagation
+ * delay is the minimum round trip time. Their product is the amount of data
+ * the path can hold without building a queue. The receiver only reports the
+ * newest packet number it saw and a counter of received packets, so losses
+ * leave the in-flight window once a later packet is acknowledged.
+ */
+struct congestion_control {
+	uint32_t packet_size;
+	uint32_t min_window;
+	enum congestion_mode mode;
+
+	uint16_t sent_no;
+	uint16_t acked_no;
+	uint8_t received;
+	bool fb_valid;
+
+	uint32_t delivered;
+	struct timeval delivered_time;
+
+	uint32_t round;
+	uint16_t round_end;
+	double bw[CONGESTION_BW_ROUNDS];
+	double full_bw;
+	int full_bw_rounds;
+
+	struct timeval min_rtt;
+	struct timeval min_rtt_stamp;
+
+	int cycle_index;
+	struct timeval cycle_stamp;
+	double pacing_gain;
+	double window_gain;
+
+	struct congestion_packet packets[CONGESTION_HISTORY];
+};
+
+/**
+ * congestion_init() - Initialize a congestion controller in startup
+ * @cc: congestion controller to initialize
+ * @packet_size: size of a packet in bytes
+ * @min_window: lower bound of the in-flight window in packets
+ */
+void congestion_init(struct congestion_control *cc, uint32_t packet_size, uint32_t min_window);
+
+/**
+ * congestion_sent() - Account for a sent packet
+ * @cc: congestion controller to update
+ * @packet_no: packet number of the sent packet
+ * @now: current time
+ */
+void congestion_sent(struct congestion_control *cc, uint16_t packet_no, const struct timeval *now);
+
+/**
+ * congestion_feedback() - Update the model from a feedback packet
+ * @cc: congestion controller to update
+ * @packet_no: newest packet number seen by the receiver
+ * @received: number of packets received by the receiver, modulo 256
+ * @now: current time
+ */
+void congestion_feedback(struct congestion_control *cc, uint16_t packet_no, uint8_t received,
+			 const struct timeval *now);
+
+/**
+ * congestion_timeout() - Handle a missing feedback
+ * @cc: congestion controller to update
+ *
+ * Considers all packets in flight as lost and starts probing again.
+ */
+void congestion_timeout(struct congestion_control *cc);
+
+/**
+ * congestion_window() - Number of packets that may be in flight
+ * @cc: congestion controller to query
+ */
+uint32_t congestion_window(const struct congestion_control *cc);
+
+/**
+ * congestion_pacing_rate() - Rate at which packets should be sent
+ * @cc: congestion controller to query
+ *
+ * Return: rate in bytes per second, 0 if there is no bandwidth estimate yet
+ */
+uint64_t congestion_pacing_rate(const struct congestion_control *cc);
+
+/**
+ * congestion_timeout_delay() - Time without feedback after which congestion_timeout() should be called
+ * @cc: congestion controller to query
+ * @delay: updated to contain the delay
+ */
+void congestion_timeout_delay(const struct congestion_control *cc, struct timeval *delay);
+
+/**
+ * congestion_in_flight() - Number of packets that were sent but not yet acknowledged
+ * @cc: congestion controller to query
+ */
+static __inline__ uint32_t congestion_in_flight(const struct congestion_control *cc)
+{
+	return (uint16_t)(cc->sent_no - cc->acked_no);
+}
+
+/**
+ * congestion_allowed() - Check if another packet may be sent
+ * @cc: congestion controller to query
+ */
+static __inline__ bool congestion_allowed(const struct congestion_control *cc)
+{
+	return congestion_in_flight(cc) < congestion_window(cc);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
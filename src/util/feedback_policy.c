@@ -0,0 +1,113 @@
+#include <string.h>
+
+#include "feedback_policy.h"
+#include "../private.h"
+
+static void feedback_policy_release(struct nck_timer_entry *entry, void *context, int success)
+{
+	UNUSED(entry);
+
+	struct feedback_policy *fp = (struct feedback_policy *)context;
+	if (success && fp->pending) {
+		fp->pending = false;
+		nck_trigger_call(&fp->on_release);
+	}
+}
+
+static bool feedback_policy_interval_passed(const struct feedback_policy *fp,
+					    const struct timeval *since, struct timeval *remaining)
+{
+	struct timeval now, deadline;
+
+	if (!fp->timer || !timerisset(&fp->min_interval))
+		return true;
+
+	nck_timer_gettime(fp->timer, &now);
+	timeradd(since, &fp->min_interval, &deadline);
+	if (!timercmp(&now, &deadline, <))
+		return true;
+
+	if (remaining)
+		timersub(&deadline, &now, remaining);
+	return false;
+}
+
+void feedback_policy_init(struct feedback_policy *fp, struct nck_timer *timer)
+{
+	memset(fp, 0, sizeof(*fp));
+
+	fp->timer = timer;
+	fp->release = nck_timer_add(timer, NULL, fp, feedback_policy_release);
+	nck_trigger_init(&fp->on_release);
+}
+
+void feedback_policy_free(struct feedback_policy *fp)
+{
+	nck_timer_cancel(fp->release);
+	nck_timer_free(fp->release);
+	fp->release = NULL;
+}
+
+void feedback_policy_reset(struct feedback_policy *fp)
+{
+	nck_timer_cancel(fp->release);
+
+	fp->packets = 0;
+	timerclear(&fp->last);
+	timerclear(&fp->last_gap);
+	fp->pending = false;
+}
+
+bool feedback_policy_packet(struct feedback_policy *fp)
+{
+	fp->packets += 1;
+
+	if (!fp->pending || fp->packets < fp->min_packets)
+		return false;
+
+	if (!feedback_policy_interval_passed(fp, &fp->last, NULL))
+		return false;
+
+	fp->pending = false;
+	nck_timer_cancel(fp->release);
+	return true;
+}
+
+bool feedback_policy_request(struct feedback_policy *fp, enum feedback_reason reason)
+{
+	struct timeval remaining = fp->min_interval;
+
+	switch (reason) {
+	case FEEDBACK_REASON_FLUSH:
+		return true;
+	case FEEDBACK_REASON_GAP:
+		// one loss report per interval may skip the queue
+		if (fp->on_gap && feedback_policy_interval_passed(fp, &fp->last_gap, NULL)) {
+			if (fp->timer)
+				nck_timer_gettime(fp->timer, &fp->last_gap);
+			return true;
+		}
+		break;
+	case FEEDBACK_REASON_NORMAL:
+		break;
+	}
+
+	if (fp->packets >= fp->min_packets &&
+	    feedback_policy_interval_passed(fp, &fp->last, &remaining))
+		return true;
+
+	fp->pending = true;
+	if (timerisset(&remaining) && !nck_timer_pending(fp->release))
+		nck_timer_rearm(fp->release, &remaining);
+
+	return false;
+}
+
+void feedback_policy_sent(struct feedback_policy *fp)
+{
+	fp->packets = 0;
+	fp->pending = false;
+	if (fp->timer)
+		nck_timer_gettime(fp->timer, &fp->last);
+	nck_timer_cancel(fp->release);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/time.h>
+
+#include <nckernel/nckernel.h>
+#include <nckernel/timer.h>
+
+/**
+ * enum feedback_reason - why a decoder wants to send feedback
+ * @FEEDBACK_REASON_NORMAL: the encoder requested it or the decoder state changed
+ * @FEEDBACK_REASON_GAP: a packet was lost since the previous one
+ * @FEEDBACK_REASON_FLUSH: the encoder has nothing more to send and waits
+ */
+enum feedback_reason {
+	FEEDBACK_REASON_NORMAL,
+	FEEDBACK_REASON_GAP,
+	FEEDBACK_REASON_FLUSH,
+};
+
+/**
+ * struct feedback_policy - coalescing of feedback packets
+ * @min_interval: minimum time between two feedback packets, ignored without @timer
+ * @min_packets: minimum number of received packets between two feedback packets
+ * @on_gap: whether a loss may bypass the limits, at most once per @min_interval
+ * @packets: packets received since the last feedback
+ * @last: time when the last feedback was sent
+ * @last_gap: time when the last feedback for a loss was allowed
+ * @pending: whether a feedback was held back
+ * @timer: timer used as clock and to release a held back feedback
+ * @release: timer entry that releases a held back feedback
+ * @on_release: trigger that is called when a held back feedback may be sent
+ *
+ * A decoder asks the policy with feedback_policy_request() whenever it would
+ * raise feedback. If the request is held back, the @on_release trigger fires
+ * once @min_interval has passed since the last feedback, so a held back
+ * feedback is delayed by at most one interval. Without @min_interval it is
+ * released by later packets once @min_packets is reached. A flush request is
+ * never held back, because the encoder waits for it.
+ */
+struct feedback_policy {
+	struct timeval min_interval;
+	uint32_t min_packets;
+	bool on_gap;
+
+	uint32_t packets;
+	struct timeval last;
+	struct timeval last_gap;
+	bool pending;
+
+	struct nck_timer *timer;
+	struct nck_timer_entry *release;
+	struct nck_trigger on_release;
+};
+
+/**
+ * feedback_policy_init() - Initialize a policy that allows every feedback
+ * @fp: policy to initialize
+ * @timer: timer for the clock and the release of held back feedback, may be NULL
+ */
+void feedback_policy_init(struct feedback_policy *fp, struct nck_timer *timer);
+
+/**
+ * feedback_policy_free() - Free the resources used by the policy
+ * @fp: policy to free
+ */
+void feedback_policy_free(struct feedback_policy *fp);
+
+/**
+ * feedback_policy_reset() - Forget the feedback history, keeping the limits
+ * @fp: policy to reset
+ */
+void feedback_policy_reset(struct feedback_policy *fp);
+
+/**
+ * feedback_policy_packet() - Count a received packet
+ * @fp: policy to update
+ *
+ * Return: true if a held back feedback may be sent now
+ */
+bool feedback_policy_packet(struct feedback_policy *fp);
+
+/**
+ * feedback_policy_request() - Ask whether a feedback may be sent now
+ * @fp: policy to ask
+ * @reason: why the feedback is wanted
+ *
+ * Return: true if the feedback may be sent now; false if it was held back
+ */
+bool feedback_policy_request(struct feedback_policy *fp, enum feedback_reason reason);
+
+/**
+ * feedback_policy_sent() - Account for a sent feedback
+ * @fp: policy to update
+ */
+void feedback_policy_sent(struct feedback_policy *fp);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -28,6 +28,41 @@ void binary8_region_multiply_subtract(uint8_t *dest, uint8_t *src, uint8_t facto
 	binary8->region_multiply_subtract(dest, src, factor, len);
 }
 
+void binary8_region_multiply_sum(uint8_t *dest, uint8_t **srcs, const uint8_t *factors, size_t count, size_t len)
+{
+	// process the destination in chunks that stay in L1 while all
+	// sources are accumulated into it
+	const size_t chunk = 512;
+
+	for (size_t offset = 0; offset < len; offset += chunk) {
+		size_t n = len - offset < chunk ? len - offset : chunk;
+		for (size_t i = 0; i < count; ++i) {
+			if (factors[i]) {
+				binary8->region_multiply_add(dest + offset, srcs[i] + offset, factors[i], n);
+			}
+		}
+	}
+}
+
+void binary8_region_multiply_sum_batch(uint8_t **dests, size_t dest_count, uint8_t **srcs, const uint8_t *factors, size_t count, size_t len)
+{
+	// every source chunk is loaded once and added to all destinations
+	// while it is still in L1, factors holds count entries per destination
+	const size_t chunk = 512;
+
+	for (size_t offset = 0; offset < len; offset += chunk) {
+		size_t n = len - offset < chunk ? len - offset : chunk;
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t d = 0; d < dest_count; ++d) {
+				uint8_t factor = factors[d * count + i];
+				if (factor) {
+					binary8->region_multiply_add(dests[d] + offset, srcs[i] + offset, factor, n);
+				}
+			}
+		}
+	}
+}
+
 uint8_t binary8_add(uint8_t a, uint8_t b)
 {
 	return binary8->add(a, b);
@@ -8,6 +8,8 @@ void binary8_init();
 void binary8_region_multiply(uint8_t *dst, uint8_t factor, size_t len);
 void binary8_region_multiply_add(uint8_t *dest, uint8_t *src, uint8_t factor, size_t len);
 void binary8_region_multiply_subtract(uint8_t *dest, uint8_t *src, uint8_t factor, size_t len);
+void binary8_region_multiply_sum(uint8_t *dest, uint8_t **srcs, const uint8_t *factors, size_t count, size_t len);
+void binary8_region_multiply_sum_batch(uint8_t **dests, size_t dest_count, uint8_t **srcs, const uint8_t *factors, size_t count, size_t len);
 uint8_t binary8_add(uint8_t a, uint8_t b);
 uint8_t binary8_subtract(uint8_t left, uint8_t right);
 uint8_t binary8_multiply(uint8_t a, uint8_t b);
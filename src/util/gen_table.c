@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen_table.h"
+
+static uint32_t gen_table_slot(const struct gen_table *table, uint32_t generation)
+{
+	return generation & (table->size - 1);
+}
+
+static void gen_table_resize(struct gen_table *table, uint32_t size)
+{
+	void **entries;
+	uint32_t gen;
+
+	entries = calloc(size, sizeof(*entries));
+
+	if (table->count > 0) {
+		for (gen = table->oldest; gen - table->oldest <= table->newest - table->oldest; ++gen) {
+			entries[gen & (size - 1)] = table->entries[gen_table_slot(table, gen)];
+		}
+	}
+
+	free(table->entries);
+	table->entries = entries;
+	table->size = size;
+}
+
+void gen_table_init(struct gen_table *table, uint32_t capacity)
+{
+	uint32_t size = 8;
+
+	memset(table, 0, sizeof(*table));
+
+	while (size < capacity) {
+		size <<= 1;
+	}
+
+	table->size = size;
+	table->max_span = GEN_TABLE_MAX_SPAN;
+	table->entries = calloc(size, sizeof(*table->entries));
+}
+
+void gen_table_set_max_span(struct gen_table *table, uint32_t max_span)
+{
+	if (max_span < 1) {
+		max_span = 1;
+	} else if (max_span > (1u << 31)) {
+		max_span = 1u << 31;
+	}
+
+	table->max_span = max_span;
+}
+
+void gen_table_free(struct gen_table *table)
+{
+	free(table->entries);
+	memset(table, 0, sizeof(*table));
+}
+
+void *gen_table_get(const struct gen_table *table, uint32_t generation)
+{
+	if (table->count == 0 || generation - table->oldest > table->newest - table->oldest) {
+		return NULL;
+	}
+
+	return table->entries[gen_table_slot(table, generation)];
+}
+
+/* the range of the table after inserting the generation */
+static void gen_table_extend(const struct gen_table *table, uint32_t generation,
+		uint32_t *oldest, uint32_t *newest)
+{
+	if (table->count == 0) {
+		*oldest = *newest = generation;
+		return;
+	}
+
+	*oldest = table->oldest;
+	*newest = table->newest;
+
+	if (gen_before(generation, table->oldest)) {
+		*oldest = generation;
+	} else if (gen_before(table->newest, generation)) {
+		*newest = generation;
+	}
+}
+
+int gen_table_fits(const struct gen_table *table, uint32_t generation)
+{
+	uint32_t oldest, newest;
+
+	gen_table_extend(table, generation, &oldest, &newest);
+
+	/* a generation 2^31 or more ahead wraps to a huge span */
+	return newest - oldest < table->max_span;
+}
+
+int gen_table_insert(struct gen_table *table, uint32_t generation, void *entry)
+{
+	uint32_t oldest, newest, size;
+
+	assert(entry != NULL);
+
+	if (!gen_table_fits(table, generation)) {
+		return -1;
+	}
+
+	gen_table_extend(table, generation, &oldest, &newest);
+
+	if (newest - oldest >= table->size) {
+		size = table->size;
+		while (newest - oldest >= size) {
+			size <<= 1;
+		}
+		gen_table_resize(table, size);
+	}
+
+	assert(gen_table_get(table, generation) == NULL);
+
+	table->entries[gen_table_slot(table, generation)] = entry;
+	table->oldest = oldest;
+	table->newest = newest;
+	table->count += 1;
+
+	return 0;
+}
+
+void gen_table_remove(struct gen_table *table, uint32_t generation)
+{
+	if (gen_table_get(table, generation) == NULL) {
+		return;
+	}
+
+	table->entries[gen_table_slot(table, generation)] = NULL;
+	table->count -= 1;
+
+	if (table->count == 0) {
+		return;
+	}
+
+	/* shrink the range to the remaining entries */
+	while (table->entries[gen_table_slot(table, table->oldest)] == NULL) {
+		table->oldest += 1;
+	}
+	while (table->entries[gen_table_slot(table, table->newest)] == NULL) {
+		table->newest -= 1;
+	}
+}
+
+void *gen_table_oldest(const struct gen_table *table)
+{
+	if (table->count == 0) {
+		return NULL;
+	}
+
+	return table->entries[gen_table_slot(table, table->oldest)];
+}
+
+void *gen_table_newest(const struct gen_table *table)
+{
+	if (table->count == 0) {
+		return NULL;
+	}
+
+	return table->entries[gen_table_slot(table, table->newest)];
+}
+
+void *gen_table_next(const struct gen_table *table, uint32_t *generation)
+{
+	uint32_t gen;
+	void *entry;
+
+	if (table->count == 0 || !gen_before(*generation, table->newest)) {
+		return NULL;
+	}
+
+	gen = gen_before(*generation, table->oldest) ? table->oldest : *generation + 1;
+	for ( ; !gen_before(table->newest, gen); ++gen) {
+		entry = table->entries[gen_table_slot(table, gen)];
+		if (entry != NULL) {
+			*generation = gen;
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+void *gen_table_first(const struct gen_table *table, uint32_t *generation)
+{
+	if (table->count == 0) {
+		return NULL;
+	}
+
+	*generation = table->oldest;
+	return table->entries[gen_table_slot(table, table->oldest)];
+}
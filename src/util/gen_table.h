@@ -0,0 +1,160 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Default for the largest distance between the oldest and the newest
+ * generation in a table. Coders lower it with gen_table_set_max_span().
+ */
+#define GEN_TABLE_MAX_SPAN (1u << 20)
+
+/*
+ * gen_before - compare two generations in serial number arithmetic
+ *
+ * Generations wrap around at 2^32, @a is before @b if it is less than 2^31
+ * generations behind it.
+ */
+#define gen_before(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
+/**
+ * struct gen_table - generation indexed ring of containers
+ * @size: number of slots, always a power of two
+ * @count: number of stored entries
+ * @oldest: generation of the oldest entry, only valid if @count > 0
+ * @newest: generation of the newest entry, only valid if @count > 0
+ * @max_span: limit for the distance between @oldest and @newest
+ * @entries: slots, the entry of generation g is stored at g & (@size - 1)
+ *
+ * The distance between @oldest and @newest is always smaller than @size, so
+ * every stored generation owns a distinct slot. Lookup, insertion and
+ * removal are O(1). The ring is enlarged when a generation would not fit,
+ * up to @max_span. Generations are compared with gen_before(), so the
+ * table keeps working when they wrap around.
+ */
+struct gen_table {
+	uint32_t size;
+	uint32_t count;
+	uint32_t oldest;
+	uint32_t newest;
+	uint32_t max_span;
+	void **entries;
+};
+
+/**
+ * gen_table_init() - Allocate an empty table
+ * @table: gen_table object to initialize
+ * @capacity: expected number of generations in flight
+ */
+void gen_table_init(struct gen_table *table, uint32_t capacity);
+
+/**
+ * gen_table_free() - Release the slots of a table
+ * @table: gen_table object to free
+ *
+ * The entries themselves are owned by the caller and are not freed.
+ */
+void gen_table_free(struct gen_table *table);
+
+/**
+ * gen_table_set_max_span() - Limit the generations stored at the same time
+ * @table: gen_table object to modify
+ * @max_span: largest distance between the oldest and the newest generation
+ *            plus one, at least 1 and at most 2^31
+ *
+ * Coders use the number of containers they keep, so a single packet with a
+ * bogus generation can not enlarge the ring beyond that.
+ */
+void gen_table_set_max_span(struct gen_table *table, uint32_t max_span);
+
+/**
+ * gen_table_fits() - Check whether a generation can be inserted
+ * @table: gen_table object to check
+ * @generation: generation to check
+ *
+ * Return: 1 if storing @generation keeps the table within its span
+ */
+int gen_table_fits(const struct gen_table *table, uint32_t generation);
+
+/**
+ * gen_table_get() - Look up the entry of a generation
+ * @table: gen_table object to search
+ * @generation: generation to look up
+ *
+ * Return: the entry or NULL if the generation is not stored
+ */
+void *gen_table_get(const struct gen_table *table, uint32_t generation);
+
+/**
+ * gen_table_insert() - Store the entry of a generation
+ * @table: gen_table object to modify
+ * @generation: generation of the entry, must not be stored yet
+ * @entry: entry to store, must not be NULL
+ *
+ * Return: 0 on success, -1 if the generation is out of the span of the
+ * table, see gen_table_fits()
+ */
+int gen_table_insert(struct gen_table *table, uint32_t generation, void *entry);
+
+/**
+ * gen_table_remove() - Remove the entry of a generation
+ * @table: gen_table object to modify
+ * @generation: generation to remove
+ */
+void gen_table_remove(struct gen_table *table, uint32_t generation);
+
+/**
+ * gen_table_oldest() - Get the entry with the smallest generation
+ * @table: gen_table object to use
+ *
+ * Return: the entry or NULL if the table is empty
+ */
+void *gen_table_oldest(const struct gen_table *table);
+
+/**
+ * gen_table_newest() - Get the entry with the largest generation
+ * @table: gen_table object to use
+ *
+ * Return: the entry or NULL if the table is empty
+ */
+void *gen_table_newest(const struct gen_table *table);
+
+/**
+ * gen_table_next() - Get the next entry in ascending generation order
+ * @table: gen_table object to use
+ * @generation: generation to start after, set to the generation of the
+ *              returned entry
+ *
+ * Return: the entry or NULL if there is no larger generation
+ */
+void *gen_table_next(const struct gen_table *table, uint32_t *generation);
+
+/**
+ * gen_table_first() - Start an iteration in ascending generation order
+ * @table: gen_table object to use
+ * @generation: set to the generation of the returned entry
+ *
+ * Return: the oldest entry or NULL if the table is empty
+ */
+void *gen_table_first(const struct gen_table *table, uint32_t *generation);
+
+/**
+ * gen_table_for_each - iterate over all entries in ascending generation order
+ * @table: gen_table object to iterate
+ * @gen: uint32_t that holds the generation of the current entry
+ * @entry: pointer that holds the current entry
+ *
+ * The current entry may be removed from the table inside the loop.
+ */
+#define gen_table_for_each(table, gen, entry) \
+	for ((entry) = gen_table_first((table), &(gen)); \
+	     (entry) != NULL; \
+	     (entry) = gen_table_next((table), &(gen)))
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,10 +10,13 @@ extern "C" {
 /**
  * enum rate_control_algo - selected rate control algorithm
  * @RATE_CONTROL_DUAL: dual phase with explicit source/coded phase
+ * @RATE_CONTROL_CREDIT: credit based with fixed redundancy
+ * @RATE_CONTROL_ADAPTIVE: credit based with redundancy following the estimated loss
  */
 enum rate_control_algo {
 	RATE_CONTROL_DUAL,
 	RATE_CONTROL_CREDIT,
+	RATE_CONTROL_ADAPTIVE,
 };
 
 /**
@@ -47,6 +50,51 @@ struct rate_control_credit {
 	bool advance_use;
 };
 
+/**
+ * struct rate_control_adaptive - loss adaptive rate control structure
+ * @credit: credit scheduler whose redundancy is set from the estimate, must be
+ *  the first member so that the credit functions can operate on it
+ * @min_redundancy: lower bound for the redundancy
+ * @max_redundancy: upper bound for the redundancy
+ * @loss: smoothed erasure rate
+ * @burst: smoothed mean length of loss bursts
+ */
+struct rate_control_adaptive {
+	struct rate_control_credit credit;
+	int32_t min_redundancy;
+	int32_t max_redundancy;
+	double loss;
+	double burst;
+};
+
+/* number of packet numbers remembered by struct rate_control_sent_log */
+#define RATE_CONTROL_SENT_LOG 256
+
+/**
+ * struct rate_control_sent_log - packets sent up to a packet number
+ * @packet_no: packet number of the packets counted in each slot
+ * @sent: value of @total after the last packet with @packet_no
+ * @total: number of packets sent so far
+ * @fb_sent: @sent of the packet number acknowledged by the previous feedback
+ * @fb_received: received counter of the previous feedback
+ * @fb_loss_runs: loss run counter of the previous feedback
+ * @fb_valid: whether the fb_ fields hold a feedback
+ *
+ * Coders that give the same packet number to several packets, e.g. recoders
+ * forwarding the number of the upstream packet, cannot tell from the packet
+ * numbers how many packets they sent. They count them here and compare the
+ * count with the reception counters of the feedback.
+ */
+struct rate_control_sent_log {
+	uint16_t packet_no[RATE_CONTROL_SENT_LOG];
+	uint32_t sent[RATE_CONTROL_SENT_LOG];
+	uint32_t total;
+	uint32_t fb_sent;
+	uint8_t fb_received;
+	uint8_t fb_loss_runs;
+	bool fb_valid;
+};
+
 /**
  * struct rate_control - general rate control structure
  * @dual: dual phase specific variables
@@ -56,6 +104,7 @@ struct rate_control {
 	union {
 		struct rate_control_dual dual;
 		struct rate_control_credit credit;
+		struct rate_control_adaptive adaptive;
 	};
 	enum rate_control_algo algo;
 
@@ -81,6 +130,18 @@ void rate_control_dual_reset(struct rate_control *rc, bool repair, int packets);
 void rate_control_credit_init(struct rate_control *rc, uint32_t symbols, int32_t redundancy);
 void rate_control_credit_change(struct rate_control *rc, int32_t redundancy);
 
+/* adaptive specific */
+void rate_control_adaptive_init(struct rate_control *rc, uint32_t symbols,
+				int32_t min_redundancy, int32_t max_redundancy);
+void rate_control_adaptive_change(struct rate_control *rc, int32_t min_redundancy,
+				  int32_t max_redundancy);
+void rate_control_adaptive_update(struct rate_control *rc, uint32_t received,
+				  uint32_t lost, uint32_t bursts);
+void rate_control_sent_log_reset(struct rate_control_sent_log *log);
+void rate_control_sent_log_add(struct rate_control_sent_log *log, uint16_t packet_no);
+void rate_control_sent_log_feedback(struct rate_control *rc, struct rate_control_sent_log *log,
+				    uint16_t packet_no, uint8_t received, uint8_t loss_runs);
+
 /* shared function wrapper */
 
 /**
@@ -201,6 +262,28 @@ static __inline__ bool rate_control_step(struct rate_control *rc, int source_sym
 	return rc->step(rc, source_symbols);
 }
 
+/**
+ * rate_control_restart() - Start again with the configured algorithm and parameters
+ * @rc: rate_control object to restart
+ *
+ * The adaptive redundancy also forgets its loss estimate.
+ */
+static __inline__ void rate_control_restart(struct rate_control *rc)
+{
+	switch (rc->algo) {
+	case RATE_CONTROL_DUAL:
+		rate_control_dual_init(rc, rc->dual.source_phase, rc->dual.repair_phase);
+		break;
+	case RATE_CONTROL_CREDIT:
+		rate_control_credit_init(rc, rc->credit.max_symbols, rc->credit.redundancy);
+		break;
+	case RATE_CONTROL_ADAPTIVE:
+		rate_control_adaptive_init(rc, rc->adaptive.credit.max_symbols,
+					   rc->adaptive.min_redundancy, rc->adaptive.max_redundancy);
+		break;
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
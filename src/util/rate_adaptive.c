@@ -0,0 +1,185 @@
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "rate.h"
+#include "../private.h"
+
+/*
+ * The adaptive rate control reuses the credit scheduler and only adjusts its
+ * redundancy. The loss rate and the burst length are smoothed over about
+ * ADAPTIVE_LOSS_HORIZON windows worth of packets and ADAPTIVE_BURST_HORIZON
+ * loss bursts. The estimate is capped at ADAPTIVE_MAX_LOSS, beyond that the
+ * link is unusable for coding anyway and max_redundancy applies.
+ */
+#define ADAPTIVE_LOSS_HORIZON 4
+#define ADAPTIVE_BURST_HORIZON 16
+#define ADAPTIVE_MAX_LOSS 0.9
+
+static int32_t rate_control_adaptive_target(const struct rate_control *rc)
+{
+	const struct rate_control_adaptive *adaptive = &rc->adaptive;
+	double window = adaptive->credit.max_symbols;
+	double loss = min_t(double, adaptive->loss, ADAPTIVE_MAX_LOSS);
+	double deviation, ratio;
+
+	/* With bursts of mean length b the variance of the number of losses
+	 * in a window of W packets grows to about W p (1 - p) (2b - 1). We
+	 * provision for the mean plus one standard deviation and scale by
+	 * 1 / (1 - p) because the repair packets are lost as well.
+	 */
+	deviation = sqrt(loss * (1 - loss) * (2 * adaptive->burst - 1) / window);
+	ratio = (loss + deviation) / (1 - loss);
+
+	return (int32_t)lround(ratio * window);
+}
+
+static void rate_control_adaptive_apply(struct rate_control *rc)
+{
+	struct rate_control_adaptive *adaptive = &rc->adaptive;
+	int32_t redundancy = rate_control_adaptive_target(rc);
+
+	redundancy = max_t(int32_t, redundancy, adaptive->min_redundancy);
+	redundancy = min_t(int32_t, redundancy, adaptive->max_redundancy);
+	adaptive->credit.redundancy = redundancy;
+}
+
+/**
+ * rate_control_adaptive_change() - Change the redundancy bounds
+ * @rc: rate_control object to change
+ * @min_redundancy: lowest number of repair packets per window
+ * @max_redundancy: highest number of repair packets per window
+ */
+void rate_control_adaptive_change(struct rate_control *rc, int32_t min_redundancy,
+				  int32_t max_redundancy)
+{
+	assert(rc->algo == RATE_CONTROL_ADAPTIVE);
+
+	rc->adaptive.min_redundancy = max_t(int32_t, -rc->adaptive.credit.max_symbols, min_redundancy);
+	rc->adaptive.max_redundancy = max_t(int32_t, rc->adaptive.min_redundancy, max_redundancy);
+	rate_control_adaptive_apply(rc);
+}
+
+/**
+ * rate_control_adaptive_update() - Account for an observation of the channel
+ * @rc: rate_control object to update
+ * @received: number of packets that arrived
+ * @lost: number of packets that were lost
+ * @bursts: number of separate runs the lost packets formed
+ *
+ * Observations are weighted by their size, so the caller can report every
+ * packet or whole feedback intervals.
+ */
+void rate_control_adaptive_update(struct rate_control *rc, uint32_t received,
+				  uint32_t lost, uint32_t bursts)
+{
+	struct rate_control_adaptive *adaptive = &rc->adaptive;
+	double total = (double)received + lost;
+	double weight;
+
+	assert(rc->algo == RATE_CONTROL_ADAPTIVE);
+
+	if (total == 0)
+		return;
+
+	weight = min_t(double, 1.0, total / (ADAPTIVE_LOSS_HORIZON * adaptive->credit.max_symbols));
+	adaptive->loss += weight * (lost / total - adaptive->loss);
+
+	if (bursts > 0 && lost >= bursts) {
+		weight = min_t(double, 1.0, (double)bursts / ADAPTIVE_BURST_HORIZON);
+		adaptive->burst += weight * ((double)lost / bursts - adaptive->burst);
+	}
+
+	rate_control_adaptive_apply(rc);
+}
+
+/**
+ * rate_control_adaptive_init() - Initialize rate control object with an adaptive redundancy
+ * @rc: rate_control object to initialize
+ * @symbols: number of packets in window
+ * @min_redundancy: lowest number of repair packets per window
+ * @max_redundancy: highest number of repair packets per window
+ *
+ * The scheduling is the same as for rate_control_credit_init(). The estimate
+ * starts at a loss free channel, so the redundancy starts at @min_redundancy.
+ */
+void rate_control_adaptive_init(struct rate_control *rc, uint32_t symbols,
+				int32_t min_redundancy, int32_t max_redundancy)
+{
+	rate_control_credit_init(rc, symbols, min_redundancy);
+	rc->algo = RATE_CONTROL_ADAPTIVE;
+
+	rc->adaptive.loss = 0;
+	rc->adaptive.burst = 1;
+	rate_control_adaptive_change(rc, min_redundancy, max_redundancy);
+}
+
+/**
+ * rate_control_sent_log_reset() - Forget all sent packets and feedback
+ * @log: log to reset
+ */
+void rate_control_sent_log_reset(struct rate_control_sent_log *log)
+{
+	memset(log, 0, sizeof(*log));
+}
+
+/**
+ * rate_control_sent_log_add() - Count a sent packet
+ * @log: log to update
+ * @packet_no: packet number the packet was sent with
+ */
+void rate_control_sent_log_add(struct rate_control_sent_log *log, uint16_t packet_no)
+{
+	uint32_t slot = packet_no % RATE_CONTROL_SENT_LOG;
+
+	log->total += 1;
+	log->packet_no[slot] = packet_no;
+	log->sent[slot] = log->total;
+}
+
+/**
+ * rate_control_sent_log_feedback() - Pass the reception statistics of a feedback to the rate control
+ * @rc: rate_control object to update
+ * @log: log of the sent packets
+ * @packet_no: last packet number received by the decoder
+ * @received: number of packets received by the decoder, modulo 256
+ * @loss_runs: number of loss bursts seen by the decoder, modulo 256, or 0
+ *  if the decoder cannot tell
+ *
+ * The decoder may have received any of the packets that were sent with
+ * @packet_no, all of them are counted as sent. The loss runs of the decoder
+ * are gaps in the packet numbers and can include losses before the coder, so
+ * they are limited to the losses of the interval.
+ */
+void rate_control_sent_log_feedback(struct rate_control *rc, struct rate_control_sent_log *log,
+				    uint16_t packet_no, uint8_t received, uint8_t loss_runs)
+{
+	uint32_t slot = packet_no % RATE_CONTROL_SENT_LOG;
+	uint32_t sent, lost;
+	uint8_t arrived = received - log->fb_received;
+	uint8_t bursts = loss_runs - log->fb_loss_runs;
+
+	if (rc->algo != RATE_CONTROL_ADAPTIVE)
+		return;
+
+	/* the packet number was not sent recently */
+	if (!log->sent[slot] || log->packet_no[slot] != packet_no)
+		return;
+
+	sent = log->sent[slot] - log->fb_sent;
+
+	/* reordered or repeated feedback carries no new information */
+	if (log->fb_valid && (int32_t)sent <= 0)
+		return;
+
+	/* the counters wrap after 256 packets, longer intervals are skipped */
+	if (log->fb_valid && sent < 256 && arrived <= sent) {
+		lost = sent - arrived;
+		rate_control_adaptive_update(rc, arrived, lost, min_t(uint32_t, bursts, lost));
+	}
+
+	log->fb_sent = log->sent[slot];
+	log->fb_received = received;
+	log->fb_loss_runs = loss_runs;
+	log->fb_valid = true;
+}
@@ -0,0 +1,132 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "repair_acc.h"
+#include "finite_field.h"
+
+void repair_acc_init(struct repair_acc *acc, uint32_t count, uint32_t symbols, size_t symbol_size)
+{
+	memset(acc, 0, sizeof(*acc));
+
+	if (count == 0)
+		return;
+
+	binary8_init();
+
+	acc->count = count;
+	acc->symbols = symbols;
+	acc->symbol_size = symbol_size;
+	acc->seed = rand();
+
+	acc->members = calloc(symbols, 1);
+	acc->coefficients = calloc(count, symbols);
+	acc->payloads = calloc(count, symbol_size);
+	acc->emitted = calloc(count, sizeof(*acc->emitted));
+}
+
+void repair_acc_free(struct repair_acc *acc)
+{
+	free(acc->members);
+	free(acc->coefficients);
+	free(acc->payloads);
+	free(acc->emitted);
+	memset(acc, 0, sizeof(*acc));
+}
+
+void repair_acc_reset(struct repair_acc *acc)
+{
+	if (acc->count == 0)
+		return;
+
+	memset(acc->members, 0, acc->symbols);
+	memset(acc->coefficients, 0, acc->count * acc->symbols);
+	memset(acc->payloads, 0, acc->count * acc->symbol_size);
+	memset(acc->emitted, 0, acc->count * sizeof(*acc->emitted));
+	acc->next = 0;
+	acc->entered = 0;
+	acc->consumed = 0;
+}
+
+void repair_acc_enter(struct repair_acc *acc, uint32_t index, const uint8_t *data)
+{
+	uint8_t coeff;
+
+	if (acc->count == 0 || acc->members[index])
+		return;
+
+	assert(index < acc->symbols);
+
+	for (uint32_t k = 0; k < acc->count; ++k) {
+		/* a zero coefficient would not change the accumulator */
+		coeff = 1 + rand_r(&acc->seed) % 255;
+
+		acc->coefficients[k * acc->symbols + index] = coeff;
+		binary8_region_multiply_add(&acc->payloads[k * acc->symbol_size],
+					    (uint8_t *)data, coeff, acc->symbol_size);
+	}
+
+	acc->members[index] = 1;
+	acc->entered += 1;
+}
+
+void repair_acc_leave(struct repair_acc *acc, uint32_t index, const uint8_t *data)
+{
+	uint8_t *coeff;
+
+	if (acc->count == 0 || !acc->members[index])
+		return;
+
+	assert(index < acc->symbols);
+
+	/* Removing a symbol does not make the accumulators innovative. The
+	 * remaining combination only differs from the emitted one by a symbol
+	 * that the receiver has or will never need. */
+	for (uint32_t k = 0; k < acc->count; ++k) {
+		coeff = &acc->coefficients[k * acc->symbols + index];
+		binary8_region_multiply_subtract(&acc->payloads[k * acc->symbol_size],
+						 (uint8_t *)data, *coeff, acc->symbol_size);
+		*coeff = 0;
+	}
+
+	acc->members[index] = 0;
+}
+
+static bool repair_acc_innovative(const struct repair_acc *acc, uint32_t k)
+{
+	uint32_t used = acc->consumed > acc->emitted[k] ? acc->consumed : acc->emitted[k];
+
+	return acc->entered > used;
+}
+
+bool repair_acc_ready(const struct repair_acc *acc)
+{
+	for (uint32_t k = 0; k < acc->count; ++k) {
+		if (repair_acc_innovative(acc, k))
+			return true;
+	}
+
+	return false;
+}
+
+void repair_acc_emit(struct repair_acc *acc, const uint8_t **coefficients, const uint8_t **payload)
+{
+	uint32_t k = acc->next;
+
+	assert(repair_acc_ready(acc));
+
+	while (!repair_acc_innovative(acc, k)) {
+		k = (k + 1) % acc->count;
+	}
+
+	/* the emission uses up the oldest symbol that is new to this
+	 * accumulator, symbols before it cannot be used by it anymore */
+	if (acc->consumed < acc->emitted[k])
+		acc->consumed = acc->emitted[k];
+	acc->consumed += 1;
+	acc->emitted[k] = acc->entered;
+	acc->next = (k + 1) % acc->count;
+
+	*coefficients = &acc->coefficients[k * acc->symbols];
+	*payload = &acc->payloads[k * acc->symbol_size];
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * struct repair_acc - running repair symbol accumulators
+ * @count: number of accumulators, 0 if disabled
+ * @symbols: number of symbol slots in the coding window
+ * @symbol_size: size of a single symbol
+ * @next: accumulator that is emitted next
+ * @seed: state of the coefficient generator
+ * @entered: number of symbols that entered the accumulators
+ * @consumed: number of entered symbols that were used up by emitted repairs
+ * @members: for every slot whether the symbol is part of the accumulators
+ * @coefficients: coefficient vector of every accumulator, @count x @symbols
+ * @payloads: accumulated payload of every accumulator, @count x @symbol_size
+ * @emitted: value of @entered when each accumulator was last emitted
+ *
+ * Every accumulator holds a linear combination of the symbols in the coding
+ * window. The combination is updated with a single multiply-add whenever a
+ * symbol enters or leaves the window, so a repair symbol can be emitted
+ * without touching the whole window again.
+ *
+ * A re-emitted accumulator only differs from its previous emission by the
+ * symbols that entered in between, and these are shared by all accumulators.
+ * Each emission therefore uses up one entered symbol. An accumulator is only
+ * innovative if a symbol entered after its last emission and after all
+ * symbols that were already used up.
+ */
+struct repair_acc {
+	uint32_t count;
+	uint32_t symbols;
+	size_t symbol_size;
+	uint32_t next;
+	unsigned int seed;
+	uint32_t entered;
+	uint32_t consumed;
+
+	uint8_t *members;
+	uint8_t *coefficients;
+	uint8_t *payloads;
+	uint32_t *emitted;
+};
+
+/**
+ * repair_acc_init() - Allocate the accumulators
+ * @acc: repair_acc object to initialize
+ * @count: number of accumulators, 0 disables them
+ * @symbols: number of symbol slots in the coding window
+ * @symbol_size: size of a single symbol
+ */
+void repair_acc_init(struct repair_acc *acc, uint32_t count, uint32_t symbols, size_t symbol_size);
+
+/**
+ * repair_acc_free() - Release the memory of the accumulators
+ * @acc: repair_acc object to free
+ */
+void repair_acc_free(struct repair_acc *acc);
+
+/**
+ * repair_acc_reset() - Remove all symbols from the accumulators
+ * @acc: repair_acc object to reset
+ *
+ * Unlike repair_acc_free() the accumulators stay allocated.
+ */
+void repair_acc_reset(struct repair_acc *acc);
+
+/**
+ * repair_acc_enter() - Add a symbol to all accumulators
+ * @acc: repair_acc object to modify
+ * @index: slot of the symbol in the coding window
+ * @data: symbol data, must stay unchanged until repair_acc_leave()
+ *
+ * Adding a symbol that is already part of the accumulators does nothing.
+ */
+void repair_acc_enter(struct repair_acc *acc, uint32_t index, const uint8_t *data);
+
+/**
+ * repair_acc_leave() - Remove a symbol from all accumulators
+ * @acc: repair_acc object to modify
+ * @index: slot of the symbol in the coding window
+ * @data: symbol data that was given to repair_acc_enter()
+ *
+ * Removing a symbol that is not part of the accumulators does nothing.
+ */
+void repair_acc_leave(struct repair_acc *acc, uint32_t index, const uint8_t *data);
+
+/**
+ * repair_acc_ready() - Check if an accumulator can be emitted
+ * @acc: repair_acc object to check
+ *
+ * Return: true if an accumulator holds an entered symbol that was not used up
+ *         by a previous emission
+ */
+bool repair_acc_ready(const struct repair_acc *acc);
+
+/**
+ * repair_acc_emit() - Get the next accumulated repair symbol
+ * @acc: repair_acc object to use
+ * @coefficients: set to the coefficient vector with one entry per slot
+ * @payload: set to the accumulated payload
+ *
+ * The returned buffers stay valid until the accumulators are modified.
+ * Must only be called if repair_acc_ready() returned true.
+ */
+void repair_acc_emit(struct repair_acc *acc, const uint8_t **coefficients, const uint8_t **payload);
+
+#ifdef __cplusplus
+}
+#endif
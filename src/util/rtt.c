@@ -0,0 +1,97 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "rtt.h"
+#include "../private.h"
+
+/* smallest timeout, below this the timer resolution dominates */
+#define RTT_MIN_TIMEOUT_US 1000
+
+static int64_t timeval_to_us(const struct timeval *tv)
+{
+	return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+static void us_to_timeval(int64_t us, struct timeval *tv)
+{
+	tv->tv_sec = us / 1000000;
+	tv->tv_usec = us % 1000000;
+}
+
+void rtt_init(struct rtt_estimator *rtt)
+{
+	memset(rtt, 0, sizeof(*rtt));
+}
+
+void rtt_update(struct rtt_estimator *rtt, const struct timeval *sample)
+{
+	int64_t r = timeval_to_us(sample);
+	int64_t srtt = timeval_to_us(&rtt->srtt);
+	int64_t rttvar = timeval_to_us(&rtt->rttvar);
+	int64_t delta;
+
+	if (r < 0)
+		return;
+
+	if (!rtt->valid) {
+		srtt = r;
+		rttvar = r / 2;
+		rtt->valid = true;
+	} else {
+		// alpha = 1/8, beta = 1/4
+		delta = r > srtt ? r - srtt : srtt - r;
+		rttvar += (delta - rttvar) / 4;
+		srtt += (r - srtt) / 8;
+	}
+
+	us_to_timeval(srtt, &rtt->srtt);
+	us_to_timeval(rttvar, &rtt->rttvar);
+}
+
+void rtt_sent(struct rtt_estimator *rtt, uint32_t key, const struct timeval *now)
+{
+	struct rtt_record *record = &rtt->history[key % RTT_HISTORY];
+
+	*record = (struct rtt_record) {
+		.key = key,
+		.sent = *now,
+		.valid = true,
+	};
+}
+
+bool rtt_acked(struct rtt_estimator *rtt, uint32_t key, const struct timeval *now,
+	       const struct timeval *delay, struct timeval *sample)
+{
+	struct rtt_record *record = &rtt->history[key % RTT_HISTORY];
+	struct timeval measured;
+
+	if (!record->valid || record->key != key)
+		return false;
+
+	record->valid = false;
+	timersub(now, &record->sent, &measured);
+	if (delay) {
+		if (timercmp(&measured, delay, >))
+			timersub(&measured, delay, &measured);
+		else
+			timerclear(&measured);
+	}
+	rtt_update(rtt, &measured);
+	if (sample)
+		*sample = measured;
+	return true;
+}
+
+void rtt_timeout(const struct rtt_estimator *rtt, const struct timeval *fallback,
+		 struct timeval *timeout)
+{
+	int64_t us;
+
+	if (!rtt->valid) {
+		*timeout = *fallback;
+		return;
+	}
+
+	us = timeval_to_us(&rtt->srtt) + 4 * timeval_to_us(&rtt->rttvar);
+	us_to_timeval(max_t(int64_t, us, RTT_MIN_TIMEOUT_US), timeout);
+}
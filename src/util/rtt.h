@@ -0,0 +1,102 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/time.h>
+
+/*
+ * Number of sent packets or generations whose send time is remembered. A
+ * key only gives a sample if fewer keys were sent before its echo arrives,
+ * so this has to cover the packets in flight on long paths. Must be a power
+ * of 2 that divides 2^16, so that 16 bit packet numbers can be used as key.
+ */
+#define RTT_HISTORY 1024
+
+/**
+ * struct rtt_record - send time of a packet or generation
+ * @key: packet number or generation the record belongs to
+ * @sent: time when it was last sent
+ * @valid: whether the record can still provide a sample
+ */
+struct rtt_record {
+	uint32_t key;
+	struct timeval sent;
+	bool valid;
+};
+
+/**
+ * struct rtt_estimator - smoothed round trip time and its variation
+ * @srtt: smoothed round trip time
+ * @rttvar: smoothed mean deviation of the round trip time
+ * @valid: whether at least one sample was taken
+ * @history: send times indexed by key modulo RTT_HISTORY
+ *
+ * The estimator follows RFC 6298. Samples are taken from acknowledgements of
+ * keys that were registered with rtt_sent(), every key gives at most one
+ * sample so repeated acknowledgements do not shrink the estimate.
+ */
+struct rtt_estimator {
+	struct timeval srtt;
+	struct timeval rttvar;
+	bool valid;
+
+	struct rtt_record history[RTT_HISTORY];
+};
+
+/**
+ * rtt_init() - Initialize an estimator without samples
+ * @rtt: estimator to initialize
+ */
+void rtt_init(struct rtt_estimator *rtt);
+
+/**
+ * rtt_update() - Add a round trip time sample
+ * @rtt: estimator to update
+ * @sample: measured round trip time
+ */
+void rtt_update(struct rtt_estimator *rtt, const struct timeval *sample);
+
+/**
+ * rtt_sent() - Remember the send time of a packet or generation
+ * @rtt: estimator to update
+ * @key: packet number or generation that was sent
+ * @now: current time
+ *
+ * Sending the same key again moves its send time forward.
+ */
+void rtt_sent(struct rtt_estimator *rtt, uint32_t key, const struct timeval *now);
+
+/**
+ * rtt_acked() - Take a sample for an acknowledged packet or generation
+ * @rtt: estimator to update
+ * @key: packet number or generation that was acknowledged
+ * @now: current time
+ * @delay: time the receiver held the acknowledgement back, or NULL
+ * @sample: set to the sample if one was taken, may be NULL
+ *
+ * The @delay is subtracted from the sample, so feedback that is coalesced
+ * or sent on a timeout does not inflate the estimate.
+ *
+ * Return: true if a sample was taken, false if the key is unknown, too old
+ *  or was already acknowledged
+ */
+bool rtt_acked(struct rtt_estimator *rtt, uint32_t key, const struct timeval *now,
+	       const struct timeval *delay, struct timeval *sample);
+
+/**
+ * rtt_timeout() - Compute a retransmission timeout
+ * @rtt: estimator to query
+ * @fallback: timeout to use while there are no samples
+ * @timeout: updated to contain srtt + 4 * rttvar, or @fallback
+ */
+void rtt_timeout(const struct rtt_estimator *rtt, const struct timeval *fallback,
+		 struct timeval *timeout);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,230 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <nckernel/interflowsw.h>
+#include <nckernel/skb.h>
+
+#include <interflow_sw/packet.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+#define FLOWS 2
+#define WINDOW 8
+#define PACKET_SIZE 64
+
+/* two packets of flow 0 with the same packet_no and length that only differ
+ * in their last six bytes, both have the mix hash 0x00344529 */
+static const uint8_t collision_a[20] = {
+	INTERFLOW_SW_PACKET_TYPE_CODED, 4, 0, 0, 0, 7,
+	'c', 'o', 'l', 'l', 'i', 'd', 'e', '!',
+	0xd6, 0xd5, 0xca, 0xc1, 0xf8, 0x2b,
+};
+
+static const uint8_t collision_b[20] = {
+	INTERFLOW_SW_PACKET_TYPE_CODED, 4, 0, 0, 0, 7,
+	'c', 'o', 'l', 'l', 'i', 'd', 'e', '!',
+	0x08, 0x7f, 0x54, 0x50, 0x19, 0xb7,
+};
+
+/* write a coded packet of a flow with a payload derived from fill */
+static void make_coded(uint8_t *buffer, struct sk_buff *packet, uint8_t flow,
+		       uint16_t packet_no, uint8_t fill, size_t payload)
+{
+	struct interflow_sw_coded_packet *header;
+	uint8_t *data;
+
+	skb_new(packet, buffer, PACKET_SIZE);
+	header = (struct interflow_sw_coded_packet *)skb_put(packet, sizeof(*header));
+	header->packet_type = INTERFLOW_SW_PACKET_TYPE_CODED;
+	header->order = 4;
+	header->flags = 0;
+	header->flow = flow;
+	header->packet_no = htons(packet_no);
+
+	data = skb_put(packet, payload);
+	for (size_t i = 0; i < payload; ++i)
+		data[i] = fill + 7 * i;
+}
+
+static void make_raw(uint8_t *buffer, struct sk_buff *packet, const uint8_t *data, size_t len)
+{
+	skb_new(packet, buffer, PACKET_SIZE);
+	memcpy(skb_put(packet, len), data, len);
+}
+
+/* give the packets of both flows to a relay and return its mixed packet */
+static void mix_pair(struct sk_buff *first, struct sk_buff *second,
+		     uint8_t *buffer, size_t size, struct sk_buff *mixed)
+{
+	struct nck_interflow_sw_mix *relay;
+
+	relay = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(relay != NULL);
+	TEST_ASSERT(size >= nck_interflow_sw_mix_coded_size(relay));
+
+	TEST_ASSERT(nck_interflow_sw_mix_put_coded(relay, first) == 0);
+	TEST_CHECK(!nck_interflow_sw_mix_has_coded(relay));
+	TEST_ASSERT(nck_interflow_sw_mix_put_coded(relay, second) == 0);
+	TEST_ASSERT(nck_interflow_sw_mix_has_coded(relay));
+
+	skb_new(mixed, buffer, size);
+	TEST_ASSERT(nck_interflow_sw_mix_get_coded(relay, mixed) == 0);
+	TEST_CHECK(!nck_interflow_sw_mix_has_coded(relay));
+
+	nck_interflow_sw_mix_free(relay);
+}
+
+/* extract from a copy, the mixed packet is modified in place */
+static int extract_copy(struct nck_interflow_sw_mix *mix, const struct sk_buff *mixed,
+			uint8_t *buffer, struct sk_buff *result)
+{
+	skb_new(result, buffer, mixed->len);
+	memcpy(skb_put(result, mixed->len), mixed->data, mixed->len);
+	return nck_interflow_sw_mix_extract(mix, result);
+}
+
+static void test_extract(void)
+{
+	uint8_t buf_a[PACKET_SIZE], buf_b[PACKET_SIZE], buf_mixed[256], buf_out[256];
+	struct sk_buff packet_a, packet_b, mixed, out;
+	struct interflow_sw_mixed_packet *header;
+	struct nck_interflow_sw_mix *node_a, *node_b, *stranger;
+
+	// the packets have different lengths, the shorter one is padded
+	make_coded(buf_a, &packet_a, 0, 3, 0x11, 10);
+	make_coded(buf_b, &packet_b, 1, 5, 0x42, 30);
+	mix_pair(&packet_a, &packet_b, buf_mixed, sizeof(buf_mixed), &mixed);
+
+	header = (struct interflow_sw_mixed_packet *)mixed.data;
+	TEST_CHECK(header->packet_type == INTERFLOW_SW_PACKET_TYPE_MIXED);
+	TEST_CHECK(header->count == 2);
+	TEST_CHECK(ntohs(header->length) == packet_b.len);
+	TEST_CHECK(mixed.len == sizeof(*header) + 2 * sizeof(struct interflow_sw_mixed_entry) + packet_b.len);
+
+	// each end knows its own packet and solves for the other one
+	node_a = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	node_b = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node_a, &packet_a) == 0);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node_b, &packet_b) == 0);
+
+	TEST_ASSERT(extract_copy(node_a, &mixed, buf_out, &out) == 0);
+	TEST_CHECK(out.len == packet_b.len);
+	TEST_CHECK(memcmp(out.data, packet_b.data, packet_b.len) == 0);
+
+	TEST_ASSERT(extract_copy(node_b, &mixed, buf_out, &out) == 0);
+	TEST_CHECK(out.len == packet_a.len);
+	TEST_CHECK(memcmp(out.data, packet_a.data, packet_a.len) == 0);
+
+	// the extracted packet is remembered, so the mix carries nothing new
+	TEST_CHECK(extract_copy(node_a, &mixed, buf_out, &out) == -1);
+
+	// a node that knows neither packet can not solve for two unknowns
+	stranger = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_CHECK(extract_copy(stranger, &mixed, buf_out, &out) == -1);
+
+	nck_interflow_sw_mix_free(stranger);
+	nck_interflow_sw_mix_free(node_a);
+	nck_interflow_sw_mix_free(node_b);
+}
+
+static void test_single_flow(void)
+{
+	uint8_t buf_a[PACKET_SIZE], buf_out[256];
+	struct sk_buff packet_a, out;
+	struct nck_interflow_sw_mix *relay;
+
+	relay = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	make_coded(buf_a, &packet_a, 0, 9, 0x23, 16);
+
+	// a single flow waits for the other one until it is flushed
+	TEST_ASSERT(nck_interflow_sw_mix_put_coded(relay, &packet_a) == 0);
+	TEST_CHECK(!nck_interflow_sw_mix_has_coded(relay));
+	nck_interflow_sw_mix_flush_coded(relay);
+	TEST_ASSERT(nck_interflow_sw_mix_has_coded(relay));
+
+	// nothing to mix with, the coded packet is sent without a mixed header
+	skb_new(&out, buf_out, sizeof(buf_out));
+	TEST_ASSERT(nck_interflow_sw_mix_get_coded(relay, &out) == 0);
+	TEST_CHECK(out.len == packet_a.len);
+	TEST_CHECK(memcmp(out.data, packet_a.data, packet_a.len) == 0);
+	TEST_CHECK(!nck_interflow_sw_mix_has_coded(relay));
+
+	nck_interflow_sw_mix_free(relay);
+}
+
+static void test_ambiguous(void)
+{
+	uint8_t buf_a[PACKET_SIZE], buf_b[PACKET_SIZE], buf_c[PACKET_SIZE];
+	uint8_t buf_mixed[256], buf_out[256];
+	struct sk_buff packet_a, packet_b, packet_c, mixed, out;
+	struct nck_interflow_sw_mix *node;
+
+	make_raw(buf_a, &packet_a, collision_a, sizeof(collision_a));
+	make_raw(buf_c, &packet_c, collision_b, sizeof(collision_b));
+	make_coded(buf_b, &packet_b, 1, 5, 0x42, 30);
+	mix_pair(&packet_a, &packet_b, buf_mixed, sizeof(buf_mixed), &mixed);
+
+	// two different packets match the entry of flow 0, the right one is
+	// the newer one so only the ambiguity makes the extraction fail
+	node = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_c) == 0);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_a) == 0);
+	TEST_CHECK(extract_copy(node, &mixed, buf_out, &out) == -1);
+	nck_interflow_sw_mix_free(node);
+
+	// copies of the same packet are not ambiguous
+	node = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_a) == 0);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_a) == 0);
+	TEST_ASSERT(extract_copy(node, &mixed, buf_out, &out) == 0);
+	TEST_CHECK(out.len == packet_b.len);
+	TEST_CHECK(memcmp(out.data, packet_b.data, packet_b.len) == 0);
+	nck_interflow_sw_mix_free(node);
+}
+
+static void test_hash_rejection(void)
+{
+	uint8_t buf_a[PACKET_SIZE], buf_b[PACKET_SIZE], buf_c[PACKET_SIZE];
+	uint8_t buf_mixed[256], buf_out[256];
+	struct sk_buff packet_a, packet_b, packet_c, mixed, out;
+	struct nck_interflow_sw_mix *node;
+
+	make_raw(buf_a, &packet_a, collision_a, sizeof(collision_a));
+	make_raw(buf_c, &packet_c, collision_b, sizeof(collision_b));
+	make_coded(buf_b, &packet_b, 1, 5, 0x42, 30);
+	mix_pair(&packet_a, &packet_b, buf_mixed, sizeof(buf_mixed), &mixed);
+
+	// the node only knows the twin of the mixed packet, removing it
+	// leaves garbage that does not match the hash of the unknown packet
+	node = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_c) == 0);
+	TEST_CHECK(extract_copy(node, &mixed, buf_out, &out) == -1);
+
+	// a corrupted payload is rejected as well
+	nck_interflow_sw_mix_free(node);
+	node = nck_interflow_sw_mix(FLOWS, WINDOW, PACKET_SIZE, NULL, NULL);
+	TEST_ASSERT(nck_interflow_sw_mix_remember(node, &packet_a) == 0);
+	mixed.data[mixed.len - 1] ^= 0x80;
+	TEST_CHECK(extract_copy(node, &mixed, buf_out, &out) == -1);
+
+	// the rejected packets were not remembered
+	mixed.data[mixed.len - 1] ^= 0x80;
+	TEST_ASSERT(extract_copy(node, &mixed, buf_out, &out) == 0);
+	TEST_CHECK(out.len == packet_b.len);
+	TEST_CHECK(memcmp(out.data, packet_b.data, packet_b.len) == 0);
+
+	nck_interflow_sw_mix_free(node);
+}
+
+TEST_LIST = {
+	{ "extract", test_extract },
+	{ "single_flow", test_single_flow },
+	{ "ambiguous", test_ambiguous },
+	{ "hash_rejection", test_hash_rejection },
+	{ NULL, NULL }
+};
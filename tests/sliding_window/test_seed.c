@@ -0,0 +1,236 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <nckernel/sw.h>
+#include <nckernel/skb.h>
+
+#include <sliding_window/packet.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+#define WINDOW 16
+#define SYMBOL_SIZE 32
+#define MAX_SOURCES 64
+
+/* offset of the systematic flag in the kodo header after the sw header */
+#define KODO_SYSTEMATIC_FLAG (sizeof(struct sw_coded_packet) + 4)
+
+/**
+ * struct link - encoder and decoder connected without delay
+ * @enc: encoder under test
+ * @dec: decoder that receives the packets that are not dropped
+ * @feedback: pass the feedback of the decoder to the encoder
+ * @drop: systematic packets of these sequence numbers are lost
+ * @sent: number of source symbols given to the encoder
+ * @delivered: number of source symbols that came out of the decoder
+ * @seeded: number of repair packets with a struct sw_seed_header
+ * @plain: number of repair packets with the kodo header
+ * @full: number of seeded repair packets that combine the whole window
+ * @wrapped: number of seeded repair packets whose range wraps around
+ */
+struct link {
+	struct nck_sw_enc *enc;
+	struct nck_sw_dec *dec;
+	int feedback;
+	uint8_t drop[MAX_SOURCES];
+	uint32_t sent, delivered;
+	uint32_t seeded, plain, full, wrapped;
+};
+
+static void make_source(uint8_t *data, uint32_t seqno)
+{
+	for (uint32_t i = 0; i < SYMBOL_SIZE; ++i)
+		data[i] = seqno * 31 + i * 7 + 1;
+}
+
+static void link_init(struct link *link, uint32_t forward_window, uint32_t systematic,
+		      uint32_t coded, int feedback)
+{
+	memset(link, 0, sizeof(*link));
+	link->feedback = feedback;
+
+	link->enc = nck_sw_enc(WINDOW, SYMBOL_SIZE, NULL, NULL);
+	link->dec = nck_sw_dec(WINDOW, SYMBOL_SIZE, NULL, NULL, NULL);
+	TEST_ASSERT(link->enc != NULL && link->dec != NULL);
+
+	nck_sw_enc_set_forward_code_window(link->enc, forward_window);
+	nck_sw_enc_set_systematic_phase(link->enc, systematic);
+	nck_sw_enc_set_coded_phase(link->enc, coded);
+	nck_sw_enc_set_seed_header(link->enc, 1);
+	if (feedback) {
+		nck_sw_enc_set_tx_attempts(link->enc, 1);
+	} else {
+		nck_sw_enc_set_feedback_period(link->enc, 0);
+		nck_sw_dec_set_feedback(link->dec, 0);
+	}
+}
+
+static void link_free(struct link *link)
+{
+	nck_sw_enc_free(link->enc);
+	nck_sw_dec_free(link->dec);
+}
+
+/* take the decoded symbols out of the decoder, they must come in order */
+static void link_receive(struct link *link)
+{
+	uint8_t buffer[SYMBOL_SIZE], expected[SYMBOL_SIZE];
+	struct sk_buff packet;
+
+	while (nck_sw_dec_has_source(link->dec)) {
+		skb_new(&packet, buffer, sizeof(buffer));
+		TEST_ASSERT(nck_sw_dec_get_source(link->dec, &packet) == 0);
+
+		make_source(expected, link->delivered);
+		TEST_CHECK_(packet.len == SYMBOL_SIZE && memcmp(packet.data, expected, SYMBOL_SIZE) == 0,
+			    "source %u differs", link->delivered);
+		link->delivered += 1;
+	}
+}
+
+/* check the header of a repair packet against the enabled range */
+static void link_inspect(struct link *link, struct sk_buff *packet)
+{
+	struct sw_coded_packet *header = (struct sw_coded_packet *)packet->data;
+	struct sw_seed_header *seed = (struct sw_seed_header *)(header + 1);
+	uint32_t first, count;
+
+	if (!(header->flags & SW_CODED_PACKET_SEED)) {
+		if (packet->data[KODO_SYSTEMATIC_FLAG] == 0)
+			link->plain += 1;
+		return;
+	}
+
+	TEST_ASSERT(packet->len >= sizeof(*header) + sizeof(*seed));
+	first = ntohs(seed->first);
+	count = ntohs(seed->count);
+	TEST_CHECK_(first < WINDOW && count > 0 && count <= WINDOW, "first %u count %u", first, count);
+
+	link->seeded += 1;
+	if (count == WINDOW)
+		link->full += 1;
+	if (first + count > WINDOW)
+		link->wrapped += 1;
+}
+
+/* send everything the encoder has and pass the feedback back */
+static void link_transfer(struct link *link)
+{
+	uint8_t coded[2048], feedback[2048];
+	struct sk_buff packet;
+	uint32_t seqno;
+
+	while (nck_sw_enc_has_coded(link->enc)) {
+		skb_new(&packet, coded, sizeof(coded));
+		TEST_ASSERT(nck_sw_enc_get_coded(link->enc, &packet) == 0);
+		link_inspect(link, &packet);
+
+		// the kodo header of a systematic packet has the sequence
+		// number after the symbol
+		if (!(packet.data[2] & SW_CODED_PACKET_SEED) &&
+		    packet.data[KODO_SYSTEMATIC_FLAG] != 0) {
+			memcpy(&seqno, packet.data + sizeof(struct sw_coded_packet), sizeof(seqno));
+			seqno = ntohl(seqno) - 1;
+			if (seqno < MAX_SOURCES && link->drop[seqno])
+				continue;
+		}
+
+		TEST_ASSERT(nck_sw_dec_put_coded(link->dec, &packet) == 0);
+		link_receive(link);
+
+		if (link->feedback && nck_sw_dec_has_feedback(link->dec)) {
+			skb_new(&packet, feedback, sizeof(feedback));
+			TEST_ASSERT(nck_sw_dec_get_feedback(link->dec, &packet) == 0);
+			TEST_ASSERT(nck_sw_enc_put_feedback(link->enc, &packet) == 0);
+		}
+	}
+}
+
+static void link_send(struct link *link, uint32_t sources)
+{
+	uint8_t buffer[SYMBOL_SIZE];
+	struct sk_buff packet;
+
+	for (uint32_t i = 0; i < sources; ++i) {
+		TEST_ASSERT(link->sent < MAX_SOURCES);
+		TEST_ASSERT(!nck_sw_enc_full(link->enc));
+
+		skb_new(&packet, buffer, sizeof(buffer));
+		make_source(skb_put(&packet, SYMBOL_SIZE), link->sent);
+		TEST_ASSERT(nck_sw_enc_put_source(link->enc, &packet) == 0);
+		link->sent += 1;
+
+		link_transfer(link);
+	}
+}
+
+static void test_wrapped(void)
+{
+	struct link link;
+
+	// one repair over the four newest symbols after every second source,
+	// the first of each pair is lost and repaired by the seeded packet
+	link_init(&link, 4, 2, 1, 0);
+	for (uint32_t i = 2; i < 3 * WINDOW; i += 2)
+		link.drop[i] = 1;
+
+	link_send(&link, 3 * WINDOW);
+
+	TEST_CHECK_(link.delivered == link.sent, "delivered %u of %u", link.delivered, link.sent);
+	TEST_CHECK(link.seeded > 0);
+	TEST_CHECK(link.wrapped > 0);
+	TEST_CHECK_(link.plain == 0, "%u repairs with the kodo header", link.plain);
+
+	link_free(&link);
+}
+
+static void test_full_window(void)
+{
+	struct link link;
+
+	// a repair over every slot of the window after every half window, so
+	// every other range starts in the middle and wraps around
+	link_init(&link, WINDOW, WINDOW / 2, 1, 0);
+	for (uint32_t i = 5; i < 3 * WINDOW; i += WINDOW / 2)
+		link.drop[i] = 1;
+
+	link_send(&link, 3 * WINDOW);
+
+	TEST_CHECK_(link.delivered == link.sent, "delivered %u of %u", link.delivered, link.sent);
+	TEST_CHECK(link.full > 0);
+	TEST_CHECK(link.wrapped > 0);
+	TEST_CHECK_(link.plain == 0, "%u repairs with the kodo header", link.plain);
+
+	link_free(&link);
+}
+
+static void test_fallback(void)
+{
+	struct link link;
+
+	// the feedback acknowledges the symbol between the two lost ones, so
+	// the enabled slots have a gap that the seed header can not describe
+	// and the first repair falls back to the kodo header
+	link_init(&link, WINDOW, 4, 2, 1);
+	link.drop[1] = 1;
+	link.drop[3] = 1;
+
+	link_send(&link, 4);
+
+	TEST_CHECK_(link.delivered == link.sent, "delivered %u of %u", link.delivered, link.sent);
+	TEST_CHECK_(link.plain > 0, "no repair with the kodo header");
+
+	link_free(&link);
+}
+
+TEST_LIST = {
+	{ "wrapped", test_wrapped },
+	{ "full_window", test_full_window },
+	{ "fallback", test_fallback },
+	{ NULL, NULL }
+};
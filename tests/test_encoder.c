@@ -1,7 +1,9 @@
 #include <cutest.h>
 #undef NDEBUG
 #include <assert.h>
+#include <nckernel/config.h>
 #include <nckernel/nckernel.h>
+#include <nckernel/pollset.h>
 #include <nckernel/skb.h>
 
 #define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
@@ -210,10 +212,223 @@ void test_on_coded()
 	}
 }
 
+void test_create_from_config()
+{
+	int index;
+	struct nck_encoder encoder;
+	struct nck_config *config;
+	const char *protocol;
+
+	struct nck_option_value options[] = {
+		{ "symbol_size", "1500" },
+		{ NULL, NULL }
+	};
+
+	for_each_protocol(index) {
+		protocol = nck_protocol_name(index);
+		if (skip_protocol(protocol)) {
+			continue;
+		}
+
+		config = nck_config_compile(protocol, NULL, options, nck_option_from_array);
+		TEST_ASSERT_(config != NULL,
+				"Encoder %s: Compiling the configuration failed", protocol);
+
+		TEST_ASSERT_(nck_create_encoder_from_config(&encoder, NULL, config) == 0,
+				"Encoder %s: Creation from configuration failed", protocol);
+
+		TEST_ASSERT_(encoder.source_size == 1500,
+				"Encoder %s: Option was lost in the configuration", protocol);
+
+		nck_free(&encoder);
+		nck_config_free(config);
+	}
+}
+
+void test_reset()
+{
+	int index, packetno;
+	struct nck_encoder encoder;
+	struct sk_buff skb;
+	const char *protocol;
+	uint8_t source[1500];
+
+	struct nck_option_value options[] = {
+		{ "protocol", NULL },
+		{ "symbol_size", "1500" },
+		{ NULL, NULL }
+	};
+
+	for_each_protocol(index) {
+		protocol = nck_protocol_name(index);
+		if (skip_protocol(protocol)) {
+			continue;
+		}
+
+		options[0].value = protocol;
+		TEST_ASSERT_(nck_create_encoder(&encoder, NULL, options, nck_option_from_array) == 0,
+				"Encoder %s: Creation failed", protocol);
+
+		for (packetno = 0; !nck_has_coded(&encoder) && packetno < 10000; ++packetno) {
+			skb_new(&skb, source, sizeof(source));
+			snprintf((char*)skb_put(&skb, 20), 20, "packet %d", packetno);
+			TEST_ASSERT_(nck_put_source(&encoder, &skb) == 0,
+					"Encoder %s: Adding a source packet failed", protocol);
+		}
+
+		TEST_ASSERT_(nck_reset(&encoder) == 0,
+				"Encoder %s: Reset failed", protocol);
+
+		TEST_ASSERT_(nck_has_coded(&encoder) == 0,
+				"Encoder %s: Has coded after reset", protocol);
+
+		TEST_ASSERT_(nck_full(&encoder) == 0,
+				"Encoder %s: Full after reset", protocol);
+
+		skb_new(&skb, source, sizeof(source));
+		snprintf((char*)skb_put(&skb, 20), 20, "packet %d", packetno);
+		TEST_ASSERT_(nck_put_source(&encoder, &skb) == 0,
+				"Encoder %s: Adding a source packet after reset failed", protocol);
+
+		nck_free(&encoder);
+	}
+}
+
+void test_pollset()
+{
+	int index, packetno;
+	struct nck_encoder encoder;
+	struct nck_pollset set;
+	struct nck_poll_handle handle;
+	struct nck_poll_event events[2];
+	struct sk_buff skb;
+	const char *protocol;
+	uint8_t source[1500];
+
+	struct nck_option_value options[] = {
+		{ "protocol", NULL },
+		{ "symbol_size", "1500" },
+		{ NULL, NULL }
+	};
+
+	for_each_protocol(index) {
+		protocol = nck_protocol_name(index);
+		if (skip_protocol(protocol)) {
+			continue;
+		}
+
+		options[0].value = protocol;
+		TEST_ASSERT_(nck_create_encoder(&encoder, NULL, options, nck_option_from_array) == 0,
+				"Encoder %s: Creation failed", protocol);
+
+		nck_pollset_init(&set);
+		TEST_ASSERT_(nck_pollset_add(&set, &handle, (struct nck_coder *)&encoder,
+					NCK_POLL_SOURCE | NCK_POLL_CODED, &encoder) == 0,
+				"Encoder %s: Registration failed", protocol);
+
+		TEST_ASSERT_(handle.events == NCK_POLL_CODED,
+				"Encoder %s: Registered for events it does not have", protocol);
+
+		// add packets until we get some coded packet
+		for (packetno = 0; !nck_has_coded(&encoder) && packetno < 10000; ++packetno) {
+			skb_new(&skb, source, sizeof(source));
+			snprintf((char*)skb_put(&skb, 20), 20, "packet %d", packetno);
+			TEST_ASSERT_(nck_put_source(&encoder, &skb) == 0,
+					"Encoder %s: Adding a source packet failed", protocol);
+		}
+
+		TEST_ASSERT_(nck_pollset_drain(&set, events, 2) == 1,
+				"Encoder %s: Not reported exactly once", protocol);
+
+		TEST_ASSERT_(events[0].context == &encoder && events[0].events == NCK_POLL_CODED,
+				"Encoder %s: Wrong event reported", protocol);
+
+		TEST_ASSERT_(nck_pollset_pending(&set) == 0,
+				"Encoder %s: Still pending after drain", protocol);
+
+		nck_pollset_del(&handle, (struct nck_coder *)&encoder);
+		nck_free(&encoder);
+	}
+}
+
+#if defined(ENABLE_CHAIN) && defined(ENABLE_TETRYS)
+void test_chain_wrap()
+{
+	struct nck_encoder chain, tetrys;
+	struct sk_buff skb, expected;
+	uint8_t source[100], coded[200], reference[200];
+	int packetno, packets = 0, repairs = 0;
+
+	// the tetrys stage is bypassed and wraps the packets of the nocode stage
+	struct nck_option_value chain_options[] = {
+		{ "protocol", "chain" },
+		{ "symbol_size", "100" },
+		{ "stage0", "nocode" },
+		{ "stage1", "tetrys" },
+		{ "stage1_window_size", "8" },
+		{ NULL, NULL }
+	};
+
+	struct nck_option_value tetrys_options[] = {
+		{ "protocol", "tetrys" },
+		{ "symbol_size", "100" },
+		{ "window_size", "8" },
+		{ NULL, NULL }
+	};
+
+	// both tetrys encoders draw their coefficients from the same seed
+	srand(1);
+	TEST_ASSERT(nck_create_encoder(&chain, NULL, chain_options, nck_option_from_array) == 0);
+	srand(1);
+	TEST_ASSERT(nck_create_encoder(&tetrys, NULL, tetrys_options, nck_option_from_array) == 0);
+	TEST_ASSERT(chain.coded_size == tetrys.coded_size);
+
+	for (packetno = 0; packetno < 40; ++packetno) {
+		skb_new(&skb, source, sizeof(source));
+		memset(skb_put(&skb, 10 + packetno), packetno, 10 + packetno);
+		TEST_ASSERT(nck_put_source(&chain, &skb) == 0);
+
+		skb_new(&skb, source, sizeof(source));
+		memset(skb_put(&skb, 10 + packetno), packetno, 10 + packetno);
+		TEST_ASSERT(nck_put_source(&tetrys, &skb) == 0);
+
+		// wrapped and refused packets must leave the chain exactly
+		// like they leave a tetrys encoder on its own
+		while (nck_has_coded(&tetrys)) {
+			TEST_ASSERT_(nck_has_coded(&chain), "Packet %d: Chain has no coded packet", packets);
+
+			skb_new(&skb, coded, sizeof(coded));
+			TEST_ASSERT(nck_get_coded(&chain, &skb) == 0);
+			skb_new(&expected, reference, sizeof(reference));
+			TEST_ASSERT(nck_get_coded(&tetrys, &expected) == 0);
+
+			TEST_ASSERT_(skb.len == expected.len && !memcmp(skb.data, expected.data, skb.len),
+					"Packet %d: Chain output differs from tetrys", packets);
+			if (expected.data[0] != 0) {
+				++repairs;
+			}
+			++packets;
+		}
+		TEST_ASSERT(!nck_has_coded(&chain));
+	}
+
+	TEST_CHECK_(repairs > 0 && repairs < packets, "%d repair packets in %d packets", repairs, packets);
+
+	nck_free(&chain);
+	nck_free(&tetrys);
+}
+#endif
+
 TEST_LIST = {
 	{ "create", test_create },
+	{ "create_from_config", test_create_from_config },
 	{ "encode", test_encode },
 	{ "full", test_full },
 	{ "on_coded", test_on_coded },
+	{ "reset", test_reset },
+	{ "pollset", test_pollset },
+#if defined(ENABLE_CHAIN) && defined(ENABLE_TETRYS)
+	{ "chain_wrap", test_chain_wrap },
+#endif
 	{ NULL }
 };
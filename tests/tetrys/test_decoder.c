@@ -29,7 +29,7 @@ int main()
 	nck_tetrys_enc_set_coded_phase(base_enc, 1);
 	nck_tetrys_enc_api(&enc, base_enc);
 
-	base_dec = nck_tetrys_dec(symbols, window_size);
+	base_dec = nck_tetrys_dec(symbols, window_size, NULL);
 	nck_tetrys_dec_api(&dec, base_dec);
 
 	assert(!nck_has_source(&dec));
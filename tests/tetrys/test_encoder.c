@@ -6,6 +6,62 @@
 #include <nckernel/tetrys.h>
 #include <nckernel/skb.h>
 
+/* count the systematic and repair packets until the encoder runs dry */
+static void get_all_coded(struct nck_encoder *enc, int *systematic, int *repair)
+{
+	uint8_t buffer[400];
+	struct sk_buff output;
+
+	while (nck_has_coded(enc)) {
+		skb_new(&output, buffer, sizeof(buffer));
+		nck_get_coded(enc, &output);
+		if (skb_pull_u8(&output) == 0)
+			*systematic += 1;
+		else
+			*repair += 1;
+	}
+}
+
+static void test_adaptive_redundancy()
+{
+	uint8_t buffer[100];
+	struct sk_buff input, feedback;
+	struct nck_encoder enc;
+	struct nck_tetrys_enc *base_enc;
+	int systematic = 0, repair = 0, i;
+
+	base_enc = nck_tetrys_enc(20, 8, NULL, NULL);
+	nck_tetrys_enc_set_adaptive_redundancy(base_enc, 0, 4);
+	nck_tetrys_enc_api(&enc, base_enc);
+
+	skb_new(&input, (uint8_t*)"test", 5);
+	skb_put(&input, 5);
+
+	// without reported losses the redundancy stays at the minimum
+	for (i = 0; i < 8; ++i)
+		nck_put_source(&enc, &input);
+	get_all_coded(&enc, &systematic, &repair);
+	assert(systematic == 8);
+	assert(repair == 0);
+
+	// every second packet was lost, the others are acknowledged
+	skb_new(&feedback, buffer, sizeof(buffer));
+	skb_put_u8(&feedback, 2);
+	for (i = 0; i < 8; i += 2)
+		skb_put_u32(&feedback, i);
+	skb_put_u32(&feedback, 8);
+	nck_put_feedback(&enc, &feedback);
+
+	systematic = 0;
+	while (!nck_full(&enc))
+		nck_put_source(&enc, &input);
+	get_all_coded(&enc, &systematic, &repair);
+	assert(systematic == 4);
+	assert(repair > 0);
+
+	nck_free(&enc);
+}
+
 int main()
 {
 	uint8_t buffer[100];
@@ -15,6 +71,8 @@ int main()
 	uint32_t symbol_size = 20, window_size = 4;
 	uint32_t systematic = 4, coded = 1;
 
+	test_adaptive_redundancy();
+
 	base_enc = nck_tetrys_enc(symbol_size, window_size, NULL, NULL);
 	nck_tetrys_enc_set_systematic_phase(base_enc, systematic);
 	nck_tetrys_enc_set_coded_phase(base_enc, coded);
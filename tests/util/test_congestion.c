@@ -0,0 +1,203 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <util/congestion.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+/* the simulated path: a bottleneck that delivers one packet per millisecond
+ * and 20 milliseconds of propagation delay for a round trip */
+#define LINK_SERVICE_US 1000
+#define LINK_DELAY_US 20000
+#define LINK_BW 1000.0
+#define PACKET_SIZE 1000
+#define STEP_US 100
+#define MAX_PACKETS 16384
+
+/**
+ * struct link - bottleneck queue with the feedback of the receiver
+ * @now: simulated time in microseconds
+ * @next_send: earliest time of the next packet allowed by the pacing rate
+ * @busy_until: time when the bottleneck has sent all queued packets
+ * @sent: number of packets that were sent
+ * @acked: number of packets whose feedback reached the sender
+ * @feedback: time when the feedback of a packet arrives at the sender
+ * @queued: number of packets waiting at the bottleneck when a packet arrived
+ */
+struct link {
+	uint64_t now;
+	uint64_t next_send;
+	uint64_t busy_until;
+	uint32_t sent;
+	uint32_t acked;
+	uint64_t feedback[MAX_PACKETS];
+	uint32_t queued[MAX_PACKETS];
+};
+
+static struct link sim;
+
+static struct timeval link_time(void)
+{
+	struct timeval result = {
+		.tv_sec = sim.now / 1000000,
+		.tv_usec = sim.now % 1000000,
+	};
+	return result;
+}
+
+/* advance the clock by one step and let the controller send and receive */
+static void link_step(struct congestion_control *cc)
+{
+	struct timeval now;
+	uint64_t start, rate;
+
+	sim.now += STEP_US;
+	now = link_time();
+
+	while (sim.acked < sim.sent && sim.feedback[sim.acked] <= sim.now) {
+		// every delivered packet is reported with the reception counter
+		congestion_feedback(cc, (uint16_t)sim.acked, (uint8_t)(sim.acked + 1), &now);
+		sim.acked += 1;
+	}
+
+	while (congestion_allowed(cc) && sim.next_send <= sim.now) {
+		assert(sim.sent < MAX_PACKETS);
+
+		congestion_sent(cc, (uint16_t)sim.sent, &now);
+
+		start = sim.busy_until > sim.now ? sim.busy_until : sim.now;
+		sim.queued[sim.sent] = (start - sim.now) / LINK_SERVICE_US;
+		sim.busy_until = start + LINK_SERVICE_US;
+		sim.feedback[sim.sent] = sim.busy_until + LINK_DELAY_US;
+		sim.sent += 1;
+
+		// without a bandwidth estimate only the window limits the sender
+		rate = congestion_pacing_rate(cc);
+		if (rate)
+			sim.next_send = sim.now + PACKET_SIZE * 1000000 / rate;
+	}
+}
+
+static double estimated_bw(const struct congestion_control *cc)
+{
+	return congestion_pacing_rate(cc) / cc->pacing_gain / PACKET_SIZE;
+}
+
+static void test_startup(void)
+{
+	struct congestion_control cc;
+	uint32_t sent_before;
+
+	memset(&sim, 0, sizeof(sim));
+	congestion_init(&cc, PACKET_SIZE, 2);
+
+	TEST_CHECK(cc.mode == CONGESTION_STARTUP);
+	TEST_CHECK(congestion_pacing_rate(&cc) == 0);
+	TEST_CHECK(congestion_window(&cc) == 10);
+
+	// the initial window goes out at once and nothing more before feedback
+	link_step(&cc);
+	TEST_CHECK_(sim.sent == 10, "sent %u", sim.sent);
+	sent_before = sim.sent;
+	link_step(&cc);
+	TEST_CHECK(sim.sent == sent_before);
+
+	// after the first round trip the startup sends faster than the link
+	while (sim.acked == 0)
+		link_step(&cc);
+	TEST_CHECK(cc.mode == CONGESTION_STARTUP);
+	TEST_CHECK_(cc.min_rtt.tv_usec >= LINK_DELAY_US + LINK_SERVICE_US &&
+		    cc.min_rtt.tv_usec < LINK_DELAY_US + 2 * LINK_SERVICE_US,
+		    "min_rtt %ld us", (long)cc.min_rtt.tv_usec);
+	TEST_CHECK(cc.pacing_gain > 2);
+}
+
+static void test_drain_and_probe(void)
+{
+	struct congestion_control cc;
+	bool drained = false, probed_up = false, probed_down = false, left = false;
+	uint32_t first_probe = 0, max_queue = 0, i;
+	double bdp = LINK_BW * (LINK_DELAY_US + LINK_SERVICE_US) / 1000000.0;
+
+	memset(&sim, 0, sizeof(sim));
+	congestion_init(&cc, PACKET_SIZE, 2);
+
+	// the startup fills the queue until the bandwidth stops growing
+	while (cc.mode == CONGESTION_STARTUP && sim.now < 1000000)
+		link_step(&cc);
+	TEST_ASSERT_(cc.mode == CONGESTION_DRAIN, "mode %d after %llu us", cc.mode,
+		     (unsigned long long)sim.now);
+	TEST_CHECK(cc.pacing_gain < 1);
+	TEST_CHECK_(estimated_bw(&cc) > 0.9 * LINK_BW && estimated_bw(&cc) < 1.1 * LINK_BW,
+		    "bandwidth %f", estimated_bw(&cc));
+
+	// the drain sends slower until the queue of the startup is gone
+	while (cc.mode == CONGESTION_DRAIN && sim.now < 2000000) {
+		link_step(&cc);
+		drained = true;
+	}
+	TEST_ASSERT_(cc.mode == CONGESTION_PROBE_BW, "mode %d after %llu us", cc.mode,
+		     (unsigned long long)sim.now);
+	TEST_CHECK(drained);
+	TEST_CHECK(congestion_in_flight(&cc) <= bdp + 1);
+	first_probe = sim.sent;
+
+	// cruising at the bandwidth with short phases probing up and down
+	while (sim.now < 4000000) {
+		link_step(&cc);
+		left |= cc.mode != CONGESTION_PROBE_BW;
+		probed_up |= cc.pacing_gain > 1;
+		probed_down |= cc.pacing_gain < 1;
+	}
+	TEST_CHECK(!left);
+	TEST_CHECK(probed_up);
+	TEST_CHECK(probed_down);
+	TEST_CHECK_(estimated_bw(&cc) > 0.9 * LINK_BW && estimated_bw(&cc) < 1.1 * LINK_BW,
+		    "bandwidth %f", estimated_bw(&cc));
+	TEST_CHECK_(congestion_window(&cc) <= 2 * bdp + 2, "window %u", congestion_window(&cc));
+
+	// the link stays busy while the queue does not grow beyond a probe
+	for (i = first_probe; i < sim.sent; ++i)
+		max_queue = sim.queued[i] > max_queue ? sim.queued[i] : max_queue;
+	TEST_CHECK_(max_queue < bdp / 2, "queue of %u packets", max_queue);
+	TEST_CHECK_((sim.sent - first_probe) * LINK_SERVICE_US > 0.9 * (sim.now - sim.feedback[first_probe]),
+		    "sent %u packets", sim.sent - first_probe);
+}
+
+static void test_timeout(void)
+{
+	struct congestion_control cc;
+	struct timeval delay;
+
+	memset(&sim, 0, sizeof(sim));
+	congestion_init(&cc, PACKET_SIZE, 2);
+
+	congestion_timeout_delay(&cc, &delay);
+	TEST_CHECK(delay.tv_sec == 1 && delay.tv_usec == 0);
+
+	while (cc.mode != CONGESTION_PROBE_BW && sim.now < 2000000)
+		link_step(&cc);
+	TEST_ASSERT(cc.mode == CONGESTION_PROBE_BW);
+
+	congestion_timeout_delay(&cc, &delay);
+	TEST_CHECK_(delay.tv_sec == 0 && delay.tv_usec == 200000, "delay %ld us", (long)delay.tv_usec);
+
+	// the feedback is lost, so everything in flight is gone and the
+	// controller probes the path from the start
+	congestion_timeout(&cc);
+	TEST_CHECK(cc.mode == CONGESTION_STARTUP);
+	TEST_CHECK(congestion_in_flight(&cc) == 0);
+	TEST_CHECK(congestion_pacing_rate(&cc) == 0);
+	TEST_CHECK(congestion_allowed(&cc));
+}
+
+TEST_LIST = {
+	{ "startup", test_startup },
+	{ "drain_and_probe", test_drain_and_probe },
+	{ "timeout", test_timeout },
+	{ NULL, NULL }
+};
@@ -0,0 +1,115 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/finite_field.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+/* not a multiple of the chunk size of the region functions */
+#define LEN 1300
+#define COUNT 7
+#define DESTS 5
+
+static uint8_t sources[COUNT][LEN];
+static uint8_t *srcs[COUNT];
+
+static void fill_sources(unsigned int seed)
+{
+	size_t i, j;
+
+	srand(seed);
+	for (i = 0; i < COUNT; ++i) {
+		for (j = 0; j < LEN; ++j) {
+			sources[i][j] = rand();
+		}
+		srcs[i] = sources[i];
+	}
+}
+
+/* sum of the sources computed one byte at a time */
+static void reference_sum(uint8_t *dest, const uint8_t *factors)
+{
+	size_t i, j;
+
+	for (j = 0; j < LEN; ++j) {
+		for (i = 0; i < COUNT; ++i) {
+			dest[j] = binary8_add(dest[j], binary8_multiply(sources[i][j], factors[i]));
+		}
+	}
+}
+
+static void test_region_multiply_sum(void)
+{
+	uint8_t factors[COUNT] = { 1, 2, 0, 0x53, 0xff, 0, 0x8e };
+	uint8_t initial[LEN], expected[LEN], actual[LEN];
+	size_t j;
+
+	binary8_init();
+	fill_sources(1);
+
+	for (j = 0; j < LEN; ++j) {
+		initial[j] = j * 7;
+	}
+
+	memcpy(expected, initial, LEN);
+	reference_sum(expected, factors);
+
+	memcpy(actual, initial, LEN);
+	binary8_region_multiply_sum(actual, srcs, factors, COUNT, LEN);
+	TEST_ASSERT(!memcmp(expected, actual, LEN));
+
+	/* must agree with repeated region_multiply_add */
+	memcpy(actual, initial, LEN);
+	for (j = 0; j < COUNT; ++j) {
+		binary8_region_multiply_add(actual, srcs[j], factors[j], LEN);
+	}
+	TEST_ASSERT(!memcmp(expected, actual, LEN));
+
+	/* no sources leave the destination untouched */
+	memcpy(actual, initial, LEN);
+	binary8_region_multiply_sum(actual, srcs, factors, 0, LEN);
+	TEST_ASSERT(!memcmp(initial, actual, LEN));
+}
+
+static void test_region_multiply_sum_batch(void)
+{
+	uint8_t factors[DESTS * COUNT];
+	uint8_t expected[DESTS][LEN], actual[DESTS][LEN];
+	uint8_t *dests[DESTS];
+	size_t d;
+
+	binary8_init();
+	fill_sources(2);
+
+	for (d = 0; d < DESTS * COUNT; ++d) {
+		factors[d] = rand();
+	}
+	/* a destination without any contribution */
+	memset(&factors[3 * COUNT], 0, COUNT);
+
+	for (d = 0; d < DESTS; ++d) {
+		memset(expected[d], 0, LEN);
+		reference_sum(expected[d], &factors[d * COUNT]);
+
+		memset(actual[d], 0, LEN);
+		dests[d] = actual[d];
+	}
+
+	binary8_region_multiply_sum_batch(dests, DESTS, srcs, factors, COUNT, LEN);
+
+	for (d = 0; d < DESTS; ++d) {
+		TEST_ASSERT_(!memcmp(expected[d], actual[d], LEN), "destination %zu", d);
+	}
+}
+
+TEST_LIST = {
+	{"region_multiply_sum", test_region_multiply_sum},
+	{"region_multiply_sum_batch", test_region_multiply_sum_batch},
+	{NULL}
+};
@@ -0,0 +1,163 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <util/gen_table.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+static int entries[64];
+
+static void check_order(struct gen_table *table, const uint32_t *expected, size_t count)
+{
+	uint32_t gen;
+	size_t i = 0;
+	int *entry;
+
+	gen_table_for_each(table, gen, entry) {
+		TEST_ASSERT(i < count);
+		TEST_ASSERT_(gen == expected[i], "expected %u, actual %u", expected[i], gen);
+		TEST_ASSERT(entry == gen_table_get(table, gen));
+		i += 1;
+	}
+	TEST_ASSERT(i == count);
+}
+
+static void test_insert_remove(void)
+{
+	struct gen_table table;
+	uint32_t order[] = { 3, 5, 20 };
+	uint32_t gen;
+
+	gen_table_init(&table, 4);
+
+	TEST_ASSERT(gen_table_oldest(&table) == NULL);
+	TEST_ASSERT(gen_table_first(&table, &gen) == NULL);
+
+	TEST_ASSERT(gen_table_insert(&table, 5, &entries[5]) == 0);
+	TEST_ASSERT(gen_table_insert(&table, 3, &entries[3]) == 0);
+	/* enlarges the ring */
+	TEST_ASSERT(gen_table_insert(&table, 20, &entries[20]) == 0);
+	TEST_ASSERT(table.size > 17);
+
+	TEST_ASSERT(gen_table_get(&table, 4) == NULL);
+	TEST_ASSERT(gen_table_get(&table, 21) == NULL);
+	TEST_ASSERT(gen_table_oldest(&table) == &entries[3]);
+	TEST_ASSERT(gen_table_newest(&table) == &entries[20]);
+	check_order(&table, order, 3);
+
+	gen_table_remove(&table, 3);
+	TEST_ASSERT(table.oldest == 5);
+	gen_table_remove(&table, 20);
+	TEST_ASSERT(table.newest == 5);
+	check_order(&table, &order[1], 1);
+
+	gen_table_remove(&table, 5);
+	TEST_ASSERT(table.count == 0);
+	TEST_ASSERT(gen_table_get(&table, 5) == NULL);
+
+	gen_table_free(&table);
+}
+
+static void test_remove_while_iterating(void)
+{
+	struct gen_table table;
+	uint32_t gen, i;
+	int *entry;
+
+	gen_table_init(&table, 8);
+	for (i = 1; i <= 6; ++i) {
+		TEST_ASSERT(gen_table_insert(&table, i, &entries[i]) == 0);
+	}
+
+	i = 0;
+	gen_table_for_each(&table, gen, entry) {
+		TEST_ASSERT(entry == &entries[gen]);
+		gen_table_remove(&table, gen);
+		i += 1;
+	}
+	TEST_ASSERT(i == 6);
+	TEST_ASSERT(table.count == 0);
+
+	gen_table_free(&table);
+}
+
+static void test_max_span(void)
+{
+	struct gen_table table;
+
+	gen_table_init(&table, 8);
+	gen_table_set_max_span(&table, 8);
+
+	TEST_ASSERT(gen_table_insert(&table, 100, &entries[0]) == 0);
+	TEST_ASSERT(gen_table_fits(&table, 107));
+	TEST_ASSERT(!gen_table_fits(&table, 108));
+	TEST_ASSERT(gen_table_fits(&table, 93));
+	TEST_ASSERT(!gen_table_fits(&table, 92));
+
+	/* out of range generations are rejected without growing the ring */
+	TEST_ASSERT(gen_table_insert(&table, 108, &entries[1]) == -1);
+	TEST_ASSERT(gen_table_insert(&table, 100 + (1u << 31), &entries[1]) == -1);
+	TEST_ASSERT(gen_table_insert(&table, 0xffffffff, &entries[1]) == -1);
+	TEST_ASSERT(table.size == 8);
+	TEST_ASSERT(table.count == 1);
+
+	TEST_ASSERT(gen_table_insert(&table, 107, &entries[1]) == 0);
+	TEST_ASSERT(!gen_table_fits(&table, 99));
+
+	/* an empty table accepts any generation */
+	gen_table_remove(&table, 100);
+	gen_table_remove(&table, 107);
+	TEST_ASSERT(gen_table_fits(&table, 0x80000000));
+
+	gen_table_free(&table);
+}
+
+static void test_wrap_around(void)
+{
+	struct gen_table table;
+	uint32_t order[] = { 0xfffffffe, 0xffffffff, 0, 1, 2 };
+	uint32_t gen;
+
+	gen_table_init(&table, 4);
+	gen_table_set_max_span(&table, 16);
+
+	TEST_ASSERT(gen_table_insert(&table, 0, &entries[2]) == 0);
+	TEST_ASSERT(gen_table_insert(&table, 0xffffffff, &entries[1]) == 0);
+	TEST_ASSERT(gen_table_insert(&table, 2, &entries[4]) == 0);
+	TEST_ASSERT(gen_table_insert(&table, 0xfffffffe, &entries[0]) == 0);
+	TEST_ASSERT(gen_table_insert(&table, 1, &entries[3]) == 0);
+
+	TEST_ASSERT(table.oldest == 0xfffffffe);
+	TEST_ASSERT(table.newest == 2);
+	TEST_ASSERT(gen_table_get(&table, 0xffffffff) == &entries[1]);
+	TEST_ASSERT(gen_table_get(&table, 3) == NULL);
+	TEST_ASSERT(gen_table_get(&table, 0xfffffffd) == NULL);
+	check_order(&table, order, 5);
+
+	gen = 0xffffffff;
+	TEST_ASSERT(gen_table_next(&table, &gen) == &entries[2]);
+	TEST_ASSERT(gen == 0);
+
+	gen_table_remove(&table, 0xfffffffe);
+	gen_table_remove(&table, 0xffffffff);
+	TEST_ASSERT(table.oldest == 0);
+	TEST_ASSERT(gen_table_oldest(&table) == &entries[2]);
+
+	TEST_ASSERT(gen_before(0xffffffff, 0));
+	TEST_ASSERT(!gen_before(0, 0xffffffff));
+	TEST_ASSERT(!gen_before(5, 5));
+
+	gen_table_free(&table);
+}
+
+TEST_LIST = {
+	{"insert_remove", test_insert_remove},
+	{"remove_while_iterating", test_remove_while_iterating},
+	{"max_span", test_max_span},
+	{"wrap_around", test_wrap_around},
+	{NULL}
+};
@@ -0,0 +1,102 @@
+#include <cutest.h>
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nckernel/trace.h>
+
+#define TEST_ASSERT(cond) assert(TEST_CHECK(cond))
+#define TEST_ASSERT_(cond, ...) assert(TEST_CHECK_(cond, __VA_ARGS__))
+
+static char decoded[16384];
+
+/* dump the binary trace and decode it into the decoded buffer */
+static void dump_and_decode(void)
+{
+	FILE *dump = tmpfile();
+	FILE *text = tmpfile();
+	size_t len;
+
+	TEST_ASSERT(dump && text);
+	TEST_ASSERT(nck_trace_dump(dump) == 0);
+	rewind(dump);
+	TEST_ASSERT(nck_trace_decode(dump, text) == 0);
+	rewind(text);
+
+	len = fread(decoded, 1, sizeof(decoded) - 1, text);
+	decoded[len] = '\0';
+
+	fclose(dump);
+	fclose(text);
+}
+
+static void test_round_trip(void)
+{
+	int context;
+	const char *first, *second;
+
+	nck_trace_set_mask(NCK_TRACE_BINARY);
+	nck_trace_set_filter("*", NULL);
+
+	nck_trace(&context, "int %d long %lld str %s", -42, 1234567890123LL, "hello");
+	nck_trace(&context, "double %.2f hex %#x char %c %%", 3.25, 0xbeef, 'z');
+
+	nck_trace_set_mask(0);
+	dump_and_decode();
+
+	first = strstr(decoded, "int -42 long 1234567890123 str hello\n");
+	second = strstr(decoded, "double 3.25 hex 0xbeef char z %\n");
+	TEST_ASSERT_(first != NULL, "decoded: %s", decoded);
+	TEST_ASSERT_(second != NULL, "decoded: %s", decoded);
+	TEST_CHECK_(first < second, "records are not ordered by time");
+	TEST_CHECK(strstr(decoded, "test_round_trip") != NULL);
+}
+
+static void test_string_precision(void)
+{
+	char unterminated[4] = { 'a', 'b', 'c', 'd' };
+	char long_string[1000];
+
+	memset(long_string, 'x', sizeof(long_string) - 1);
+	long_string[sizeof(long_string) - 1] = '\0';
+
+	nck_trace_set_mask(NCK_TRACE_BINARY);
+	nck_trace_set_filter("*", NULL);
+
+	// only the bytes within the precision are read, so neither record is
+	// truncated even though the strings are longer than a record
+	nck_trace(NULL, "star [%.*s]", (int)sizeof(unterminated), unterminated);
+	nck_trace(NULL, "fixed [%.3s]", long_string);
+	nck_trace(NULL, "star [%.*s]", 2, long_string);
+
+	nck_trace_set_mask(0);
+	dump_and_decode();
+
+	TEST_CHECK_(strstr(decoded, "star [abcd]\n") != NULL, "decoded: %s", decoded);
+	TEST_CHECK_(strstr(decoded, "fixed [xxx]\n") != NULL, "decoded: %s", decoded);
+	TEST_CHECK_(strstr(decoded, "star [xx]\n") != NULL, "decoded: %s", decoded);
+}
+
+static void test_invalid(void)
+{
+	FILE *in = tmpfile();
+	FILE *out = tmpfile();
+
+	TEST_ASSERT(in && out);
+	fputs("not a trace", in);
+	rewind(in);
+
+	TEST_CHECK(nck_trace_decode(in, out) == -1);
+
+	fclose(in);
+	fclose(out);
+}
+
+TEST_LIST = {
+	{ "round_trip", test_round_trip },
+	{ "string_precision", test_string_precision },
+	{ "invalid", test_invalid },
+	{ NULL, NULL }
+};